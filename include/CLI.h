@@ -1,8 +1,12 @@
 #ifndef _CLI_H_
 #define _CLI_H_
 
+#include <stdint.h>
+
 extern const char* CLI_USAGE;
 
+#define CLI_MAX_BREAKPOINTS 16
+
 typedef enum CompileFileType_t {
     CFT_BIN, 
     CFT_ASM, 
@@ -28,6 +32,7 @@ typedef struct CompileOption_t {
     unsigned int skip_preasm : 1;   // [skip] [pre]processor of [as]se[m]bler
     // Disassembler
     unsigned int d : 1;             // [d]isassemble
+    unsigned int estimate : 1;      // cycle [estimate] per instruction and label, from the cost model
     // Optimizer
     unsigned int O : 1;             // [O]ptimization
     // Canonicalizer
@@ -39,8 +44,31 @@ typedef struct CompileOption_t {
     unsigned int toc : 1;           // transpile [to] [C]
     // Emulator
     unsigned int run : 1;           // [run]
+    unsigned int fast : 1;          // [fast] instruction stepped execution
+    unsigned int jit : 1;           // [jit] translated basic blocks on top of fast
+    unsigned int bench : 1;         // [bench]mark host time per guest instruction
+    unsigned int no_fusion : 1;     // [no] superinstruction [fusion] in the decode cache
+    unsigned int hybrid : 1;        // [hybrid] fast execution that drops to cycle accuracy when needed
+    unsigned int burst_fetch : 1;   // [burst fetch] keep the whole 8 byte ram response in a prefetch buffer
+    unsigned int word_stores : 1;   // [word stores] 16-bit stores in one bus transaction
+    unsigned int bus_events : 1;    // [bus events] serve every pending request each bus clock instead of round-robin
+    unsigned int dma : 1;           // [dma] controller on the bus
+    unsigned int pipeline : 1;      // [pipeline] pipelined timing model next to the multi-cycle one
+    unsigned int trace : 1;         // [trace] every instruction the cpu starts
+    int branch_predictor;           // CpuBranchPredictorKind_t, -1 if off
+    int lockstep;                   // [lockstep] lanes, 0 for a single system
+    int cores;                      // [cores] on the bus, more than one run on host threads with -fast
+    int outstanding;                // tagged bus requests every cpu can have [outstanding], 0 for none
+    int peripheral_divider;         // terminal and filesystem are clocked every n-th cycle [peripheral divider], 1 for every cycle
+    char* cycles_json;              // file the [cycles] per cpu state are exported to as [json], NULL if not
     // CPU
     unsigned int cache_size;
+    unsigned int decode_cache_size;
+    // Debugging
+    uint16_t breakpoint[CLI_MAX_BREAKPOINTS];
+    int breakpoint_count;
+    uint16_t cycle_window_start;    // cycle accurate pc window [start, end) in hybrid execution
+    uint16_t cycle_window_end;
 } CompileOption_t;
 
 extern const CompileOption_t CO_DEFAULT;
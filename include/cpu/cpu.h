@@ -8,6 +8,10 @@
 #include "modules/cache.h"
 
 #include "cpu/cpu_instructions.h"
+#include "cpu/cpu_decode_cache.h"
+#include "cpu/cpu_jit.h"
+#include "cpu/cpu_pipeline.h"
+#include "cpu/cpu_branch_predictor.h"
 
 /*
 Instructions are encoded as follows: 
@@ -115,12 +119,78 @@ typedef struct CpuMemoryLayout_t {
     uint16_t segment_irq_table; // lookup table for interrupt subroutines
 } CpuMemoryLayout_t;
 
+/*
+Estimated cost of a cache miss or store when cpu_step_instruction accesses ram directly, in sixteenths of a cycle.
+They stand in for the bus round trip that system_clock would have simulated, the remainder is carried in direct_fraction.
+Fitted against system_clock with 64, 8 and no cache lines: the IR compiled fibonacci and a libc test land within 2%, 
+a 253 instruction test up to 8% high. example_scripts/asm/fibonacci.asm under main (ticker on) lands 3.5% low.
+*/
+#define CPU_DIRECT_READ_CYCLES 34     // ~2.13 cycles per cache miss
+#define CPU_DIRECT_WRITE_CYCLES 34    // and per store
+
+/*
+CMP and TST do not compute their status bits right away, they only record the operands. 
+The bits are computed once something reads them: conditional jumps and moves only resolve the one bit they test, 
+PUSHSR, POPSR, the status bit instructions and cpu_status_register resolve all of them.
+*/
+typedef enum CpuFlagsOperation_t {
+    CFO_NONE, 
+    CFO_COMPARE, 
+    CFO_TEST, 
+} CpuFlagsOperation_t;
+
+#define CPU_FLAGS_COMPARE_MASK 0x007f   // Z, FZ, L, UL, FL, DL, LL
+#define CPU_FLAGS_TEST_MASK 0x0007      // Z, FZ, L
+
+/*
+Burst fetch: ram answers every fetch with the 8 bytes starting at the requested address, 
+the prefetch buffer keeps them so the rest of the instruction (and data next to it) needs no further bus round trip. 
+It works without a data cache, is only filled from ram (never MMIO) and is updated by the cpu's own stores.
+With tagged transactions on the device (split transactions, device_set_transaction_capacity), the cpu fetches the
+bytes at pc ahead from the moment the current instruction is decoded until it has written back, the reply moves into the buffer once
+the fetch gets there. A store to bytes that are fetched ahead drops the fetch.
+*/
+#define CPU_PREFETCH_BYTES 8
+#define CPU_PREFETCH_AHEAD_BYTES 4    // pc is fetched ahead once fewer of its bytes are left in the buffer
+
+/*
+Hardware interrupts are latched when the bus delivers them and taken at the next instruction boundary (fetch or sleep), 
+so the instruction in flight always completes. An interrupt that arrives while interrupts are masked (MI), 
+or while another one is still pending, is dropped, and so are the ones a device folded into the interrupt it was already raising 
+(the ticker firing again before its last interrupt got delivered). 
+The latency from the device raising the interrupt (Device_t asserted) to the first instruction of the handler is collected in a histogram, 
+so it includes the time the interrupt waited for the bus: 
+bucket b counts latencies of b significant bits, [2^(b-1), 2^b) cycles, the last bucket everything above
+*/
+#define CPU_INTERRUPT_LATENCY_BUCKETS 16
+
+/*
+Cycles per CpuState_t. A cycle that ends with a request to the bus in flight, or the estimated ram access of 
+cpu_read_memory/cpu_write_memory with direct ram, is stalled and counts for the state that waits for the memory. 
+Every other cycle is active and counts for the state it started in. 
+Cycles the fast paths add in bulk (JIT blocks, skipped idle loops, fast forwarded sleep, lockstep followers) are in neither: 
+they are what cpu->clock has on top of both
+*/
+typedef struct CpuCycles_t {
+    uint64_t active[CS_COUNT];
+    uint64_t stalled[CS_COUNT];
+    uint64_t memory;            // stalled cycles booked by direct ram accesses so far
+} CpuCycles_t;
+
 typedef struct CPU_t {
+    void (*clock_variant)(struct CPU_t* cpu);   // cpu_clock specialized for what is mounted, see cpu_select_clock_variant
     uint64_t clock;             // keeps track of the number of cycles
     uint64_t instruction;       // keeps track of the number of executed instructions
+    uint64_t stores;            // counts writes that may have changed something, a loop that leaves it unchanged has no side effects
     CPU_INSTRUCTION_MNEMONIC_t last_instruction; // the last executed/pending instruction of the cpu
 
     Cache_t* cache;
+    CpuDecodeCache_t* decode_cache;     // optional, skips the decode states for already decoded instructions
+    RAM_t* direct_ram;                  // set while cpu_step_instruction runs, ram is then accessed without the bus
+    uint8_t direct_fraction;            // sixteenths of a cycle charged for direct ram accesses, not yet on clock
+    CpuJit_t* jit;                      // optional, runs translated blocks in system_run_fast
+    CpuPipeline_t* pipeline;            // optional, pipelined timing model fed with every started instruction
+    CpuBranchPredictor_t* branch_predictor; // optional, fed with every conditional jump, conditional move, call and return
 
     struct {
         uint16_t r0, r1, r2, r3, pc, sp;
@@ -145,6 +215,36 @@ typedef struct CPU_t {
         } sr;
     } regs;
 
+    struct {
+        uint8_t active;         // burst fetch is off by default, so the bus timing stays byte exact
+        uint8_t valid;
+        uint16_t address;       // address of the first buffered byte
+        uint64_t data;
+        uint64_t hit, fill;
+        uint64_t ahead, ahead_used;     // tagged fetches of the next instruction, and the ones it was fetched from
+    } prefetch;
+
+    struct {
+        uint8_t pending;        // delivered but not taken yet
+        uint8_t servicing;      // taken, the irq vector has not been loaded yet
+        uint16_t irq_id;
+        uint64_t asserted;      // cpu clock when the device raised it
+        uint64_t taken, dropped, latency_max;
+        uint64_t latency[CPU_INTERRUPT_LATENCY_BUCKETS];
+    } interrupt;
+
+    CpuCycles_t cycles;
+
+    uint8_t trace;              // log every instruction the cpu starts, call cpu_select_clock_variant after changing it
+    uint8_t core_id;            // index of the core on a multi-core system, what HWCORE returns
+    uint8_t word_stores;        // 16-bit stores to ram and memory banks go out as one 2 byte transaction, off for byte exact timing
+
+    struct {
+        uint8_t operation;      // CpuFlagsOperation_t of the last CMP/TST
+        uint8_t pending;        // sr bits that still have to be computed from a and b
+        uint16_t a, b;
+    } flags;
+
 
     CpuState_t state;
     CpuIntermediate_t intermediate;
@@ -157,14 +257,28 @@ extern CPU_t* cpu_create(void);
 
 extern void cpu_delete(CPU_t** cpu);
 
+// picks the cpu_clock variant that matches the mounted cache, pipeline, branch predictor and trace flag, the mounts call it themselves
+extern void cpu_select_clock_variant(CPU_t* cpu);
+
 extern void cpu_mount_cache(CPU_t* cpu, Cache_t* cache);
 
+extern void cpu_mount_decode_cache(CPU_t* cpu, CpuDecodeCache_t* decode_cache);
+
+extern void cpu_mount_jit(CPU_t* cpu, CpuJit_t* jit);
+
+extern void cpu_mount_pipeline(CPU_t* cpu, CpuPipeline_t* pipeline);
+
+extern void cpu_mount_branch_predictor(CPU_t* cpu, CpuBranchPredictor_t* branch_predictor);
+
 extern void cpu_print_cache(CPU_t* cpu);
 
 extern void cpu_print_state(CPU_t* cpu);
 
 extern void cpu_print_state_compact(CPU_t* cpu);
 
+// writes cpu->cycles as JSON, returns 0 if the file could not be written
+extern int cpu_export_cycles_json(CPU_t* cpu, const char* filename);
+
 extern void cpu_print_stack(CPU_t* cpu, RAM_t* ram, int count);
 
 extern void cpu_print_stack_compact(CPU_t* cpu, RAM_t* ram, int count);
@@ -173,7 +287,33 @@ extern int cpu_read_memory(CPU_t* cpu, uint16_t address, uint8_t *data);
 
 extern int cpu_write_memory(CPU_t* cpu, uint16_t address, uint8_t data);
 
+// stores the low width bytes of data (1, 2, 4 or 8) in a single transaction
+extern int cpu_write_memory_width(CPU_t* cpu, uint16_t address, uint64_t data, uint8_t width);
+
+// 1 if a 16-bit store at address goes out as one transaction
+extern int cpu_word_store(CPU_t* cpu, uint16_t address);
+
+// charges count direct reads of ram to the clock and the ram statistics without reading anything, the JIT uses it for instruction bytes
+extern void cpu_charge_direct_reads(CPU_t* cpu, uint32_t count);
+
 extern void cpu_clock(CPU_t* cpu);
 
+// computes the pending status bits in mask and writes them to sr
+extern void cpu_resolve_flags(CPU_t* cpu, uint16_t mask);
+
+/*
+Returns the status register with all pending bits resolved. 
+cpu_clock resolves them after every cycle on the bus, with direct ram (cpu_step_instruction) 
+regs.sr can lag behind until this is called
+*/
+extern uint16_t cpu_status_register(CPU_t* cpu);
+
+/*
+Runs the cpu until the current instruction is finished, reading and writing the given ram directly. 
+Only accesses outside of ram (MMIO, memory banks) go through the bus.
+Returns 1 on an instruction boundary, 0 if the cpu is waiting on the bus or halted, excepted or asleep
+*/
+extern int cpu_step_instruction(CPU_t* cpu, RAM_t* ram);
+
 
 #endif
@@ -0,0 +1,72 @@
+#ifndef _CPU_BRANCH_PREDICTOR_H_
+#define _CPU_BRANCH_PREDICTOR_H_
+
+#include <stdint.h>
+
+/*
+Branch prediction model. The cpu never speculates, it hands every resolved conditional jump (J*, RJ*),
+conditional move (CMOV*, as if it were a branch around a mov) and call/return to the predictor,
+which checks what it would have predicted and learns from the outcome.
+The counts are kept per branch pc, so the branches that cost the most can be found and looked at.
+A pipeline timing model that is mounted next to it only pays the redirect for mispredictions.
+*/
+
+typedef enum CpuBranchPredictorKind_t {
+    CBP_STATIC,         // backward taken, forward not taken
+    CBP_BIMODAL,        // 2-bit saturating counter per pc
+    CBP_GSHARE,         // 2-bit saturating counters indexed by pc xor global history
+    CBP_COUNT,
+} CpuBranchPredictorKind_t;
+
+extern const char* cpu_branch_predictor_name[CBP_COUNT];
+
+#define CPU_BRANCH_PREDICTOR_TABLE_BITS 10
+#define CPU_BRANCH_PREDICTOR_TABLE_SIZE (1 << CPU_BRANCH_PREDICTOR_TABLE_BITS)
+#define CPU_RETURN_STACK_DEPTH 16
+
+typedef struct CpuBranchSite_t {
+    uint16_t pc;
+    int instruction;                // mnemonic of the branch
+    uint64_t taken, not_taken;
+    uint64_t mispredicted;
+} CpuBranchSite_t;
+
+typedef struct CpuBranchPredictor_t {
+    CpuBranchPredictorKind_t kind;
+    uint8_t counter[CPU_BRANCH_PREDICTOR_TABLE_SIZE];  // 0-1 predict not taken, 2-3 predict taken
+    uint16_t history;               // global history, most recent outcome in bit 0
+
+    uint16_t return_stack[CPU_RETURN_STACK_DEPTH];     // circular, overflows drop the oldest entry
+    int return_top;
+    int return_depth;
+
+    uint16_t* site_index;           // pc -> index + 1 into site, 0 if the pc has not branched yet
+    CpuBranchSite_t* site;
+    int site_count, site_capacity;
+
+    uint16_t last_pc;               // the last resolved branch or return
+    uint8_t last_valid;
+    uint8_t last_mispredicted;
+
+    uint64_t branches, mispredicted;
+    uint64_t returns, returns_mispredicted;
+} CpuBranchPredictor_t;
+
+
+extern CpuBranchPredictor_t* cpu_branch_predictor_create(CpuBranchPredictorKind_t kind);
+
+extern void cpu_branch_predictor_delete(CpuBranchPredictor_t** predictor);
+
+// a conditional jump or move at pc resolved to taken, backward tells whether its target lies at or before pc
+extern void cpu_branch_predictor_resolve(CpuBranchPredictor_t* predictor, uint16_t pc, int instruction, int backward, int taken);
+
+// a call (or interrupt) that returns to return_address
+extern void cpu_branch_predictor_call(CpuBranchPredictor_t* predictor, uint16_t return_address);
+
+// the return at pc went to target
+extern void cpu_branch_predictor_return(CpuBranchPredictor_t* predictor, uint16_t pc, uint16_t target);
+
+// prints totals and the count branch sites with the most mispredictions
+extern void cpu_branch_predictor_print(CpuBranchPredictor_t* predictor, int count);
+
+#endif
@@ -0,0 +1,95 @@
+#ifndef _CPU_DECODE_CACHE_H_
+#define _CPU_DECODE_CACHE_H_
+
+#include <stdint.h>
+
+#include "modules/ram.h"
+
+/*
+The decode cache remembers fully decoded instructions by their PC, so that the CPU can skip
+CS_FETCH_ADDRESSING_MODES and CS_FETCH_ARGUMENT_BYTES for code it has already seen.
+It is direct mapped, just like the data cache.
+Entries are stamped with the write generation of the RAM blocks they were decoded from,
+so any write to the code (be it through cpu_write_memory or ram_write) invalidates them.
+Only code that lives entirely in the given RAM is cached, since banked memory can change without a write.
+
+Once the instructions after an entry are decoded too, the entry is checked against a handful of idioms the
+IR compiler emits all the time. A matching entry becomes the head of a fused superinstruction that the cpu
+executes in one go when it runs with direct ram, charging the same cycles and instruction counts as the
+single instructions would have.
+*/
+
+#define CPU_FUSION_MAX_FOLLOWERS 2      // instructions after the head that can be fused into it
+
+typedef enum CpuFusion_t {
+    CF_NONE, 
+    CF_LOAD_PUSH,           // mov rX, [rY + imm]; push rX
+    CF_LEA_STORE,           // lea r0, [...]; mov [r0], reg/imm
+    CF_COMPARE_JUMP,        // cmp/tst reg/imm; jcc/rjcc imm
+    CF_PROLOGUE,            // push rX; mov rX, sp; sub sp, imm
+    CF_COUNT, 
+} CpuFusion_t;
+
+extern const char* cpu_fusion_name[CF_COUNT];
+
+typedef struct CpuDecodedFollower_t {
+    int instruction;
+    uint8_t addressing_mode;
+    int8_t argument_data_raw[5];
+} CpuDecodedFollower_t;
+
+typedef struct CpuDecodedInstruction_t {
+    uint16_t pc;                    // address of the first byte (including EXT prefixes)
+    uint8_t valid;
+    uint8_t length;                 // total length in bytes (including EXT prefixes)
+    uint8_t no_cache;               // NC bit of the opcode byte
+    uint8_t addressing_mode;        // raw addressing mode byte (admr/admx)
+    int instruction;                // mnemonic, extension already applied
+    int argument_count;
+    int8_t argument_bytes_to_load;
+    int8_t argument_data_raw[5];
+    int entry_state;                // CpuState_t the cpu continues with after decoding
+    uint32_t generation[2];         // RAM generation of the first and last block of the instruction
+
+    uint8_t fusion_checked;         // the instructions after this one have been looked at
+    uint8_t fusion;                 // CpuFusion_t, CF_NONE if this is not the head of a superinstruction
+    uint8_t fused_length;           // total length in bytes of all fused instructions
+    uint16_t fused_next_pc;         // pc after the last fused instruction
+    uint32_t fused_generation[2];   // RAM generation of the first and last block of all fused instructions
+    CpuDecodedFollower_t follower[CPU_FUSION_MAX_FOLLOWERS];
+} CpuDecodedInstruction_t;
+
+typedef struct CpuDecodeCache_t {
+    uint16_t capacity;
+    CpuDecodedInstruction_t* entry;
+    RAM_t* ram;                     // the memory the decoded code is fetched from
+    uint64_t hit, miss;
+    uint8_t fusion;                 // superinstructions are formed and executed, on by default
+    uint64_t fused[CF_COUNT];       // superinstructions executed, by kind
+    uint64_t fused_instructions;    // instructions executed as part of a superinstruction
+    uint64_t fusion_fallback;       // superinstructions that had to run as single instructions (operands outside of ram)
+} CpuDecodeCache_t;
+
+
+extern CpuDecodeCache_t* cpu_decode_cache_create(uint16_t capacity, RAM_t* ram);
+
+extern void cpu_decode_cache_delete(CpuDecodeCache_t** decode_cache);
+
+// returns the decoded instruction at pc, or NULL if there is none or it went stale
+extern CpuDecodedInstruction_t* cpu_decode_cache_lookup(CpuDecodeCache_t* decode_cache, uint16_t pc);
+
+// stamps the entry with the current RAM generation and stores it
+extern void cpu_decode_cache_insert(CpuDecodeCache_t* decode_cache, CpuDecodedInstruction_t* decoded);
+
+extern void cpu_decode_cache_invalidate(CpuDecodeCache_t* decode_cache);
+
+/*
+Tries to make the entry the head of a superinstruction, using the entries of the instructions that follow it.
+Does nothing if those have not been decoded yet, so it is retried on a later hit
+*/
+extern void cpu_decode_cache_fuse(CpuDecodeCache_t* decode_cache, CpuDecodedInstruction_t* decoded);
+
+// returns 1 if the superinstruction headed by the entry is still what is in ram and all of its followers still have their entries
+extern int cpu_decode_cache_fusion_valid(CpuDecodeCache_t* decode_cache, CpuDecodedInstruction_t* decoded);
+
+#endif
@@ -189,6 +189,9 @@ typedef enum CPU_INSTRUCTION_MNEMONIC {
     USS,        // uss dest, src    :: dest = max((int32_t) (dest - src), 0x0000)
     USM,        // usm dest, src    :: dest = min((int32_t) (dest * src), 0xffff)
 
+    // Self Identification (continued)
+    HWCORE,     // returns the [h]ard[w]are [core] id of the executing cpu in r0 (0 on single core systems)
+
     EXTNOP2 = 0x100, 
 
     // Number of defined instructions
@@ -205,6 +208,191 @@ typedef struct {
     int is_relative_jump_instruction;       // If an entry is one, it is a relative jump instruction and will treat labels differently during assembly
 } CPU_INSTRUCTION_ENCODING_t;
 
+/*
+Every mnemonic the cpu executes: X(mnemonic, string, argument_count, single_operant_writeback, is_jump_instruction, is_relative_jump_instruction).
+instruction_encoding[] and the CS_EXECUTE dispatch table of the cpu are both built from it, so a mnemonic without a handler does not compile.
+EXT is only a prefix and not part of it.
+*/
+#define CPU_INSTRUCTION_LIST(X) \
+    /* Data Manipulation */ \
+    X(NOP, "nop", 0, 0, 0, 0) \
+    X(MOV, "mov", 2, 0, 0, 0) \
+    X(PUSH, "push", 1, 0, 0, 0) \
+    X(POP, "pop", 1, 1, 0, 0) \
+    X(PUSHSR, "pushsr", 0, 0, 0, 0) \
+    X(POPSR, "popsr", 0, 0, 0, 0) \
+    X(LEA, "lea", 2, 0, 0, 0) \
+    \
+    /* Jumps and Calls */ \
+    X(JMP, "jmp", 1, 0, 1, 0) \
+    X(JZ, "jz", 1, 0, 1, 0) \
+    X(JNZ, "jnz", 1, 0, 1, 0) \
+    X(JFZ, "jfz", 1, 0, 1, 0) \
+    X(JNFZ, "jnfz", 1, 0, 1, 0) \
+    X(JL, "jl", 1, 0, 1, 0) \
+    X(JNL, "jnl", 1, 0, 1, 0) \
+    X(JUL, "jul", 1, 0, 1, 0) \
+    X(JNUL, "jnul", 1, 0, 1, 0) \
+    X(JFL, "jfl", 1, 0, 1, 0) \
+    X(JNFL, "jnfl", 1, 0, 1, 0) \
+    X(JDL, "jdl", 1, 0, 1, 0) \
+    X(JNDL, "jndl", 1, 0, 1, 0) \
+    X(JLL, "jll", 1, 0, 1, 0) \
+    X(JNLL, "jnll", 1, 0, 1, 0) \
+    X(JAO, "jao", 1, 0, 1, 0) \
+    X(JNAO, "jnao", 1, 0, 1, 0) \
+    X(CALL, "call", 1, 0, 1, 0) \
+    X(RET, "ret", 0, 0, 1, 0) \
+    \
+    /* Relative Jumps and Calls */ \
+    X(RJMP, "rjmp", 1, 0, 1, 1) \
+    X(RJZ, "rjz", 1, 0, 1, 1) \
+    X(RJNZ, "rjnz", 1, 0, 1, 1) \
+    X(RJFZ, "rjfz", 1, 0, 1, 1) \
+    X(RJNFZ, "rjnfz", 1, 0, 1, 1) \
+    X(RJL, "rjl", 1, 0, 1, 1) \
+    X(RJNL, "rjnl", 1, 0, 1, 1) \
+    X(RJUL, "rjul", 1, 0, 1, 1) \
+    X(RJNUL, "rjnul", 1, 0, 1, 1) \
+    X(RJFL, "rjfl", 1, 0, 1, 1) \
+    X(RJNFL, "rjnfl", 1, 0, 1, 1) \
+    X(RJDL, "rjdl", 1, 0, 1, 1) \
+    X(RJNDL, "rjndl", 1, 0, 1, 1) \
+    X(RJLL, "rjll", 1, 0, 1, 1) \
+    X(RJNLL, "rjnll", 1, 0, 1, 1) \
+    X(RJAO, "rjao", 1, 0, 1, 1) \
+    X(RJNAO, "rjnao", 1, 0, 1, 1) \
+    X(RCALL, "rcall", 1, 0, 1, 1) \
+    \
+    /* Arithmetic Integer Operations */ \
+    X(ADD, "add", 2, 0, 0, 0) \
+    X(ADC, "adc", 2, 0, 0, 0) \
+    X(SUB, "sub", 2, 0, 0, 0) \
+    X(SBC, "sbc", 2, 0, 0, 0) \
+    X(MUL, "mul", 2, 0, 0, 0) \
+    X(DIV, "div", 2, 0, 0, 0) \
+    X(NEG, "neg", 1, 1, 0, 0) \
+    X(ABS, "abs", 1, 1, 0, 0) \
+    X(INC, "inc", 1, 1, 0, 0) \
+    X(DEC, "dec", 1, 1, 0, 0) \
+    \
+    /* Saturated Arithmetic Signed Integer Operations */ \
+    X(SSA, "ssa", 2, 0, 0, 0) \
+    X(SSS, "sss", 2, 0, 0, 0) \
+    X(SSM, "ssm", 2, 0, 0, 0) \
+    \
+    /* Saturated Arithmetic Unsigned Integer Operations */ \
+    X(USA, "usa", 2, 0, 0, 0) \
+    X(USS, "uss", 2, 0, 0, 0) \
+    X(USM, "usm", 2, 0, 0, 0) \
+    \
+    /* Arithmetic Float Operations */ \
+    X(ADDF, "addf", 2, 0, 0, 0) \
+    X(SUBF, "subf", 2, 0, 0, 0) \
+    X(MULF, "mulf", 2, 0, 0, 0) \
+    X(DIVF, "divf", 2, 0, 0, 0) \
+    \
+    /* Arithmetic Double Operations */ \
+    X(ADDD, "addd", 2, 0, 0, 0) \
+    X(SUBD, "subd", 2, 0, 0, 0) \
+    X(MULD, "muld", 2, 0, 0, 0) \
+    X(DIVD, "divd", 2, 0, 0, 0) \
+    \
+    /* Arithmetic Long Operations */ \
+    X(ADDL, "addl", 2, 0, 0, 0) \
+    X(SUBL, "subl", 2, 0, 0, 0) \
+    X(MULL, "mull", 2, 0, 0, 0) \
+    X(DIVL, "divl", 2, 0, 0, 0) \
+    \
+    /* Type Conversion Operations */ \
+    X(CIF, "cif", 1, 1, 0, 0) \
+    X(CID, "cid", 1, 1, 0, 0) \
+    X(CIL, "cil", 1, 1, 0, 0) \
+    X(CFI, "cfi", 1, 1, 0, 0) \
+    X(CFD, "cfd", 1, 1, 0, 0) \
+    X(CFL, "cfl", 1, 1, 0, 0) \
+    X(CDI, "cdi", 1, 1, 0, 0) \
+    X(CDF, "cdf", 1, 1, 0, 0) \
+    X(CDL, "cdl", 1, 1, 0, 0) \
+    X(CLI, "cli", 1, 1, 0, 0) \
+    X(CLF, "clf", 1, 1, 0, 0) \
+    X(CLD, "cld", 1, 1, 0, 0) \
+    X(CBI, "cbi", 1, 1, 0, 0) \
+    \
+    /* Bitwise Logic */ \
+    X(UBS, "ubs", 2, 0, 0, 0) \
+    X(SBS, "sbs", 2, 0, 0, 0) \
+    X(AND, "and", 2, 0, 0, 0) \
+    X(OR, "or", 2, 0, 0, 0) \
+    X(XOR, "xor", 2, 0, 0, 0) \
+    X(NOT, "not", 1, 1, 0, 0) \
+    \
+    /* Tests */ \
+    X(CMP, "cmp", 2, 0, 0, 0) \
+    X(TST, "tst", 1, 0, 0, 0) \
+    \
+    /* Status Bit Manipulation */ \
+    X(CLZ, "clz", 0, 0, 0, 0) \
+    X(SEZ, "sez", 0, 0, 0, 0) \
+    X(CLFZ, "clfz", 0, 0, 0, 0) \
+    X(SEFZ, "sefz", 0, 0, 0, 0) \
+    X(CLL, "cll", 0, 0, 0, 0) \
+    X(SEL, "sel", 0, 0, 0, 0) \
+    X(CLUL, "clul", 0, 0, 0, 0) \
+    X(SEUL, "seul", 0, 0, 0, 0) \
+    X(CLFL, "clfl", 0, 0, 0, 0) \
+    X(SEFL, "sefl", 0, 0, 0, 0) \
+    X(CLDL, "cldl", 0, 0, 0, 0) \
+    X(SEDL, "sedl", 0, 0, 0, 0) \
+    X(CLLL, "clll", 0, 0, 0, 0) \
+    X(SELL, "sell", 0, 0, 0, 0) \
+    X(CLAO, "clao", 0, 0, 0, 0) \
+    X(SEAO, "seao", 0, 0, 0, 0) \
+    X(CLMI, "clmi", 0, 0, 0, 0) \
+    X(SEMI, "semi", 0, 0, 0, 0) \
+    \
+    /* Conditional Operations */ \
+    X(CMOVZ, "cmovz", 2, 0, 0, 0) \
+    X(CMOVNZ, "cmovnz", 2, 0, 0, 0) \
+    X(CMOVFZ, "cmovfz", 2, 0, 0, 0) \
+    X(CMOVNFZ, "cmovnfz", 2, 0, 0, 0) \
+    X(CMOVL, "cmovl", 2, 0, 0, 0) \
+    X(CMOVNL, "cmovnl", 2, 0, 0, 0) \
+    X(CMOVUL, "cmovul", 2, 0, 0, 0) \
+    X(CMOVNUL, "cmovnul", 2, 0, 0, 0) \
+    X(CMOVFL, "cmovfl", 2, 0, 0, 0) \
+    X(CMOVNFL, "cmovnfl", 2, 0, 0, 0) \
+    X(CMOVDL, "cmovdl", 2, 0, 0, 0) \
+    X(CMOVNDL, "cmovndl", 2, 0, 0, 0) \
+    X(CMOVLL, "cmovll", 2, 0, 0, 0) \
+    X(CMOVNLL, "cmovnll", 2, 0, 0, 0) \
+    X(CMOVAO, "cmovao", 2, 0, 0, 0) \
+    X(CMOVNAO, "cmovnao", 2, 0, 0, 0) \
+    X(CMOVMI, "cmovmi", 2, 0, 0, 0) \
+    X(CMOVNMI, "cmovnmi", 2, 0, 0, 0) \
+    \
+    X(MOVB, "movb", 2, 0, 0, 0) \
+    X(PUSHB, "pushb", 1, 0, 0, 0) \
+    X(POPB, "popb", 1, 1, 0, 0) \
+    \
+    /* Cache Operations */ \
+    X(INV, "inv", 0, 0, 0, 0) \
+    X(FTC, "ftc", 1, 0, 0, 0) \
+    \
+    /* Self Identification and HW-Info Operations */ \
+    X(HWCLOCK, "hwclock", 0, 0, 0, 0) \
+    X(HWINSTR, "hwinstr", 0, 0, 0, 0) \
+    X(HWSLEEP, "hwsleep", 0, 0, 0, 0) \
+    X(HWCORE, "hwcore", 0, 0, 0, 0) \
+    \
+    /* Other */ \
+    X(INT, "int", 1, 0, 0, 0) \
+    X(HLT, "hlt", 0, 0, 0, 0) \
+    \
+    /* Extended Instructions */ \
+    X(EXTNOP, "extnop", 0, 0, 0, 0) \
+    X(EXTNOP2, "extnop2", 0, 0, 0, 0)
+
 extern const CPU_INSTRUCTION_ENCODING_t instruction_encoding[INSTRUCTION_COUNT];
 
 #endif
@@ -0,0 +1,81 @@
+#ifndef _CPU_JIT_H_
+#define _CPU_JIT_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "modules/ram.h"
+
+/*
+The JIT translates guest basic blocks into x86-64 host code.
+A block starts at any PC and ends after the first jump, call or return, or right before an instruction
+the JIT does not translate (INT, HLT, POPSR, HWSLEEP, HWCLOCK, HWINSTR, HWCORE, INV, FTC, instructions with the NC bit set, unknown opcodes).
+Those are left to the interpreter, so is everything that touches memory outside of ram (MMIO, memory banks):
+the block then exits right before that instruction and the interpreter executes it.
+
+Guest registers stay in CPU_t, so the interpreter can pick up after any block exit.
+Data accesses go through cpu_read_memory/cpu_write_memory with direct ram. The instruction bytes are accounted for per block
+(see CpuJitFetch_t): without a data cache the direct reads they would take are charged at the block exits,
+with one the block is probed on entry and its bytes are counted as hits if all of them are cached.
+Only otherwise (prefetch, bus transactions, NC, a cold block) every instruction reads its bytes before it runs.
+Together with the cycles the state machine spends on each instruction, this keeps the data cache statistics and the clock identical
+to cpu_step_instruction without a decode cache (which skips the instruction fetches), only the per address read counters of __RAM_DEBUG miss the fetches.
+Arithmetic that is more than a couple of host instructions (float, saturating, shifts, CMP, ...) calls the CS_EXECUTE code in cpu_alu.h.
+
+Blocks are stamped with the RAM write generation of the code they were translated from, just like the decode cache.
+A store that hits translated code also makes the running block exit after the current instruction.
+*/
+
+#define CPU_JIT_CODE_SIZE (4 << 20)         // bytes of host code before everything is flushed
+#define CPU_JIT_BLOCK_INSTRUCTIONS 64       // max guest instructions per block
+#define CPU_JIT_BLOCK_CODE_MAX (48 << 10)   // upper bound of host code a single block can take
+
+struct CPU_t;
+
+// how the instruction bytes of the running block are accounted for
+typedef enum CpuJitFetch_t {
+    CJF_EACH,                       // every instruction reads its bytes through cpu_read_memory
+    CJF_DIRECT,                     // no data cache, the direct reads are charged at the block exits
+    CJF_CACHED,                     // every byte of the block was cached on entry, they are counted as hits at the block exits
+} CpuJitFetch_t;
+
+struct CpuJit_t;
+
+typedef int (*CpuJitBlockCode_t)(struct CPU_t* cpu, struct CpuJit_t* jit);
+
+typedef struct CpuJitBlock_t {
+    uint16_t pc;                    // guest address of the first instruction
+    uint16_t end;                   // guest address after the last translated byte
+    int instruction_count;          // 0 if the first instruction cannot be translated
+    CpuJitBlockCode_t code;
+    uint32_t generation[];          // RAM generation of every block in [pc, end)
+} CpuJitBlock_t;
+
+typedef struct CpuJit_t {
+    RAM_t* ram;                     // the memory the guest code is translated from
+    uint8_t* code;                  // executable buffer
+    size_t code_used;
+    CpuJitBlock_t** block;          // indexed by pc, only code in ram is translated
+    uint8_t* code_map;              // marks RAM generation blocks that contain translated code
+    uint8_t exit_requested;         // set by stores into translated code and by evicted code bytes, checked after every data access
+    uint8_t fetch;                  // CpuJitFetch_t of the running block
+    uint16_t fetch_start, fetch_end;    // guest range of the running block
+    uint64_t translated, executed, side_exits, flushes;
+} CpuJit_t;
+
+
+extern CpuJit_t* cpu_jit_create(RAM_t* ram);
+
+extern void cpu_jit_delete(CpuJit_t** jit);
+
+/*
+Runs the block at the current pc, translating it first if needed.
+The cpu has to be on an instruction boundary with the bus idle.
+Returns 1 if a block ran to its end, 0 if nothing was executed or the block left an instruction for the interpreter
+*/
+extern int cpu_jit_run(CpuJit_t* jit, struct CPU_t* cpu);
+
+// drops all translated blocks
+extern void cpu_jit_flush(CpuJit_t* jit);
+
+#endif
@@ -0,0 +1,93 @@
+#ifndef _CPU_PIPELINE_H_
+#define _CPU_PIPELINE_H_
+
+#include <stdint.h>
+
+#include "modules/ram.h"
+
+#include "cpu/cpu_branch_predictor.h"
+
+/*
+Timing model of a classic in-order 5 stage pipeline (fetch, decode, execute, memory, writeback)
+that runs next to the multi-cycle cpu. The cpu still executes every instruction, so all architectural
+results are the ones of the multi-cycle cpu, the pipeline only answers how many cycles the same
+instruction stream would have taken on a pipelined core.
+
+Every instruction the cpu starts is handed to the model once it knows where the next one starts.
+The model decodes it from ram and schedules it:
+- fetch of the next instruction overlaps with decode, execute and writeback of the ones in flight
+- data hazards: an instruction waits in decode for the registers (and status bits) it reads,
+  results are forwarded from the end of execute, loads from the end of memory (load-use stall)
+- control hazards: taken jumps, calls, returns and interrupts are resolved at the end of execute,
+  the instructions fetched behind them are flushed. With a branch predictor mounted on the cpu only
+  mispredicted branches and returns and indirect jumps flush, direct jumps and calls are taken from a branch target buffer
+- long latency arithmetic (mul, div, float) occupies execute for several cycles
+Time the cpu spends sleeping is not part of the model.
+*/
+
+typedef enum CpuTimingModel_t {
+    CTM_MULTI_CYCLE,    // one CpuState_t after the other, cpu->clock
+    CTM_PIPELINED,      // cpu->clock plus the pipelined estimate in cpu->pipeline
+} CpuTimingModel_t;
+
+#define CPU_PIPELINE_REGISTERS 6            // r0-r3, sp and the status register
+
+typedef struct CpuPipelineConfig_t {
+    int fetch_bytes;                        // instruction bytes fetched per cycle
+    int memory_cycles;                      // cycles a load or store spends in the memory stage
+    int multiply_cycles;                    // execute cycles of integer and fixed point multiplications
+    int divide_cycles;                      // and divisions
+    int float_cycles;                       // execute cycles of float16 and bfloat16 arithmetic
+    int forwarding;                         // 0: results are only available after writeback
+} CpuPipelineConfig_t;
+
+#define CPU_PIPELINE_DEFAULT_CONFIG ((CpuPipelineConfig_t) { \
+    .fetch_bytes = 4, \
+    .memory_cycles = 1, \
+    .multiply_cycles = 3, \
+    .divide_cycles = 12, \
+    .float_cycles = 4, \
+    .forwarding = 1, \
+})
+
+typedef struct CpuPipeline_t {
+    RAM_t* ram;                             // the memory instructions are decoded from
+    CpuPipelineConfig_t config;
+    CpuBranchPredictor_t* predictor;        // optional, set by cpu_mount_branch_predictor
+
+    uint8_t in_flight;                      // an instruction has been started and not been scheduled yet
+    uint16_t pc;                            // and this is where it started
+
+    uint64_t fetch_free;                    // cycle the fetch stage takes the next instruction
+    uint64_t decode_free;
+    uint64_t execute_free;
+    uint64_t memory_free;
+    uint64_t fetch_resume;                  // no fetch before this cycle, set by control hazards
+    uint64_t ready[CPU_PIPELINE_REGISTERS]; // cycle each register can be forwarded from
+
+    uint64_t clock;                         // cycle the last scheduled instruction left writeback
+    uint64_t instructions;
+    uint64_t data_stalls;                   // cycles instructions waited in decode for operands
+    uint64_t control_stalls;                // fetch cycles lost to redirects
+    uint64_t redirects;
+} CpuPipeline_t;
+
+
+extern CpuPipeline_t* cpu_pipeline_create(RAM_t* ram, CpuPipelineConfig_t config);
+
+extern void cpu_pipeline_delete(CpuPipeline_t** pipeline);
+
+/*
+Called whenever the cpu starts a fresh instruction at pc.
+Schedules the instruction that was in flight before, pc tells whether it redirected the fetch.
+Superinstructions of the decode cache are split back into the instructions they were made of
+*/
+extern void cpu_pipeline_fetch(CpuPipeline_t* pipeline, uint16_t pc);
+
+// the instruction in flight completed and an interrupt is taken instead of the one at pc
+extern void cpu_pipeline_interrupt(CpuPipeline_t* pipeline, uint16_t pc);
+
+// moves the whole pipeline ahead by cycles, for instructions that are skipped instead of executed
+extern void cpu_pipeline_advance(CpuPipeline_t* pipeline, uint64_t cycles, uint64_t instructions);
+
+#endif
@@ -8,6 +8,7 @@ A unified header for all sorts of interrupt types with their respective identifi
 typedef enum {
     INT_RESET = 0, 
     INT_CLOCK = 1,          // this type is called by Ticker_t
+    INT_DMA = 2,            // DMA_t finished a transfer that asked for it
 
 } InterruptType_t;
 
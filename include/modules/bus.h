@@ -2,16 +2,48 @@
 #define _BUS_H_
 
 #include <stdint.h>
+#include <stdatomic.h>
 
 #include "modules/device.h"
 
 
+#define BUS_PAGE_COUNT 256      // pages of the address decode, address >> 8
+#define BUS_PAGE_SIZE 256
+
+/*
+Address decode, precomputed from the listening regions of the devices on the bus. A page that one device (or none)
+listens to as a whole maps straight to it, a page that listeners share (like the MMIO page) gets a sub-table with
+the device of every address. Rebuilt whenever a device is added or a device on the bus gets another listening region
+*/
+typedef struct BusPage_t {
+    Device_t* device;           // listener of the whole page, if sub is NULL
+    Device_t** sub;             // BUS_PAGE_SIZE entries for a shared page, NULL if the page has one listener
+} BusPage_t;
+
+/*
+Devices post to the bus (bus_post) when they have something for it: a request, a reply or an interrupt.
+The bus only serves posted devices, a device that has to wait for another one (a busy target) stays posted.
+The pending devices are a bit set by slot, posting is atomic, so cores on host threads can post their requests
+*/
+typedef enum BusTimingModel_t {
+    BTM_ROUND_ROBIN,    // one slot per bus clock in turn, a request waits until the bus comes around to it (default)
+    BTM_EVENT,          // every bus clock serves everything pending, a ram access is answered within one system clock
+} BusTimingModel_t;
+
 typedef struct BUS_t {
     uint64_t clock;
     
     int device_count;           // the number of devices connected
+    int rotation_count;         // the first ones, which the round robin goes through
     int attended_device_index;  // the currently attented device id
     Device_t* device[16];       // the devices connected to the bus
+    Device_t* owner;            // set while one cpu has the bus to itself (system_run_parallel), no other cpu is attended
+
+    BusTimingModel_t timing_model;
+    _Atomic uint32_t pending;   // bit per slot of the devices that posted
+
+    BusPage_t read_page[BUS_PAGE_COUNT];
+    BusPage_t write_page[BUS_PAGE_COUNT];
 } BUS_t;
 
 extern BUS_t* bus_create(void);
@@ -20,8 +52,44 @@ extern void bus_delete(BUS_t** bus);
 
 extern void bus_add_device(BUS_t* bus, Device_t* device);
 
+/*
+Adds a device the round robin does not go through, after every device that it does, 
+so the bus phases of the others stay what they were without it. 
+It is attended by bus_attend_outside_rotation instead
+*/
+extern void bus_add_device_outside_rotation(BUS_t* bus, Device_t* device);
+
+// rebuilds the address decode from the listening regions, logs every region that overlaps one of another device
+extern void bus_map_addresses(BUS_t* bus);
+
+// the device that answers reads (writes) at address, NULL for open bus
+extern Device_t* bus_find_readable_device_by_mmio_address(BUS_t* bus, uint16_t address);
+
+extern Device_t* bus_find_writable_device_by_mmio_address(BUS_t* bus, uint16_t address);
+
+// device has a request, a reply or an interrupt for the bus
+extern void bus_post(BUS_t* bus, Device_t* device);
+
+/*
+The callbacks devices register in their DeviceOps_t, the bus itself only dispatches to them.
+bus_forward_request hands the request of a requesting device (cpu) to the device listening at its address,
+bus_return_reply sends the data (fetches) or the acknowledgement (stores) of a processed request back to the device that made it,
+bus_deliver_interrupt passes an interrupt on to the core it is routed to, the first cpu if none is set
+*/
+extern int bus_forward_request(BUS_t* bus, Device_t* device);
+
+extern void bus_return_reply(BUS_t* bus, Device_t* device);
+
+extern int bus_deliver_interrupt(BUS_t* bus, Device_t* device);
+
+// hands the tagged requests of device to their targets, returns 0 if one has to wait for a busy target
+extern int bus_issue_transactions(BUS_t* bus, Device_t* device);
+
 extern void bus_clock(BUS_t* bus);
 
+// serves the posted devices outside the rotation, without a bus clock and without moving the round robin on
+extern void bus_attend_outside_rotation(BUS_t* bus);
+
 
 #endif
 
@@ -33,6 +33,9 @@ extern void cache_delete(Cache_t** cache);
 
 extern int cache_read(Cache_t* cache, uint16_t address, uint8_t* data);
 
+// 1 if address is cached, counts neither hit nor miss
+extern int cache_contains(Cache_t* cache, uint16_t address);
+
 // cache_write returns 1 if a dirty write has happened, else 0
 extern int cache_write(Cache_t* cache, uint16_t address, uint8_t* data, size_t data_size);
 
@@ -0,0 +1,58 @@
+#ifndef _COST_MODEL_H_
+#define _COST_MODEL_H_
+
+#include <stdio.h>
+#include <stdint.h>
+
+#include "modules/system.h"
+
+/*
+Static cycle cost per (mnemonic, admr, admx), for compilers and the optimizer that need to know what an instruction
+costs without running the program. The costs are not written down by hand, they are measured on a private system
+(multi-cycle timing, no ticker) with the real cpu_clock and bus timing, so they follow every change to the
+state machine: an entry is measured the first time it is looked up, once for every bus phase the instruction
+can start in, with all register and address operands pointing at ram. An instruction costs the cycles it adds in front of a hlt,
+back to back instructions overlap in the cycle one ends and the next starts fetching.
+Cold is the first execution after the data cache was invalidated, warm the same instruction right after it,
+with its code and data bytes cached. Without a data cache both are the same.
+A taken jump costs what the jump itself costs, the redirect of the next fetch is part of the next instruction
+*/
+
+#define COST_MODEL_MAX_CYCLES 1024      // measurement gives up after that many cycles (sleep, exceptions)
+
+typedef struct InstructionCost_t {
+    uint8_t measured;
+    uint8_t valid;          // 0 if the cpu could not complete the instruction (exception)
+    uint16_t min, max;      // cold cycles over the bus phases
+    float cold;             // average over the bus phases
+    float warm;
+} InstructionCost_t;
+
+typedef struct CostModel_t {
+    System_t* system;       // the instructions are measured on
+    int bus_phases;         // starting points of the round-robin, 1 for the event bus
+    uint16_t cache_capacity;
+    float halt_cold, halt_warm; // the hlt every measurement ends on
+    InstructionCost_t* cost;    // INSTRUCTION_COUNT x no cache bit x admr x admx
+} CostModel_t;
+
+
+// cache_capacity 0 measures without data cache
+extern CostModel_t* cost_model_create(uint16_t cache_capacity, BusTimingModel_t bus_timing);
+
+extern void cost_model_delete(CostModel_t** model);
+
+// no_cache is the % prefix of the instruction. Returns NULL for an instruction that does not exist
+extern const InstructionCost_t* cost_model_lookup(CostModel_t* model, int instruction, int admr, int admx, int no_cache);
+
+// decodes the instruction at binary[address] and looks it up, length gets its size in bytes. NULL if it is no instruction
+extern const InstructionCost_t* cost_model_lookup_binary(CostModel_t* model, const uint8_t* binary, long binary_size, uint16_t address, int* length);
+
+/*
+Writes binary as listing to file, every instruction with its estimated cycles and every label with the sum of
+the instructions up to the next label. label_name may be NULL, the labels are then named after their address.
+Bytes that do not decode to an instruction are listed as data
+*/
+extern void cost_model_annotate(CostModel_t* model, const uint8_t* binary, long binary_size, const uint16_t* label_address, char** label_name, int label_count, FILE* file);
+
+#endif
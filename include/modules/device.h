@@ -15,6 +15,7 @@ typedef enum {
     DT_STORAGE,         // Storage, like hard drives
     DT_DISPLAY,         // Visual display
     DT_KEYBOARD,        // User input device
+    DT_DMA,             // Direct memory access controller, moves blocks without the cpu
 } DEVICE_TYPE_t;
 
 typedef enum {
@@ -44,29 +45,107 @@ typedef struct ListeningRegion_t {
     uint16_t address_listener_high;         // the highest memory address this device is listening to
 } ListeningRegion_t;
 
+/*
+Split transactions: besides the one request in the device itself (tag 0), a device can have up to
+transaction_capacity tagged requests outstanding on the bus. The bus hands them to their targets like the
+untagged one, the target remembers the tag and its reply lands in the transaction instead of the device.
+Nothing else changes for devices that never issue one
+*/
+#define DEVICE_MAX_TRANSACTIONS 8       // tagged requests a device can have outstanding at most
+
+typedef struct DeviceTransaction_t {
+    DEVICE_STATE_t state;                   // DS_FETCH or DS_STORE while the tag is in use, DS_IDLE if it is free
+    uint8_t issued;                         // the bus handed it to its target
+    uint8_t processed;                      // the target replied
+    uint8_t cancelled;                      // released before the reply arrived, the tag is free again once it does
+    uint8_t width;
+    uint64_t address;
+    uint64_t data;
+} DeviceTransaction_t;
+
+struct BUS_t;
+struct Device_t;
+
+/*
+What the system and the bus do with a device, registered by the module that owns it.
+clock runs the owner for one of its cycles, request forwards what the device wants from the bus to the
+device that listens there and returns 0 if that one is busy, reply sends the answer to a request the device
+processed back to the one that made it. Callbacks a device does not need are NULL.
+A device is clocked every divider-th system cycle, and not at all while it has nothing to do
+(idle, or a processed request waiting for the bus) unless clock_idle is set
+*/
+typedef struct DeviceOps_t {
+    void (*clock)(void* owner);
+    int (*request)(struct BUS_t* bus, struct Device_t* device);
+    void (*reply)(struct BUS_t* bus, struct Device_t* device);
+    uint8_t clock_idle;                     // the device does work of its own while idle (cpus, the ticker)
+} DeviceOps_t;
+
 typedef struct Device_t {
     DeviceID_t device_id;                   // self identifier
     DeviceID_t device_target_id;            // identifier of the target
+    int slot;                               // index on the bus, assigned by bus_add_device, -1 while not attached
+    int target_slot;                        // slot of the target, what replies are routed by, -1 if none
     DEVICE_TYPE_t device_type;              // What device type the holder is, i.e. CPU
     DEVICE_STATE_t device_state;            // The current state of the device (idle, busy, read, write, fetch, dispatch)
     int processed;                          // Flag to indicated that the current request has been processed
     uint64_t address;                       // the request body, like address
     uint64_t data;                          // the response to the request
+    uint8_t width;                          // bytes of data a DS_STORE writes (1, 2, 4 or 8), devices without memory only take the low byte
+    uint8_t target_tag;                     // tag of the request being served, its reply goes to this transaction of the target (0: the target itself)
+    uint64_t asserted;                      // clock of the interrupted cpu when the device raised DS_INTERRUPT, delivered along with the interrupt
+    uint32_t coalesced;                     // further interrupts the device folded into the one it is raising, delivered along with it
+
+    int transaction_capacity;               // tagged requests that can be outstanding next to the untagged one, 0 for none
+    DeviceTransaction_t* transaction;       // tag t is transaction[t - 1]
 
     int listening_region_count;
     ListeningRegion_t* listening_region;
+    struct BUS_t* bus;                      // the bus the device is attached to, its address decode follows new listening regions
+
+    const DeviceOps_t* ops;                 // NULL for a device nobody clocks or serves
+    void* owner;                            // the module the device belongs to, what ops->clock is called with
+    uint32_t divider;                       // clocked every divider-th system cycle, 1 for every cycle
 } Device_t;
 
 extern Device_t device_create(DEVICE_TYPE_t type);
 
 extern ListeningRegion_t listening_region_create(uint16_t address_listener_low, uint16_t address_listener_high, ListeningRegionAccess_t access_type);
 
-// adds a listening region to the device
+// adds a listening region to the device (and to the address decode of its bus)
 extern void device_add_listening_region(Device_t* device, ListeningRegion_t listening_region);
 
+// sets what the system and the bus call for the device and how slow it is clocked (divider 1: every cycle)
+extern void device_register_ops(Device_t* device, const DeviceOps_t* ops, void* owner, uint32_t divider);
+
+extern void device_set_clock_divider(Device_t* device, uint32_t divider);
+
+// 1 if the system has to clock the device in this system cycle
+static inline int device_clock_due(const Device_t* device, uint64_t system_clock) {
+    if (device->divider > 1 && system_clock % device->divider) {return 0;}
+    return device->ops->clock_idle || (device->device_state != DS_IDLE && !device->processed);
+}
+
 // sets the device back to idle and set processed to 0
 extern void device_reset(Device_t* device);
 
+// tells the bus of the device that it has a request, a reply or an interrupt for it
+extern void device_post(Device_t* device);
+
+// sets how many tagged requests the device can have outstanding, the ones in flight are dropped
+extern void device_set_transaction_capacity(Device_t* device, int capacity);
+
+// starts a tagged request (DS_FETCH or DS_STORE) and posts it, returns its tag or 0 if every tag is in use
+extern int device_issue(Device_t* device, DEVICE_STATE_t state, uint64_t address, uint64_t data, uint8_t width);
+
+// frees the tag, a transaction that is still in flight is freed when its reply arrives
+extern void device_release(Device_t* device, int tag);
+
+// completes the request tag of device with data, or only acknowledges it (stores), tag 0 is the untagged request
+extern void device_reply(Device_t* device, uint8_t tag, uint64_t data);
+
+extern void device_acknowledge(Device_t* device, uint8_t tag);
+
 // returns 1 if the current request has been processed, else 0
 extern int device_check_response(Device_t* device);
 
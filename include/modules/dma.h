@@ -0,0 +1,72 @@
+#ifndef _DMA_H_
+#define _DMA_H_
+
+#include <stdint.h>
+
+#include "modules/device.h"
+#include "modules/memory_bank.h"
+
+/*
+The DMA controller moves blocks of memory over the bus while the cpu goes on with its own work. 
+It is set up through byte registers in the MMIO page, 16-bit registers take the low byte first, 
+so a 16-bit mov to the low address sets both: 
+source, destination, length, value (the fill byte, or the bank index for DMA_BANK_TO_RAM) and mode. 
+Writing the mode starts the transfer, reading it returns the mode while the transfer runs and 0 once it is done, 
+source, destination and length read back how far it got. 
+The controller is a bus master of its own: it reads up to 8 bytes with one tagged fetch and writes them with one
+wide store, a fetch of the next block overlaps the store of the last one. Blocks never cross a 256 byte page, 
+MMIO addresses and fixed addresses (I/O registers) go byte by byte. 
+DMA_BANK_TO_RAM reads the bank directly through its own port to the memory bank, source is the offset into the bank. 
+Like the stores of another core, DMA writes are not seen by the data caches of the cpus (read with NC or INV first)
+*/
+
+#define DMA_TRANSACTIONS 2          // one fetch and one store in flight
+#define DMA_BLOCK_BYTES 8           // what one ram fetch returns
+
+typedef enum DmaMode_t {
+    DMA_COPY = 1,                   // source to destination in the address space
+    DMA_FILL = 2,                   // value to destination
+    DMA_BANK_TO_RAM = 3,            // bank value, offset source, to destination
+    DMA_OPERATION = 0x0f,           // mask of the above
+    DMA_FIXED_SOURCE = 0x10,        // source stays on one address (an I/O register)
+    DMA_FIXED_DESTINATION = 0x20,   // destination stays on one address
+    DMA_INTERRUPT = 0x80,           // raise INT_DMA when the transfer is done
+} DmaMode_t;
+
+typedef struct DMA_t {
+    Device_t device;
+    MemoryBank_t* memory_bank;      // DMA_BANK_TO_RAM reads its ram, NULL if there is none
+    uint64_t clock;
+
+    uint16_t source, destination, length;
+    uint8_t value;
+    uint8_t mode;                   // of the running transfer, 0 while idle
+    int interrupt_slot;             // bus slot of the core that started the transfer
+    uint8_t interrupt_pending;      // done, INT_DMA goes out once the register access in progress is answered
+
+    uint8_t fetch_tag, store_tag;   // transactions in flight, 0 for none
+    uint8_t staged;                 // a block waits in staged_data for its store
+    uint8_t staged_width;
+    uint16_t staged_destination;
+    uint64_t staged_data;
+
+    uint64_t transfers;             // completed
+    uint64_t bytes;
+} DMA_t;
+
+extern const uint16_t MMIO_DMA_SOURCE_REGISTER;         // low byte, the high byte follows
+extern const uint16_t MMIO_DMA_DESTINATION_REGISTER;
+extern const uint16_t MMIO_DMA_LENGTH_REGISTER;
+extern const uint16_t MMIO_DMA_VALUE_REGISTER;
+extern const uint16_t MMIO_DMA_MODE_REGISTER;
+
+extern DMA_t* dma_create(MemoryBank_t* memory_bank);
+
+extern void dma_delete(DMA_t** dma);
+
+extern void dma_clock(DMA_t* dma);
+
+// 1 while a transfer runs or its interrupt has not been delivered yet
+extern int dma_busy(DMA_t* dma);
+
+#endif // _DMA_H_
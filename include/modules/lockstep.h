@@ -0,0 +1,67 @@
+#ifndef _LOCKSTEP_H_
+#define _LOCKSTEP_H_
+
+#include <stdint.h>
+
+#include "modules/system.h"
+
+/*
+Runs count copies of the same program in lockstep, for parameter sweeps where only the inputs differ.
+Every lane is a whole System_t (cpu, ram and devices), run like system_run_fast without data cache and ticker,
+so that the timing of an instruction does not depend on the lane. The run options of the caller (cache size, pipeline,
+cores, decode cache, jit, dma) are not applied, so lane clocks count direct ram timing and are not comparable
+to the clock of a normal run of the same program. A program that sleeps waiting for the ticker stops its lane, see lockstep_run.
+
+While running, the registers of all lanes live in struct-of-arrays form. Each step picks the lowest pc
+any lane is at and the lanes that are at it (with the same code bytes there) step together:
+the first of them runs the instruction through the cpu like it always would, and if it is a plain
+register instruction (mov, add, sub, and, or, xor, inc, dec, not on r0-r3/sp with a register or immediate source)
+the other lanes apply it in one pass over the register arrays and take over its clock and instruction count.
+The passes are plain loops over the lanes, gcc vectorizes them with -O3 (make fast) to whatever the host has.
+Everything else (memory operands, cmp, jumps, calls), and every lane that branched off to a different pc, 
+steps one by one through the cpu, which on ordinary programs is most of the lane instructions:
+with 64 identical lanes 30-44% of them go through passes, less once the inputs make the lanes diverge.
+Lanes at a lower pc run first, so lanes that diverged on a branch join up again at the next common pc.
+*/
+
+#define LOCKSTEP_REGISTERS 5    // r0-r3 and sp, in admr order
+
+typedef struct Lockstep_t {
+    int count;
+    System_t** system;
+
+    uint16_t* regs[LOCKSTEP_REGISTERS]; // count entries each
+    uint16_t* pc;
+    uint16_t* sr;
+    uint16_t* immediate;                // immediate source operand, repeated for every lane
+    uint8_t* member;                    // lanes that take part in the current step
+    uint8_t* running;                   // lanes that have neither halted, excepted nor gone to sleep
+
+    uint64_t steps;                     // instructions the leading lane stepped
+    uint64_t vector_steps;              // of those applied to the other lanes in one pass
+    uint64_t vector_lanes;              // lane instructions executed in those passes
+    uint64_t scalar_steps;              // lane instructions stepped one by one (leaders included)
+    double host_seconds;
+} Lockstep_t;
+
+
+// count lanes, all without data cache and ticker, whatever the caller runs with otherwise
+extern Lockstep_t* lockstep_create(int count);
+
+extern void lockstep_delete(Lockstep_t** lockstep);
+
+// writes the same binary into the ram of every lane
+extern void lockstep_load(Lockstep_t* lockstep, const uint8_t* binary, long size);
+
+/*
+Runs until every lane halted, excepted, went to sleep or executed max_instructions.
+A lane that goes to sleep is logged as an error, there is no ticker to wake it, so the program needs a normal run.
+Per lane inputs go into lockstep->system[lane] (registers or ram) before the call.
+Returns the number of guest instructions executed by all lanes together
+*/
+extern uint64_t lockstep_run(Lockstep_t* lockstep, uint64_t max_instructions);
+
+// aggregate guest instructions per host second and how much of it ran in vector passes
+extern void lockstep_print(Lockstep_t* lockstep);
+
+#endif
@@ -8,6 +8,9 @@
 #define __RAM_DEBUG
 #undef __RAM_DEBUG
 
+// every write bumps the generation of its 16 byte block, so predecoded code can tell when it went stale
+#define RAM_GENERATION_SHIFT 4
+
 
 #ifdef __RAM_DEBUG
     typedef struct {
@@ -28,8 +31,10 @@ typedef struct RAM_t {
 
     uint64_t reads;
     uint64_t writes;
+    uint32_t* generation;       // write counter per (1 << RAM_GENERATION_SHIFT) byte block
     
     uint32_t capacity;
+    uint8_t shared;             // cores on other host threads access it directly (system_run_parallel), see ram_peek
 } RAM_t;
 
 
@@ -43,6 +48,18 @@ extern void ram_write(RAM_t* ram, uint16_t address, uint8_t data);
 
 extern void ram_clock(RAM_t* ram);
 
+/*
+The byte at address, without counting a read. 
+While the ram is shared, bytes, the read and write counters and the generations are accessed with relaxed atomics 
+(ram_read and ram_write too), so the cores never tear or lose a counter update, but see each others stores in no particular order
+*/
+static inline uint8_t ram_peek(RAM_t* ram, uint16_t address) {
+    if (ram->shared) {
+        return __atomic_load_n(&ram->data[address % ram->capacity], __ATOMIC_RELAXED);
+    }
+    return ram->data[address % ram->capacity];
+}
+
 
 #endif
 
@@ -1,6 +1,8 @@
 #ifndef _SYSTEM_H_
 #define _SYSTEM_H_
 
+#include <stdatomic.h>
+
 #include "cpu/cpu.h"
 #include "modules/bus.h"
 #include "modules/memory_bank.h"
@@ -8,19 +10,10 @@
 #include "modules/ticker.h"
 #include "modules/terminal.h"
 #include "modules/filesystem.h"
+#include "modules/dma.h"
 
 extern int VERBOSE;
 
-typedef enum {
-    SCD_CPU, 
-    SCD_RAM, 
-    SCD_BUS, 
-    SCD_TICKER, 
-    SCD_TERMINAL, 
-    SCD_FILESYSTEM, 
-    SCD_MEMORY_BANK, 
-} SystemClockDevice_t;
-
 typedef enum {
     HC_CHANGE,          // triggers when the target value changes
     HC_MATCH,           // triggers when the target value matches match value
@@ -36,20 +29,84 @@ typedef struct Hook_t {
     void (*action)(void*);
 } Hook_t;
 
+/*
+Longest instruction in bytes, extension prefix included. 
+system_run_hybrid runs an instruction cycle by cycle if a pc hook could match anywhere inside it
+*/
+#define SYSTEM_HYBRID_LOOKAHEAD 8
+
+#define SYSTEM_DEFAULT_FREQUENCY 1000000    // emulated cycles per host second
+
+/*
+Cores that can share one bus, next to ram, terminal, memory bank, filesystem and ticker it has room for 16 devices. 
+All cores start at pc 0 on the same ram and tell themselves apart with HWCORE, 
+core c starts with its stack SYSTEM_CORE_STACK_SIZE * c bytes below the one of core 0. 
+Their data caches are not kept coherent, memory that is shared between cores is accessed with the NC bit set
+*/
+#define SYSTEM_MAX_CORES 8
+#define SYSTEM_CORE_STACK_SIZE 0x400
+
+/*
+system_clock goes through clock_order once per system cycle, an entry is the bus slot of a device, clocked through
+its DeviceOps_t if it is due (see device_clock_due), SYSTEM_CLOCK_BUS for a bus clock, 
+or SYSTEM_CLOCK_BUS_OUTSIDE for bus_attend_outside_rotation
+*/
+#define SYSTEM_CLOCK_BUS -1
+#define SYSTEM_CLOCK_BUS_OUTSIDE -2
+#define SYSTEM_CLOCK_ORDER_CAPACITY (SYSTEM_MAX_CORES + 16)
+
+// instructions the core the ticker interrupts runs in system_run_parallel between two looks at the ticker
+#define SYSTEM_PARALLEL_TICKER_INTERVAL 64
+
+typedef struct SystemCycleWindow_t {
+    uint16_t start, end;    // instructions starting in [start, end) run cycle by cycle in system_run_hybrid
+} SystemCycleWindow_t;
+
+/*
+Snapshot of the cpu taken whenever a backward jump lands on a loop head. 
+If the next backward jump lands on the same head with the same registers and status and nothing was written in between, 
+the loop only read memory and MMIO that did not change: every further iteration is identical until a device raises an event.
+*/
+typedef struct SystemIdleLoop_t {
+    uint16_t pc;                            // loop head
+    uint16_t r0, r1, r2, r3, sp, sr;
+    uint8_t flags_operation, flags_pending; // lazy CMP/TST state, compared instead of resolved
+    uint16_t flags_a, flags_b;
+    uint64_t clock, instruction, stores;    // at the start of the iteration
+    uint64_t pipeline_clock, pipeline_instructions;
+    uint8_t valid;
+} SystemIdleLoop_t;
+
 typedef struct System_t {
     BUS_t* bus;
-    CPU_t* cpu;
+    CPU_t* cpu;                         // core 0, the one hooks, breakpoints and the fast paths work on
+    CPU_t* core[SYSTEM_MAX_CORES];
+    int core_count;
+    int interrupt_core;                 // core the ticker interrupts
+    atomic_int bus_owner;               // spinlock, core that has the bus in system_run_parallel, -1 if it is free
     RAM_t* ram;
     Ticker_t* ticker;
     Terminal_t* terminal;
     MemoryBank_t* memory_bank;
     FileSystem_t* filesystem;
+    DMA_t* dma;                         // NULL unless system_attach_dma
+    uint64_t clock;                     // system cycles, what the device clock dividers count
     int clock_order_size;
-    SystemClockDevice_t* clock_order;
+    int* clock_order;
+    uint32_t frequency;                 // cycles per host second, the clocks advance at this rate while fast forwarding
     Hook_t* hook;
     int hook_count;
     uint8_t* memory_intermediate;       // this array stores the value watch values
     int memory_intermediate_size;
+    uint16_t* breakpoint;               // pcs system_run_hybrid stops at
+    int breakpoint_count;
+    SystemCycleWindow_t* cycle_window;
+    int cycle_window_count;
+    uint64_t hybrid_fast_instructions;  // instructions system_run_hybrid ran with direct ram
+    uint64_t hybrid_accurate_cycles;    // and cycles it ran through system_clock
+    SystemIdleLoop_t idle_loop;
+    uint64_t idle_loop_skips;           // times a polling loop was fast forwarded
+    uint64_t idle_loop_cycles;          // and cycles skipped by doing so
 } System_t;
 
 
@@ -68,12 +125,63 @@ extern void hook_action_halt(void* system);
 
 
 
-extern System_t* system_create(int cache_active, uint16_t cache_capacity, int ticker_active, float ticker_frequency);
+// core_count cpus on the bus (1 to SYSTEM_MAX_CORES), each with its own data cache and timing model
+extern System_t* system_create(int cache_active, uint16_t cache_capacity, int ticker_active, float ticker_frequency, CpuTimingModel_t timing_model, int core_count);
 
 extern void system_delete(System_t** system);
 
 extern void system_clock(System_t* system);
 
+// switches the bus between round-robin and event timing (BusTimingModel_t), the clock order follows
+extern void system_set_bus_timing(System_t* system, BusTimingModel_t timing_model);
+
+/*
+Puts a DMA controller on the bus (see DMA_t), outside the round robin (bus_add_device_outside_rotation): 
+it is attended right after its own clock without a bus clock of its own, so a program that does not use it 
+runs the same cycles as without it. 
+While it transfers, system_run_fast and system_run_hybrid run cycle by cycle, so the cpu shares the bus with it
+*/
+extern void system_attach_dma(System_t* system);
+
+// routes the ticker interrupts to core instead of core 0
+extern void system_set_interrupt_target(System_t* system, int core);
+
+// number of cores that have neither halted nor excepted
+extern int system_cores_running(System_t* system);
+
+/*
+Runs whole instructions at a time until the cpu halts, excepts, executed max_instructions or its clock advanced by max_cycles. 
+It also stops (with an error) when the cpu sleeps and nothing can wake it up: interrupts masked, or no ticker and no DMA routed to it. 
+Only core 0 runs, the other cores of a multi-core system stay where they are (see system_run_parallel). 
+RAM is accessed directly, the bus is only clocked for MMIO, memory bank accesses and while the cpu sleeps. 
+cpu->clock is kept as an estimate of what system_clock would have counted. 
+Busy-wait loops (see SystemIdleLoop_t) are skipped up to the next ticker interrupt, or to max_instructions without a ticker, 
+in whole iterations: clock and instruction count advance as if they had run
+*/
+extern void system_run_fast(System_t* system, uint64_t max_instructions, uint64_t max_cycles);
+
+/*
+Runs every core on a host thread of its own, each like system_run_fast with direct ram, until all of them halted, 
+excepted, went to sleep without the ticker being routed to them or with interrupts masked (an error), 
+executed max_instructions or advanced their clock by max_cycles. 
+Whatever needs the bus (MMIO, memory banks, sleeping) is done under a spinlock: the core that won the bus_owner word 
+with a compare and swap clocks itself, the bus and the devices for one cycle and gives the bus back, 
+the others spin on it (yielding the host thread) and the bus does not attend them meanwhile. 
+The core the ticker interrupts looks at it every SYSTEM_PARALLEL_TICKER_INTERVAL instructions, if the bus is free. 
+Ram is shared with relaxed atomics (see ram_peek), no store is torn or lost, but there is no ordering between the cores, 
+like the guest sees it on real hardware without atomic instructions. 
+The JIT, the idle loop skipping and hooks are not used
+*/
+extern void system_run_parallel(System_t* system, uint64_t max_instructions, uint64_t max_cycles);
+
+/*
+Skips the cycles in which nothing can happen: the cpus sleep (HWSLEEP) or are done and no device has a request pending. 
+The next event is the ticker interrupt, which is due in host time, so the host sleeps until then and 
+the cpu, bus and device clocks jump ahead by the cycles that pass at system->frequency, at most max_cycles. 
+Returns the number of skipped cycles, 0 if an event is due right now or nothing is scheduled at all (no ticker)
+*/
+extern uint64_t system_fast_forward(System_t* system, uint64_t max_cycles);
+
 // This function adds a hardware watch that allows for thorough debugging
 // These hooks include a watch-target, a trigger condition and an action-on-trigger
 extern void system_hook(System_t* system, Hook_t hook);
@@ -82,4 +190,23 @@ extern void system_hook_print(System_t* system);
 
 extern void system_clock_debug(System_t *system);
 
+extern void system_add_breakpoint(System_t* system, uint16_t pc);
+
+extern void system_add_cycle_window(System_t* system, uint16_t start, uint16_t end);
+
+/*
+Runs like system_run_fast, but drops to system_clock (system_clock_debug if there are hooks) whenever cycles matter: 
+- for instructions starting inside a cycle window
+- for instructions a pc HC_MATCH hook could fire in, so it fires on the exact cycle
+- for the rest of an instruction that touches a device other than ram (MMIO, memory banks) 
+- for the whole run if a hook has to see every cycle (HC_ALWAYS, HC_READ_FROM, HC_CHANGE on the pc)
+Other hooks are checked after every instruction that ran with direct ram. 
+The JIT is only used when there are no hooks, breakpoints or cycle windows.
+Returns 1 when the cpu reached a breakpoint, before the instruction there is executed. 
+Calling it again resumes from there, so the caller can step through the instruction with system_clock first or not at all.
+Returns 0 when the cpu halted, excepted, executed max_instructions, advanced its clock by max_cycles 
+or sleeps with nothing to wake it up (like system_run_fast)
+*/
+extern int system_run_hybrid(System_t* system, uint64_t max_instructions, uint64_t max_cycles);
+
 #endif
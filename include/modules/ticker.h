@@ -27,6 +27,9 @@ extern void ticker_delete(Ticker_t** ticker);
 
 extern void ticker_clock(Ticker_t* ticker);
 
+// host seconds until the next interrupt is due, 0 or less if it is due already
+extern double ticker_time_to_interrupt(Ticker_t* ticker);
+
 
 #endif
 
@@ -21,6 +21,8 @@
 #include "compiler/asm/disassembler.h"
 
 #include "modules/system.h"
+#include "modules/lockstep.h"
+#include "modules/cost_model.h"
 #include "CLI.h"
 
 #include <stdarg.h>
@@ -189,6 +191,30 @@ int main(int argc, char* argv[]) {
             ((DO_ADD_JUMP_LABEL) | (0&DO_ADD_DEST_LABEL) | (0&DO_ADD_SOURCE_LABEL) | (0&DO_ADD_LABEL_TO_CODE_SEGMENT) | (0&DO_ADD_SPECULATIVE_CODE) | (0&DO_USE_FLOAT_LITERALS) | (0&DO_ALIGN_ADDRESS_JUMP) | (DO_ADD_RAW_BYTES)));
     }
 
+    if (co.estimate) {
+        CostModel_t* model = cost_model_create((uint16_t) co.cache_size, co.bus_events ? BTM_EVENT : BTM_ROUND_ROBIN);
+        if (!model) {
+            log_msg(LP_ERROR, "Main: Cost model could not be created [%s:%d]", __FILE__, __LINE__);
+            return 0;
+        }
+        // labels are only known when the binary came out of the assembler
+        int label_count = co.cft > CFT_BIN ? jump_label_index : 0;
+        uint16_t* label_address = calloc(label_count + 1, sizeof(uint16_t));
+        char** label_name = calloc(label_count + 1, sizeof(char*));
+        if (!label_address || !label_name) {
+            log_msg(LP_ERROR, "Main: Memory allocation failure [%s:%d]", __FILE__, __LINE__);
+            return 0;
+        }
+        for (int l = 0; l < label_count; l++) {
+            label_address[l] = (uint16_t) jump_label[l].value;
+            label_name[l] = jump_label[l].name;
+        }
+        cost_model_annotate(model, bin, binary_size, label_address, label_name, label_count, stdout);
+        free(label_address);
+        free(label_name);
+        cost_model_delete(&model);
+    }
+
     if (co.toc) {
         long filesize;
         char* result = transpile_from_file(co.input_filename, &filesize);
@@ -202,20 +228,84 @@ int main(int argc, char* argv[]) {
     free(segment);
 
     
-    if (co.run) {
+    if (co.run && co.lockstep) {
+        if (co.pipeline || co.cores > 1 || co.decode_cache_size || co.jit || co.dma || co.bus_events) {
+            log_msg(LP_WARNING, "Main: Lockstep lanes run without cache and ticker, the other run options are ignored [%s:%d]", __FILE__, __LINE__);
+        }
+        Lockstep_t* lockstep = lockstep_create(co.lockstep);
+        if (!lockstep) {
+            log_msg(LP_ERROR, "Main: Lockstep lanes could not be created [%s:%d]", __FILE__, __LINE__);
+            return 0;
+        }
+        lockstep_load(lockstep, bin, binary_size);
+        for (int lane = 0; lane < lockstep->count; lane++) {
+            lockstep->system[lane]->cpu->regs.r0 = (uint16_t) lane;
+        }
+        lockstep_run(lockstep, 10000000);
+        cpu_print_state(lockstep->system[0]->cpu);
+        lockstep_print(lockstep);
+        lockstep_delete(&lockstep);
+    } else if (co.run) {
     
         // Hardware setup
         System_t* system = system_create(
             co.cache_size != 0, 
             co.cache_size, 
             1, 
-            100.0
+            100.0, 
+            co.pipeline ? CTM_PIPELINED : CTM_MULTI_CYCLE, 
+            co.cores
         );
 
         if (!system) {
             log_msg(LP_ERROR, "Main: System could not be created [%s:%d]", __FILE__, __LINE__);
             return 0;
         }
+
+        if (co.bus_events) {
+            system_set_bus_timing(system, BTM_EVENT);
+        }
+        if (co.dma) {
+            system_attach_dma(system);
+        }
+        device_set_clock_divider(&system->terminal->device, (uint32_t) co.peripheral_divider);
+        device_set_clock_divider(&system->filesystem->device, (uint32_t) co.peripheral_divider);
+
+        for (int c = 0; c < system->core_count; c++) {
+            system->core[c]->prefetch.active = co.burst_fetch;
+            system->core[c]->word_stores = co.word_stores;
+            system->core[c]->trace = co.trace;
+            device_set_transaction_capacity(&system->core[c]->device, co.outstanding);
+            cpu_select_clock_variant(system->core[c]);
+        }
+
+        if (co.branch_predictor >= 0) {
+            CpuBranchPredictor_t* branch_predictor = cpu_branch_predictor_create((CpuBranchPredictorKind_t) co.branch_predictor);
+            if (!branch_predictor) {
+                log_msg(LP_ERROR, "Main: Branch predictor could not be created [%s:%d]", __FILE__, __LINE__);
+                return 0;
+            }
+            cpu_mount_branch_predictor(system->cpu, branch_predictor);
+        }
+
+        if (co.decode_cache_size) {
+            CpuDecodeCache_t* decode_cache = cpu_decode_cache_create(co.decode_cache_size, system->ram);
+            if (!decode_cache) {
+                log_msg(LP_ERROR, "Main: Decode cache could not be created [%s:%d]", __FILE__, __LINE__);
+                return 0;
+            }
+            decode_cache->fusion = !co.no_fusion;
+            cpu_mount_decode_cache(system->cpu, decode_cache);
+        }
+
+        if (co.jit) {
+            CpuJit_t* jit = cpu_jit_create(system->ram);
+            if (!jit) {
+                log_msg(LP_ERROR, "Main: JIT could not be created [%s:%d]", __FILE__, __LINE__);
+                return 0;
+            }
+            cpu_mount_jit(system->cpu, jit);
+        }
     
         #ifdef HW_WATCH
             uint16_t match = 0x10ee;
@@ -231,37 +321,94 @@ int main(int argc, char* argv[]) {
             );
         #endif
 
+        for (int i = 0; i < co.breakpoint_count; i++) {
+            system_add_breakpoint(system, co.breakpoint[i]);
+        }
+        if (co.cycle_window_end > co.cycle_window_start) {
+            system_add_cycle_window(system, co.cycle_window_start, co.cycle_window_end);
+        }
+
         for (long i = 0; i < binary_size; i++) {
             ram_write(system->ram, i, bin[i]);
         }
 
-        uint32_t frequency = 1000000;
+        uint32_t frequency = system->frequency;
 
         struct timeval tv;
         gettimeofday(&tv,NULL);
         uint64_t t = tv.tv_sec * 1000000 + tv.tv_usec;
         double dt = 0;
 
+        struct timeval tv_start = tv;
+
         // Execution step
-        for (long long int i = 0; i < 10000000 && system->cpu->state != CS_HALT && system->cpu->state != CS_EXCEPTION; i++) {
-            #ifdef HW_WATCH
-                system_clock_debug(system);
-            #else
-                system_clock(system);
-            #endif
-            while(1) {
-                gettimeofday(&tv,NULL);
-                dt += (double) (tv.tv_sec * 1000000 + tv.tv_usec - t);
-                t = tv.tv_sec * 1000000 + tv.tv_usec;
-                if (dt < (1000000.0 / frequency)) {
+        if (co.hybrid) {
+            uint64_t instruction_end = system->cpu->instruction + 10000000;
+            uint64_t clock_end = system->cpu->clock + 10000000;
+            while (system->cpu->instruction < instruction_end && system->cpu->clock < clock_end && 
+                system_run_hybrid(system, instruction_end - system->cpu->instruction, clock_end - system->cpu->clock)) {
+                log_msg(LP_NOTICE, "Main: Breakpoint at 0x%.4X [%s:%d]", system->cpu->regs.pc, __FILE__, __LINE__);
+                cpu_print_state_compact(system->cpu);
+            }
+            printf("Hybrid: %lu instructions fast, %lu cycles cycle accurate\n", (unsigned long) system->hybrid_fast_instructions, (unsigned long) system->hybrid_accurate_cycles);
+        } else if (co.fast && system->core_count > 1) {
+            system_run_parallel(system, 10000000, 10000000);
+        } else if (co.fast) {
+            system_run_fast(system, 10000000, 10000000);
+        } else {
+            for (long long int i = 0; i < 10000000 && system_cores_running(system); i++) {
+                if (system->cpu->state == CS_SLEEP) {
+                    uint64_t skipped = system_fast_forward(system, 10000000 - i);
+                    if (skipped) {
+                        // the host already waited for these cycles
+                        i += skipped - 1;
+                        gettimeofday(&tv, NULL);
+                        t = tv.tv_sec * 1000000 + tv.tv_usec;
+                        dt = 0;
+                        continue;
+                    }
+                }
+                #ifdef HW_WATCH
+                    system_clock_debug(system);
+                #else
+                    system_clock(system);
+                #endif
+                if (co.bench) {
                     continue;
                 }
-                dt -= (1000000.0 / frequency);
-                break;
+                while(1) {
+                    gettimeofday(&tv,NULL);
+                    dt += (double) (tv.tv_sec * 1000000 + tv.tv_usec - t);
+                    t = tv.tv_sec * 1000000 + tv.tv_usec;
+                    if (dt < (1000000.0 / frequency)) {
+                        continue;
+                    }
+                    dt -= (1000000.0 / frequency);
+                    break;
+                }
             }
         }
 
         cpu_print_state(system->cpu);
+        if (co.cycles_json) {
+            cpu_export_cycles_json(system->cpu, co.cycles_json);
+        }
+        for (int c = 1; c < system->core_count; c++) {
+            printf("Core %d: ", c);
+            cpu_print_state_compact(system->core[c]);
+        }
+        if (system->idle_loop_skips) {
+            printf("Idle loops: skipped %lu times, %lu cycles\n", (unsigned long) system->idle_loop_skips, (unsigned long) system->idle_loop_cycles);
+        }
+        if (system->dma && system->dma->transfers) {
+            printf("DMA: %lu transfers, %lu bytes\n", (unsigned long) system->dma->transfers, (unsigned long) system->dma->bytes);
+        }
+        if (co.bench) {
+            struct timeval tv_end;
+            gettimeofday(&tv_end, NULL);
+            double host_us = (double) (tv_end.tv_sec - tv_start.tv_sec) * 1000000.0 + (double) (tv_end.tv_usec - tv_start.tv_usec);
+            printf("Host: %.3f s, %.1f ns per instruction\n", host_us / 1000000.0, host_us * 1000.0 / (double) system->cpu->instruction);
+        }
         //cpu_print_stack(system->cpu, system->ram, 20);
         //cpu_print_cache(system->cpu);
 
@@ -5,6 +5,9 @@
 #include "utils/String.h"
 #include "utils/Log.h"
 
+#include "cpu/cpu_branch_predictor.h"
+#include "modules/system.h"
+
 #include "CLI.h"
 
 const char* CLI_USAGE = "\
@@ -26,6 +29,7 @@ ASSEMBLER:\n\
 \n\
 DISASSEMBLER:\n\
   -d                      Enable disassembly\n\
+  -estimate               list every instruction with its estimated cycles and every label with its sum (with -cache-size)\n\
 \n\
 OPTIMIZER:\n\
   -O0                     No optimization\n\
@@ -40,6 +44,27 @@ IR:\n\
 \n\
 EMULATOR:\n\
   -run                    execute final binary in emulator\n\
+  -fast                   execute whole instructions at a time, only going through the bus for MMIO (cycle count is estimated)\n\
+  -jit                    translate basic blocks to host code, implies -fast (x86-64 hosts only)\n\
+  -bench                  run without real time throttling and report host ns per guest instruction\n\
+  -cache-size=<n>         Size of the cpu data cache, 0 disables it (default: n=64)\n\
+  -decode-cache-size=<n>  Size of the predecoded instruction cache, 0 disables it (default: n=0)\n\
+  -burst-fetch            keep the 8 bytes of every ram response in a prefetch buffer, saves bus round trips without a cache\n\
+  -word-stores            store 16-bit values to ram and memory banks in one bus transaction instead of two\n\
+  -bus-events             the bus serves every pending request each bus clock, instead of one device per clock in turn\n\
+  -outstanding=<n>        n tagged bus requests per cpu next to the plain one, used to fetch the next instruction ahead (default: n=0)\n\
+  -dma                    put a DMA controller on the bus, its registers are at $F010-$F017 (see include/modules/dma.h)\n\
+  -peripheral-divider=<n> clock the terminal and the filesystem every n-th cycle only (default: n=1)\n\
+  -pipeline               also time the program on a 5 stage pipelined cpu, reported next to the multi-cycle clock\n\
+  -branch-predictor=<p>   static | bimodal | gshare; count taken and mispredicted branches per pc (default: off)\n\
+  -lockstep=<n>           run n copies of the program in lockstep (like -fast without cache and ticker, other run options are ignored), each starts with its lane index in r0\n\
+  -cores=<n>              n cpus share the bus, HWCORE tells them apart, with -fast each runs on its own host thread (default: n=1)\n\
+  -cycles-json=<file>     write the cycles per cpu state (active and stalled on memory) of core 0 to file as JSON\n\
+  -trace                  log pc and registers before every instruction (JIT blocks and fused superinstructions excepted)\n\
+  -no-fusion              do not fuse common instruction sequences in the decode cache into superinstructions\n\
+  -hybrid                 execute like -fast, but drop to cycle accurate execution for hooks, breakpoints and MMIO\n\
+  -break=<pc>             stop at pc and print the cpu state, implies -hybrid (up to 16 times)\n\
+  -cycle-window=<a>:<b>   execute instructions in [a, b) cycle accurately, implies -hybrid\n\
 \n\
 EXAMPLES:\n\
   ./main input.ir -c=ir -run -O0 -o prog.bin -save-temps -no-c -d -pic -no-preamble -pad-zero -noerr-overlap -overwrite-overlap\n\
@@ -65,6 +90,7 @@ const CompileOption_t CO_DEFAULT = {
     .skip_preasm = 0, 
     // Disassembler
     .d = 0, 
+    .estimate = 0, 
     // Optimizer
     .O = 1, 
     // Canonicalizer
@@ -76,8 +102,30 @@ const CompileOption_t CO_DEFAULT = {
     .toc = 0, 
     // Emulator
     .run = 0, 
+    .fast = 0, 
+    .jit = 0, 
+    .bench = 0, 
+    .no_fusion = 0, 
+    .hybrid = 0, 
+    .burst_fetch = 0, 
+    .word_stores = 0, 
+    .bus_events = 0, 
+    .dma = 0, 
+    .pipeline = 0, 
+    .trace = 0, 
+    .branch_predictor = -1, 
+    .lockstep = 0, 
+    .cores = 1, 
+    .outstanding = 0, 
+    .peripheral_divider = 1, 
+    .cycles_json = NULL, 
     // CPU
     .cache_size = 64, 
+    .decode_cache_size = 0, 
+    // Debugging
+    .breakpoint_count = 0, 
+    .cycle_window_start = 0, 
+    .cycle_window_end = 0, 
 };
 
 
@@ -92,6 +140,141 @@ CompileOption_t cli_parse_arguments(int argc, char** argv, int* error) {
             arg_index ++;
             continue;
         }
+        if (strcmp(argv[arg_index], "-fast") == 0) {
+            co.fast = 1;
+            arg_index ++;
+            continue;
+        }
+        if (strcmp(argv[arg_index], "-no-fusion") == 0) {
+            co.no_fusion = 1;
+            arg_index ++;
+            continue;
+        }
+        if (strcmp(argv[arg_index], "-burst-fetch") == 0) {
+            co.burst_fetch = 1;
+            arg_index ++;
+            continue;
+        }
+        if (strcmp(argv[arg_index], "-word-stores") == 0) {
+            co.word_stores = 1;
+            arg_index ++;
+            continue;
+        }
+        if (strcmp(argv[arg_index], "-dma") == 0) {
+            co.dma = 1;
+            arg_index ++;
+            continue;
+        }
+        if (strcmp(argv[arg_index], "-bus-events") == 0) {
+            co.bus_events = 1;
+            arg_index ++;
+            continue;
+        }
+        if (strcmp(argv[arg_index], "-trace") == 0) {
+            co.trace = 1;
+            arg_index ++;
+            continue;
+        }
+        if (strcmp(argv[arg_index], "-pipeline") == 0) {
+            co.pipeline = 1;
+            arg_index ++;
+            continue;
+        }
+        if (strncmp(argv[arg_index], "-branch-predictor=", 18) == 0) {
+            co.branch_predictor = -1;
+            for (int i = 0; i < CBP_COUNT; i++) {
+                if (strcmp(&argv[arg_index][18], cpu_branch_predictor_name[i]) == 0) {
+                    co.branch_predictor = i;
+                }
+            }
+            if (co.branch_predictor < 0) {
+                log_msg(LP_ERROR, "CLI: Unknown branch predictor '%s' [%s:%d]", &argv[arg_index][18], __FILE__, __LINE__);
+            }
+            arg_index ++;
+            continue;
+        }
+        if (strncmp(argv[arg_index], "-lockstep=", 10) == 0) {
+            co.lockstep = (int) strtol(&argv[arg_index][10], NULL, 0);
+            if (co.lockstep <= 0) {
+                log_msg(LP_ERROR, "CLI: Lockstep needs at least one lane [%s:%d]", __FILE__, __LINE__);
+                co.lockstep = 0;
+            }
+            arg_index ++;
+            continue;
+        }
+        if (strncmp(argv[arg_index], "-outstanding=", 13) == 0) {
+            co.outstanding = (int) strtol(&argv[arg_index][13], NULL, 0);
+            if (co.outstanding < 0 || co.outstanding > DEVICE_MAX_TRANSACTIONS) {
+                log_msg(LP_ERROR, "CLI: Outstanding transactions have to be in [0, %d] [%s:%d]", DEVICE_MAX_TRANSACTIONS, __FILE__, __LINE__);
+                co.outstanding = 0;
+            }
+            arg_index ++;
+            continue;
+        }
+        if (strncmp(argv[arg_index], "-peripheral-divider=", 20) == 0) {
+            co.peripheral_divider = (int) strtol(&argv[arg_index][20], NULL, 0);
+            if (co.peripheral_divider < 1) {
+                log_msg(LP_ERROR, "CLI: Peripheral clock divider has to be at least 1 [%s:%d]", __FILE__, __LINE__);
+                co.peripheral_divider = 1;
+            }
+            arg_index ++;
+            continue;
+        }
+        if (strncmp(argv[arg_index], "-cores=", 7) == 0) {
+            co.cores = (int) strtol(&argv[arg_index][7], NULL, 0);
+            if (co.cores <= 0 || co.cores > SYSTEM_MAX_CORES) {
+                log_msg(LP_ERROR, "CLI: Cores have to be in [1, %d] [%s:%d]", SYSTEM_MAX_CORES, __FILE__, __LINE__);
+                co.cores = 1;
+            }
+            arg_index ++;
+            continue;
+        }
+        if (strncmp(argv[arg_index], "-cycles-json=", 13) == 0) {
+            co.cycles_json = &argv[arg_index][13];
+            arg_index ++;
+            continue;
+        }
+        if (strcmp(argv[arg_index], "-bench") == 0) {
+            co.bench = 1;
+            arg_index ++;
+            continue;
+        }
+        if (strcmp(argv[arg_index], "-hybrid") == 0) {
+            co.hybrid = 1;
+            arg_index ++;
+            continue;
+        }
+        if (strncmp(argv[arg_index], "-break=", 7) == 0) {
+            if (co.breakpoint_count >= CLI_MAX_BREAKPOINTS) {
+                log_msg(LP_ERROR, "CLI: Too many breakpoints (max %d) [%s:%d]", CLI_MAX_BREAKPOINTS, __FILE__, __LINE__);
+                arg_index ++;
+                continue;
+            }
+            co.breakpoint[co.breakpoint_count++] = (uint16_t) strtol(&argv[arg_index][7], NULL, 0);
+            co.hybrid = 1;
+            arg_index ++;
+            continue;
+        }
+        if (strncmp(argv[arg_index], "-cycle-window=", 14) == 0) {
+            char* end;
+            long start = strtol(&argv[arg_index][14], &end, 0);
+            if (*end != ':' || start < 0 || start > 0xffff || strtol(end + 1, NULL, 0) <= start || strtol(end + 1, NULL, 0) > 0xffff) {
+                log_msg(LP_ERROR, "CLI: Cycle window has to look like -cycle-window=<start>:<end> with start < end [%s:%d]", __FILE__, __LINE__);
+                arg_index ++;
+                continue;
+            }
+            co.cycle_window_start = (uint16_t) start;
+            co.cycle_window_end = (uint16_t) strtol(end + 1, NULL, 0);
+            co.hybrid = 1;
+            arg_index ++;
+            continue;
+        }
+        if (strcmp(argv[arg_index], "-jit") == 0) {
+            co.fast = 1;
+            co.jit = 1;
+            arg_index ++;
+            continue;
+        }
         if (strcmp(argv[arg_index], "-O0") == 0) {
             co.O = 0;
             arg_index ++;
@@ -124,6 +307,11 @@ CompileOption_t cli_parse_arguments(int argc, char** argv, int* error) {
             arg_index ++;
             continue;
         }
+        if (strcmp(argv[arg_index], "-estimate") == 0) {
+            co.estimate = 1;
+            arg_index ++;
+            continue;
+        }
         if (strcmp(argv[arg_index], "-no-c") == 0) {
             co.no_c = 1;
             arg_index ++;
@@ -192,6 +380,19 @@ CompileOption_t cli_parse_arguments(int argc, char** argv, int* error) {
             continue;
         }
         strcpy(tmp, argv[arg_index]);
+        tmp[19] = '\0';
+        if (strcmp(tmp, "-decode-cache-size=") == 0) {
+            int decode_cache_size = atoi(&argv[arg_index][19]);
+            if (decode_cache_size < 0 || decode_cache_size > 32768 || (decode_cache_size & (decode_cache_size - 1))) {
+                log_msg(LP_ERROR, "CLI: Decode cache size has to be a power of two up to 32768 (actual value: %d) [%s:%d]", decode_cache_size, __FILE__, __LINE__);
+                arg_index ++;
+                continue;
+            }
+            co.decode_cache_size = decode_cache_size;
+            arg_index ++;
+            continue;
+        }
+        strcpy(tmp, argv[arg_index]);
         tmp[3] = '\0';
         if (strcmp(tmp, "-c=") == 0) {
             co.c = 1;
@@ -6,14 +6,19 @@
 #include "globals/memory_layout.h"
 
 #include "utils/ExtendedTypes.h"
+#include "utils/Log.h"
 
 #include "modules/cache.h"
 #include "modules/device.h"
+#include "modules/bus.h"
+#include "modules/ram.h"
 
 #include "cpu/cpu_instructions.h"
 #include "cpu/cpu_addressing_modes.h"
 #include "cpu/cpu.h"
 
+#include "cpu_alu.h"
+
 
 #define _CPU_DEBUG_
 #undef _CPU_DEBUG_
@@ -23,10 +28,23 @@
                 
 
 
-#ifdef _CPU_DEBUG_
-#include "utils/Log.h"
-#elif defined _CPU_DEEP_DEBUG_
-#include "utils/Log.h"
+/*
+CS_EXECUTE dispatches through a table of label addresses (GCC/clang labels as values) instead of the switch.
+The table is built from CPU_INSTRUCTION_LIST, a mnemonic without an EXECUTE_ label fails to compile.
+Build with -DCPU_NO_THREADED_DISPATCH to get the plain switch back.
+*/
+#if defined(__GNUC__) && !defined(CPU_NO_THREADED_DISPATCH)
+#define CPU_THREADED_DISPATCH
+#define CPU_EXECUTE_LABEL(mnemonic) EXECUTE_##mnemonic:
+#define CPU_EXECUTE_TARGET(mnemonic) (__extension__ &&EXECUTE_##mnemonic)
+#define CPU_EXECUTE_TARGET_ENTRY(mnemonic, ...) [mnemonic] = CPU_EXECUTE_TARGET(mnemonic),   // for CPU_INSTRUCTION_LIST
+#define CPU_EXECUTE_DISPATCH(target) \
+    _Pragma("GCC diagnostic push") \
+    _Pragma("GCC diagnostic ignored \"-Wpedantic\"") \
+    goto *(target); \
+    _Pragma("GCC diagnostic pop")
+#else
+#define CPU_EXECUTE_LABEL(mnemonic)
 #endif
 
 
@@ -67,6 +85,17 @@ const char* cpu_state_name[CS_COUNT] = {
 };
 
 
+static void cpu_device_clock(void* cpu) {
+    ((CPU_t*) cpu)->clock_variant(cpu);
+}
+
+// cpus make the requests, the bus forwards them
+static const DeviceOps_t cpu_device_ops = {
+    .clock = cpu_device_clock, 
+    .request = bus_forward_request, 
+    .clock_idle = 1, 
+};
+
 CPU_t* cpu_create(void) {
     CPU_t* cpu = malloc(sizeof(CPU_t));
     if (!cpu) return NULL;  // Always check for malloc failure
@@ -75,6 +104,7 @@ CPU_t* cpu_create(void) {
 
     // Zero out the entire CPU structure
     memset(cpu, 0, sizeof(CPU_t));
+    device_register_ops(&cpu->device, &cpu_device_ops, cpu, 1);
 
     // Explicitly reset the status register
     cpu->regs.sr.value = 0x0000;
@@ -88,6 +118,8 @@ CPU_t* cpu_create(void) {
 
     cpu->intermediate.extension_index = 0;
 
+    cpu_select_clock_variant(cpu);
+
     return cpu;
 }
 
@@ -95,12 +127,125 @@ CPU_t* cpu_create(void) {
 void cpu_delete(CPU_t** cpu) {
     if (!cpu) {return;}
     cache_delete(&(*cpu)->cache);
+    cpu_decode_cache_delete(&(*cpu)->decode_cache);
+    cpu_jit_delete(&(*cpu)->jit);
+    cpu_pipeline_delete(&(*cpu)->pipeline);
+    cpu_branch_predictor_delete(&(*cpu)->branch_predictor);
+    device_set_transaction_capacity(&(*cpu)->device, 0);
     free(*cpu);
     *cpu = NULL;
 }
 
 void cpu_mount_cache(CPU_t* cpu, Cache_t* cache) {
     cpu->cache = cache;
+    cpu_select_clock_variant(cpu);
+}
+
+void cpu_mount_decode_cache(CPU_t* cpu, CpuDecodeCache_t* decode_cache) {
+    cpu->decode_cache = decode_cache;
+}
+
+void cpu_mount_jit(CPU_t* cpu, CpuJit_t* jit) {
+    cpu->jit = jit;
+}
+
+void cpu_mount_pipeline(CPU_t* cpu, CpuPipeline_t* pipeline) {
+    cpu->pipeline = pipeline;
+    if (pipeline) {
+        pipeline->predictor = cpu->branch_predictor;
+    }
+    cpu_select_clock_variant(cpu);
+}
+
+void cpu_mount_branch_predictor(CPU_t* cpu, CpuBranchPredictor_t* branch_predictor) {
+    cpu->branch_predictor = branch_predictor;
+    if (cpu->pipeline) {
+        cpu->pipeline->predictor = branch_predictor;
+    }
+    cpu_select_clock_variant(cpu);
+}
+
+
+/*
+Hands the tagged fetch of cpu_prefetch_ahead that covers address to the read: a completed one moves into the prefetch buffer, 
+for one still in flight the read waits instead of asking the bus a second time. 
+Returns 1 with data set, 0 to wait and -1 if no tagged fetch covers address
+*/
+static inline int cpu_prefetch_collect(CPU_t* cpu, uint16_t address, uint8_t* data, const int cached) {
+    if (cpu->device.device_state != DS_IDLE || cpu->device.processed) {return -1;}  // the untagged request is on its way already
+    for (int t = 0; t < cpu->device.transaction_capacity; t++) {
+        DeviceTransaction_t* transaction = &cpu->device.transaction[t];
+        uint16_t offset = (uint16_t) (address - transaction->address);
+        if (transaction->state != DS_FETCH || transaction->cancelled || offset >= CPU_PREFETCH_BYTES) {continue;}
+        if (!transaction->processed) {return 0;}
+        uint64_t response = transaction->data;
+        if (cached) {
+            cache_write(cpu->cache, transaction->address, (uint8_t*) &response, sizeof(response));
+        }
+        cpu->prefetch.valid = 1;
+        cpu->prefetch.address = transaction->address;
+        cpu->prefetch.data = response;
+        cpu->prefetch.ahead_used ++;
+        device_release(&cpu->device, t + 1);
+        *data = (uint8_t) (response >> (8 * offset));
+        return 1;
+    }
+    return -1;
+}
+
+// tag of the fetch whose bytes cover address, 0 if there is none
+static int cpu_prefetch_covering(CPU_t* cpu, uint16_t address) {
+    for (int t = 0; t < cpu->device.transaction_capacity; t++) {
+        DeviceTransaction_t* transaction = &cpu->device.transaction[t];
+        if (transaction->state == DS_FETCH && !transaction->cancelled && (uint16_t) (address - transaction->address) < CPU_PREFETCH_BYTES) {
+            return t + 1;
+        }
+    }
+    return 0;
+}
+
+/*
+Fetches the bytes from pc on with tagged requests while the instruction before them is still busy, 
+one block of CPU_PREFETCH_BYTES per tag. Fetches of blocks that are not next any more (the cpu jumped) are dropped
+*/
+static void cpu_prefetch_ahead(CPU_t* cpu) {
+    if (cpu->direct_ram) {return;}
+    uint16_t address = cpu->regs.pc;
+    if (cpu->cache && cache_contains(cpu->cache, address)) {return;}
+    uint32_t wanted = 0;
+    int missing_count = 0;
+    uint16_t missing[DEVICE_MAX_TRANSACTIONS];
+    for (int block = 0; block < cpu->device.transaction_capacity && address <= SEGMENT_CODE_END; block++) {
+        int tag = cpu_prefetch_covering(cpu, address);
+        if (cpu->prefetch.valid && (uint16_t) (address - cpu->prefetch.address) + CPU_PREFETCH_AHEAD_BYTES <= CPU_PREFETCH_BYTES) {
+            address = cpu->prefetch.address + CPU_PREFETCH_BYTES;
+        } else if (tag) {
+            wanted |= 1u << tag;
+            address = cpu->device.transaction[tag - 1].address + CPU_PREFETCH_BYTES;
+        } else {
+            missing[missing_count++] = address;
+            address += CPU_PREFETCH_BYTES;
+        }
+    }
+    for (int t = 0; t < cpu->device.transaction_capacity; t++) {
+        if (cpu->device.transaction[t].state == DS_FETCH && !((wanted >> (t + 1)) & 1)) {
+            device_release(&cpu->device, t + 1);
+        }
+    }
+    for (int m = 0; m < missing_count && device_issue(&cpu->device, DS_FETCH, missing[m], 0, 1); m++) {
+        cpu->prefetch.ahead ++;
+    }
+}
+
+// drops the fetches ahead that the store at address may have overtaken, the bytes are fetched again when they are needed
+static void cpu_prefetch_store(CPU_t* cpu, uint16_t address, uint8_t width) {
+    for (int t = 0; t < cpu->device.transaction_capacity; t++) {
+        DeviceTransaction_t* transaction = &cpu->device.transaction[t];
+        if (transaction->state != DS_FETCH || transaction->cancelled) {continue;}
+        if ((uint16_t) (address - transaction->address) < CPU_PREFETCH_BYTES || (uint16_t) (transaction->address - address) < width) {
+            device_release(&cpu->device, t + 1);
+        }
+    }
 }
 
 
@@ -108,14 +253,44 @@ void cpu_mount_cache(CPU_t* cpu, Cache_t* cache) {
 Returns 1 if the data has been successfully fetched, else 0. The result will be put in the data pointer
 First it looks through cache, if its not there, it sends a request to ram
 */
-int cpu_read_memory(CPU_t* cpu, uint16_t address, uint8_t *data) {
+// adds the estimated bus round trip of a direct ram access, given in sixteenths of a cycle
+static inline void cpu_charge_direct(CPU_t* cpu, uint32_t sixteenths) {
+    sixteenths += cpu->direct_fraction;
+    cpu->direct_fraction = sixteenths & 0xf;
+    cpu->clock += sixteenths >> 4;
+    cpu->cycles.stalled[cpu->state] += sixteenths >> 4;
+    cpu->cycles.memory += sixteenths >> 4;
+}
+
+static inline __attribute__((always_inline)) int cpu_read_memory_variant(CPU_t* cpu, uint16_t address, uint8_t *data, const int cached) {
     #ifdef _CPU_DEEP_DEBUG_
     log_msg(LP_DEBUG, "CPU (C:%d CS:%d DS:%d): Attempting to request memory at address 0x%.4x", cpu->clock, cpu->state, cpu->device.device_state, address);
     log_msg(LP_DEBUG, "CPU (C:%d CS:%d DS:%d): Checking cache first", cpu->clock, cpu->state, cpu->device.device_state);
     #endif
-    if (!cpu->regs.sr.NC) {
+    if (cached && !cpu->regs.sr.NC) {
         if (cache_read(cpu->cache, address, data)) return 1;
     }
+    if (cpu->prefetch.valid && !cpu->regs.sr.NC && (uint16_t) (address - cpu->prefetch.address) < CPU_PREFETCH_BYTES && address <= SEGMENT_CODE_END) {
+        *data = (uint8_t) (cpu->prefetch.data >> (8 * (uint16_t) (address - cpu->prefetch.address)));
+        cpu->prefetch.hit ++;
+        return 1;
+    }
+    if (cpu->direct_ram && address <= SEGMENT_CODE_END && cpu->device.device_state == DS_IDLE && !cpu->device.processed) {
+        uint64_t response = 0;
+        for (size_t i = 0; i < sizeof(response); i++) {
+            response |= ((uint64_t) ram_read(cpu->direct_ram, address + i) << (8 * i));
+        }
+        if (cached && !cpu->regs.sr.NC) {
+            cache_write(cpu->cache, address, (uint8_t*) &response, sizeof(response));
+        }
+        *data = (uint8_t) response;
+        cpu_charge_direct(cpu, CPU_DIRECT_READ_CYCLES);
+        return 1;
+    }
+    if (cpu->device.transaction_capacity && !cpu->regs.sr.NC && address <= SEGMENT_CODE_END) {
+        int collected = cpu_prefetch_collect(cpu, address, data, cached);
+        if (collected >= 0) {return collected;}
+    }
     #ifdef _CPU_DEEP_DEBUG_
     log_msg(LP_DEBUG, "CPU (C:%d CS:%d DS:%d): \tCache miss", cpu->clock, cpu->state, cpu->device.device_state);
     log_msg(LP_DEBUG, "CPU (C:%d CS:%d DS:%d): Checking device response", cpu->clock, cpu->state, cpu->device.device_state);
@@ -128,6 +303,7 @@ int cpu_read_memory(CPU_t* cpu, uint16_t address, uint8_t *data) {
             cpu->device.address = address;
             cpu->device.processed = 0;
             cpu->device.device_state = DS_FETCH;
+            device_post(&cpu->device);
             return 0;
         }
         #ifdef _CPU_DEEP_DEBUG_
@@ -141,7 +317,15 @@ int cpu_read_memory(CPU_t* cpu, uint16_t address, uint8_t *data) {
         log_msg(LP_DEBUG, "CPU (C:%d CS:%d DS:%d): Requesting write to cache", cpu->clock, cpu->state, cpu->device.device_state);
         #endif
         if (!cpu->regs.sr.NC) {
-            cache_write(cpu->cache, cpu->device.address, (uint8_t*) &response, sizeof(response));
+            if (cached) {
+                cache_write(cpu->cache, cpu->device.address, (uint8_t*) &response, sizeof(response));
+            }
+            if (cpu->prefetch.active && address <= SEGMENT_CODE_END) {
+                cpu->prefetch.valid = 1;
+                cpu->prefetch.address = address;
+                cpu->prefetch.data = response;
+                cpu->prefetch.fill ++;
+            }
         }
 
         *data = (uint8_t) response;
@@ -163,16 +347,73 @@ int cpu_read_memory(CPU_t* cpu, uint16_t address, uint8_t *data) {
     cpu->device.address = address;
     cpu->device.processed = 0;
     cpu->device.device_state = DS_FETCH;
+    device_post(&cpu->device);
 
     return 0;
 }
 
+int cpu_read_memory(CPU_t* cpu, uint16_t address, uint8_t *data) {
+    return cpu_read_memory_variant(cpu, address, data, 1);
+}
+
+void cpu_charge_direct_reads(CPU_t* cpu, uint32_t count) {
+    // every direct read takes a whole response from ram
+    uint64_t reads = (uint64_t) count * sizeof(uint64_t);
+    if (cpu->direct_ram->shared) {
+        __atomic_fetch_add(&cpu->direct_ram->reads, reads, __ATOMIC_RELAXED);
+    } else {
+        cpu->direct_ram->reads += reads;
+    }
+    cpu_charge_direct(cpu, count * CPU_DIRECT_READ_CYCLES);
+}
+
+// for cpus without a data cache
+static int cpu_read_memory_uncached(CPU_t* cpu, uint16_t address, uint8_t *data) {
+    return cpu_read_memory_variant(cpu, address, data, 0);
+}
+
 
 int cpu_write_memory(CPU_t* cpu, uint16_t address, uint8_t data) {
+    return cpu_write_memory_width(cpu, address, data, 1);
+}
+
+int cpu_word_store(CPU_t* cpu, uint16_t address) {
+    if (!cpu->word_stores) {return 0;}
+    // only ram and the memory bank window take wide stores, MMIO registers stay byte wise
+    return address < SEGMENT_CODE_END || (address >= SEGMENT_MEMORY_BANK && address < SEGMENT_MEMORY_BANK_END);
+}
+
+static inline __attribute__((always_inline)) int cpu_write_memory_variant(CPU_t* cpu, uint16_t address, uint64_t data, uint8_t width, const int cached) {
     #ifdef _CPU_DEEP_DEBUG_
-    log_msg(LP_DEBUG, "CPU (C:%d CS:%d DS:%d): Attempting to write data 0x%.2x at address 0x%.4x", cpu->clock, cpu->state, cpu->device.device_state, data, address);
+    log_msg(LP_DEBUG, "CPU (C:%d CS:%d DS:%d): Attempting to write %d bytes 0x%.16lx at address 0x%.4x", cpu->clock, cpu->state, cpu->device.device_state, width, data, address);
     #endif
-                                
+
+    for (uint8_t i = 0; i < width; i++) {
+        uint16_t offset = (uint16_t) (address + i - cpu->prefetch.address);
+        if (cpu->prefetch.valid && offset < CPU_PREFETCH_BYTES) {
+            // keep the buffer coherent with what the store leaves in ram
+            cpu->prefetch.data = (cpu->prefetch.data & ~((uint64_t) 0xff << (8 * offset))) | (((data >> (8 * i)) & 0xff) << (8 * offset));
+        }
+    }
+    if (cpu->device.transaction_capacity) {
+        cpu_prefetch_store(cpu, address, width);
+    }
+    if (cpu->direct_ram && address + width - 1 <= SEGMENT_CODE_END && cpu->device.device_state == DS_IDLE && !cpu->device.processed) {
+        for (uint8_t i = 0; i < width; i++) {
+            uint8_t byte = (uint8_t) (data >> (8 * i));
+            if (ram_peek(cpu->direct_ram, address + i) != byte) {
+                cpu->stores ++;
+            }
+            ram_write(cpu->direct_ram, address + i, byte);
+        }
+        if (cached && !cpu->regs.sr.NC) {
+            cache_write(cpu->cache, address, (uint8_t*) &data, width);
+        }
+        cpu_charge_direct(cpu, CPU_DIRECT_WRITE_CYCLES);
+        return 1;
+    }
+
+    cpu->stores ++;
     if (cpu->device.processed) {
         #ifdef _CPU_DEEP_DEBUG_
         log_msg(LP_DEBUG, "CPU (C:%d CS:%d DS:%d): Update went through", cpu->clock, cpu->state, cpu->device.device_state);
@@ -194,18 +435,32 @@ int cpu_write_memory(CPU_t* cpu, uint16_t address, uint8_t data) {
     }
     cpu->device.address = address;
     cpu->device.data = data;
+    cpu->device.width = width;
     cpu->device.processed = 0;
     cpu->device.device_state = DS_STORE;
+    device_post(&cpu->device);
 
     int accept_dirty_write = 0;
-    if (!cpu->regs.sr.NC) {
-        accept_dirty_write = cache_write(cpu->cache, cpu->device.address, (uint8_t*) &data, 1);
+    if (cached && !cpu->regs.sr.NC) {
+        accept_dirty_write = cache_write(cpu->cache, cpu->device.address, (uint8_t*) &data, width);
     }
     return accept_dirty_write;
 }
 
+int cpu_write_memory_width(CPU_t* cpu, uint16_t address, uint64_t data, uint8_t width) {
+    return cpu_write_memory_variant(cpu, address, data, width, 1);
+}
+
+// for cpus without a data cache
+static int cpu_write_memory_width_uncached(CPU_t* cpu, uint16_t address, uint64_t data, uint8_t width) {
+    return cpu_write_memory_variant(cpu, address, data, width, 0);
+}
+
 
 void cpu_update_status_register(CPU_t* cpu, uint16_t result) {
+    cpu_resolve_flags(cpu, 1 << 1);     // FZ is the only bit left untouched
+    cpu->flags.pending = 0;
+    cpu->flags.operation = CFO_NONE;
     cpu->regs.sr.Z = (result == 0);
     cpu->regs.sr.L = (result >> 15); // ((int16_t) result < 0)
     cpu->regs.sr.UL = 0;
@@ -214,2436 +469,407 @@ void cpu_update_status_register(CPU_t* cpu, uint16_t result) {
     cpu->regs.sr.LL = (result >> 15);
 }
 
-void cpu_clock(CPU_t* cpu) {
-    #ifdef _CPU_DEEP_DEBUG_
-    log_msg(LP_DEBUG, "CS %d, DS %d", cpu->state, cpu->device.device_state);
+static int cpu_compare_bit(int bit, uint16_t a, uint16_t b) {
+    switch (bit) {
+        case 0: return (a == b);
+        case 1: return (a == b || (((a & 0x7fff) == 0) && ((b & 0x7fff) == 0)));
+        case 2: return ((int16_t) a < (int16_t) b);
+        case 3: return (a < b);
+        case 4: return (float_from_f16(a) < float_from_f16(b));
+        case 5: return (float_from_bf16(a) < float_from_bf16(b));
+        default: return (long_long_from_fi16(a) < long_long_from_fi16(b));
+    }
+}
 
-    log_msg(LP_INFO, "CPU (C:%d CS:%d DS:%d): Checking for interrupt", cpu->clock, cpu->state, cpu->device.device_state);
-    #endif
-    if (cpu->device.device_state == DS_INTERRUPT) {
-        #ifdef _CPU_DEBUG_
-        log_msg(LP_INFO, "CPU (C:%d CS:%d DS:%d): PC %.4x - interrupt on CS %d, irqid %d", cpu->clock, cpu->state, cpu->device.device_state, cpu->regs.pc, cpu->state, cpu->device.address);
-        #endif
-        
-        if (!cpu->regs.sr.MI && !cpu->regs.sr.MNI) {
-            cpu->regs.pc = cpu->intermediate.previous_pc;
-            cpu->regs.sp = cpu->intermediate.previous_sp;
-            cpu->state = CS_INTERRUPT_PUSH_PC_HIGH;
-            cpu->intermediate.irq_id = cpu->device.address;
-        }
-        cpu->device.device_state = DS_IDLE;
+static int cpu_test_bit(int bit, uint16_t value) {
+    switch (bit) {
+        case 0: return (value == 0);
+        case 1: return ((value & 0x7fff) == 0);
+        default: return ((value & 0x8000) != 0);
     }
+}
 
-    switch (cpu->state) {
-
-        case CS_FETCH_INSTRUCTION:
-            {
-                CS_FETCH_INSTRUCTION:
-                #ifdef _CPU_DEEP_DEBUG_
-                log_msg(LP_INFO, "CPU (C:%d CS:%d DS:%d): Fetching instruction", cpu->clock, cpu->state, cpu->device.device_state);
-                #endif
-                cpu->regs.sr.MNI = 0;
-                uint16_t address = cpu->regs.pc;
-                if (cpu->intermediate.extension_index == 0) { // This check prevents prev values from updating when iterating over extension prefixes, keeping the prev at the base of the instruction. 
-                    cpu->intermediate.previous_pc = cpu->regs.pc;
-                    cpu->intermediate.previous_sp = cpu->regs.sp;
-                }
-                uint8_t data;
-                int success = cpu_read_memory(cpu, address, &data);
-                if (success) {
-                    // ok, we got the data for the instruction, saving it intermediatly
-                    cpu->regs.sr.NC = (data & 0x80) != 0;
-                    cpu->intermediate.instruction = data & 0x7F;
-
-                    if (cpu->intermediate.instruction == EXT) {
-                        #ifdef _CPU_DEEP_DEBUG_
-                        log_msg(LP_CRITICAL, "CPU (C:%d CS:%d DS:%d): Fetch was successful, loaded EXT instruction, fetching next byte...", cpu->clock, cpu->state, cpu->device.device_state);
-                        #endif
-                        cpu->regs.pc ++;
-                        cpu->intermediate.extension_index ++;
-                        break;
-                    }
-
-                    cpu->intermediate.instruction += (cpu->intermediate.extension_index * 0x80);
-                    #ifdef _CPU_DEEP_DEBUG_
-                    log_msg(LP_INFO, "CPU (C:%d CS:%d DS:%d): Fetch was successful, loaded instruction %s (%d)", cpu->clock, cpu->state, cpu->device.device_state, instruction_encoding[cpu->intermediate.instruction].instruction_string, cpu->intermediate.instruction);
-                    #endif
-                    cpu->intermediate.argument_count = instruction_encoding[cpu->intermediate.instruction].argument_count;
-
-                    if (cpu->intermediate.instruction < INSTRUCTION_COUNT) {
-                        cpu->last_instruction = (CPU_INSTRUCTION_MNEMONIC_t) cpu->intermediate.instruction;
-                        #ifdef _CPU_DEBUG_
-                        if (cpu->intermediate.argument_count == 0) {
-                            log_msg(LP_DEBUG, "CPU (C:%d CS:%d DS:%d): PC %.4x - instruction (argc:0): %s - nc: %d - sp: %.4x", 
-                                cpu->clock, cpu->state, cpu->device.device_state, 
-                                cpu->regs.pc, 
-                                instruction_encoding[cpu->intermediate.instruction].instruction_string, 
-                                cpu->regs.sr.NC, 
-                                cpu->regs.sp
-                            );
-                        }
-                        #endif
-                    } else {
-                        #ifdef _CPU_DEEP_DEBUG_
-                        log_msg(LP_ERROR, "CPU (C:%d CS:%d DS:%d): Unknown instruction [%d, nc:%d, PC: 0x%.4x] [%s:%d]", cpu->clock, cpu->state, cpu->device.device_state, cpu->intermediate.instruction, cpu->regs.sr.NC, cpu->regs.pc - 1, __FILE__, __LINE__);
-                        #endif
-                        cpu->state = CS_EXCEPTION;
-                        break;
-                    }
-
-                    cpu->intermediate.extension_index = 0;
-                    if (cpu->intermediate.argument_count == 0) {
-                        cpu->regs.pc ++;
-                        cpu->state = CS_EXECUTE;
-                        goto CS_EXECUTE;
-                    } else {
-                        cpu->state = CS_FETCH_ADDRESSING_MODES;
-                        cpu->regs.pc ++;
-                        goto CS_FETCH_ADDRESSING_MODES;
-                    }
-                } else {
-                    #ifdef _CPU_DEEP_DEBUG_
-                    log_msg(LP_INFO, "CPU (C:%d CS:%d DS:%d): Fetch was unsuccessful", cpu->clock, cpu->state, cpu->device.device_state);
-                    #endif
-                }
+void cpu_resolve_flags(CPU_t* cpu, uint16_t mask) {
+    uint8_t resolve = cpu->flags.pending & mask;
+    for (int bit = 0; resolve >> bit; bit++) {
+        if (!((resolve >> bit) & 1)) {continue;}
+        int value = cpu->flags.operation == CFO_COMPARE ? cpu_compare_bit(bit, cpu->flags.a, cpu->flags.b) : cpu_test_bit(bit, cpu->flags.a);
+        cpu->regs.sr.value = (cpu->regs.sr.value & ~(1 << bit)) | (value << bit);
+    }
+    cpu->flags.pending &= ~resolve;
+    if (!cpu->flags.pending) {
+        cpu->flags.operation = CFO_NONE;
+    }
+}
+
+uint16_t cpu_status_register(CPU_t* cpu) {
+    if (cpu->flags.pending) {
+        cpu_resolve_flags(cpu, CPU_FLAGS_COMPARE_MASK);
+    }
+    return cpu->regs.sr.value;
+}
+
+
+/*
+Resolves the pending status bits an instruction is about to read or overwrite. 
+Conditional jumps and moves only need the bit they test
+*/
+static void cpu_resolve_flags_for(CPU_t* cpu, int instruction) {
+    int condition;
+    if (instruction >= JZ && instruction <= JNAO) {
+        condition = instruction - JZ;
+    } else if (instruction >= RJZ && instruction <= RJNAO) {
+        condition = instruction - RJZ;
+    } else if (instruction >= CMOVZ && instruction <= CMOVNMI) {
+        condition = instruction - CMOVZ;
+    } else if (instruction == PUSHSR || instruction == POPSR || (instruction >= CLZ && instruction <= SEMI)) {
+        cpu_resolve_flags(cpu, CPU_FLAGS_COMPARE_MASK);
+        return;
+    } else {
+        return;
+    }
+    cpu_resolve_flags(cpu, 1 << (condition / 2));
+}
+
+/*
+Saves the fully decoded instruction starting at previous_pc, so the next time it is fetched 
+the cpu can continue with entry_state right away
+*/
+static void cpu_decode_cache_store(CPU_t* cpu, CpuState_t entry_state) {
+    if (!cpu->decode_cache) {return;}
+    uint16_t pc = cpu->intermediate.previous_pc;
+    uint16_t length = cpu->regs.pc - pc;
+    if (cpu->regs.pc <= pc || cpu->regs.pc - 1 > SEGMENT_CODE_END) {return;}   // only code that lives in ram and does not wrap around
+
+    CpuDecodedInstruction_t decoded = {
+        .pc = pc, 
+        .length = length, 
+        .no_cache = cpu->regs.sr.NC, 
+        .addressing_mode = cpu->intermediate.addressing_mode.value, 
+        .instruction = cpu->intermediate.instruction, 
+        .argument_count = cpu->intermediate.argument_count, 
+        .argument_bytes_to_load = cpu->intermediate.argument_bytes_to_load, 
+        .entry_state = entry_state, 
+    };
+    memcpy(decoded.argument_data_raw, cpu->intermediate.argument_data_raw, sizeof(decoded.argument_data_raw));
+    cpu_decode_cache_insert(cpu->decode_cache, &decoded);
+}
+
+
+// =======================================================================================
+// superinstructions, only run with direct ram, where every access to ram completes right away
+
+// r0, r1, r2, r3, sp, in the order of the register addressing modes
+static uint16_t* cpu_register(CPU_t* cpu, int index) {
+    switch (index) {
+        case 0: return &cpu->regs.r0;
+        case 1: return &cpu->regs.r1;
+        case 2: return &cpu->regs.r2;
+        case 3: return &cpu->regs.r3;
+        default: return &cpu->regs.sp;
+    }
+}
+
+static uint16_t cpu_immediate(const int8_t* argument_data_raw) {
+    return (uint8_t) argument_data_raw[0] | ((uint8_t) argument_data_raw[1] << 8);
+}
+
+// value of an ADMX_IMM16 or ADMX_R0..ADMX_SP source
+static uint16_t cpu_fused_source(CPU_t* cpu, int admx, const int8_t* argument_data_raw) {
+    if (admx == ADMX_IMM16) {
+        return cpu_immediate(argument_data_raw);
+    }
+    return *cpu_register(cpu, admx - ADMX_R0);
+}
+
+static uint16_t cpu_fused_read16(CPU_t* cpu, uint16_t address) {
+    uint8_t low = 0, high = 0;
+    cpu_read_memory(cpu, address, &low);
+    cpu_read_memory(cpu, address + 1, &high);
+    return low | (high << 8);
+}
+
+static void cpu_fused_write16(CPU_t* cpu, uint16_t address, uint16_t data) {
+    if (cpu_word_store(cpu, address)) {
+        cpu_write_memory_width(cpu, address, data, 2);
+        return;
+    }
+    cpu_write_memory(cpu, address, data & 0x00ff);
+    cpu_write_memory(cpu, address + 1, (data & 0xff00) >> 8);
+}
+
+static void cpu_fused_push16(CPU_t* cpu, uint16_t data) {
+    if (cpu_word_store(cpu, cpu->regs.sp - 2)) {
+        cpu_write_memory_width(cpu, cpu->regs.sp - 2, data, 2);
+        cpu->regs.sp -= 2;
+        return;
+    }
+    cpu_write_memory(cpu, cpu->regs.sp - 1, (data & 0xff00) >> 8);
+    cpu->regs.sp --;
+    cpu_write_memory(cpu, cpu->regs.sp - 1, data & 0x00ff);
+    cpu->regs.sp --;
+}
+
+/*
+Cycles a single instruction is charged with direct ram, not counting memory accesses: 
+instructions with arguments end one cycle in CS_COMPUTE_ADDRESS, the cycle an instruction finishes in returns at the next fetch uncounted
+*/
+static int cpu_fused_cycles(int instruction) {
+    return instruction_encoding[instruction].argument_count ? 1 : 0;
+}
+
+// a 16 bit access at address stays inside of ram
+static int cpu_fused_in_ram(uint16_t address) {
+    return address < SEGMENT_CODE_END;
+}
+
+/*
+Executes the superinstruction headed by decoded, in place of the single instructions.
+Instruction counts, memory accesses (and with them the cache and the clock) are the same as the single instructions would have produced, 
+on top of that the clock is charged the cycles the single instructions would have ended.
+Returns 0 without any side effect if an operand lies outside of ram, the head then runs as a normal instruction
+*/
+static int cpu_execute_fused(CPU_t* cpu, CpuDecodedInstruction_t* decoded) {
+    CpuDecodeCache_t* decode_cache = cpu->decode_cache;
+    if (!cpu_decode_cache_fusion_valid(decode_cache, decoded)) {return 0;}
+
+    int admr = decoded->addressing_mode & 0x07;
+    int admx = decoded->addressing_mode >> 3;
+    CpuDecodedFollower_t* next = decoded->follower;
+    int next_admx = next[0].addressing_mode >> 3;
+    int followers = 1;
+    uint16_t pc = decoded->fused_next_pc;
+
+    switch (decoded->fusion) {
+        case CF_LOAD_PUSH: {
+                // mov rX, [rY + imm]; push rX
+                uint16_t address = *cpu_register(cpu, admx - ADMX_IND_R0_OFFSET16) + cpu_immediate(decoded->argument_data_raw);
+                if (!cpu_fused_in_ram(address) || !cpu_fused_in_ram(cpu->regs.sp - 2)) {break;}
+                uint16_t value = cpu_fused_read16(cpu, address);
+                *cpu_register(cpu, admr - ADMR_R0) = value;
+                cpu->instruction += 2;
+                cpu_fused_push16(cpu, value);
+                cpu->instruction ++;
+                goto FUSED;
             }
-            break;
-        
-        case CS_FETCH_ADDRESSING_MODES:
-            {
-                CS_FETCH_ADDRESSING_MODES:
-                #ifdef _CPU_DEEP_DEBUG_
-                log_msg(LP_INFO, "CPU (C:%d CS:%d DS:%d): Fetching addressing modes", cpu->clock, cpu->state, cpu->device.device_state);
-                #endif
-                cpu->regs.sr.MNI = 0;
-                uint16_t address = cpu->regs.pc;
-                uint8_t data;
-                int success = cpu_read_memory(cpu, address, &data);
-                if (success) {
-                    #ifdef _CPU_DEEP_DEBUG_
-                    log_msg(LP_INFO, "CPU (C:%d CS:%d DS:%d): Fetch was successful", cpu->clock, cpu->state, cpu->device.device_state);
-                    #endif
-                    // ok, we got the data for the instruction, saving it intermediatly
-                    cpu->intermediate.addressing_mode.value = data;
-
-                    if (cpu->intermediate.argument_count == 2) {
-                        #ifdef _CPU_DEBUG_
-                            log_msg(LP_DEBUG, "CPU (C:%d CS:%d DS:%d): PC %.4x - instruction (argc:2): %s %s, %s - nc: %d - sp: %.4x", 
-                                cpu->clock, cpu->state, cpu->device.device_state, 
-                                cpu->regs.pc - 1, 
-                                instruction_encoding[cpu->intermediate.instruction].instruction_string, 
-                                cpu_reduced_addressing_mode_string[cpu->intermediate.addressing_mode.addressing_mode_reduced], 
-                                cpu_extended_addressing_mode_string[cpu->intermediate.addressing_mode.addressing_mode_extended], 
-                                cpu->regs.sr.NC, 
-                                cpu->regs.sp
-                            );
-                        #endif
-                        if (cpu->intermediate.addressing_mode.addressing_mode_reduced == ADMR_NONE || cpu->intermediate.addressing_mode.addressing_mode_extended == ADMX_NONE) {
-                            #ifdef _CPU_DEEP_DEBUG_
-                            log_msg(LP_ERROR, "CPU (C:%d CS:%d DS:%d): Encountered an invalid instruction [admr or admx is none] [%s:%d]", cpu->clock, cpu->state, cpu->device.device_state, __FILE__, __LINE__);
-                            #endif
-                            cpu->state = CS_EXCEPTION;
-                        }
-                    } else {
-                        if (instruction_encoding[cpu->intermediate.instruction].single_operant_writeback) {
-                            #ifdef _CPU_DEBUG_
-                                log_msg(LP_DEBUG, "CPU (C:%d CS:%d DS:%d): PC %.4x - instruction (argc:1 single_operant_writeback): %s %s - nc: %d - sp: %.4x", 
-                                    cpu->clock, cpu->state, cpu->device.device_state, 
-                                    cpu->regs.pc - 1, 
-                                    instruction_encoding[cpu->intermediate.instruction].instruction_string, 
-                                    cpu_reduced_addressing_mode_string[cpu->intermediate.addressing_mode.addressing_mode_reduced], 
-                                    cpu->regs.sr.NC, 
-                                    cpu->regs.sp
-                                );
-                            #endif
-                            if (cpu->intermediate.addressing_mode.addressing_mode_reduced == ADMR_NONE) {
-                                #ifdef _CPU_DEEP_DEBUG_
-                                log_msg(LP_ERROR, "CPU (C:%d CS:%d DS:%d): Encountered an invalid instruction [admr is none] [%s:%d]", cpu->clock, cpu->state, cpu->device.device_state, __FILE__, __LINE__);
-                                #endif
-                                cpu->state = CS_EXCEPTION;
-                            }
-                        } else {
-                            #ifdef _CPU_DEBUG_
-                                log_msg(LP_DEBUG, "CPU (C:%d CS:%d DS:%d): PC %.4x - instruction (argc:1): %s %s - nc: %d - sp: %.4x", 
-                                    cpu->clock, cpu->state, cpu->device.device_state, 
-                                    cpu->regs.pc - 1, 
-                                    instruction_encoding[cpu->intermediate.instruction].instruction_string, 
-                                    cpu_extended_addressing_mode_string[cpu->intermediate.addressing_mode.addressing_mode_extended], 
-                                    cpu->regs.sr.NC, 
-                                    cpu->regs.sp
-                                );
-                            #endif
-                            if (cpu->intermediate.addressing_mode.addressing_mode_extended == ADMX_NONE) {
-                                #ifdef _CPU_DEEP_DEBUG_
-                                log_msg(LP_ERROR, "CPU (C:%d CS:%d DS:%d): Encountered an invalid instruction [admx is none] [%s:%d]", cpu->clock, cpu->state, cpu->device.device_state, __FILE__, __LINE__);
-                                #endif
-                                
-                                cpu->state = CS_EXCEPTION;
-                            }
-                        }
-                    }
-                    
-                    // here check how many bytes to load for 
-                    cpu->intermediate.argument_bytes_to_load = 0;
-                    if (cpu->intermediate.argument_count == 2) {
-                        cpu->intermediate.argument_bytes_to_load = 
-                            cpu_reduced_addressing_mode_bytes[cpu->intermediate.addressing_mode.addressing_mode_reduced] +
-                            cpu_extended_addressing_mode_bytes[cpu->intermediate.addressing_mode.addressing_mode_extended];
-                    } else if (cpu->intermediate.argument_count == 1) {
-                        if (instruction_encoding[cpu->intermediate.instruction].single_operant_writeback) {
-                            cpu->intermediate.argument_bytes_to_load = cpu_reduced_addressing_mode_bytes[cpu->intermediate.addressing_mode.addressing_mode_reduced];
-                        } else {
-                            cpu->intermediate.argument_bytes_to_load = cpu_extended_addressing_mode_bytes[cpu->intermediate.addressing_mode.addressing_mode_extended];
-                        }
-                    }
-
-                    cpu->regs.pc ++;
-
-                    if (cpu->intermediate.argument_bytes_to_load == 0) {
-                        #ifdef _CPU_DEEP_DEBUG_
-                        log_msg(LP_INFO, "CPU (C:%d CS:%d DS:%d): No bytes to fetch, skipping to CS_COMPUTE_ADDRESS");
-                        #endif
-                        cpu->state = CS_COMPUTE_ADDRESS;
-                        goto CS_COMPUTE_ADDRESS;
-                        break;
-                    }
-
-                    #ifdef _CPU_DEEP_DEBUG_
-                    log_msg(LP_INFO, "CPU (C:%d CS:%d DS:%d): Addressing modes require %d bytes for arguments", cpu->clock, cpu->state, cpu->device.device_state, cpu->intermediate.argument_bytes_to_load);
-                    #endif
-                                
-                    cpu->intermediate.argument_data_raw_index = 0;
-                    cpu->state = CS_FETCH_ARGUMENT_BYTES;
-                    goto CS_FETCH_ARGUMENT_BYTES;
+
+        case CF_LEA_STORE: {
+                // lea r0, [...]; mov [r0], reg/imm
+                uint16_t address;
+                if (admx == ADMX_IND16) {
+                    address = cpu_immediate(decoded->argument_data_raw);
+                } else if (admx >= ADMX_IND_R0 && admx <= ADMX_IND_SP) {
+                    address = *cpu_register(cpu, admx - ADMX_IND_R0);
                 } else {
-                    #ifdef _CPU_DEEP_DEBUG_
-                    log_msg(LP_INFO, "CPU (C:%d CS:%d DS:%d): Fetch was unsuccessful", cpu->clock, cpu->state, cpu->device.device_state);
-                    #endif
-                }
-            }
-            break;
-        
-        case CS_FETCH_ARGUMENT_BYTES: 
-            {
-                CS_FETCH_ARGUMENT_BYTES:
-                #ifdef _CPU_DEEP_DEBUG_
-                log_msg(LP_INFO, "CPU (C:%d CS:%d DS:%d): Fetching all argument bytes", cpu->clock, cpu->state, cpu->device.device_state);
-                #endif
-                cpu->regs.sr.MNI = 0;
-                uint8_t data;
-                int success = cpu_read_memory(cpu, cpu->regs.pc, &data);
-                if (success) {
-                    #ifdef _CPU_DEEP_DEBUG_
-                    log_msg(LP_INFO, "CPU (C:%d CS:%d DS:%d): Fetched byte %d/%d [0x%.2x]", cpu->clock, cpu->state, cpu->device.device_state, cpu->intermediate.argument_data_raw_index + 1, cpu->intermediate.argument_bytes_to_load, data);
-                    #endif
-                    cpu->intermediate.argument_data_raw[cpu->intermediate.argument_data_raw_index] = data;
-                    cpu->intermediate.argument_data_raw_index ++;
-                    cpu->regs.pc ++;
-
-                    if (cpu->intermediate.argument_data_raw_index >= cpu->intermediate.argument_bytes_to_load) {
-                        int admc;
-                        if (!instruction_encoding[cpu->intermediate.instruction].single_operant_writeback) {
-                            admc = cpu_extended_addressing_mode_category[cpu->intermediate.addressing_mode.addressing_mode_extended];
-                        } else {
-                            admc = cpu_reduced_addressing_mode_category[cpu->intermediate.addressing_mode.addressing_mode_reduced];
-                        }
-
-                        // if its only for admx, then skip to fetch source
-                        switch (admc) {
-                            case ADMC_IND:
-                                cpu->state = CS_COMPUTE_ADDRESS;
-                                goto CS_COMPUTE_ADDRESS;
-                                break;
-                            case ADMC_IMM:
-                                #ifdef _CPU_DEEP_DEBUG_
-                                log_msg(LP_INFO, "CPU (C:%d CS:%d DS:%d): admc is not indirect, skipping CS_COMPUTE_ADDRESS", cpu->clock, cpu->state, cpu->device.device_state);
-                                #endif
-                                cpu->state = CS_COMPUTE_ADDRESS;//CS_FETCH_SOURCE;
-                                goto CS_COMPUTE_ADDRESS;
-                                break;
-                            case ADMC_REG:
-                                cpu->state = CS_COMPUTE_ADDRESS;//CS_FETCH_SOURCE;
-                                goto CS_COMPUTE_ADDRESS;
-                                break;
-                            default:
-                                #ifdef _CPU_DEEP_DEBUG_
-                                log_msg(LP_ERROR, "CPU (C:%d CS:%d DS:%d): Unkown extended adm category %d [%s:%d]", cpu->clock, cpu->state, cpu->device.device_state, admc, __FILE__, __LINE__);
-                                #endif
-                                break;
-                        }
-                        break;
-                    }
-                }
-            }
-            break;
-        
-        case CS_COMPUTE_ADDRESS: 
-            {
-                CS_COMPUTE_ADDRESS:
-                #ifdef _CPU_DEEP_DEBUG_
-                log_msg(LP_INFO, "CPU (C:%d CS:%d DS:%d): Calculating source address from argument composition", cpu->clock, cpu->state, cpu->device.device_state);
-                #endif
-                cpu->regs.sr.MNI = 0;
-                int admr = cpu->intermediate.addressing_mode.addressing_mode_reduced;
-                int admx = cpu->intermediate.addressing_mode.addressing_mode_extended;
-                int argument_index = 0;
-                #ifdef _CPU_DEEP_DEBUG_
-                log_msg(LP_INFO, "CPU (C:%d CS:%d DS:%d): admx %s", cpu->clock, cpu->state, cpu->device.device_state, cpu_extended_addressing_mode_string[admx]);
-                #endif
-                cpu->intermediate.argument_count_for_admr = argument_index;
-                switch (admx) {
-                    case ADMX_R0:
-                    case ADMX_R1:
-                    case ADMX_R2:
-                    case ADMX_R3:
-                    case ADMX_SP:
-                    case ADMX_PC:
-                        // Idea, here set flag to not fetch data from this "address"
-                        #ifdef _CPU_DEEP_DEBUG_
-                        log_msg(LP_DEBUG, "CPU (C:%d CS:%d DS:%d): admx is not an address", cpu->clock, cpu->state, cpu->device.device_state, cpu->intermediate.argument_address_reduced);
-                        #endif
-                        cpu->state = CS_FETCH_SOURCE;
-                        break;
-                    case ADMX_IMM16:
-                        argument_index += 2;
-                        cpu->state = CS_FETCH_SOURCE;
-                        break;
-                    
-                    case ADMX_IND_R0:
-                        {
-                            cpu->intermediate.argument_address_extended = cpu->regs.r0;
-                            #ifdef _CPU_DEEP_DEBUG_
-                            log_msg(LP_DEBUG, "CPU (C:%d CS:%d DS:%d): admx base address [%.4x]", cpu->clock, cpu->state, cpu->device.device_state, cpu->intermediate.argument_address_extended);
-                            #endif
-                            cpu->state = CS_FETCH_SOURCE;
-                        }
-                        break;
-                    
-                    case ADMX_IND_R1:
-                        {
-                            cpu->intermediate.argument_address_extended = cpu->regs.r1;
-                            #ifdef _CPU_DEEP_DEBUG_
-                            log_msg(LP_DEBUG, "CPU (C:%d CS:%d DS:%d): admx base address [%.4x]", cpu->clock, cpu->state, cpu->device.device_state, cpu->intermediate.argument_address_extended);
-                            #endif
-                            cpu->state = CS_FETCH_SOURCE;
-                        }
-                        break;
-                    
-                    case ADMX_IND_R2:
-                        {
-                            cpu->intermediate.argument_address_extended = cpu->regs.r2;
-                            #ifdef _CPU_DEEP_DEBUG_
-                            log_msg(LP_DEBUG, "CPU (C:%d CS:%d DS:%d): admx base address [%.4x]", cpu->clock, cpu->state, cpu->device.device_state, cpu->intermediate.argument_address_extended);
-                            #endif
-                            cpu->state = CS_FETCH_SOURCE;
-                        }
-                        break;
-                    
-                    case ADMX_IND_R3:
-                        {
-                            cpu->intermediate.argument_address_extended = cpu->regs.r3;
-                            #ifdef _CPU_DEEP_DEBUG_
-                            log_msg(LP_DEBUG, "CPU (C:%d CS:%d DS:%d): admx base address [%.4x]", cpu->clock, cpu->state, cpu->device.device_state, cpu->intermediate.argument_address_extended);
-                            #endif
-                            cpu->state = CS_FETCH_SOURCE;
-                        }
-                        break;
-                    
-                    case ADMX_IND_SP:
-                        {
-                            cpu->intermediate.argument_address_extended = cpu->regs.sp;
-                            #ifdef _CPU_DEEP_DEBUG_
-                            log_msg(LP_DEBUG, "CPU (C:%d CS:%d DS:%d): admx base address [%.4x]", cpu->clock, cpu->state, cpu->device.device_state, cpu->intermediate.argument_address_extended); 
-                            #endif
-                            cpu->state = CS_FETCH_SOURCE;
-                        }
-                        break;
-                    
-                    case ADMX_IND_PC:
-                        {
-                            cpu->intermediate.argument_address_extended = cpu->regs.pc;
-                            #ifdef _CPU_DEEP_DEBUG_
-                            log_msg(LP_DEBUG, "CPU (C:%d CS:%d DS:%d): admx base address [%.4x]", cpu->clock, cpu->state, cpu->device.device_state, cpu->intermediate.argument_address_extended); 
-                            #endif
-                            cpu->state = CS_FETCH_SOURCE;
-                        }
-                        break;
-                    
-                    case ADMX_IND16:
-                        {
-                            cpu->intermediate.argument_address_extended = (uint8_t) cpu->intermediate.argument_data_raw[argument_index];
-                            argument_index ++;
-                            cpu->intermediate.argument_address_extended |= (cpu->intermediate.argument_data_raw[argument_index] << 8);
-                            argument_index ++;
-                            #ifdef _CPU_DEEP_DEBUG_
-                            log_msg(LP_DEBUG, "CPU (C:%d CS:%d DS:%d): admx base address [%.4x]", cpu->clock, cpu->state, cpu->device.device_state, cpu->intermediate.argument_address_extended);
-                            #endif
-                            cpu->state = CS_FETCH_SOURCE;
-                        }
-                        break;
-                    
-                    case ADMX_IND_R0_OFFSET16:
-                        {
-                            cpu->intermediate.argument_address_extended = (uint8_t) cpu->intermediate.argument_data_raw[argument_index];
-                            argument_index ++;
-                            cpu->intermediate.argument_address_extended |= (cpu->intermediate.argument_data_raw[argument_index] << 8);
-                            argument_index ++;
-                            ////log_msg_inline(LP_DEBUG, "CPU (C:%d CS:%d DS:%d): admx base address [%.4x + %.4x] = ", cpu->clock, cpu->state, cpu->device.device_state, cpu->intermediate.argument_address_extended, cpu->regs.r0);
-                            cpu->intermediate.argument_address_extended += cpu->regs.r0;
-                            //printf("[%.4x]\n", cpu->intermediate.argument_address_extended);
-                            cpu->state = CS_FETCH_SOURCE;
-                        }
-                        break;
-                    
-                    case ADMX_IND_R1_OFFSET16:
-                        {
-                            cpu->intermediate.argument_address_extended = (uint8_t) cpu->intermediate.argument_data_raw[argument_index];
-                            argument_index ++;
-                            cpu->intermediate.argument_address_extended |= (cpu->intermediate.argument_data_raw[argument_index] << 8);
-                            argument_index ++;
-                            ////log_msg_inline(LP_DEBUG, "CPU (C:%d CS:%d DS:%d): admx base address [%.4x + %.4x] = ", cpu->clock, cpu->state, cpu->device.device_state, cpu->intermediate.argument_address_extended, cpu->regs.r1);
-                            cpu->intermediate.argument_address_extended += cpu->regs.r1;
-                            //printf("[%.4x]\n", cpu->intermediate.argument_address_extended);
-                            cpu->state = CS_FETCH_SOURCE;
-                        }
-                        break;
-                    
-                    case ADMX_IND_R2_OFFSET16:
-                        {
-                            cpu->intermediate.argument_address_extended = (uint8_t) cpu->intermediate.argument_data_raw[argument_index];
-                            argument_index ++;
-                            cpu->intermediate.argument_address_extended |= (cpu->intermediate.argument_data_raw[argument_index] << 8);
-                            argument_index ++;
-                            ////log_msg_inline(LP_DEBUG, "CPU (C:%d CS:%d DS:%d): admx base address [%.4x + %.4x] = ", cpu->clock, cpu->state, cpu->device.device_state, cpu->intermediate.argument_address_extended, cpu->regs.r2);
-                            cpu->intermediate.argument_address_extended += cpu->regs.r2;
-                            //printf("[%.4x]\n", cpu->intermediate.argument_address_extended);
-                            cpu->state = CS_FETCH_SOURCE;
-                        }
-                        break;
-                    
-                    case ADMX_IND_R3_OFFSET16:
-                        {
-                            cpu->intermediate.argument_address_extended = (uint8_t) cpu->intermediate.argument_data_raw[argument_index];
-                            argument_index ++;
-                            cpu->intermediate.argument_address_extended |= (cpu->intermediate.argument_data_raw[argument_index] << 8);
-                            argument_index ++;
-                            ////log_msg_inline(LP_DEBUG, "CPU (C:%d CS:%d DS:%d): admx base address [%.4x + %.4x] = ", cpu->clock, cpu->state, cpu->device.device_state, cpu->intermediate.argument_address_extended, cpu->regs.r3);
-                            cpu->intermediate.argument_address_extended += cpu->regs.r3;
-                            //printf("[%.4x]\n", cpu->intermediate.argument_address_extended);
-                            cpu->state = CS_FETCH_SOURCE;
-                        }
-                        break;
-                    
-                    case ADMX_IND_SP_OFFSET16:
-                        {
-                            cpu->intermediate.argument_address_extended = (uint8_t) cpu->intermediate.argument_data_raw[argument_index];
-                            argument_index ++;
-                            cpu->intermediate.argument_address_extended |= (cpu->intermediate.argument_data_raw[argument_index] << 8);
-                            argument_index ++;
-                            ////log_msg_inline(LP_DEBUG, "CPU (C:%d CS:%d DS:%d): admx base address [%.4x + %.4x] = ", cpu->clock, cpu->state, cpu->device.device_state, cpu->intermediate.argument_address_extended, cpu->regs.sp);
-                            cpu->intermediate.argument_address_extended += cpu->regs.sp;
-                            //printf("[%.4x]\n", cpu->intermediate.argument_address_extended);
-                            cpu->state = CS_FETCH_SOURCE;
-                        }
-                        break;
-                    
-                    case ADMX_IND_PC_OFFSET16:
-                        {
-                            cpu->intermediate.argument_address_extended = (uint8_t) cpu->intermediate.argument_data_raw[argument_index];
-                            argument_index ++;
-                            cpu->intermediate.argument_address_extended |= (cpu->intermediate.argument_data_raw[argument_index] << 8);
-                            argument_index ++;
-                            ////log_msg_inline(LP_DEBUG, "CPU (C:%d CS:%d DS:%d): admx base address [%.4x + %.4x] = ", cpu->clock, cpu->state, cpu->device.device_state, cpu->intermediate.argument_address_extended, cpu->regs.pc);
-                            cpu->intermediate.argument_address_extended += cpu->regs.pc;
-                            //printf("[%.4x]\n", cpu->intermediate.argument_address_extended);
-                            cpu->state = CS_FETCH_SOURCE;
-                        }
-                        break;
-
-                    case ADMX_IND16_SCALED8_R0_OFFSET:
-                        {
-                            cpu->intermediate.argument_address_extended = (uint8_t) cpu->intermediate.argument_data_raw[argument_index];
-                            argument_index ++;
-                            cpu->intermediate.argument_address_extended |= (cpu->intermediate.argument_data_raw[argument_index] << 8);
-                            argument_index ++;
-                            uint8_t scaler = cpu->intermediate.argument_data_raw[argument_index];
-                            ////log_msg_inline(LP_DEBUG, "CPU (C:%d CS:%d DS:%d): admx base address [%.4x + %.2x * %.4x] = ", cpu->clock, cpu->state, cpu->device.device_state, cpu->intermediate.argument_address_extended, scaler, cpu->regs.r0);
-                            cpu->intermediate.argument_address_extended += scaler * cpu->regs.r0;
-                            //printf("[%.4x]\n", cpu->intermediate.argument_address_extended);
-                            cpu->state = CS_FETCH_SOURCE;
-                        }
-                        break;
-
-                    case ADMX_IND16_SCALED8_R1_OFFSET:
-                        {
-                            cpu->intermediate.argument_address_extended = (uint8_t) cpu->intermediate.argument_data_raw[argument_index];
-                            argument_index ++;
-                            cpu->intermediate.argument_address_extended |= (cpu->intermediate.argument_data_raw[argument_index] << 8);
-                            argument_index ++;
-                            uint8_t scaler = cpu->intermediate.argument_data_raw[argument_index];
-                            ////log_msg_inline(LP_DEBUG, "CPU (C:%d CS:%d DS:%d): admx base address [%.4x + %.2x * %.4x] = ", cpu->clock, cpu->state, cpu->device.device_state, cpu->intermediate.argument_address_extended, scaler, cpu->regs.r1);
-                            cpu->intermediate.argument_address_extended += scaler * cpu->regs.r1;
-                            //printf("[%.4x]\n", cpu->intermediate.argument_address_extended);
-                            cpu->state = CS_FETCH_SOURCE;
-                        }
-                        break;
-
-                    case ADMX_IND16_SCALED8_R2_OFFSET:
-                        {
-                            cpu->intermediate.argument_address_extended = (uint8_t) cpu->intermediate.argument_data_raw[argument_index];
-                            argument_index ++;
-                            cpu->intermediate.argument_address_extended |= (cpu->intermediate.argument_data_raw[argument_index] << 8);
-                            argument_index ++;
-                            uint8_t scaler = cpu->intermediate.argument_data_raw[argument_index];
-                            ////log_msg_inline(LP_DEBUG, "CPU (C:%d CS:%d DS:%d): admx base address [%.4x + %.2x * %.4x] = ", cpu->clock, cpu->state, cpu->device.device_state, cpu->intermediate.argument_address_extended, scaler, cpu->regs.r2);
-                            cpu->intermediate.argument_address_extended += scaler * cpu->regs.r2;
-                            //printf("[%.4x]\n", cpu->intermediate.argument_address_extended);
-                            cpu->state = CS_FETCH_SOURCE;
-                        }
-                        break;
-
-                    case ADMX_IND16_SCALED8_R3_OFFSET:
-                        {
-                            cpu->intermediate.argument_address_extended = (uint8_t) cpu->intermediate.argument_data_raw[argument_index];
-                            argument_index ++;
-                            cpu->intermediate.argument_address_extended |= (cpu->intermediate.argument_data_raw[argument_index] << 8);
-                            argument_index ++;
-                            uint8_t scaler = cpu->intermediate.argument_data_raw[argument_index];
-                            ////log_msg_inline(LP_DEBUG, "CPU (C:%d CS:%d DS:%d): admx base address [%.4x + %.2x * %.4x] = ", cpu->clock, cpu->state, cpu->device.device_state, cpu->intermediate.argument_address_extended, scaler, cpu->regs.r3);
-                            cpu->intermediate.argument_address_extended += scaler * cpu->regs.r3;
-                            //printf("[%.4x]\n", cpu->intermediate.argument_address_extended);
-                            cpu->state = CS_FETCH_SOURCE;
-                        }
-                        break;
-
-                    case ADMX_IND16_SCALED8_SP_OFFSET:
-                        {
-                            cpu->intermediate.argument_address_extended = (uint8_t) cpu->intermediate.argument_data_raw[argument_index];
-                            argument_index ++;
-                            cpu->intermediate.argument_address_extended |= (cpu->intermediate.argument_data_raw[argument_index] << 8);
-                            argument_index ++;
-                            uint8_t scaler = cpu->intermediate.argument_data_raw[argument_index];
-                            ////log_msg_inline(LP_DEBUG, "CPU (C:%d CS:%d DS:%d): admx base address [%.4x + %.2x * %.4x] = ", cpu->clock, cpu->state, cpu->device.device_state, cpu->intermediate.argument_address_extended, scaler, cpu->regs.sp);
-                            cpu->intermediate.argument_address_extended += scaler * cpu->regs.sp;
-                            //printf("[%.4x]\n", cpu->intermediate.argument_address_extended);
-                            cpu->state = CS_FETCH_SOURCE;
-                        }
-                        break;
-
-                    case ADMX_IND16_SCALED8_PC_OFFSET:
-                        {
-                            cpu->intermediate.argument_address_extended = (uint8_t) cpu->intermediate.argument_data_raw[argument_index];
-                            argument_index ++;
-                            cpu->intermediate.argument_address_extended |= (cpu->intermediate.argument_data_raw[argument_index] << 8);
-                            argument_index ++;
-                            uint8_t scaler = cpu->intermediate.argument_data_raw[argument_index];
-                            ////log_msg_inline(LP_DEBUG, "CPU (C:%d CS:%d DS:%d): admx base address [%.4x + %.2x * %.4x] = ", cpu->clock, cpu->state, cpu->device.device_state, cpu->intermediate.argument_address_extended, scaler, cpu->regs.pc);
-                            cpu->intermediate.argument_address_extended += scaler * cpu->regs.pc;
-                            //printf("[%.4x]\n", cpu->intermediate.argument_address_extended);
-                            cpu->state = CS_FETCH_SOURCE;
-                        }
-                        break;
-
-                    case ADMX_NONE:
-                        #ifdef _CPU_DEEP_DEBUG_
-                        log_msg(LP_DEBUG, "CPU (C:%d CS:%d DS:%d): no admx address specified", cpu->clock, cpu->state, cpu->device.device_state);
-                        #endif
-                        cpu->state = CS_FETCH_DESTINATION;
-                        break;
-
-                    default:
-                        #ifdef _CPU_DEEP_DEBUG_
-                        log_msg(LP_ERROR, "CPU (C:%d CS:%d DS:%d): unknown extended addressing mode [%s:%d]", cpu->clock, cpu->state, cpu->device.device_state, __FILE__, __LINE__);
-                        #endif
-                        break;
-                }
-                // We cant switch the oder of admr and admx to add goto skip-aheads, because of argument_index
-                #ifdef _CPU_DEEP_DEBUG_
-                log_msg(LP_INFO, "CPU (C:%d CS:%d DS:%d): admr %s", cpu->clock, cpu->state, cpu->device.device_state, cpu_reduced_addressing_mode_string[admr]);
-                #endif
-                switch (admr) {
-                    case ADMR_R0:
-                    case ADMR_R1:
-                    case ADMR_R2:
-                    case ADMR_R3:
-                    case ADMR_SP:
-                        #ifdef _CPU_DEEP_DEBUG_
-                        log_msg(LP_DEBUG, "CPU (C:%d CS:%d DS:%d): admr is not an address", cpu->clock, cpu->state, cpu->device.device_state, cpu->intermediate.argument_address_reduced);
-                        #endif
-                        break;
-
-                    case ADMR_IND16:
-                        cpu->intermediate.argument_address_reduced = (uint8_t) cpu->intermediate.argument_data_raw[argument_index];
-                        argument_index ++;
-                        cpu->intermediate.argument_address_reduced |= (cpu->intermediate.argument_data_raw[argument_index] << 8);
-                        //argument_index ++;
-                        #ifdef _CPU_DEEP_DEBUG_
-                        log_msg(LP_DEBUG, "CPU (C:%d CS:%d DS:%d): admr address [%.4x]", cpu->clock, cpu->state, cpu->device.device_state, cpu->intermediate.argument_address_reduced);
-                        #endif
-                        break;
-
-                    case ADMR_IND_R0:
-                        cpu->intermediate.argument_address_reduced = cpu->regs.r0;
-                        #ifdef _CPU_DEEP_DEBUG_
-                        log_msg(LP_DEBUG, "CPU (C:%d CS:%d DS:%d): admr address [%.4x]", cpu->clock, cpu->state, cpu->device.device_state, cpu->intermediate.argument_address_reduced);
-                        #endif
-                        break;
-
-                    case ADMR_NONE:
-                        #ifdef _CPU_DEEP_DEBUG_
-                        log_msg(LP_DEBUG, "CPU (C:%d CS:%d DS:%d): no admx address specified", cpu->clock, cpu->state, cpu->device.device_state);
-                        #endif
-                        //cpu->state = CS_FETCH_DESTINATION;
-                        break;
-
-                    default:
-                        #ifdef _CPU_DEEP_DEBUG_
-                        log_msg(LP_ERROR, "CPU (C:%d CS:%d DS:%d): unknown reduced addressing mode [%s:%d]", cpu->clock, cpu->state, cpu->device.device_state, __FILE__, __LINE__);
-                        #endif
-                        break;
+                    address = *cpu_register(cpu, admx - ADMX_IND_R0_OFFSET16) + cpu_immediate(decoded->argument_data_raw);
                 }
+                if (!cpu_fused_in_ram(address)) {break;}
+                cpu_fused_read16(cpu, address);     // lea fetches its source like any other two argument instruction
+                cpu->regs.r0 = address;
+                cpu->instruction += 2;
+                uint16_t value = cpu_fused_source(cpu, next_admx, next[0].argument_data_raw);
+                cpu_fused_read16(cpu, address);     // and so does the mov with its destination
+                cpu_fused_write16(cpu, address, value);
+                cpu->instruction ++;
+                goto FUSED;
             }
-            break;
 
-        case CS_FETCH_SOURCE: // only fetch data from source, nothing else
-            {
-                #ifdef _CPU_DEEP_DEBUG_
-                log_msg(LP_INFO, "CPU (C:%d CS:%d DS:%d): Fetching source (low) from adm address", cpu->clock, cpu->state, cpu->device.device_state);
-                #endif
-                cpu->regs.sr.MNI = 0;
-                int admxc = cpu_extended_addressing_mode_category[cpu->intermediate.addressing_mode.addressing_mode_extended];
-                switch (admxc) {
-                    case ADMC_IMM:
-                        {
-                            int admx = cpu->intermediate.addressing_mode.addressing_mode_extended;
-                            switch (admx) {
-                                case ADMX_IMM16:
-                                    #ifdef _CPU_DEEP_DEBUG_
-                                    log_msg(LP_DEBUG, "CPU (C:%d CS:%d DS:%d): IMM16", cpu->clock, cpu->state, cpu->device.device_state);
-                                    #endif
-                                    cpu->intermediate.data_address_extended = (uint8_t) cpu->intermediate.argument_data_raw[cpu->intermediate.argument_count_for_admr];
-                                    cpu->intermediate.data_address_extended |= (cpu->intermediate.argument_data_raw[cpu->intermediate.argument_count_for_admr + 1] << 8);
-                                    break;
-                                default:
-                                    #ifdef _CPU_DEEP_DEBUG_
-                                    log_msg(LP_ERROR, "CPU (C:%d CS:%d DS:%d): unknown immediate extended addressing mode [%s:%d]", cpu->clock, cpu->state, cpu->device.device_state, __FILE__, __LINE__);
-                                    #endif
-                                    break;
-                            }
-                            if (cpu->intermediate.argument_count == 2) {
-                                cpu->state = CS_FETCH_DESTINATION;
-                                goto CS_FETCH_DESTINATION;
-                            } else {
-                                #ifdef _CPU_DEEP_DEBUG_
-                                log_msg(LP_DEBUG, "CPU (C:%d CS:%d DS:%d): Skipping destination fetching, cause only one argument", cpu->clock, cpu->state, cpu->device.device_state);
-                                #endif
-                                cpu->state = CS_EXECUTE;
-                                goto CS_EXECUTE;
-                            }
-                            
-                        }
-                        break;
-                    case ADMC_REG:
-                        {
-                            int admx = cpu->intermediate.addressing_mode.addressing_mode_extended;
-                            switch (admx) {
-                                case ADMX_R0:
-                                    #ifdef _CPU_DEEP_DEBUG_
-                                    log_msg(LP_DEBUG, "CPU (C:%d CS:%d DS:%d): r0", cpu->clock, cpu->state, cpu->device.device_state);
-                                    #endif
-                                    cpu->intermediate.data_address_extended = cpu->regs.r0;
-                                    break;
-                                case ADMX_R1:
-                                    #ifdef _CPU_DEEP_DEBUG_
-                                    log_msg(LP_DEBUG, "CPU (C:%d CS:%d DS:%d): r1", cpu->clock, cpu->state, cpu->device.device_state);
-                                    #endif
-                                    cpu->intermediate.data_address_extended = cpu->regs.r1;
-                                    break;
-                                case ADMX_R2:
-                                    #ifdef _CPU_DEEP_DEBUG_
-                                    log_msg(LP_DEBUG, "CPU (C:%d CS:%d DS:%d): r2", cpu->clock, cpu->state, cpu->device.device_state);
-                                    #endif
-                                    cpu->intermediate.data_address_extended = cpu->regs.r2;
-                                    break;
-                                case ADMX_R3:
-                                    #ifdef _CPU_DEEP_DEBUG_
-                                    log_msg(LP_DEBUG, "CPU (C:%d CS:%d DS:%d): r3", cpu->clock, cpu->state, cpu->device.device_state);
-                                    #endif
-                                    cpu->intermediate.data_address_extended = cpu->regs.r3;
-                                    break;
-                                case ADMX_SP:
-                                    #ifdef _CPU_DEEP_DEBUG_
-                                    log_msg(LP_DEBUG, "CPU (C:%d CS:%d DS:%d): sp", cpu->clock, cpu->state, cpu->device.device_state);
-                                    #endif
-                                    cpu->intermediate.data_address_extended = cpu->regs.sp;
-                                    break;
-                                case ADMX_PC:
-                                    #ifdef _CPU_DEEP_DEBUG_
-                                    log_msg(LP_DEBUG, "CPU (C:%d CS:%d DS:%d): pc", cpu->clock, cpu->state, cpu->device.device_state);
-                                    #endif
-                                    cpu->intermediate.data_address_extended = cpu->intermediate.previous_pc;
-                                    break;
-                                    
-                                default:
-                                    #ifdef _CPU_DEEP_DEBUG_
-                                    log_msg(LP_ERROR, "CPU (C:%d CS:%d DS:%d): unknown register extended addressing mode [%s:%d]", cpu->clock, cpu->state, cpu->device.device_state, __FILE__, __LINE__);
-                                    #endif
-                                    break;
-                            }
-                            if (cpu->intermediate.argument_count == 2) {
-                                cpu->state = CS_FETCH_DESTINATION;
-                                goto CS_FETCH_DESTINATION;
-                            } else {
-                                #ifdef _CPU_DEEP_DEBUG_
-                                log_msg(LP_DEBUG, "CPU (C:%d CS:%d DS:%d): Skipping destination fetching, cause only one argument", cpu->clock, cpu->state, cpu->device.device_state);
-                                #endif
-                                cpu->state = CS_EXECUTE;
-                                goto CS_EXECUTE;
-                            }
-                        }
-                        break;
-                    case ADMC_IND:
-                        {
-                            uint8_t data;
-                            int success = cpu_read_memory(cpu, cpu->intermediate.argument_address_extended, &data);
-                            if (success) {
-                                cpu->intermediate.data_address_extended = (uint8_t) data;
-                                cpu->state = CS_FETCH_SOURCE_HIGH;
-                                goto CS_FETCH_SOURCE_HIGH;
-                            }
-                            break;
-                        }
-                    default:
-                        #ifdef _CPU_DEEP_DEBUG_
-                        log_msg(LP_ERROR, "CPU (C:%d CS:%d DS:%d): Unkown indirect extended addressing mode category %d [%s:%d]", cpu->clock, cpu->state, cpu->device.device_state, admxc, __FILE__, __LINE__);
-                        #endif
-                        break;
+        case CF_COMPARE_JUMP: {
+                // cmp/tst reg/imm; jcc/rjcc imm
+                uint16_t source = cpu_fused_source(cpu, admx, decoded->argument_data_raw);
+                if (decoded->instruction == CMP) {
+                    cpu_compare(cpu, *cpu_register(cpu, admr - ADMR_R0), source);
+                } else {
+                    cpu_test(cpu, source);
                 }
-            }
-            #ifdef _CPU_DEEP_DEBUG_
-            log_msg(LP_INFO, "CPU (C:%d CS:%d DS:%d): Intermediate data_address_extended %.4x", cpu->clock, cpu->state, cpu->device.device_state, cpu->intermediate.data_address_extended);
-            #endif
-            break;
-        
-        case CS_FETCH_SOURCE_HIGH: // only fetch data from source, nothing else
-            {
-                CS_FETCH_SOURCE_HIGH:
-                #ifdef _CPU_DEEP_DEBUG_
-                log_msg(LP_INFO, "CPU (C:%d CS:%d DS:%d): Fetching source high from adm address", cpu->clock, cpu->state, cpu->device.device_state);
-                #endif
-                cpu->regs.sr.MNI = 0;
-                int admc = cpu_extended_addressing_mode_category[cpu->intermediate.addressing_mode.addressing_mode_extended];
-                switch (admc) {
-                    case ADMC_IND:
-                        {
-                            uint8_t data;
-                            int success = cpu_read_memory(cpu, cpu->intermediate.argument_address_extended + 1, &data);
-                            if (success) {
-                                cpu->intermediate.data_address_extended |= (uint16_t)(data << 8);
-                                
-                                if (cpu->intermediate.argument_count == 2) {
-                                    cpu->state = CS_FETCH_DESTINATION;
-                                    goto CS_FETCH_DESTINATION;
-                                } else {
-                                    #ifdef _CPU_DEEP_DEBUG_
-                                    log_msg(LP_DEBUG, "CPU (C:%d CS:%d DS:%d): Skipping destination fetching, cause only one argument", cpu->clock, cpu->state, cpu->device.device_state);
-                                    #endif
-                                    cpu->state = CS_EXECUTE;
-                                    goto CS_EXECUTE;
-                                }
-                            }
-                            break;
-                        }
-                    default:
-                        #ifdef _CPU_DEEP_DEBUG_
-                        log_msg(LP_ERROR, "CPU (C:%d CS:%d DS:%d): Unkown indirect extended addressing mode category %d [%s:%d]", cpu->clock, cpu->state, cpu->device.device_state, admc, __FILE__, __LINE__);
-                        #endif
-                        break;
+                cpu->instruction ++;
+                int relative = next[0].instruction >= RJZ;
+                int condition = relative ? next[0].instruction - RJZ : next[0].instruction - JZ;
+                cpu_resolve_flags(cpu, 1 << (condition / 2));
+                int taken = ((cpu->regs.sr.value >> (condition / 2)) & 1) != (condition & 1);
+                if (cpu->branch_predictor) {
+                    uint16_t jump_pc = decoded->pc + decoded->length;
+                    uint16_t target = cpu_immediate(next[0].argument_data_raw);
+                    target = relative ? pc + target : target;
+                    cpu_branch_predictor_resolve(cpu->branch_predictor, jump_pc, next[0].instruction, target <= jump_pc, taken);
                 }
-            }
-            #ifdef _CPU_DEEP_DEBUG_
-            log_msg(LP_INFO, "CPU (C:%d CS:%d DS:%d): Intermediate data_address_extended %.4x", cpu->clock, cpu->state, cpu->device.device_state, cpu->intermediate.data_address_extended);
-            #endif
-            break;
-        
-        case CS_FETCH_DESTINATION: // only fetch data from destination, nothing else
-            {
-                CS_FETCH_DESTINATION:
-                #ifdef _CPU_DEEP_DEBUG_
-                log_msg(LP_INFO, "CPU (C:%d CS:%d DS:%d): Fetching destination from adm address", cpu->clock, cpu->state, cpu->device.device_state);
-                #endif
-                cpu->regs.sr.MNI = 0;
-                int admc = cpu_reduced_addressing_mode_category[cpu->intermediate.addressing_mode.addressing_mode_reduced];
-                switch (admc) {
-                    
-                    case ADMC_REG:
-                        {
-                            int admr = cpu->intermediate.addressing_mode.addressing_mode_reduced;
-                            switch (admr) {
-                                case ADMR_R0:
-                                    #ifdef _CPU_DEEP_DEBUG_
-                                    log_msg(LP_DEBUG, "CPU (C:%d CS:%d DS:%d): r0", cpu->clock, cpu->state, cpu->device.device_state);
-                                    #endif
-                                    cpu->intermediate.data_address_reduced = cpu->regs.r0;
-                                    break;
-                                case ADMR_R1:
-                                    #ifdef _CPU_DEEP_DEBUG_
-                                    log_msg(LP_DEBUG, "CPU (C:%d CS:%d DS:%d): r1", cpu->clock, cpu->state, cpu->device.device_state);
-                                    #endif
-                                    cpu->intermediate.data_address_reduced = cpu->regs.r1;
-                                    break;
-                                case ADMR_R2:
-                                    #ifdef _CPU_DEEP_DEBUG_
-                                    log_msg(LP_DEBUG, "CPU (C:%d CS:%d DS:%d): r2", cpu->clock, cpu->state, cpu->device.device_state);
-                                    #endif
-                                    cpu->intermediate.data_address_reduced = cpu->regs.r2;
-                                    break;
-                                case ADMR_R3:
-                                    #ifdef _CPU_DEEP_DEBUG_
-                                    log_msg(LP_DEBUG, "CPU (C:%d CS:%d DS:%d): r3", cpu->clock, cpu->state, cpu->device.device_state);
-                                    #endif
-                                    cpu->intermediate.data_address_reduced = cpu->regs.r3;
-                                    break;
-                                case ADMR_SP:
-                                    #ifdef _CPU_DEEP_DEBUG_
-                                    log_msg(LP_DEBUG, "CPU (C:%d CS:%d DS:%d): sp", cpu->clock, cpu->state, cpu->device.device_state);
-                                    #endif
-                                    cpu->intermediate.data_address_reduced = cpu->regs.sp;
-                                    break;
-
-                                default:
-                                    #ifdef _CPU_DEEP_DEBUG_
-                                    log_msg(LP_ERROR, "CPU (C:%d CS:%d DS:%d): unknown register extended addressing mode [%s:%d]", cpu->clock, cpu->state, cpu->device.device_state, __FILE__, __LINE__);
-                                    #endif
-                                    break;
-                            }
-                            cpu->state = CS_EXECUTE;
-                            goto CS_EXECUTE;
-                        }
-                        break;
-                    case ADMC_IND:
-                        {
-                            uint8_t data;
-                            int success = cpu_read_memory(cpu, cpu->intermediate.argument_address_reduced, &data);
-                            if (success) {
-                                cpu->intermediate.data_address_reduced = (uint8_t) data;
-                                cpu->state = CS_FETCH_DESTINATION_HIGH;
-                                goto CS_FETCH_DESTINATION_HIGH;
-                            }
-                            break;
-                        }
-                    default:
-                        #ifdef _CPU_DEEP_DEBUG_
-                        log_msg(LP_ERROR, "CPU (C:%d CS:%d DS:%d): Unkown indirect extended addressing mode category %d [%s:%d]", cpu->clock, cpu->state, cpu->device.device_state, admc, __FILE__, __LINE__);
-                        #endif
-                        cpu->state = CS_EXCEPTION;
-                        break;
+                if (taken) {
+                    uint16_t target = cpu_immediate(next[0].argument_data_raw);
+                    pc = relative ? pc + target : target;
                 }
+                cpu->instruction ++;
+                goto FUSED;
             }
-            #ifdef _CPU_DEEP_DEBUG_
-            log_msg(LP_INFO, "CPU (C:%d CS:%d DS:%d): Intermediate data_address_reduced %.4x", cpu->clock, cpu->state, cpu->device.device_state, cpu->intermediate.data_address_reduced);
-            #endif
-            break;
 
-        case CS_FETCH_DESTINATION_HIGH: // only fetch data from destination, nothing else
-            {
-                CS_FETCH_DESTINATION_HIGH:
-                #ifdef _CPU_DEEP_DEBUG_
-                log_msg(LP_INFO, "CPU (C:%d CS:%d DS:%d): Fetching destination from adm address", cpu->clock, cpu->state, cpu->device.device_state);
-                #endif
-                cpu->regs.sr.MNI = 0;
-                int admc = cpu_reduced_addressing_mode_category[cpu->intermediate.addressing_mode.addressing_mode_reduced];
-                switch (admc) {
-                    case ADMC_IND:
-                        {
-                            uint8_t data;
-                            int success = cpu_read_memory(cpu, cpu->intermediate.argument_address_reduced + 1, &data);
-                            if (success) {
-                                cpu->intermediate.data_address_reduced |= (uint16_t)(data << 8);
-                                cpu->state = CS_EXECUTE;
-                                goto CS_EXECUTE;
-                            }
-                            break;
-                        }
-                    default:
-                        #ifdef _CPU_DEEP_DEBUG_
-                        log_msg(LP_ERROR, "CPU (C:%d CS:%d DS:%d): Unkown indirect extended addressing mode category %d [%s:%d]", cpu->clock, cpu->state, cpu->device.device_state, admc, __FILE__, __LINE__);
-                        #endif
-                        break;
-                }
-            }
-            #ifdef _CPU_DEEP_DEBUG_
-            log_msg(LP_INFO, "CPU (C:%d CS:%d DS:%d): Intermediate data_address_reduced %.4x", cpu->clock, cpu->state, cpu->device.device_state, cpu->intermediate.data_address_reduced);
-            #endif
-            break;
-        
-        // =======================================================================================
-        case CS_EXECUTE: 
-            {
-                CS_EXECUTE:
-                #ifdef _CPU_DEEP_DEBUG_
-                log_msg(LP_INFO, "CPU (C:%d CS:%d DS:%d): Executing instruction and writing to intermediate result for possible writeback", cpu->clock, cpu->state, cpu->device.device_state);
-                #endif
-                cpu->regs.sr.MNI = 0;
-                switch (cpu->intermediate.instruction) {
-                    case NOP:
-                        cpu->instruction ++;
-                        cpu->state = CS_FETCH_INSTRUCTION;
-                        goto CS_FETCH_INSTRUCTION;
-                        break;
-                
-                    case MOV:
-                        cpu->intermediate.result = cpu->intermediate.data_address_extended;
-                        cpu->state = CS_WRITEBACK_LOW;
-                        goto CS_WRITEBACK_LOW;
-                        break;
-                
-                    case MOVB:
-                        cpu->intermediate.result = (cpu->intermediate.data_address_extended & 0x00ff) | (cpu->intermediate.data_address_extended << 8); // janky, just to get the behavior to be consistent between register and ram usage
-                        cpu->intermediate.argument_address_reduced -= 1;
-                        cpu->state = CS_WRITEBACK_HIGH;
-                        goto CS_WRITEBACK_HIGH;
-                        break;
-
-                    case PUSH:
-                        cpu->intermediate.result = cpu->intermediate.data_address_extended;
-                        cpu->state = CS_PUSH_HIGH;
-                        goto CS_PUSH_HIGH;
-                        break;
-                
-                    case PUSHB:
-                        cpu->intermediate.result = cpu->intermediate.data_address_extended;
-                        cpu->state = CS_PUSH_LOW;
-                        goto CS_PUSH_LOW;
-                        break;
-
-                    case POP:
-                        cpu->state = CS_POP_LOW;
-                        goto CS_POP_LOW;
-                        break;
-                
-                    case POPB:
-                        cpu->state = CS_POP_LOW;
-                        goto CS_POP_LOW;
-                        break;
-
-                    case PUSHSR:
-                        cpu->intermediate.result = cpu->regs.sr.value;
-                        cpu->state = CS_PUSH_HIGH;
-                        goto CS_PUSH_HIGH;
-                        break;
-
-                    case POPSR:
-                        cpu->intermediate.argument_address_reduced = cpu->regs.sp;
-                        cpu->state = CS_POPSR_LOW;
-                        goto CS_POPSR_LOW;
-                        break;
-                    
-                    
-                    case JMP:
-                        cpu->regs.pc = cpu->intermediate.data_address_extended;
-                        cpu->instruction ++;
-                        cpu->state = CS_FETCH_INSTRUCTION;
-                        goto CS_FETCH_INSTRUCTION;
-                        break;
-                    
-                    case JZ:
-                        if (cpu->regs.sr.Z) {
-                            cpu->regs.pc = cpu->intermediate.data_address_extended;
-                        }
-                        cpu->instruction ++;
-                        cpu->state = CS_FETCH_INSTRUCTION;
-                        goto CS_FETCH_INSTRUCTION;
-                        break;
-                    
-                    case JNZ:
-                        if (!cpu->regs.sr.Z) {
-                            cpu->regs.pc = cpu->intermediate.data_address_extended;
-                        }
-                        cpu->instruction ++;
-                        cpu->state = CS_FETCH_INSTRUCTION;
-                        goto CS_FETCH_INSTRUCTION;
-                        break;
-            
-                    case CALL:
-                        cpu->intermediate.result = cpu->regs.pc;
-                        cpu->regs.pc = cpu->intermediate.data_address_extended;
-                        cpu->state = CS_PUSH_HIGH;
-                        goto CS_PUSH_HIGH;
-                        break;
-                    
-                    case RET:
-                        cpu->intermediate.argument_address_reduced = cpu->regs.sp;
-                        cpu->state = CS_POP_LOW; // the part with writing to pc is taken care of in CS_POP_HIGH
-                        goto CS_POP_LOW;
-                        break;
-
-                    case CMP: {
-                            uint16_t a = cpu->intermediate.data_address_reduced;
-                            uint16_t b = cpu->intermediate.data_address_extended;
-                            cpu->regs.sr.Z = (a == b);
-                            cpu->regs.sr.FZ = (a == b || (((a & 0x7fff) == 0) && ((b & 0x7fff) == 0)));
-                            cpu->regs.sr.L = ((int16_t) a < (int16_t) b);
-                            cpu->regs.sr.UL = (a < b);
-                            cpu->regs.sr.FL = (float_from_f16(a) < float_from_f16(b));
-                            cpu->regs.sr.DL = (float_from_bf16(a) < float_from_bf16(b));
-                            cpu->regs.sr.LL = (long_long_from_fi16(a) < long_long_from_fi16(b));
-                            cpu->instruction ++;
-                            cpu->state = CS_FETCH_INSTRUCTION;
-                            goto CS_FETCH_INSTRUCTION;
-                        }
-                        break;
-                    
-                    case TST: {
-                            uint16_t value = cpu->intermediate.data_address_extended;
-                            cpu->regs.sr.Z = (value == 0);
-                            cpu->regs.sr.FZ = ((value & 0x7fff) == 0);
-                            cpu->regs.sr.L = ((value & 0x8000) != 0);
-                            cpu->instruction ++;
-                            cpu->state = CS_FETCH_INSTRUCTION;
-                            goto CS_FETCH_INSTRUCTION;
-                        }
-                        break;
-                
-                    case AND:
-                        cpu->intermediate.result = cpu->intermediate.data_address_reduced & cpu->intermediate.data_address_extended;
-                        //cpu_update_status_register(cpu, cpu->intermediate.result);
-                        cpu->state = CS_WRITEBACK_LOW;
-                        goto CS_WRITEBACK_LOW;
-                        break;
-                    
-                    case OR:
-                        cpu->intermediate.result = cpu->intermediate.data_address_reduced | cpu->intermediate.data_address_extended;
-                        //cpu_update_status_register(cpu, cpu->intermediate.result);
-                        cpu->state = CS_WRITEBACK_LOW;
-                        goto CS_WRITEBACK_LOW;
-                        break;
-                    
-                    case XOR:
-                        cpu->intermediate.result = cpu->intermediate.data_address_reduced ^ cpu->intermediate.data_address_extended;
-                        //cpu_update_status_register(cpu, cpu->intermediate.result);
-                        cpu->state = CS_WRITEBACK_LOW;
-                        goto CS_WRITEBACK_LOW;
-                        break;
-                    
-                    case NOT:
-                        cpu->intermediate.result = ~cpu->intermediate.data_address_reduced;
-                        //cpu_update_status_register(cpu, cpu->intermediate.result);
-                        cpu->state = CS_WRITEBACK_LOW;
-                        goto CS_WRITEBACK_LOW;
-                        break;
-
-                    case UBS: {
-                            int16_t shift = (int16_t) cpu->intermediate.data_address_extended;
-                            if (shift > 0) {
-                                cpu->intermediate.result = (cpu->intermediate.data_address_reduced >> shift);
-                            } else {
-                                cpu->intermediate.result = cpu->intermediate.data_address_reduced << (-shift);
-                            }
-                            //cpu_update_status_register(cpu, cpu->intermediate.result);
-                            cpu->state = CS_WRITEBACK_LOW;
-                            goto CS_WRITEBACK_LOW;
-                        }
-                        break;
-
-                    case SBS: {
-                            int16_t shift = (int16_t) cpu->intermediate.data_address_extended;
-                            if (shift > 0) {
-                                cpu->intermediate.result = (cpu->intermediate.data_address_reduced >> shift) | (0xffff << ((16 - shift) < 0 ? 0 : (16 - shift)));
-                            } else {
-                                cpu->intermediate.result = cpu->intermediate.data_address_reduced << (-shift);
-                            }
-                            //cpu_update_status_register(cpu, cpu->intermediate.result);
-                            cpu->state = CS_WRITEBACK_LOW;
-                            goto CS_WRITEBACK_LOW;
-                        }
-                        break;
-
-                    case INT:
-                        #ifdef _CPU_DEEP_DEBUG_
-                        log_msg(LP_ERROR, "CPU (C:%d CS:%d DS:%d): undefined instruction INT [%s:%d]", cpu->clock, cpu->state, cpu->device.device_state, __FILE__, __LINE__);
-                        #endif
-                        //printf("%c", cpu->intermediate.data_address_extended & 0xffff);
-                        //cpu->instruction ++;
-                        //cpu->state = CS_FETCH_INSTRUCTION;
-                        cpu->instruction ++;
-                        cpu->state = CS_INTERRUPT_PUSH_PC_HIGH;
-                        goto CS_INTERRUPT_PUSH_PC_HIGH;
-                        //cpu->intermediate.irq_id = ;
-                        break;
-
-                    case HLT:
-                        cpu->instruction ++;
-                        cpu->state = CS_HALT;
-                        break;
-
-                    case LEA:
-                        cpu->intermediate.result = cpu->intermediate.argument_address_extended;
-                        cpu->state = CS_WRITEBACK_LOW;
-                        goto CS_WRITEBACK_LOW;
-                        break;
-
-                    case ADD:
-                        cpu->intermediate.result = (int16_t) cpu->intermediate.data_address_reduced + (int16_t) cpu->intermediate.data_address_extended;
-                        cpu->regs.sr.AO = ((uint32_t) cpu->intermediate.data_address_reduced + (uint32_t) cpu->intermediate.data_address_extended) > 0xffff;
-                        //cpu_update_status_register(cpu, cpu->intermediate.result);
-                        cpu->state = CS_WRITEBACK_LOW;
-                        goto CS_WRITEBACK_LOW;
-                        break;
-
-                    case SUB:
-                        cpu->intermediate.result = (int16_t) cpu->intermediate.data_address_reduced - (int16_t) cpu->intermediate.data_address_extended;
-                        cpu->regs.sr.AO = ((int32_t) cpu->intermediate.data_address_reduced - (int32_t) cpu->intermediate.data_address_extended) < 0;
-                        //cpu_update_status_register(cpu, cpu->intermediate.result);
-                        cpu->state = CS_WRITEBACK_LOW;
-                        goto CS_WRITEBACK_LOW;
-                        break;
-
-                    case NEG:
-                        cpu->intermediate.result = ~cpu->intermediate.data_address_reduced + 1;
-                        //cpu_update_status_register(cpu, cpu->intermediate.result);
-                        cpu->state = CS_WRITEBACK_LOW;
-                        goto CS_WRITEBACK_LOW;
-                        break;
-
-                    case ABS: {
-                        cpu->intermediate.result = cpu->intermediate.data_address_reduced;
-                        if ((int16_t) cpu->intermediate.result < 0) {
-                            cpu->intermediate.result = ~cpu->intermediate.data_address_reduced + 1;
-                        }
-                        //cpu_update_status_register(cpu, cpu->intermediate.result);
-                        cpu->state = CS_WRITEBACK_LOW;
-                        goto CS_WRITEBACK_LOW;
-                        break;
-                    }
-
-                    case INC:
-                        cpu->intermediate.result = cpu->intermediate.data_address_reduced + 1;
-                        cpu->regs.sr.AO = cpu->intermediate.result == 0;
-                        //cpu_update_status_register(cpu, cpu->intermediate.result);
-                        cpu->state = CS_WRITEBACK_LOW;
-                        goto CS_WRITEBACK_LOW;
-                        break;
-
-                    case DEC:
-                        cpu->intermediate.result = cpu->intermediate.data_address_reduced - 1;
-                        cpu->regs.sr.AO = cpu->intermediate.result == 0xffff;
-                        //cpu_update_status_register(cpu, cpu->intermediate.result);
-                        cpu->state = CS_WRITEBACK_LOW;
-                        goto CS_WRITEBACK_LOW;
-                        break;
-
-                    case SSA: {
-                        int32_t tmp = (int32_t) ((int16_t) cpu->intermediate.data_address_reduced) + (int32_t) ((int16_t) cpu->intermediate.data_address_extended);
-                        cpu->intermediate.result = (tmp < (int32_t)((int16_t) 0x8000)) ? 0x8000 : ((tmp > (int16_t) 0x7fff) ? 0x7fff : tmp);
-                        cpu->regs.sr.AO = 0;
-                        //cpu_update_status_register(cpu, cpu->intermediate.result);
-                        cpu->state = CS_WRITEBACK_LOW;
-                        goto CS_WRITEBACK_LOW;
-                        break;
-                    }
-
-                    case SSS: {
-                        int32_t tmp = (int32_t) ((int16_t) cpu->intermediate.data_address_reduced) - (int32_t) ((int16_t) cpu->intermediate.data_address_extended);
-                        cpu->intermediate.result = (tmp < (int32_t)((int16_t) 0x8000)) ? 0x8000 : ((tmp > (int32_t)((int16_t) 0x7fff)) ? 0x7fff : tmp);
-                        cpu->regs.sr.AO = 0;
-                        //cpu_update_status_register(cpu, cpu->intermediate.result);
-                        cpu->state = CS_WRITEBACK_LOW;
-                        goto CS_WRITEBACK_LOW;
-                        break;
-                    }
-
-                    case SSM: {
-                        int32_t tmp = (int32_t) ((int16_t) cpu->intermediate.data_address_reduced) * (int32_t) ((int16_t) cpu->intermediate.data_address_extended);
-                        cpu->intermediate.result = (tmp < (int32_t)((int16_t) 0x8000)) ? 0x8000 : ((tmp > (int16_t) 0x7fff) ? 0x7fff : tmp);
-                        cpu->regs.sr.AO = 0;
-                        //cpu_update_status_register(cpu, cpu->intermediate.result);
-                        cpu->state = CS_WRITEBACK_LOW;
-                        goto CS_WRITEBACK_LOW;
-                        break;
-                    }
-                        
-                    case USA: {
-                        int32_t tmp = (int32_t) cpu->intermediate.data_address_reduced + (int32_t) cpu->intermediate.data_address_extended;
-                        cpu->intermediate.result = (tmp < 0) ? 0 : ((tmp > 0xffff) ? 0xffff : tmp);
-                        cpu->regs.sr.AO = 0;
-                        //cpu_update_status_register(cpu, cpu->intermediate.result);
-                        cpu->state = CS_WRITEBACK_LOW;
-                        goto CS_WRITEBACK_LOW;
-                        break;
-                    }
-
-                    case USS: {
-                        int32_t tmp = (int32_t) cpu->intermediate.data_address_reduced - (int32_t) cpu->intermediate.data_address_extended;
-                        cpu->intermediate.result = (tmp < 0) ? 0 : ((tmp > 0xffff) ? 0xffff : tmp);
-                        cpu->regs.sr.AO = 0;
-                        //cpu_update_status_register(cpu, cpu->intermediate.result);
-                        cpu->state = CS_WRITEBACK_LOW;
-                        goto CS_WRITEBACK_LOW;
-                        break;
-                    }
-
-                    case USM: {
-                        int32_t tmp = (int32_t) cpu->intermediate.data_address_reduced * (int32_t) cpu->intermediate.data_address_extended;
-                        cpu->intermediate.result = (tmp < 0) ? 0 : ((tmp > 0xffff) ? 0xffff : tmp);
-                        cpu->regs.sr.AO = 0;
-                        //cpu_update_status_register(cpu, cpu->intermediate.result);
-                        cpu->state = CS_WRITEBACK_LOW;
-                        goto CS_WRITEBACK_LOW;
-                        break;
-                    }
-
-                    case MUL:
-                        cpu->intermediate.result = (int16_t) cpu->intermediate.data_address_reduced * (int16_t) cpu->intermediate.data_address_extended;
-                        cpu->regs.sr.AO = ((uint32_t) cpu->intermediate.data_address_reduced * (uint32_t) cpu->intermediate.data_address_extended) > 0xffff;
-                        //cpu_update_status_register(cpu, cpu->intermediate.result);
-                        cpu->state = CS_WRITEBACK_LOW;
-                        goto CS_WRITEBACK_LOW;
-                        break;
-
-                    case DIV:
-                        if ((int16_t) cpu->intermediate.data_address_extended == 0) {
-                            cpu->intermediate.result = 0;
-                            cpu->regs.sr.AO = 1;
-                        } else {
-                            cpu->intermediate.result = (int16_t) cpu->intermediate.data_address_reduced / (int16_t) cpu->intermediate.data_address_extended;
-                        }
-                        //cpu_update_status_register(cpu, cpu->intermediate.result);
-                        cpu->state = CS_WRITEBACK_LOW;
-                        goto CS_WRITEBACK_LOW;
-                        break;
-
-                    case ADC:
-                        cpu->intermediate.result = (int16_t) cpu->intermediate.data_address_reduced + (int16_t) cpu->intermediate.data_address_extended + cpu->regs.sr.AO;
-                        cpu->regs.sr.AO = ((uint32_t) cpu->intermediate.data_address_reduced + (uint32_t) cpu->intermediate.data_address_extended) > 0xffff;
-                        //cpu_update_status_register(cpu, cpu->intermediate.result);
-                        cpu->state = CS_WRITEBACK_LOW;
-                        goto CS_WRITEBACK_LOW;
-                        break;
-
-                    case SBC:
-                        cpu->intermediate.result = (int16_t) cpu->intermediate.data_address_reduced - (int16_t) cpu->intermediate.data_address_extended - cpu->regs.sr.AO;
-                        cpu->regs.sr.AO = ((int32_t) cpu->intermediate.data_address_reduced - (int32_t) cpu->intermediate.data_address_extended) < 0;
-                        //cpu_update_status_register(cpu, cpu->intermediate.result);
-                        cpu->state = CS_WRITEBACK_LOW;
-                        goto CS_WRITEBACK_LOW;
-                        break;
-
-                    case JFZ:
-                        if (cpu->regs.sr.FZ) {
-                            cpu->regs.pc = cpu->intermediate.data_address_extended;
-                        }
-                        cpu->instruction ++;
-                        cpu->state = CS_FETCH_INSTRUCTION;
-                        goto CS_FETCH_INSTRUCTION;
-                        break;
-                    
-                    case JNFZ:
-                        if (!cpu->regs.sr.FZ) {
-                            cpu->regs.pc = cpu->intermediate.data_address_extended;
-                        }
-                        cpu->instruction ++;
-                        cpu->state = CS_FETCH_INSTRUCTION;
-                        goto CS_FETCH_INSTRUCTION;
-                        break;
-
-                    case JL:
-                        if (cpu->regs.sr.L) {
-                            cpu->regs.pc = cpu->intermediate.data_address_extended;
-                        }
-                        cpu->instruction ++;
-                        cpu->state = CS_FETCH_INSTRUCTION;
-                        goto CS_FETCH_INSTRUCTION;
-                        break;
-                    
-                    case JNL:
-                        if (!cpu->regs.sr.L) {
-                            cpu->regs.pc = cpu->intermediate.data_address_extended;
-                        }
-                        cpu->instruction ++;
-                        cpu->state = CS_FETCH_INSTRUCTION;
-                        goto CS_FETCH_INSTRUCTION;
-                        break;
-                    
-                    case JUL:
-                        if (cpu->regs.sr.UL) {
-                            cpu->regs.pc = cpu->intermediate.data_address_extended;
-                        }
-                        cpu->instruction ++;
-                        cpu->state = CS_FETCH_INSTRUCTION;
-                        goto CS_FETCH_INSTRUCTION;
-                        break;
-                    
-                    case JNUL:
-                        if (!cpu->regs.sr.UL) {
-                            cpu->regs.pc = cpu->intermediate.data_address_extended;
-                        }
-                        cpu->instruction ++;
-                        cpu->state = CS_FETCH_INSTRUCTION;
-                        goto CS_FETCH_INSTRUCTION;
-                        break;
-                    
-                    case JFL:
-                        if (cpu->regs.sr.FL) {
-                            cpu->regs.pc = cpu->intermediate.data_address_extended;
-                        }
-                        cpu->instruction ++;
-                        cpu->state = CS_FETCH_INSTRUCTION;
-                        goto CS_FETCH_INSTRUCTION;
-                        break;
-                    
-                    case JNFL:
-                        if (!cpu->regs.sr.FL) {
-                            cpu->regs.pc = cpu->intermediate.data_address_extended;
-                        }
-                        cpu->instruction ++;
-                        cpu->state = CS_FETCH_INSTRUCTION;
-                        goto CS_FETCH_INSTRUCTION;
-                        break;
-                    
-                    case JDL:
-                        if (cpu->regs.sr.DL) {
-                            cpu->regs.pc = cpu->intermediate.data_address_extended;
-                        }
-                        cpu->instruction ++;
-                        cpu->state = CS_FETCH_INSTRUCTION;
-                        goto CS_FETCH_INSTRUCTION;
-                        break;
-                    
-                    case JNDL:
-                        if (!cpu->regs.sr.DL) {
-                            cpu->regs.pc = cpu->intermediate.data_address_extended;
-                        }
-                        cpu->instruction ++;
-                        cpu->state = CS_FETCH_INSTRUCTION;
-                        goto CS_FETCH_INSTRUCTION;
-                        break;
-                    
-                    case JLL:
-                        if (cpu->regs.sr.LL) {
-                            cpu->regs.pc = cpu->intermediate.data_address_extended;
-                        }
-                        cpu->instruction ++;
-                        cpu->state = CS_FETCH_INSTRUCTION;
-                        goto CS_FETCH_INSTRUCTION;
-                        break;
-                    
-                    case JNLL:
-                        if (!cpu->regs.sr.LL) {
-                            cpu->regs.pc = cpu->intermediate.data_address_extended;
-                        }
-                        cpu->instruction ++;
-                        cpu->state = CS_FETCH_INSTRUCTION;
-                        goto CS_FETCH_INSTRUCTION;
-                        break;
-                    
-                    case JAO:
-                        if (cpu->regs.sr.AO) {
-                            cpu->regs.pc = cpu->intermediate.data_address_extended;
-                        }
-                        cpu->instruction ++;
-                        cpu->state = CS_FETCH_INSTRUCTION;
-                        goto CS_FETCH_INSTRUCTION;
-                        break;
-                    
-                    case JNAO:
-                        if (!cpu->regs.sr.AO) {
-                            cpu->regs.pc = cpu->intermediate.data_address_extended;
-                        }
-                        cpu->instruction ++;
-                        cpu->state = CS_FETCH_INSTRUCTION;
-                        goto CS_FETCH_INSTRUCTION;
-                        break;
-
-                    case CLZ:
-                        cpu->regs.sr.Z = 0;
-                        cpu->instruction ++;
-                        cpu->state = CS_FETCH_INSTRUCTION;
-                        goto CS_FETCH_INSTRUCTION;
-                        break;
-
-                    case SEZ:
-                        cpu->regs.sr.Z = 1;
-                        cpu->instruction ++;
-                        cpu->state = CS_FETCH_INSTRUCTION;
-                        goto CS_FETCH_INSTRUCTION;
-                        break;
-
-                    case CLFZ:
-                        cpu->regs.sr.FZ = 0;
-                        cpu->instruction ++;
-                        cpu->state = CS_FETCH_INSTRUCTION;
-                        goto CS_FETCH_INSTRUCTION;
-                        break;
-
-                    case SEFZ:
-                        cpu->regs.sr.FZ = 1;
-                        cpu->instruction ++;
-                        cpu->state = CS_FETCH_INSTRUCTION;
-                        goto CS_FETCH_INSTRUCTION;
-                        break;
-
-                    case CLL:
-                        cpu->regs.sr.L = 0;
-                        cpu->instruction ++;
-                        cpu->state = CS_FETCH_INSTRUCTION;
-                        goto CS_FETCH_INSTRUCTION;
-                        break;
-
-                    case SEL:
-                        cpu->regs.sr.L = 1;
-                        cpu->instruction ++;
-                        cpu->state = CS_FETCH_INSTRUCTION;
-                        goto CS_FETCH_INSTRUCTION;
-                        break;
-
-                    case CLUL:
-                        cpu->regs.sr.UL = 0;
-                        cpu->instruction ++;
-                        cpu->state = CS_FETCH_INSTRUCTION;
-                        goto CS_FETCH_INSTRUCTION;
-                        break;
-
-                    case SEUL:
-                        cpu->regs.sr.UL = 1;
-                        cpu->instruction ++;
-                        cpu->state = CS_FETCH_INSTRUCTION;
-                        goto CS_FETCH_INSTRUCTION;
-                        break;
-
-                    case CLFL:
-                        cpu->regs.sr.FL = 0;
-                        cpu->instruction ++;
-                        cpu->state = CS_FETCH_INSTRUCTION;
-                        goto CS_FETCH_INSTRUCTION;
-                        break;
-
-                    case SEFL:
-                        cpu->regs.sr.FL = 1;
-                        cpu->instruction ++;
-                        cpu->state = CS_FETCH_INSTRUCTION;
-                        goto CS_FETCH_INSTRUCTION;
-                        break;
-
-                    case CLDL:
-                        cpu->regs.sr.DL = 0;
-                        cpu->instruction ++;
-                        cpu->state = CS_FETCH_INSTRUCTION;
-                        goto CS_FETCH_INSTRUCTION;
-                        break;
-
-                    case SEDL:
-                        cpu->regs.sr.DL = 1;
-                        cpu->instruction ++;
-                        cpu->state = CS_FETCH_INSTRUCTION;
-                        goto CS_FETCH_INSTRUCTION;
-                        break;
-
-                    case CLLL:
-                        cpu->regs.sr.LL = 0;
-                        cpu->instruction ++;
-                        cpu->state = CS_FETCH_INSTRUCTION;
-                        goto CS_FETCH_INSTRUCTION;
-                        break;
-
-                    case SELL:
-                        cpu->regs.sr.LL = 1;
-                        cpu->instruction ++;
-                        cpu->state = CS_FETCH_INSTRUCTION;
-                        goto CS_FETCH_INSTRUCTION;
-                        break;
-
-                    case CLAO:
-                        cpu->regs.sr.AO = 0;
-                        cpu->instruction ++;
-                        cpu->state = CS_FETCH_INSTRUCTION;
-                        goto CS_FETCH_INSTRUCTION;
-                        break;
-
-                    case SEAO:
-                        cpu->regs.sr.AO = 1;
-                        cpu->instruction ++;
-                        cpu->state = CS_FETCH_INSTRUCTION;
-                        goto CS_FETCH_INSTRUCTION;
-                        break;
-
-                    case CLMI:
-                        cpu->regs.sr.MI = 0;
-                        cpu->instruction ++;
-                        cpu->state = CS_FETCH_INSTRUCTION;
-                        goto CS_FETCH_INSTRUCTION;
-                        break;
-
-                    case SEMI:
-                        cpu->regs.sr.MI = 1;
-                        cpu->instruction ++;
-                        cpu->state = CS_FETCH_INSTRUCTION;
-                        goto CS_FETCH_INSTRUCTION;
-                        break;
-
-                    case RJMP:
-                        cpu->regs.pc += (int16_t) cpu->intermediate.data_address_extended;
-                        cpu->instruction ++;
-                        cpu->state = CS_FETCH_INSTRUCTION;
-                        goto CS_FETCH_INSTRUCTION;
-                        break;
-
-                    case RJZ:
-                        if (cpu->regs.sr.Z) {
-                            cpu->regs.pc += (int16_t) cpu->intermediate.data_address_extended;
-                        }
-                        cpu->instruction ++;
-                        cpu->state = CS_FETCH_INSTRUCTION;
-                        goto CS_FETCH_INSTRUCTION;
-                        break;
-
-                    case RJNZ:
-                        if (!cpu->regs.sr.Z) {
-                            cpu->regs.pc += (int16_t) cpu->intermediate.data_address_extended;
-                        }
-                        cpu->instruction ++;
-                        cpu->state = CS_FETCH_INSTRUCTION;
-                        goto CS_FETCH_INSTRUCTION;
-                        break;
-
-                    case RJL:
-                        if (cpu->regs.sr.L) {
-                            cpu->regs.pc += (int16_t) cpu->intermediate.data_address_extended;
-                        }
-                        cpu->instruction ++;
-                        cpu->state = CS_FETCH_INSTRUCTION;
-                        goto CS_FETCH_INSTRUCTION;
-                        break;
-
-                    case RJNL:
-                        if (!cpu->regs.sr.L) {
-                            cpu->regs.pc += (int16_t) cpu->intermediate.data_address_extended;
-                        }
-                        cpu->instruction ++;
-                        cpu->state = CS_FETCH_INSTRUCTION;
-                        goto CS_FETCH_INSTRUCTION;
-                        break;
-
-                    case RJFZ:
-                        if (cpu->regs.sr.FZ) {
-                            cpu->regs.pc += (int16_t) cpu->intermediate.data_address_extended;
-                        }
-                        cpu->instruction ++;
-                        cpu->state = CS_FETCH_INSTRUCTION;
-                        goto CS_FETCH_INSTRUCTION;
-                        break;
-                    
-                    case RJNFZ:
-                        if (!cpu->regs.sr.FZ) {
-                            cpu->regs.pc += (int16_t) cpu->intermediate.data_address_extended;
-                        }
-                        cpu->instruction ++;
-                        cpu->state = CS_FETCH_INSTRUCTION;
-                        goto CS_FETCH_INSTRUCTION;
-                        break;
-                    
-                    case RJUL:
-                        if (cpu->regs.sr.UL) {
-                            cpu->regs.pc += (int16_t) cpu->intermediate.data_address_extended;
-                        }
-                        cpu->instruction ++;
-                        cpu->state = CS_FETCH_INSTRUCTION;
-                        goto CS_FETCH_INSTRUCTION;
-                        break;
-                    
-                    case RJNUL:
-                        if (!cpu->regs.sr.UL) {
-                            cpu->regs.pc += (int16_t) cpu->intermediate.data_address_extended;
-                        }
-                        cpu->instruction ++;
-                        cpu->state = CS_FETCH_INSTRUCTION;
-                        goto CS_FETCH_INSTRUCTION;
-                        break;
-                    
-                    case RJFL:
-                        if (cpu->regs.sr.FL) {
-                            cpu->regs.pc += (int16_t) cpu->intermediate.data_address_extended;
-                        }
-                        cpu->instruction ++;
-                        cpu->state = CS_FETCH_INSTRUCTION;
-                        goto CS_FETCH_INSTRUCTION;
-                        break;
-                    
-                    case RJNFL:
-                        if (!cpu->regs.sr.FL) {
-                            cpu->regs.pc += (int16_t) cpu->intermediate.data_address_extended;
-                        }
-                        cpu->instruction ++;
-                        cpu->state = CS_FETCH_INSTRUCTION;
-                        goto CS_FETCH_INSTRUCTION;
-                        break;
-                    
-                    case RJDL:
-                        if (cpu->regs.sr.DL) {
-                            cpu->regs.pc += (int16_t) cpu->intermediate.data_address_extended;
-                        }
-                        cpu->instruction ++;
-                        cpu->state = CS_FETCH_INSTRUCTION;
-                        goto CS_FETCH_INSTRUCTION;
-                        break;
-                    
-                    case RJNDL:
-                        if (!cpu->regs.sr.DL) {
-                            cpu->regs.pc += (int16_t) cpu->intermediate.data_address_extended;
-                        }
-                        cpu->instruction ++;
-                        cpu->state = CS_FETCH_INSTRUCTION;
-                        goto CS_FETCH_INSTRUCTION;
-                        break;
-                    
-                    case RJLL:
-                        if (cpu->regs.sr.LL) {
-                            cpu->regs.pc += (int16_t) cpu->intermediate.data_address_extended;
-                        }
-                        cpu->instruction ++;
-                        cpu->state = CS_FETCH_INSTRUCTION;
-                        goto CS_FETCH_INSTRUCTION;
-                        break;
-                    
-                    case RJNLL:
-                        if (!cpu->regs.sr.LL) {
-                            cpu->regs.pc += (int16_t) cpu->intermediate.data_address_extended;
-                        }
-                        cpu->instruction ++;
-                        cpu->state = CS_FETCH_INSTRUCTION;
-                        goto CS_FETCH_INSTRUCTION;
-                        break;
-                    
-                    case RJAO:
-                        if (cpu->regs.sr.AO) {
-                            cpu->regs.pc += (int16_t) cpu->intermediate.data_address_extended;
-                        }
-                        cpu->instruction ++;
-                        cpu->state = CS_FETCH_INSTRUCTION;
-                        goto CS_FETCH_INSTRUCTION;
-                        break;
-                    
-                    case RJNAO:
-                        if (!cpu->regs.sr.AO) {
-                            cpu->regs.pc += (int16_t) cpu->intermediate.data_address_extended;
-                        }
-                        cpu->instruction ++;
-                        cpu->state = CS_FETCH_INSTRUCTION;
-                        goto CS_FETCH_INSTRUCTION;
-                        break;
-                    
-                    case RCALL:
-                        cpu->intermediate.result = cpu->regs.pc;
-                        cpu->regs.pc += (int16_t) cpu->intermediate.data_address_extended;
-                        cpu->state = CS_PUSH_HIGH;
-                        goto CS_PUSH_HIGH;
-                        break;
-
-                    case CMOVZ:
-                        if (cpu->regs.sr.Z) {
-                            cpu->intermediate.result = cpu->intermediate.data_address_extended;
-                            cpu->state = CS_WRITEBACK_LOW;
-                            goto CS_WRITEBACK_LOW;
-                            break;
-                        }
-                        cpu->instruction ++;
-                        cpu->state = CS_FETCH_INSTRUCTION;
-                        goto CS_FETCH_INSTRUCTION;
-                        break;
-
-                    case CMOVNZ:
-                        if (!cpu->regs.sr.Z) {
-                            cpu->intermediate.result = cpu->intermediate.data_address_extended;
-                            cpu->state = CS_WRITEBACK_LOW;
-                            goto CS_WRITEBACK_LOW;
-                            break;
-                        }
-                        cpu->instruction ++;
-                        cpu->state = CS_FETCH_INSTRUCTION;
-                        goto CS_FETCH_INSTRUCTION;
-                        break;
-
-                    case CMOVFZ:
-                        if (cpu->regs.sr.FZ) {
-                            cpu->intermediate.result = cpu->intermediate.data_address_extended;
-                            cpu->state = CS_WRITEBACK_LOW;
-                            goto CS_WRITEBACK_LOW;
-                            break;
-                        }
-                        cpu->instruction ++;
-                        cpu->state = CS_FETCH_INSTRUCTION;
-                        goto CS_FETCH_INSTRUCTION;
-                        break;
-
-                    case CMOVNFZ:
-                        if (!cpu->regs.sr.FZ) {
-                            cpu->intermediate.result = cpu->intermediate.data_address_extended;
-                            cpu->state = CS_WRITEBACK_LOW;
-                            goto CS_WRITEBACK_LOW;
-                            break;
-                        }
-                        cpu->instruction ++;
-                        cpu->state = CS_FETCH_INSTRUCTION;
-                        goto CS_FETCH_INSTRUCTION;
-                        break;
-
-                    case CMOVL:
-                        if (cpu->regs.sr.L) {
-                            cpu->intermediate.result = cpu->intermediate.data_address_extended;
-                            cpu->state = CS_WRITEBACK_LOW;
-                            goto CS_WRITEBACK_LOW;
-                            break;
-                        }
-                        cpu->instruction ++;
-                        cpu->state = CS_FETCH_INSTRUCTION;
-                        goto CS_FETCH_INSTRUCTION;
-                        break;
-
-                    case CMOVNL:
-                        if (!cpu->regs.sr.L) {
-                            cpu->intermediate.result = cpu->intermediate.data_address_extended;
-                            cpu->state = CS_WRITEBACK_LOW;
-                            goto CS_WRITEBACK_LOW;
-                            break;
-                        }
-                        cpu->instruction ++;
-                        cpu->state = CS_FETCH_INSTRUCTION;
-                        goto CS_FETCH_INSTRUCTION;
-                        break;
-
-                    case CMOVUL:
-                        if (cpu->regs.sr.UL) {
-                            cpu->intermediate.result = cpu->intermediate.data_address_extended;
-                            cpu->state = CS_WRITEBACK_LOW;
-                            goto CS_WRITEBACK_LOW;
-                            break;
-                        }
-                        cpu->instruction ++;
-                        cpu->state = CS_FETCH_INSTRUCTION;
-                        goto CS_FETCH_INSTRUCTION;
-                        break;
-
-                    case CMOVNUL:
-                        if (!cpu->regs.sr.UL) {
-                            cpu->intermediate.result = cpu->intermediate.data_address_extended;
-                            cpu->state = CS_WRITEBACK_LOW;
-                            goto CS_WRITEBACK_LOW;
-                            break;
-                        }
-                        cpu->instruction ++;
-                        cpu->state = CS_FETCH_INSTRUCTION;
-                        goto CS_FETCH_INSTRUCTION;
-                        break;
-
-                    case CMOVFL:
-                        if (cpu->regs.sr.FL) {
-                            cpu->intermediate.result = cpu->intermediate.data_address_extended;
-                            cpu->state = CS_WRITEBACK_LOW;
-                            goto CS_WRITEBACK_LOW;
-                            break;
-                        }
-                        cpu->instruction ++;
-                        cpu->state = CS_FETCH_INSTRUCTION;
-                        goto CS_FETCH_INSTRUCTION;
-                        break;
-
-                    case CMOVNFL:
-                        if (!cpu->regs.sr.FL) {
-                            cpu->intermediate.result = cpu->intermediate.data_address_extended;
-                            cpu->state = CS_WRITEBACK_LOW;
-                            goto CS_WRITEBACK_LOW;
-                            break;
-                        }
-                        cpu->instruction ++;
-                        cpu->state = CS_FETCH_INSTRUCTION;
-                        goto CS_FETCH_INSTRUCTION;
-                        break;
-
-                    case CMOVDL:
-                        if (cpu->regs.sr.DL) {
-                            cpu->intermediate.result = cpu->intermediate.data_address_extended;
-                            cpu->state = CS_WRITEBACK_LOW;
-                            goto CS_WRITEBACK_LOW;
-                            break;
-                        }
-                        cpu->instruction ++;
-                        cpu->state = CS_FETCH_INSTRUCTION;
-                        goto CS_FETCH_INSTRUCTION;
-                        break;
-
-                    case CMOVNDL:
-                        if (!cpu->regs.sr.DL) {
-                            cpu->intermediate.result = cpu->intermediate.data_address_extended;
-                            cpu->state = CS_WRITEBACK_LOW;
-                            goto CS_WRITEBACK_LOW;
-                            break;
-                        }
-                        cpu->instruction ++;
-                        cpu->state = CS_FETCH_INSTRUCTION;
-                        goto CS_FETCH_INSTRUCTION;
-                        break;
-
-                    case CMOVLL:
-                        if (cpu->regs.sr.LL) {
-                            cpu->intermediate.result = cpu->intermediate.data_address_extended;
-                            cpu->state = CS_WRITEBACK_LOW;
-                            goto CS_WRITEBACK_LOW;
-                            break;
-                        }
-                        cpu->instruction ++;
-                        cpu->state = CS_FETCH_INSTRUCTION;
-                        goto CS_FETCH_INSTRUCTION;
-                        break;
-
-                    case CMOVNLL:
-                        if (!cpu->regs.sr.LL) {
-                            cpu->intermediate.result = cpu->intermediate.data_address_extended;
-                            cpu->state = CS_WRITEBACK_LOW;
-                            goto CS_WRITEBACK_LOW;
-                            break;
-                        }
-                        cpu->instruction ++;
-                        cpu->state = CS_FETCH_INSTRUCTION;
-                        goto CS_FETCH_INSTRUCTION;
-                        break;
-
-                    case CMOVAO:
-                        if (cpu->regs.sr.AO) {
-                            cpu->intermediate.result = cpu->intermediate.data_address_extended;
-                            cpu->state = CS_WRITEBACK_LOW;
-                            goto CS_WRITEBACK_LOW;
-                            break;
-                        }
-                        cpu->instruction ++;
-                        cpu->state = CS_FETCH_INSTRUCTION;
-                        goto CS_FETCH_INSTRUCTION;
-                        break;
-
-                    case CMOVNAO:
-                        if (!cpu->regs.sr.AO) {
-                            cpu->intermediate.result = cpu->intermediate.data_address_extended;
-                            cpu->state = CS_WRITEBACK_LOW;
-                            goto CS_WRITEBACK_LOW;
-                            break;
-                        }
-                        cpu->instruction ++;
-                        cpu->state = CS_FETCH_INSTRUCTION;
-                        goto CS_FETCH_INSTRUCTION;
-                        break;
-                        cpu->instruction ++;
-                        cpu->state = CS_FETCH_INSTRUCTION;
-                        goto CS_FETCH_INSTRUCTION;
-                        break;
-
-                    case CMOVMI:
-                        if (cpu->regs.sr.MI) {
-                            cpu->intermediate.result = cpu->intermediate.data_address_extended;
-                            cpu->state = CS_WRITEBACK_LOW;
-                            goto CS_WRITEBACK_LOW;
-                            break;
-                        }
-                        cpu->instruction ++;
-                        cpu->state = CS_FETCH_INSTRUCTION;
-                        goto CS_FETCH_INSTRUCTION;
-                        break;
-
-                    case CMOVNMI:
-                        if (!cpu->regs.sr.MI) {
-                            cpu->intermediate.result = cpu->intermediate.data_address_extended;
-                            cpu->state = CS_WRITEBACK_LOW;
-                            goto CS_WRITEBACK_LOW;
-                            break;
-                        }
-                        cpu->instruction ++;
-                        cpu->state = CS_FETCH_INSTRUCTION;
-                        goto CS_FETCH_INSTRUCTION;
-                        break;
-
-                    case CBI:
-                        cpu->intermediate.result = (int16_t) ((int8_t) cpu->intermediate.data_address_reduced);
-                        cpu->state = CS_WRITEBACK_LOW;
-                        goto CS_WRITEBACK_LOW;
-                        break;
-
-                    case ADDF:
-                        cpu->intermediate.result = f16_add(cpu->intermediate.data_address_reduced, cpu->intermediate.data_address_extended);
-                        //cpu_update_status_register(cpu, cpu->intermediate.result);
-                        cpu->state = CS_WRITEBACK_LOW;
-                        goto CS_WRITEBACK_LOW;
-                        break;
-
-                    case SUBF:
-                        cpu->intermediate.result = f16_sub(cpu->intermediate.data_address_reduced, cpu->intermediate.data_address_extended);
-                        //cpu_update_status_register(cpu, cpu->intermediate.result);
-                        cpu->state = CS_WRITEBACK_LOW;
-                        goto CS_WRITEBACK_LOW;
-                        break;
-
-                    case MULF:
-                        cpu->intermediate.result = f16_mult(cpu->intermediate.data_address_reduced, cpu->intermediate.data_address_extended);
-                        //cpu_update_status_register(cpu, cpu->intermediate.result);
-                        cpu->state = CS_WRITEBACK_LOW;
-                        goto CS_WRITEBACK_LOW;
-                        break;
-
-                    case DIVF:
-                        cpu->intermediate.result = f16_div(cpu->intermediate.data_address_reduced, cpu->intermediate.data_address_extended);
-                        //cpu_update_status_register(cpu, cpu->intermediate.result);
-                        cpu->state = CS_WRITEBACK_LOW;
-                        goto CS_WRITEBACK_LOW;
-                        break;
-
-                    case ADDD:
-                        cpu->intermediate.result = bf16_add(cpu->intermediate.data_address_reduced, cpu->intermediate.data_address_extended);
-                        //cpu_update_status_register(cpu, cpu->intermediate.result);
-                        cpu->state = CS_WRITEBACK_LOW;
-                        goto CS_WRITEBACK_LOW;
-                        break;
-
-                    case SUBD:
-                        cpu->intermediate.result = bf16_sub(cpu->intermediate.data_address_reduced, cpu->intermediate.data_address_extended);
-                        //cpu_update_status_register(cpu, cpu->intermediate.result);
-                        cpu->state = CS_WRITEBACK_LOW;
-                        goto CS_WRITEBACK_LOW;
-                        break;
-
-                    case MULD:
-                        cpu->intermediate.result = bf16_mult(cpu->intermediate.data_address_reduced, cpu->intermediate.data_address_extended);
-                        //cpu_update_status_register(cpu, cpu->intermediate.result);
-                        cpu->state = CS_WRITEBACK_LOW;
-                        goto CS_WRITEBACK_LOW;
-                        break;
-
-                    case DIVD:
-                        cpu->intermediate.result = bf16_div(cpu->intermediate.data_address_reduced, cpu->intermediate.data_address_extended);
-                        //cpu_update_status_register(cpu, cpu->intermediate.result);
-                        cpu->state = CS_WRITEBACK_LOW;
-                        goto CS_WRITEBACK_LOW;
-                        break;
-
-                    case ADDL:
-                        cpu->intermediate.result = fi16_add(cpu->intermediate.data_address_reduced, cpu->intermediate.data_address_extended);
-                        //cpu_update_status_register(cpu, cpu->intermediate.result);
-                        cpu->state = CS_WRITEBACK_LOW;
-                        goto CS_WRITEBACK_LOW;
-                        break;
-
-                    case SUBL:
-                        cpu->intermediate.result = fi16_sub(cpu->intermediate.data_address_reduced, cpu->intermediate.data_address_extended);
-                        //cpu_update_status_register(cpu, cpu->intermediate.result);
-                        cpu->state = CS_WRITEBACK_LOW;
-                        goto CS_WRITEBACK_LOW;
-                        break;
-
-                    case MULL:
-                        cpu->intermediate.result = fi16_mult(cpu->intermediate.data_address_reduced, cpu->intermediate.data_address_extended);
-                        //cpu_update_status_register(cpu, cpu->intermediate.result);
-                        cpu->state = CS_WRITEBACK_LOW;
-                        goto CS_WRITEBACK_LOW;
-                        break;
-
-                    case DIVL:
-                        cpu->intermediate.result = fi16_div(cpu->intermediate.data_address_reduced, cpu->intermediate.data_address_extended);
-                        //cpu_update_status_register(cpu, cpu->intermediate.result);
-                        cpu->state = CS_WRITEBACK_LOW;
-                        goto CS_WRITEBACK_LOW;
-                        break;
-
-                    case CIF:
-                        cpu->intermediate.result = f16_from_float((float) ((int16_t) cpu->intermediate.data_address_reduced));
-                        cpu->state = CS_WRITEBACK_LOW;
-                        goto CS_WRITEBACK_LOW;
-                        break;
-
-                    case CID:
-                        cpu->intermediate.result = bf16_from_float((float) ((int16_t) cpu->intermediate.data_address_reduced));
-                        cpu->state = CS_WRITEBACK_LOW;
-                        goto CS_WRITEBACK_LOW;
-                        break;
-
-                    case CIL:
-                        cpu->intermediate.result = fi16_from_int(((int) cpu->intermediate.data_address_reduced));
-                        cpu->state = CS_WRITEBACK_LOW;
-                        goto CS_WRITEBACK_LOW;
-                        break;
-
-                    case CFI:
-                        cpu->intermediate.result = (int16_t) float_from_f16(cpu->intermediate.data_address_reduced);
-                        cpu->state = CS_WRITEBACK_LOW;
-                        goto CS_WRITEBACK_LOW;
-                        break;
-
-                    case CFD:
-                        cpu->intermediate.result = bf16_from_float(float_from_f16(cpu->intermediate.data_address_reduced));
-                        cpu->state = CS_WRITEBACK_LOW;
-                        goto CS_WRITEBACK_LOW;
-                        break;
-
-                    case CFL:
-                        cpu->intermediate.result = fi16_from_long_long((long long int)(float_from_f16(cpu->intermediate.data_address_reduced)));
-                        cpu->state = CS_WRITEBACK_LOW;
-                        goto CS_WRITEBACK_LOW;
-                        break;
-
-                    case CDI:
-                        cpu->intermediate.result = (int16_t) float_from_bf16(cpu->intermediate.data_address_reduced);
-                        cpu->state = CS_WRITEBACK_LOW;
-                        goto CS_WRITEBACK_LOW;
-                        break;
-
-                    case CDF:
-                        cpu->intermediate.result = f16_from_float(float_from_bf16(cpu->intermediate.data_address_reduced));
-                        cpu->state = CS_WRITEBACK_LOW;
-                        goto CS_WRITEBACK_LOW;
-                        break;
-
-                    case CDL:
-                        cpu->intermediate.result = fi16_from_long_long((long long int)(float_from_bf16(cpu->intermediate.data_address_reduced)));
-                        cpu->state = CS_WRITEBACK_LOW;
-                        goto CS_WRITEBACK_LOW;
-                        break;
-
-                    case CLI:
-                        cpu->intermediate.result = (int16_t) int_from_fi16((fint16_t) cpu->intermediate.data_address_reduced);
-                        cpu->state = CS_WRITEBACK_LOW;
-                        goto CS_WRITEBACK_LOW;
-                        break;
-
-                    case CLF:
-                        cpu->intermediate.result = f16_from_float((float) int_from_fi16((fint16_t) cpu->intermediate.data_address_reduced));
-                        cpu->state = CS_WRITEBACK_LOW;
-                        goto CS_WRITEBACK_LOW;
-                        break;
-
-                    case CLD:
-                        cpu->intermediate.result = bf16_from_float((float) int_from_fi16((fint16_t) cpu->intermediate.data_address_reduced));
-                        cpu->state = CS_WRITEBACK_LOW;
-                        goto CS_WRITEBACK_LOW;
-                        break;
-
-                    case INV:
-                        cache_invalidate(cpu->cache);
-                        cpu->instruction ++;
-                        cpu->state = CS_FETCH_INSTRUCTION;
-                        goto CS_FETCH_INSTRUCTION;
-                        break;
-                    
-                    case FTC: {
-                        // doesnt even improve performance on optimal scenraios
-                        uint8_t data;
-                        int success = cpu_read_memory(cpu, cpu->intermediate.data_address_extended, &data);
-                        if (success) {
-                            cpu->instruction ++;
-                            cpu->state = CS_FETCH_INSTRUCTION;
-                            goto CS_FETCH_INSTRUCTION;
-                        }
-                        break;
-                    }
-
-                    case HWCLOCK:
-                        cpu->regs.r0 = cpu->clock & ((uint64_t) 0xffff << 0);
-                        cpu->regs.r1 = cpu->clock & ((uint64_t) 0xffff << 16);
-                        cpu->regs.r2 = cpu->clock & ((uint64_t) 0xffff << 32);
-                        cpu->regs.r3 = cpu->clock & ((uint64_t) 0xffff << 48);
-                        cpu->instruction ++;
-                        cpu->state = CS_FETCH_INSTRUCTION;
-                        goto CS_FETCH_INSTRUCTION;
-                        break;
-                    
-                    case HWINSTR:
-                        cpu->regs.r0 = cpu->instruction & ((uint64_t) 0xffff << 0);
-                        cpu->regs.r1 = cpu->instruction & ((uint64_t) 0xffff << 16);
-                        cpu->regs.r2 = cpu->instruction & ((uint64_t) 0xffff << 32);
-                        cpu->regs.r3 = cpu->instruction & ((uint64_t) 0xffff << 48);
-                        cpu->instruction ++;
-                        cpu->state = CS_FETCH_INSTRUCTION;
-                        goto CS_FETCH_INSTRUCTION;
-                        break;
-                    
-                    case HWSLEEP:
-                        cpu->state = CS_SLEEP;
-                        goto CS_SLEEP;
-                        break;
-                    
-                    // Extended instructions
-
-                    case EXTNOP:
-                        cpu->instruction ++;
-                        cpu->state = CS_FETCH_INSTRUCTION;
-                        goto CS_FETCH_INSTRUCTION;
-                        break;
-
-                    case EXTNOP2:
-                        cpu->instruction ++;
-                        cpu->state = CS_FETCH_INSTRUCTION;
-                        goto CS_FETCH_INSTRUCTION;
-                        break;
-
-                    default:
-                        #ifdef _CPU_DEEP_DEBUG_
-                        log_msg(LP_ERROR, "CPU (C:%d CS:%d DS:%d): Unknown instruction [%d] [%s:%d]", cpu->clock, cpu->state, cpu->device.device_state, cpu->intermediate.instruction, __FILE__, __LINE__);
-                        #endif
-                        cpu->instruction ++;
-                        cpu->state = CS_EXCEPTION;
-                        break;
-                }
-                #ifdef _CPU_DEEP_DEBUG_
-                log_msg(LP_INFO, "CPU (C:%d CS:%d DS:%d): intermediate result: 0x%.4x", cpu->clock, cpu->state, cpu->device.device_state, cpu->intermediate.result);
-                #endif
-            }
-            break;
-        // =======================================================================================
-        
-        case CS_WRITEBACK_LOW: 
-            {
-                CS_WRITEBACK_LOW:
-                #ifdef _CPU_DEEP_DEBUG_
-                log_msg(LP_INFO, "CPU (C:%d CS:%d DS:%d): Writing low result back to cpu/memory", cpu->clock, cpu->state, cpu->device.device_state);
-                #endif
-                cpu->regs.sr.MNI = 1;
-                switch (cpu_reduced_addressing_mode_category[cpu->intermediate.addressing_mode.addressing_mode_reduced]) {
-                    case ADMC_IND:
-                        {
-                            int success = cpu_write_memory(cpu, cpu->intermediate.argument_address_reduced, (uint8_t) (cpu->intermediate.result & 0x00ff));
-                            if (success) {
-                                cpu->state = CS_WRITEBACK_HIGH;
-                                goto CS_WRITEBACK_HIGH;
-                            }
-                        }
-                        break;
-
-                    case ADMC_REG:
-                        switch (cpu->intermediate.addressing_mode.addressing_mode_reduced) {
-                            case ADMR_R0:
-                                cpu->regs.r0 = (cpu->regs.r0 & 0x00ff) | (cpu->intermediate.result & 0xff00);
-                                break;
-                            case ADMR_R1:
-                                cpu->regs.r1 = (cpu->regs.r1 & 0x00ff) | (cpu->intermediate.result & 0xff00);
-                                break;
-                            case ADMR_R2:
-                                cpu->regs.r2 = (cpu->regs.r2 & 0x00ff) | (cpu->intermediate.result & 0xff00);
-                                break;
-                            case ADMR_R3:
-                                cpu->regs.r3 = (cpu->regs.r3 & 0x00ff) | (cpu->intermediate.result & 0xff00);
-                                break;
-                            case ADMR_SP:
-                                cpu->regs.sp = (cpu->regs.sp & 0x00ff) | (cpu->intermediate.result & 0xff00);
-                                break;
-                            default:
-                                break;
-                        }
-                        cpu->instruction ++;
-                        cpu->state = CS_WRITEBACK_HIGH;
-                        goto CS_WRITEBACK_HIGH;
-                        break;
-
-                    case ADMC_NONE:
-                        // Here if writeback happens to admx instead of admr
-                        #ifdef _CPU_DEEP_DEBUG_
-                        log_msg(LP_NOTICE, "CPU (C:%d CS:%d DS:%d): Writeback to ADMX instead of ADMR", cpu->clock, cpu->state, cpu->device.device_state);
-                        #endif
-                        break;
-
-                    default:
-                        #ifdef _CPU_DEEP_DEBUG_
-                        log_msg(LP_ERROR, "CPU (C:%d CS:%d DS:%d): Unkown addressing mode category %d [%s:%d]", cpu->clock, cpu->state, cpu->device.device_state, cpu->intermediate.addressing_mode.addressing_mode_reduced, __FILE__, __LINE__);
-                        #endif
-                        cpu->state = CS_EXCEPTION;
-                        break;
-                }
-            }
-            break;
-        
-        case CS_WRITEBACK_HIGH: 
-            {
-                CS_WRITEBACK_HIGH:
-                #ifdef _CPU_DEEP_DEBUG_
-                log_msg(LP_INFO, "CPU (C:%d CS:%d DS:%d): Writing high result back to memory", cpu->clock, cpu->state, cpu->device.device_state);
-                #endif
-                cpu->regs.sr.MNI = 1;
-                switch (cpu_reduced_addressing_mode_category[cpu->intermediate.addressing_mode.addressing_mode_reduced]) {
-                    case ADMC_IND:
-                        {
-                            int success = cpu_write_memory(cpu, cpu->intermediate.argument_address_reduced + 1, (uint8_t) ((cpu->intermediate.result & 0xff00) >> 8));
-                            if (success) {
-                                cpu->instruction ++;
-                                cpu->state = CS_FETCH_INSTRUCTION;
-                                goto CS_FETCH_INSTRUCTION;
-                            }
-                        }
-                        break;
-
-                    case ADMC_REG:
-                        // TODO: switch case and write to register
-                        switch (cpu->intermediate.addressing_mode.addressing_mode_reduced) {
-                            case ADMR_R0:
-                                cpu->regs.r0 = (cpu->regs.r0 & 0xff00) | (cpu->intermediate.result & 0x00ff);
-                                break;
-                            case ADMR_R1:
-                                cpu->regs.r1 = (cpu->regs.r1 & 0xff00) | (cpu->intermediate.result & 0x00ff);
-                                break;
-                            case ADMR_R2:
-                                cpu->regs.r2 = (cpu->regs.r2 & 0xff00) | (cpu->intermediate.result & 0x00ff);
-                                break;
-                            case ADMR_R3:
-                                cpu->regs.r3 = (cpu->regs.r3 & 0xff00) | (cpu->intermediate.result & 0x00ff);
-                                break;
-                            case ADMR_SP:
-                                cpu->regs.sp = (cpu->regs.sp & 0xff00) | (cpu->intermediate.result & 0x00ff);
-                                break;
-                            default:
-                                break;
-                        }
-                        cpu->instruction ++;
-                        cpu->state = CS_FETCH_INSTRUCTION;
-                        goto CS_FETCH_INSTRUCTION;
-                        break;
-                    
-                    case ADMC_IMM:
-                    case ADMC_NONE:
-                    default:
-                        #ifdef _CPU_DEEP_DEBUG_
-                        log_msg(LP_ERROR, "CPU (C:%d CS:%d DS:%d): Unkown addressing mode category %d [%s:%d]", cpu->clock, cpu->state, cpu->device.device_state, cpu->intermediate.argument_address_reduced, __FILE__, __LINE__);
-                        #endif
-                        break;
-                }
-            }
-            break;
-        
-        case CS_PUSH_HIGH: 
-            {
-                CS_PUSH_HIGH:
-                #ifdef _CPU_DEEP_DEBUG_
-                log_msg(LP_INFO, "CPU (C:%d CS:%d DS:%d): Pushing low result", cpu->clock, cpu->state, cpu->device.device_state);
-                #endif
-                cpu->regs.sr.MNI = 1;
-                int success = cpu_write_memory(cpu, cpu->regs.sp - 1, (uint8_t) ((cpu->intermediate.result & 0xff00) >> 8));
-                if (success) {
-                    cpu->regs.sp --;
-                    cpu->state = CS_PUSH_LOW;
-                    goto CS_PUSH_LOW;
-                }
-            }
-            break;
-        
-        case CS_PUSH_LOW: 
-            {   
-                CS_PUSH_LOW:
-                #ifdef _CPU_DEEP_DEBUG_
-                log_msg(LP_INFO, "CPU (C:%d CS:%d DS:%d): Pushing high result", cpu->clock, cpu->state, cpu->device.device_state);
-                #endif
-                cpu->regs.sr.MNI = 1;
-                int success = cpu_write_memory(cpu, cpu->regs.sp - 1, (uint8_t) (cpu->intermediate.result & 0x00ff));
-                if (success) {
-                    cpu->regs.sp --;
-                    cpu->instruction ++;
-                    cpu->state = CS_FETCH_INSTRUCTION;
-                    goto CS_FETCH_INSTRUCTION;
-                }
-            }
-            break;
-        
-        case CS_POP_LOW: 
-            {
-                CS_POP_LOW:
-                #ifdef _CPU_DEEP_DEBUG_
-                log_msg(LP_INFO, "CPU (C:%d CS:%d DS:%d): Popping low result", cpu->clock, cpu->state, cpu->device.device_state);
-                #endif
-                cpu->regs.sr.MNI = 1;
-                uint8_t data;
-                int success = cpu_read_memory(cpu, cpu->regs.sp, &data);
-                if (success) {
-                    cpu->regs.sp ++;
-                    cpu->intermediate.result = data;
-                    #ifdef _CPU_DEEP_DEBUG_
-                    log_msg(LP_DEBUG, "CPU (C:%d CS:%d DS:%d): intermediate result: %.4x", cpu->clock, cpu->state, cpu->device.device_state, cpu->intermediate.result);
-                    #endif
-                    if (cpu->intermediate.instruction == POPB) {
-                        cpu->state = CS_WRITEBACK_LOW;
-                        goto CS_WRITEBACK_LOW;
-                    }
-                    cpu->state = CS_POP_HIGH;
-                    goto CS_POP_HIGH;
-                }
-            }
-            break;
-        
-        case CS_POP_HIGH: 
-            {   
-                CS_POP_HIGH:
-                #ifdef _CPU_DEEP_DEBUG_
-                log_msg(LP_INFO, "CPU (C:%d CS:%d DS:%d): Popping high result", cpu->clock, cpu->state, cpu->device.device_state);
-                #endif
-                cpu->regs.sr.MNI = 1;
-                uint8_t data;
-                int success = cpu_read_memory(cpu, cpu->regs.sp, &data);
-                if (success) {
-                    cpu->regs.sp ++;
-                    cpu->intermediate.result |= (uint16_t) (data << 8);
-                    #ifdef _CPU_DEEP_DEBUG_
-                    log_msg(LP_DEBUG, "CPU (C:%d CS:%d DS:%d): intermediate result: %.4x", cpu->clock, cpu->state, cpu->device.device_state, cpu->intermediate.result);
-                    #endif
-                    if (cpu->intermediate.instruction == RET) {
-                        cpu->regs.pc = cpu->intermediate.result;
-                        cpu->instruction ++;
-                        cpu->state = CS_FETCH_INSTRUCTION;
-                        goto CS_FETCH_INSTRUCTION;
-                    } else {
-                        cpu->state = CS_WRITEBACK_LOW;
-                        goto CS_WRITEBACK_LOW;
-                    }
-                }
-            }
-            break;
-        
-        case CS_POPSR_LOW: 
-            {
-                CS_POPSR_LOW:
-                #ifdef _CPU_DEEP_DEBUG_
-                log_msg(LP_INFO, "CPU (C:%d CS:%d DS:%d): Popping low result", cpu->clock, cpu->state, cpu->device.device_state);
-                #endif
-                cpu->regs.sr.MNI = 1;
-                uint8_t data;
-                int success = cpu_read_memory(cpu, cpu->regs.sp, &data);
-                if (success) {
-                    cpu->regs.sp ++;
-                    cpu->regs.sr.value = (uint8_t) data;
-                    #ifdef _CPU_DEEP_DEBUG_
-                    log_msg(LP_DEBUG, "CPU (C:%d CS:%d DS:%d): intermediate result: %.4x", cpu->clock, cpu->state, cpu->device.device_state, cpu->intermediate.result);
-                    #endif
-                    cpu->state = CS_POPSR_HIGH;
-                    goto CS_POPSR_HIGH;
-                }
-            }
-            break;
-        
-        case CS_POPSR_HIGH: 
-            {   
-                CS_POPSR_HIGH:
-                #ifdef _CPU_DEEP_DEBUG_
-                log_msg(LP_INFO, "CPU (C:%d CS:%d DS:%d): Popping high result", cpu->clock, cpu->state, cpu->device.device_state);
-                #endif
-                cpu->regs.sr.MNI = 1;
-                uint8_t data;
-                int success = cpu_read_memory(cpu, cpu->regs.sp, &data);
-                if (success) {
-                    cpu->regs.sp ++;
-                    cpu->regs.sr.value |= (uint16_t) (data << 8);
-                    #ifdef _CPU_DEEP_DEBUG_
-                    log_msg(LP_DEBUG, "CPU (C:%d CS:%d DS:%d): intermediate result: %.4x", cpu->clock, cpu->state, cpu->device.device_state, cpu->intermediate.result);
-                    #endif
-                    cpu->state = CS_FETCH_INSTRUCTION;
-                    goto CS_FETCH_INSTRUCTION;
-                }
-            }
-            break;
-        
-        case CS_INTERRUPT_PUSH_PC_HIGH:
-            {
-                CS_INTERRUPT_PUSH_PC_HIGH:
-                #ifdef _CPU_DEEP_DEBUG_
-                log_msg(LP_INFO, "CPU (C:%d CS:%d DS:%d): Interrupt push pc high", cpu->clock, cpu->state, cpu->device.device_state);
-                #endif
-                cpu->regs.sr.MNI = 1;
-                int success = cpu_write_memory(cpu, cpu->regs.sp - 1, (uint8_t) ((cpu->regs.pc & 0xff00) >> 8));
-                if (success) {
-                    cpu->regs.sp --;
-                    cpu->state = CS_INTERRUPT_PUSH_PC_LOW;
-                    goto CS_INTERRUPT_PUSH_PC_LOW;
-                }
-            }
-            break;
-        
-        case CS_INTERRUPT_PUSH_PC_LOW:
-            {   
-                CS_INTERRUPT_PUSH_PC_LOW:
-                #ifdef _CPU_DEEP_DEBUG_
-                log_msg(LP_INFO, "CPU (C:%d CS:%d DS:%d): Interrupt push pc low", cpu->clock, cpu->state, cpu->device.device_state);
-                #endif
-                cpu->regs.sr.MNI = 1;
-                int success = cpu_write_memory(cpu, cpu->regs.sp - 1, (uint8_t) (cpu->regs.pc & 0x00ff));
-                if (success) {
-                    cpu->regs.sp --;
-                    cpu->state = CS_INTERRUPT_FETCH_IRQ_VECTOR_LOW;
-                    goto CS_INTERRUPT_FETCH_IRQ_VECTOR_LOW;
-                }
-            }
-            break;
-    
-        case CS_INTERRUPT_FETCH_IRQ_VECTOR_LOW:
-            {
-                CS_INTERRUPT_FETCH_IRQ_VECTOR_LOW:
-                #ifdef _CPU_DEEP_DEBUG_
-                log_msg(LP_INFO, "CPU (C:%d CS:%d DS:%d): Interrupt fetch irq vector low (0x%.4x)", cpu->clock, cpu->state, cpu->device.device_state, SEGMENT_IRQ_TABLE + cpu->intermediate.irq_id * 2);
-                #endif
-                cpu->regs.sr.MNI = 1;
-                uint8_t data;
-                int success = cpu_read_memory(cpu, SEGMENT_IRQ_TABLE + cpu->intermediate.irq_id * 2, &data);
-                if (success) {
-                    cpu->intermediate.data_address_extended = (uint8_t) data;
-                    cpu->state = CS_INTERRUPT_FETCH_IRQ_VECTOR_HIGH;
-                    goto CS_INTERRUPT_FETCH_IRQ_VECTOR_HIGH;
-                }
-            }
-            break;
-    
-        case CS_INTERRUPT_FETCH_IRQ_VECTOR_HIGH:
-            {
-                CS_INTERRUPT_FETCH_IRQ_VECTOR_HIGH:
-                #ifdef _CPU_DEEP_DEBUG_
-                log_msg(LP_INFO, "CPU (C:%d CS:%d DS:%d): Interrupt fetch irq vector high (0x%.4x)", cpu->clock, cpu->state, cpu->device.device_state, SEGMENT_IRQ_TABLE + cpu->intermediate.irq_id * 2);
-                #endif
-                cpu->regs.sr.MNI = 1;
-                uint8_t data;
-                int success = cpu_read_memory(cpu, SEGMENT_IRQ_TABLE + cpu->intermediate.irq_id * 2 + 1, &data);
-                if (success) {
-                    cpu->intermediate.data_address_extended |= ((uint16_t) data) << 8;
-                    cpu->regs.pc = cpu->intermediate.data_address_extended;
-                    cpu->state = CS_FETCH_INSTRUCTION;
-                    goto CS_FETCH_INSTRUCTION;
-                }
+        case CF_PROLOGUE: {
+                // push rX; mov rX, sp; sub sp, imm
+                if (!cpu_fused_in_ram(cpu->regs.sp - 2)) {break;}
+                uint16_t* frame = cpu_register(cpu, admx - ADMX_R0);
+                cpu_fused_push16(cpu, *frame);
+                cpu->instruction ++;
+                *frame = cpu->regs.sp;
+                cpu->instruction += 2;
+                uint16_t a = cpu->regs.sp;
+                uint16_t b = cpu_immediate(next[1].argument_data_raw);
+                cpu->regs.sp = a - b;
+                cpu->regs.sr.AO = ((int32_t) a - (int32_t) b) < 0;
+                cpu->instruction += 2;
+                followers = 2;
+                goto FUSED;
             }
+
+        default:
             break;
+    }
+    decode_cache->fusion_fallback ++;
+    return 0;
 
-        case CS_HALT: 
-            {
-                cpu->regs.sr.MNI = 1;
-                if (!halted) {
-                    halted = 1;
-                }
-                //exit(1);
-                break;
-            }
+    FUSED:
+    cpu->regs.sr.NC = 0;
+    cpu->regs.pc = pc;
+    int cycles = cpu_fused_cycles(decoded->instruction);
+    for (int i = 0; i < followers; i++) {
+        cycles += cpu_fused_cycles(next[i].instruction);
+    }
+    cpu->clock += cycles;
+    cpu->last_instruction = (CPU_INSTRUCTION_MNEMONIC_t) next[followers - 1].instruction;
+    decode_cache->hit += followers;     // the lookups the single instructions would have done
+    decode_cache->fused[decoded->fusion] ++;
+    decode_cache->fused_instructions += 1 + followers;
+    return 1;
+}
 
-        case CS_SLEEP: 
-            {
-                CS_SLEEP:
-                #ifdef _CPU_DEEP_DEBUG_
-                log_msg(LP_DEBUG, "CPU (C:%d, I:%d CS:%d DS:%d): SLEEP [%s:%d]", cpu->clock, cpu->instruction, cpu->state, cpu->device.device_state, __FILE__, __LINE__);
-                #endif
-                break;
-            }
+// starts the pending interrupt on an instruction boundary, 0 if it got masked in the meantime
+static int cpu_take_interrupt(CPU_t* cpu) {
+    cpu->interrupt.pending = 0;
+    if (cpu->regs.sr.MI) {
+        cpu->interrupt.dropped ++;
+        return 0;
+    }
+    cpu->intermediate.irq_id = cpu->interrupt.irq_id;
+    cpu->interrupt.servicing = 1;
+    cpu->interrupt.taken ++;
+    if (cpu->branch_predictor) {
+        cpu_branch_predictor_call(cpu->branch_predictor, cpu->regs.pc);
+    }
+    if (cpu->pipeline) {
+        cpu_pipeline_interrupt(cpu->pipeline, cpu->regs.pc);
+    }
+    cpu->state = CS_INTERRUPT_PUSH_PC_HIGH;
+    return 1;
+}
 
-        case CS_EXCEPTION:
-            if (!halted) {
-                #ifdef _CPU_DEEP_DEBUG_
-                log_msg(LP_ERROR, "CPU (C:%d CS:%d DS:%d): EXCEPTION [%s:%d]", cpu->clock, cpu->state, cpu->device.device_state, __FILE__, __LINE__);
-                #endif
-                halted = 1;
-            }
-            break;
+// hands the outcome of a conditional jump or move, or the return address of a call, to the branch predictor
+static void cpu_predict_branch(CPU_t* cpu) {
+    int instruction = cpu->intermediate.instruction;
+    int condition, backward = 0;
+    if (instruction >= JZ && instruction <= JNAO) {
+        condition = instruction - JZ;
+        backward = cpu->intermediate.data_address_extended <= cpu->intermediate.previous_pc;
+    } else if (instruction >= RJZ && instruction <= RJNAO) {
+        condition = instruction - RJZ;
+        backward = (uint16_t) (cpu->regs.pc + (int16_t) cpu->intermediate.data_address_extended) <= cpu->intermediate.previous_pc;
+    } else if (instruction >= CMOVZ && instruction <= CMOVNMI) {
+        condition = instruction - CMOVZ;
+    } else {
+        if (instruction == CALL || instruction == RCALL || instruction == INT) {
+            cpu_branch_predictor_call(cpu->branch_predictor, cpu->regs.pc);
+        }
+        return;
+    }
+    int taken = ((cpu->regs.sr.value >> (condition / 2)) & 1) != (condition & 1);
+    cpu_branch_predictor_resolve(cpu->branch_predictor, cpu->intermediate.previous_pc, instruction, backward, taken);
+}
 
-        default:
-            if (!halted) {
-                #ifdef _CPU_DEEP_DEBUG_
-                log_msg(LP_ERROR, "CPU (C:%d CS:%d DS:%d): UNKNOWN STATE [%s:%d]", cpu->clock, cpu->state, cpu->device.device_state, __FILE__, __LINE__);
-                #endif
-                halted = 1;
-            }
-            break;
+static void cpu_record_interrupt_latency(CPU_t* cpu) {
+    uint64_t latency = cpu->clock - cpu->interrupt.asserted;
+    int bucket = 0;
+    while (bucket < CPU_INTERRUPT_LATENCY_BUCKETS - 1 && (latency >> bucket)) {
+        bucket ++;
     }
+    cpu->interrupt.latency[bucket] ++;
+    if (latency > cpu->interrupt.latency_max) {
+        cpu->interrupt.latency_max = latency;
+    }
+    cpu->interrupt.servicing = 0;
+}
 
-    cpu->clock ++;
-    return;
+// books the cycles cpu_clock spent since it started in state, see CpuCycles_t
+static inline void cpu_account_cycles(CPU_t* cpu, CpuState_t state, uint64_t clock_start, uint64_t memory_start) {
+    uint64_t cycles = (cpu->clock - clock_start) - (cpu->cycles.memory - memory_start);
+    if (cpu->device.device_state == DS_FETCH || cpu->device.device_state == DS_STORE) {
+        cpu->cycles.stalled[cpu->state] += cycles;
+    } else {
+        cpu->cycles.active[state] += cycles;
+    }
 }
 
+/*
+cpu_clock is generated from cpu_clock_template.h for every combination of cache and observers (pipeline, branch predictor), 
+so the common configurations do not branch on what they do not use for every byte they touch. 
+cpu_clock itself is the variant that checks everything, cpu_select_clock_variant picks the one that fits the cpu
+*/
+static void cpu_clock_uncached(CPU_t* cpu);
+static void cpu_clock_unobserved(CPU_t* cpu);
+static void cpu_clock_uncached_unobserved(CPU_t* cpu);
+static void cpu_clock_traced(CPU_t* cpu);
+
+#define CPU_CLOCK_FUNCTION cpu_clock
+#define CPU_CLOCK_CACHE 1
+#define CPU_CLOCK_OBSERVED 1
+#define CPU_CLOCK_TRACE 0
+#include "cpu_clock_template.h"
+
+#define CPU_CLOCK_FUNCTION cpu_clock_uncached
+#define CPU_CLOCK_CACHE 0
+#define CPU_CLOCK_OBSERVED 1
+#define CPU_CLOCK_TRACE 0
+#include "cpu_clock_template.h"
+
+#define CPU_CLOCK_FUNCTION cpu_clock_unobserved
+#define CPU_CLOCK_CACHE 1
+#define CPU_CLOCK_OBSERVED 0
+#define CPU_CLOCK_TRACE 0
+#include "cpu_clock_template.h"
+
+#define CPU_CLOCK_FUNCTION cpu_clock_uncached_unobserved
+#define CPU_CLOCK_CACHE 0
+#define CPU_CLOCK_OBSERVED 0
+#define CPU_CLOCK_TRACE 0
+#include "cpu_clock_template.h"
+
+#define CPU_CLOCK_FUNCTION cpu_clock_traced
+#define CPU_CLOCK_CACHE 1
+#define CPU_CLOCK_OBSERVED 1
+#define CPU_CLOCK_TRACE 1
+#include "cpu_clock_template.h"
+
+void cpu_select_clock_variant(CPU_t* cpu) {
+    int observed = cpu->pipeline || cpu->branch_predictor;
+    if (cpu->trace) {
+        cpu->clock_variant = cpu_clock_traced;
+    } else if (cpu->cache) {
+        cpu->clock_variant = observed ? cpu_clock : cpu_clock_unobserved;
+    } else {
+        cpu->clock_variant = observed ? cpu_clock_uncached : cpu_clock_uncached_unobserved;
+    }
+}
+
+
+int cpu_step_instruction(CPU_t* cpu, RAM_t* ram) {
+    cpu->direct_ram = ram;
+    do {
+        if (cpu->state == CS_HALT || cpu->state == CS_EXCEPTION || cpu->state == CS_SLEEP) {
+            cpu->direct_ram = NULL;
+            return 0;
+        }
+        cpu->clock_variant(cpu);
+        if (cpu->device.device_state != DS_IDLE || cpu->device.processed) {
+            // waiting on a device other than ram, only the bus can help here
+            cpu->direct_ram = NULL;
+            return 0;
+        }
+    } while (cpu->state != CS_FETCH_INSTRUCTION || cpu->intermediate.extension_index != 0);
+    cpu->direct_ram = NULL;
+    return 1;
+}
@@ -0,0 +1,150 @@
+/*
+CS_EXECUTE semantics of the instructions that compute their result from (reduced, extended) alone, plus CMP and TST.
+Shared by cpu_clock_template.h and the helpers the JIT calls, so both run the same code.
+Only included by the cpu sources
+*/
+
+#ifndef _CPU_ALU_H_
+#define _CPU_ALU_H_
+
+#include <stdint.h>
+
+#include "utils/ExtendedTypes.h"
+
+#include "cpu/cpu.h"
+
+
+// the flags are computed once a reader asks for them, see cpu_resolve_flags
+static inline void cpu_compare(CPU_t* cpu, uint16_t a, uint16_t b) {
+    cpu->flags.operation = CFO_COMPARE;
+    cpu->flags.pending = CPU_FLAGS_COMPARE_MASK;
+    cpu->flags.a = a;
+    cpu->flags.b = b;
+}
+
+static inline void cpu_test(CPU_t* cpu, uint16_t value) {
+    if (cpu->flags.pending & ~CPU_FLAGS_TEST_MASK) {
+        // tst leaves the other bits of an earlier cmp as they are
+        cpu_resolve_flags(cpu, CPU_FLAGS_COMPARE_MASK & ~CPU_FLAGS_TEST_MASK);
+    }
+    cpu->flags.operation = CFO_TEST;
+    cpu->flags.pending = CPU_FLAGS_TEST_MASK;
+    cpu->flags.a = value;
+}
+
+static inline uint16_t cpu_alu_adc(CPU_t* cpu, uint16_t a, uint16_t b) {
+    uint16_t result = (int16_t) a + (int16_t) b + cpu->regs.sr.AO;
+    cpu->regs.sr.AO = ((uint32_t) a + (uint32_t) b) > 0xffff;
+    return result;
+}
+
+static inline uint16_t cpu_alu_sbc(CPU_t* cpu, uint16_t a, uint16_t b) {
+    uint16_t result = (int16_t) a - (int16_t) b - cpu->regs.sr.AO;
+    cpu->regs.sr.AO = ((int32_t) a - (int32_t) b) < 0;
+    return result;
+}
+
+static inline uint16_t cpu_alu_mul(CPU_t* cpu, uint16_t a, uint16_t b) {
+    cpu->regs.sr.AO = ((uint32_t) a * (uint32_t) b) > 0xffff;
+    return (int16_t) a * (int16_t) b;
+}
+
+static inline uint16_t cpu_alu_div(CPU_t* cpu, uint16_t a, uint16_t b) {
+    if ((int16_t) b == 0) {
+        cpu->regs.sr.AO = 1;
+        return 0;
+    }
+    return (int16_t) a / (int16_t) b;
+}
+
+static inline uint16_t cpu_alu_abs(CPU_t* cpu, uint16_t a, uint16_t b) {
+    (void) cpu; (void) b;
+    if ((int16_t) a < 0) {
+        return ~a + 1;
+    }
+    return a;
+}
+
+static inline uint16_t cpu_alu_ssa(CPU_t* cpu, uint16_t a, uint16_t b) {
+    int32_t tmp = (int32_t) ((int16_t) a) + (int32_t) ((int16_t) b);
+    cpu->regs.sr.AO = 0;
+    return (tmp < (int32_t)((int16_t) 0x8000)) ? 0x8000 : ((tmp > (int16_t) 0x7fff) ? 0x7fff : tmp);
+}
+
+static inline uint16_t cpu_alu_sss(CPU_t* cpu, uint16_t a, uint16_t b) {
+    int32_t tmp = (int32_t) ((int16_t) a) - (int32_t) ((int16_t) b);
+    cpu->regs.sr.AO = 0;
+    return (tmp < (int32_t)((int16_t) 0x8000)) ? 0x8000 : ((tmp > (int32_t)((int16_t) 0x7fff)) ? 0x7fff : tmp);
+}
+
+static inline uint16_t cpu_alu_ssm(CPU_t* cpu, uint16_t a, uint16_t b) {
+    int32_t tmp = (int32_t) ((int16_t) a) * (int32_t) ((int16_t) b);
+    cpu->regs.sr.AO = 0;
+    return (tmp < (int32_t)((int16_t) 0x8000)) ? 0x8000 : ((tmp > (int16_t) 0x7fff) ? 0x7fff : tmp);
+}
+
+static inline uint16_t cpu_alu_usa(CPU_t* cpu, uint16_t a, uint16_t b) {
+    int32_t tmp = (int32_t) a + (int32_t) b;
+    cpu->regs.sr.AO = 0;
+    return (tmp < 0) ? 0 : ((tmp > 0xffff) ? 0xffff : tmp);
+}
+
+static inline uint16_t cpu_alu_uss(CPU_t* cpu, uint16_t a, uint16_t b) {
+    int32_t tmp = (int32_t) a - (int32_t) b;
+    cpu->regs.sr.AO = 0;
+    return (tmp < 0) ? 0 : ((tmp > 0xffff) ? 0xffff : tmp);
+}
+
+static inline uint16_t cpu_alu_usm(CPU_t* cpu, uint16_t a, uint16_t b) {
+    int32_t tmp = (int32_t) a * (int32_t) b;
+    cpu->regs.sr.AO = 0;
+    return (tmp < 0) ? 0 : ((tmp > 0xffff) ? 0xffff : tmp);
+}
+
+static inline uint16_t cpu_alu_ubs(CPU_t* cpu, uint16_t a, uint16_t b) {
+    (void) cpu;
+    int16_t shift = (int16_t) b;
+    if (shift > 0) {
+        return a >> shift;
+    }
+    return a << (-shift);
+}
+
+static inline uint16_t cpu_alu_sbs(CPU_t* cpu, uint16_t a, uint16_t b) {
+    (void) cpu;
+    int16_t shift = (int16_t) b;
+    if (shift > 0) {
+        return (a >> shift) | (0xffff << ((16 - shift) < 0 ? 0 : (16 - shift)));
+    }
+    return a << (-shift);
+}
+
+static inline uint16_t cpu_alu_addf(CPU_t* cpu, uint16_t a, uint16_t b) {(void) cpu; return f16_add(a, b);}
+static inline uint16_t cpu_alu_subf(CPU_t* cpu, uint16_t a, uint16_t b) {(void) cpu; return f16_sub(a, b);}
+static inline uint16_t cpu_alu_mulf(CPU_t* cpu, uint16_t a, uint16_t b) {(void) cpu; return f16_mult(a, b);}
+static inline uint16_t cpu_alu_divf(CPU_t* cpu, uint16_t a, uint16_t b) {(void) cpu; return f16_div(a, b);}
+static inline uint16_t cpu_alu_addd(CPU_t* cpu, uint16_t a, uint16_t b) {(void) cpu; return bf16_add(a, b);}
+static inline uint16_t cpu_alu_subd(CPU_t* cpu, uint16_t a, uint16_t b) {(void) cpu; return bf16_sub(a, b);}
+static inline uint16_t cpu_alu_muld(CPU_t* cpu, uint16_t a, uint16_t b) {(void) cpu; return bf16_mult(a, b);}
+static inline uint16_t cpu_alu_divd(CPU_t* cpu, uint16_t a, uint16_t b) {(void) cpu; return bf16_div(a, b);}
+static inline uint16_t cpu_alu_addl(CPU_t* cpu, uint16_t a, uint16_t b) {(void) cpu; return fi16_add(a, b);}
+static inline uint16_t cpu_alu_subl(CPU_t* cpu, uint16_t a, uint16_t b) {(void) cpu; return fi16_sub(a, b);}
+static inline uint16_t cpu_alu_mull(CPU_t* cpu, uint16_t a, uint16_t b) {(void) cpu; return fi16_mult(a, b);}
+static inline uint16_t cpu_alu_divl(CPU_t* cpu, uint16_t a, uint16_t b) {(void) cpu; return fi16_div(a, b);}
+
+// conversions only look at the reduced operand
+static inline uint16_t cpu_alu_cif(CPU_t* cpu, uint16_t a, uint16_t b) {(void) cpu; (void) b; return f16_from_float((float) ((int16_t) a));}
+static inline uint16_t cpu_alu_cid(CPU_t* cpu, uint16_t a, uint16_t b) {(void) cpu; (void) b; return bf16_from_float((float) ((int16_t) a));}
+static inline uint16_t cpu_alu_cil(CPU_t* cpu, uint16_t a, uint16_t b) {(void) cpu; (void) b; return fi16_from_int(((int) a));}
+static inline uint16_t cpu_alu_cfi(CPU_t* cpu, uint16_t a, uint16_t b) {(void) cpu; (void) b; return (int16_t) float_from_f16(a);}
+static inline uint16_t cpu_alu_cfd(CPU_t* cpu, uint16_t a, uint16_t b) {(void) cpu; (void) b; return bf16_from_float(float_from_f16(a));}
+static inline uint16_t cpu_alu_cfl(CPU_t* cpu, uint16_t a, uint16_t b) {(void) cpu; (void) b; return fi16_from_long_long((long long int)(float_from_f16(a)));}
+static inline uint16_t cpu_alu_cdi(CPU_t* cpu, uint16_t a, uint16_t b) {(void) cpu; (void) b; return (int16_t) float_from_bf16(a);}
+static inline uint16_t cpu_alu_cdf(CPU_t* cpu, uint16_t a, uint16_t b) {(void) cpu; (void) b; return f16_from_float(float_from_bf16(a));}
+static inline uint16_t cpu_alu_cdl(CPU_t* cpu, uint16_t a, uint16_t b) {(void) cpu; (void) b; return fi16_from_long_long((long long int)(float_from_bf16(a)));}
+static inline uint16_t cpu_alu_cli(CPU_t* cpu, uint16_t a, uint16_t b) {(void) cpu; (void) b; return (int16_t) int_from_fi16((fint16_t) a);}
+static inline uint16_t cpu_alu_clf(CPU_t* cpu, uint16_t a, uint16_t b) {(void) cpu; (void) b; return f16_from_float((float) int_from_fi16((fint16_t) a));}
+static inline uint16_t cpu_alu_cld(CPU_t* cpu, uint16_t a, uint16_t b) {(void) cpu; (void) b; return bf16_from_float((float) int_from_fi16((fint16_t) a));}
+static inline uint16_t cpu_alu_cbi(CPU_t* cpu, uint16_t a, uint16_t b) {(void) cpu; (void) b; return (int16_t) ((int8_t) a);}
+
+#endif
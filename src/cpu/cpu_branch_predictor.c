@@ -0,0 +1,166 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "utils/Log.h"
+
+#include "cpu/cpu_instructions.h"
+#include "cpu/cpu_branch_predictor.h"
+
+
+const char* cpu_branch_predictor_name[CBP_COUNT] = {
+    "static",
+    "bimodal",
+    "gshare",
+};
+
+
+CpuBranchPredictor_t* cpu_branch_predictor_create(CpuBranchPredictorKind_t kind) {
+    if (kind < 0 || kind >= CBP_COUNT) {
+        log_msg(LP_ERROR, "Branch Predictor: Unknown kind %d [%s:%d]", kind, __FILE__, __LINE__);
+        return NULL;
+    }
+    CpuBranchPredictor_t* predictor = calloc(1, sizeof(CpuBranchPredictor_t));
+    if (!predictor) {
+        log_msg(LP_ERROR, "Branch Predictor: Memory allocation failure [%s:%d]", __FILE__, __LINE__);
+        return NULL;
+    }
+    predictor->kind = kind;
+    memset(predictor->counter, 1, sizeof(predictor->counter));     // weakly not taken
+    predictor->site_index = calloc(1 << 16, sizeof(uint16_t));
+    if (!predictor->site_index) {
+        log_msg(LP_ERROR, "Branch Predictor: Memory allocation failure [%s:%d]", __FILE__, __LINE__);
+        free(predictor);
+        return NULL;
+    }
+    return predictor;
+}
+
+void cpu_branch_predictor_delete(CpuBranchPredictor_t** predictor) {
+    if (!predictor) {return;}
+    if (!*predictor) {return;}
+    free((*predictor)->site_index);
+    free((*predictor)->site);
+    free(*predictor);
+    *predictor = NULL;
+}
+
+
+static CpuBranchSite_t* cpu_branch_predictor_site(CpuBranchPredictor_t* predictor, uint16_t pc, int instruction) {
+    uint16_t index = predictor->site_index[pc];
+    if (index) {
+        return &predictor->site[index - 1];
+    }
+    if (predictor->site_count >= predictor->site_capacity) {
+        int capacity = predictor->site_capacity ? predictor->site_capacity * 2 : 64;
+        CpuBranchSite_t* site = realloc(predictor->site, capacity * sizeof(CpuBranchSite_t));
+        if (!site) {
+            log_msg(LP_ERROR, "Branch Predictor: Memory allocation failure [%s:%d]", __FILE__, __LINE__);
+            return NULL;
+        }
+        predictor->site = site;
+        predictor->site_capacity = capacity;
+    }
+    CpuBranchSite_t* site = &predictor->site[predictor->site_count++];
+    *site = (CpuBranchSite_t) {.pc = pc, .instruction = instruction};
+    predictor->site_index[pc] = (uint16_t) predictor->site_count;
+    return site;
+}
+
+void cpu_branch_predictor_resolve(CpuBranchPredictor_t* predictor, uint16_t pc, int instruction, int backward, int taken) {
+    int prediction;
+    uint8_t* counter = NULL;
+    switch (predictor->kind) {
+        case CBP_STATIC:
+            prediction = backward;
+            break;
+        case CBP_BIMODAL:
+            counter = &predictor->counter[pc & (CPU_BRANCH_PREDICTOR_TABLE_SIZE - 1)];
+            prediction = *counter >= 2;
+            break;
+        case CBP_GSHARE:
+        default:
+            counter = &predictor->counter[(pc ^ predictor->history) & (CPU_BRANCH_PREDICTOR_TABLE_SIZE - 1)];
+            prediction = *counter >= 2;
+            break;
+    }
+    if (counter) {
+        if (taken && *counter < 3) {(*counter) ++;}
+        if (!taken && *counter > 0) {(*counter) --;}
+    }
+    predictor->history = (uint16_t) ((predictor->history << 1) | (taken != 0));
+
+    int mispredicted = prediction != (taken != 0);
+    predictor->branches ++;
+    predictor->mispredicted += mispredicted;
+    predictor->last_pc = pc;
+    predictor->last_valid = 1;
+    predictor->last_mispredicted = (uint8_t) mispredicted;
+
+    CpuBranchSite_t* site = cpu_branch_predictor_site(predictor, pc, instruction);
+    if (!site) {return;}
+    if (taken) {
+        site->taken ++;
+    } else {
+        site->not_taken ++;
+    }
+    site->mispredicted += mispredicted;
+}
+
+void cpu_branch_predictor_call(CpuBranchPredictor_t* predictor, uint16_t return_address) {
+    predictor->return_top = (predictor->return_top + 1) % CPU_RETURN_STACK_DEPTH;
+    predictor->return_stack[predictor->return_top] = return_address;
+    if (predictor->return_depth < CPU_RETURN_STACK_DEPTH) {
+        predictor->return_depth ++;
+    }
+}
+
+void cpu_branch_predictor_return(CpuBranchPredictor_t* predictor, uint16_t pc, uint16_t target) {
+    int mispredicted = 1;
+    if (predictor->return_depth) {
+        mispredicted = predictor->return_stack[predictor->return_top] != target;
+        predictor->return_top = (predictor->return_top + CPU_RETURN_STACK_DEPTH - 1) % CPU_RETURN_STACK_DEPTH;
+        predictor->return_depth --;
+    }
+    predictor->returns ++;
+    predictor->returns_mispredicted += mispredicted;
+    predictor->last_pc = pc;
+    predictor->last_valid = 1;
+    predictor->last_mispredicted = (uint8_t) mispredicted;
+
+    CpuBranchSite_t* site = cpu_branch_predictor_site(predictor, pc, RET);
+    if (!site) {return;}
+    site->taken ++;
+    site->mispredicted += mispredicted;
+}
+
+
+static int cpu_branch_site_compare(const void* a, const void* b) {
+    const CpuBranchSite_t* x = a;
+    const CpuBranchSite_t* y = b;
+    if (x->mispredicted != y->mispredicted) {
+        return x->mispredicted < y->mispredicted ? 1 : -1;
+    }
+    return (int) x->pc - (int) y->pc;
+}
+
+void cpu_branch_predictor_print(CpuBranchPredictor_t* predictor, int count) {
+    printf("\n\033[1;33m Branch Prediction (%s)\033[0m\n", cpu_branch_predictor_name[predictor->kind]);
+    printf(" \033[1;32mBranches\033[0m [%lu]  \033[1;32mMispredicted\033[0m [%lu]  \033[1;32mRate\033[0m [%2.2f%%]\n", predictor->branches, predictor->mispredicted, predictor->branches ? (double) (predictor->branches - predictor->mispredicted) / (double) predictor->branches * 100.0 : 0.0);
+    printf(" \033[1;32mReturns\033[0m [%lu]  \033[1;32mMispredicted\033[0m [%lu]  \033[1;32mSites\033[0m [%d]\n", predictor->returns, predictor->returns_mispredicted, predictor->site_count);
+    if (!predictor->site_count || count <= 0) {return;}
+
+    CpuBranchSite_t* sorted = malloc(predictor->site_count * sizeof(CpuBranchSite_t));
+    if (!sorted) {
+        log_msg(LP_ERROR, "Branch Predictor: Memory allocation failure [%s:%d]", __FILE__, __LINE__);
+        return;
+    }
+    memcpy(sorted, predictor->site, predictor->site_count * sizeof(CpuBranchSite_t));
+    qsort(sorted, predictor->site_count, sizeof(CpuBranchSite_t), cpu_branch_site_compare);
+    printf("   pc     instr     taken      not taken  mispredicted\n");
+    for (int i = 0; i < predictor->site_count && i < count; i++) {
+        if (!sorted[i].mispredicted) {break;}
+        printf("   0x%04x %-9s %-10lu %-10lu %lu\n", sorted[i].pc, instruction_encoding[sorted[i].instruction].instruction_string, sorted[i].taken, sorted[i].not_taken, sorted[i].mispredicted);
+    }
+    free(sorted);
+}
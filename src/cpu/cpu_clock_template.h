@@ -0,0 +1,2518 @@
+/*
+Body of cpu_clock, included by cpu.c once per variant (see cpu_select_clock_variant). Before including, define
+CPU_CLOCK_FUNCTION      name of the variant
+CPU_CLOCK_CACHE         1 if the data cache is looked at, 0 if the cpu has none
+CPU_CLOCK_OBSERVED      1 if the pipeline and branch predictor are fed, 0 if neither is mounted
+CPU_CLOCK_TRACE         1 to log every instruction the cpu starts
+All four are undefined again at the end
+*/
+
+#if CPU_CLOCK_CACHE
+#define CPU_CLOCK_READ_MEMORY cpu_read_memory
+#define CPU_CLOCK_WRITE_MEMORY cpu_write_memory_width
+#else
+#define CPU_CLOCK_READ_MEMORY cpu_read_memory_uncached
+#define CPU_CLOCK_WRITE_MEMORY cpu_write_memory_width_uncached
+#endif
+
+void CPU_CLOCK_FUNCTION(CPU_t* cpu) {
+    CpuState_t state_start = cpu->state;
+    uint64_t clock_start = cpu->clock;
+    uint64_t memory_start = cpu->cycles.memory;
+    #ifdef _CPU_DEEP_DEBUG_
+    log_msg(LP_DEBUG, "CS %d, DS %d", cpu->state, cpu->device.device_state);
+
+    log_msg(LP_INFO, "CPU (C:%d CS:%d DS:%d): Checking for interrupt", cpu->clock, cpu->state, cpu->device.device_state);
+    #endif
+    if (cpu->device.device_state == DS_INTERRUPT) {
+        #ifdef _CPU_DEBUG_
+        log_msg(LP_INFO, "CPU (C:%d CS:%d DS:%d): PC %.4x - interrupt on CS %d, irqid %d", cpu->clock, cpu->state, cpu->device.device_state, cpu->regs.pc, cpu->state, cpu->device.address);
+        #endif
+        
+        if (!cpu->regs.sr.MI && !cpu->interrupt.pending) {
+            cpu->interrupt.pending = 1;
+            cpu->interrupt.irq_id = cpu->device.address;
+            cpu->interrupt.asserted = cpu->device.asserted;
+        } else {
+            cpu->interrupt.dropped ++;
+        }
+        cpu->interrupt.dropped += cpu->device.coalesced;
+        cpu->device.coalesced = 0;
+        cpu->device.device_state = DS_IDLE;
+    }
+
+    // with direct ram nothing ever waits, so the states would chain into the next instruction forever
+    int stop_at_fetch = (cpu->state != CS_FETCH_INSTRUCTION);
+
+    switch (cpu->state) {
+
+        case CS_FETCH_INSTRUCTION:
+            {
+                CS_FETCH_INSTRUCTION:
+                #ifdef _CPU_DEEP_DEBUG_
+                log_msg(LP_INFO, "CPU (C:%d CS:%d DS:%d): Fetching instruction", cpu->clock, cpu->state, cpu->device.device_state);
+                #endif
+                cpu->regs.sr.MNI = 0;
+                if (cpu->direct_ram && stop_at_fetch) {
+                    // an interrupt taken before the next fetch rolls back to these, not into the finished instruction
+                    cpu->intermediate.previous_pc = cpu->regs.pc;
+                    cpu->intermediate.previous_sp = cpu->regs.sp;
+                    cpu_account_cycles(cpu, state_start, clock_start, memory_start);
+                    return;     // the fetch would have happened in this very cycle, so the cycle is not over yet
+                }
+                stop_at_fetch = 1;
+                uint16_t address = cpu->regs.pc;
+                if (cpu->intermediate.extension_index == 0) { // This check prevents prev values from updating when iterating over extension prefixes, keeping the prev at the base of the instruction. 
+                    cpu->intermediate.previous_pc = cpu->regs.pc;
+                    cpu->intermediate.previous_sp = cpu->regs.sp;
+
+                    if (cpu->interrupt.pending && cpu->device.device_state == DS_IDLE && !cpu->device.processed && cpu_take_interrupt(cpu)) {
+                        goto CS_INTERRUPT_PUSH_PC_HIGH;
+                    }
+
+                    if (CPU_CLOCK_OBSERVED && cpu->pipeline && cpu->device.device_state == DS_IDLE && !cpu->device.processed) {
+                        cpu_pipeline_fetch(cpu->pipeline, address);
+                    }
+
+                    #if CPU_CLOCK_TRACE
+                    if (cpu->device.device_state == DS_IDLE && !cpu->device.processed) {
+                        log_msg(LP_DEBUG, "CPU %d (C:%lu I:%lu): pc 0x%.4x  r0 0x%.4x  r1 0x%.4x  r2 0x%.4x  r3 0x%.4x  sp 0x%.4x", cpu->core_id, cpu->clock, cpu->instruction, address, cpu->regs.r0, cpu->regs.r1, cpu->regs.r2, cpu->regs.r3, cpu->regs.sp);
+                    }
+                    #endif
+
+                    // only look up on a fresh fetch, not while waiting for the bus
+                    if (cpu->decode_cache && cpu->device.device_state == DS_IDLE && !cpu->device.processed) {
+                        CpuDecodedInstruction_t* decoded = cpu_decode_cache_lookup(cpu->decode_cache, address);
+                        if (decoded) {
+                            cpu_decode_cache_fuse(cpu->decode_cache, decoded);
+                            if (decoded->fusion && cpu->decode_cache->fusion && cpu->direct_ram && cpu_execute_fused(cpu, decoded)) {
+                                cpu->state = CS_FETCH_INSTRUCTION;
+                                goto CS_FETCH_INSTRUCTION;
+                            }
+                            cpu->regs.sr.NC = decoded->no_cache;
+                            cpu->intermediate.instruction = decoded->instruction;
+                            cpu->last_instruction = (CPU_INSTRUCTION_MNEMONIC_t) decoded->instruction;
+                            cpu->intermediate.argument_count = decoded->argument_count;
+                            cpu->intermediate.addressing_mode.value = decoded->addressing_mode;
+                            cpu->intermediate.argument_bytes_to_load = decoded->argument_bytes_to_load;
+                            cpu->intermediate.argument_data_raw_index = decoded->argument_bytes_to_load;
+                            memcpy(cpu->intermediate.argument_data_raw, decoded->argument_data_raw, sizeof(decoded->argument_data_raw));
+                            cpu->regs.pc += decoded->length;
+                            if (decoded->entry_state == CS_EXECUTE) {
+                                cpu->state = CS_EXECUTE;
+                                goto CS_EXECUTE;
+                            }
+                            cpu->state = CS_COMPUTE_ADDRESS;
+                            goto CS_COMPUTE_ADDRESS;
+                        }
+                    }
+                }
+                uint8_t data;
+                int success = CPU_CLOCK_READ_MEMORY(cpu, address, &data);
+                if (success) {
+                    // ok, we got the data for the instruction, saving it intermediatly
+                    cpu->regs.sr.NC = (data & 0x80) != 0;
+                    cpu->intermediate.instruction = data & 0x7F;
+
+                    if (cpu->intermediate.instruction == EXT) {
+                        #ifdef _CPU_DEEP_DEBUG_
+                        log_msg(LP_CRITICAL, "CPU (C:%d CS:%d DS:%d): Fetch was successful, loaded EXT instruction, fetching next byte...", cpu->clock, cpu->state, cpu->device.device_state);
+                        #endif
+                        cpu->regs.pc ++;
+                        cpu->intermediate.extension_index ++;
+                        break;
+                    }
+
+                    cpu->intermediate.instruction += (cpu->intermediate.extension_index * 0x80);
+                    #ifdef _CPU_DEEP_DEBUG_
+                    log_msg(LP_INFO, "CPU (C:%d CS:%d DS:%d): Fetch was successful, loaded instruction %s (%d)", cpu->clock, cpu->state, cpu->device.device_state, instruction_encoding[cpu->intermediate.instruction].instruction_string, cpu->intermediate.instruction);
+                    #endif
+                    cpu->intermediate.argument_count = instruction_encoding[cpu->intermediate.instruction].argument_count;
+
+                    if (cpu->intermediate.instruction < INSTRUCTION_COUNT) {
+                        cpu->last_instruction = (CPU_INSTRUCTION_MNEMONIC_t) cpu->intermediate.instruction;
+                        #ifdef _CPU_DEBUG_
+                        if (cpu->intermediate.argument_count == 0) {
+                            log_msg(LP_DEBUG, "CPU (C:%d CS:%d DS:%d): PC %.4x - instruction (argc:0): %s - nc: %d - sp: %.4x", 
+                                cpu->clock, cpu->state, cpu->device.device_state, 
+                                cpu->regs.pc, 
+                                instruction_encoding[cpu->intermediate.instruction].instruction_string, 
+                                cpu->regs.sr.NC, 
+                                cpu->regs.sp
+                            );
+                        }
+                        #endif
+                    } else {
+                        #ifdef _CPU_DEEP_DEBUG_
+                        log_msg(LP_ERROR, "CPU (C:%d CS:%d DS:%d): Unknown instruction [%d, nc:%d, PC: 0x%.4x] [%s:%d]", cpu->clock, cpu->state, cpu->device.device_state, cpu->intermediate.instruction, cpu->regs.sr.NC, cpu->regs.pc - 1, __FILE__, __LINE__);
+                        #endif
+                        cpu->state = CS_EXCEPTION;
+                        break;
+                    }
+
+                    cpu->intermediate.extension_index = 0;
+                    if (cpu->intermediate.argument_count == 0) {
+                        cpu->regs.pc ++;
+                        cpu_decode_cache_store(cpu, CS_EXECUTE);
+                        cpu->state = CS_EXECUTE;
+                        goto CS_EXECUTE;
+                    } else {
+                        cpu->state = CS_FETCH_ADDRESSING_MODES;
+                        cpu->regs.pc ++;
+                        goto CS_FETCH_ADDRESSING_MODES;
+                    }
+                } else {
+                    #ifdef _CPU_DEEP_DEBUG_
+                    log_msg(LP_INFO, "CPU (C:%d CS:%d DS:%d): Fetch was unsuccessful", cpu->clock, cpu->state, cpu->device.device_state);
+                    #endif
+                }
+            }
+            break;
+        
+        case CS_FETCH_ADDRESSING_MODES:
+            {
+                CS_FETCH_ADDRESSING_MODES:
+                #ifdef _CPU_DEEP_DEBUG_
+                log_msg(LP_INFO, "CPU (C:%d CS:%d DS:%d): Fetching addressing modes", cpu->clock, cpu->state, cpu->device.device_state);
+                #endif
+                cpu->regs.sr.MNI = 0;
+                uint16_t address = cpu->regs.pc;
+                uint8_t data;
+                int success = CPU_CLOCK_READ_MEMORY(cpu, address, &data);
+                if (success) {
+                    #ifdef _CPU_DEEP_DEBUG_
+                    log_msg(LP_INFO, "CPU (C:%d CS:%d DS:%d): Fetch was successful", cpu->clock, cpu->state, cpu->device.device_state);
+                    #endif
+                    // ok, we got the data for the instruction, saving it intermediatly
+                    cpu->intermediate.addressing_mode.value = data;
+
+                    if (cpu->intermediate.argument_count == 2) {
+                        #ifdef _CPU_DEBUG_
+                            log_msg(LP_DEBUG, "CPU (C:%d CS:%d DS:%d): PC %.4x - instruction (argc:2): %s %s, %s - nc: %d - sp: %.4x", 
+                                cpu->clock, cpu->state, cpu->device.device_state, 
+                                cpu->regs.pc - 1, 
+                                instruction_encoding[cpu->intermediate.instruction].instruction_string, 
+                                cpu_reduced_addressing_mode_string[cpu->intermediate.addressing_mode.addressing_mode_reduced], 
+                                cpu_extended_addressing_mode_string[cpu->intermediate.addressing_mode.addressing_mode_extended], 
+                                cpu->regs.sr.NC, 
+                                cpu->regs.sp
+                            );
+                        #endif
+                        if (cpu->intermediate.addressing_mode.addressing_mode_reduced == ADMR_NONE || cpu->intermediate.addressing_mode.addressing_mode_extended == ADMX_NONE) {
+                            #ifdef _CPU_DEEP_DEBUG_
+                            log_msg(LP_ERROR, "CPU (C:%d CS:%d DS:%d): Encountered an invalid instruction [admr or admx is none] [%s:%d]", cpu->clock, cpu->state, cpu->device.device_state, __FILE__, __LINE__);
+                            #endif
+                            cpu->state = CS_EXCEPTION;
+                        }
+                    } else {
+                        if (instruction_encoding[cpu->intermediate.instruction].single_operant_writeback) {
+                            #ifdef _CPU_DEBUG_
+                                log_msg(LP_DEBUG, "CPU (C:%d CS:%d DS:%d): PC %.4x - instruction (argc:1 single_operant_writeback): %s %s - nc: %d - sp: %.4x", 
+                                    cpu->clock, cpu->state, cpu->device.device_state, 
+                                    cpu->regs.pc - 1, 
+                                    instruction_encoding[cpu->intermediate.instruction].instruction_string, 
+                                    cpu_reduced_addressing_mode_string[cpu->intermediate.addressing_mode.addressing_mode_reduced], 
+                                    cpu->regs.sr.NC, 
+                                    cpu->regs.sp
+                                );
+                            #endif
+                            if (cpu->intermediate.addressing_mode.addressing_mode_reduced == ADMR_NONE) {
+                                #ifdef _CPU_DEEP_DEBUG_
+                                log_msg(LP_ERROR, "CPU (C:%d CS:%d DS:%d): Encountered an invalid instruction [admr is none] [%s:%d]", cpu->clock, cpu->state, cpu->device.device_state, __FILE__, __LINE__);
+                                #endif
+                                cpu->state = CS_EXCEPTION;
+                            }
+                        } else {
+                            #ifdef _CPU_DEBUG_
+                                log_msg(LP_DEBUG, "CPU (C:%d CS:%d DS:%d): PC %.4x - instruction (argc:1): %s %s - nc: %d - sp: %.4x", 
+                                    cpu->clock, cpu->state, cpu->device.device_state, 
+                                    cpu->regs.pc - 1, 
+                                    instruction_encoding[cpu->intermediate.instruction].instruction_string, 
+                                    cpu_extended_addressing_mode_string[cpu->intermediate.addressing_mode.addressing_mode_extended], 
+                                    cpu->regs.sr.NC, 
+                                    cpu->regs.sp
+                                );
+                            #endif
+                            if (cpu->intermediate.addressing_mode.addressing_mode_extended == ADMX_NONE) {
+                                #ifdef _CPU_DEEP_DEBUG_
+                                log_msg(LP_ERROR, "CPU (C:%d CS:%d DS:%d): Encountered an invalid instruction [admx is none] [%s:%d]", cpu->clock, cpu->state, cpu->device.device_state, __FILE__, __LINE__);
+                                #endif
+                                
+                                cpu->state = CS_EXCEPTION;
+                            }
+                        }
+                    }
+                    
+                    // here check how many bytes to load for 
+                    cpu->intermediate.argument_bytes_to_load = 0;
+                    if (cpu->intermediate.argument_count == 2) {
+                        cpu->intermediate.argument_bytes_to_load = 
+                            cpu_reduced_addressing_mode_bytes[cpu->intermediate.addressing_mode.addressing_mode_reduced] +
+                            cpu_extended_addressing_mode_bytes[cpu->intermediate.addressing_mode.addressing_mode_extended];
+                    } else if (cpu->intermediate.argument_count == 1) {
+                        if (instruction_encoding[cpu->intermediate.instruction].single_operant_writeback) {
+                            cpu->intermediate.argument_bytes_to_load = cpu_reduced_addressing_mode_bytes[cpu->intermediate.addressing_mode.addressing_mode_reduced];
+                        } else {
+                            cpu->intermediate.argument_bytes_to_load = cpu_extended_addressing_mode_bytes[cpu->intermediate.addressing_mode.addressing_mode_extended];
+                        }
+                    }
+
+                    cpu->regs.pc ++;
+
+                    if (cpu->intermediate.argument_bytes_to_load == 0) {
+                        #ifdef _CPU_DEEP_DEBUG_
+                        log_msg(LP_INFO, "CPU (C:%d CS:%d DS:%d): No bytes to fetch, skipping to CS_COMPUTE_ADDRESS");
+                        #endif
+                        cpu_decode_cache_store(cpu, CS_COMPUTE_ADDRESS);
+                        cpu->state = CS_COMPUTE_ADDRESS;
+                        goto CS_COMPUTE_ADDRESS;
+                        break;
+                    }
+
+                    #ifdef _CPU_DEEP_DEBUG_
+                    log_msg(LP_INFO, "CPU (C:%d CS:%d DS:%d): Addressing modes require %d bytes for arguments", cpu->clock, cpu->state, cpu->device.device_state, cpu->intermediate.argument_bytes_to_load);
+                    #endif
+                                
+                    cpu->intermediate.argument_data_raw_index = 0;
+                    cpu->state = CS_FETCH_ARGUMENT_BYTES;
+                    goto CS_FETCH_ARGUMENT_BYTES;
+                } else {
+                    #ifdef _CPU_DEEP_DEBUG_
+                    log_msg(LP_INFO, "CPU (C:%d CS:%d DS:%d): Fetch was unsuccessful", cpu->clock, cpu->state, cpu->device.device_state);
+                    #endif
+                }
+            }
+            break;
+        
+        case CS_FETCH_ARGUMENT_BYTES: 
+            {
+                CS_FETCH_ARGUMENT_BYTES:
+                #ifdef _CPU_DEEP_DEBUG_
+                log_msg(LP_INFO, "CPU (C:%d CS:%d DS:%d): Fetching all argument bytes", cpu->clock, cpu->state, cpu->device.device_state);
+                #endif
+                cpu->regs.sr.MNI = 0;
+                uint8_t data;
+                int success = CPU_CLOCK_READ_MEMORY(cpu, cpu->regs.pc, &data);
+                if (success) {
+                    #ifdef _CPU_DEEP_DEBUG_
+                    log_msg(LP_INFO, "CPU (C:%d CS:%d DS:%d): Fetched byte %d/%d [0x%.2x]", cpu->clock, cpu->state, cpu->device.device_state, cpu->intermediate.argument_data_raw_index + 1, cpu->intermediate.argument_bytes_to_load, data);
+                    #endif
+                    cpu->intermediate.argument_data_raw[cpu->intermediate.argument_data_raw_index] = data;
+                    cpu->intermediate.argument_data_raw_index ++;
+                    cpu->regs.pc ++;
+
+                    if (cpu->intermediate.argument_data_raw_index >= cpu->intermediate.argument_bytes_to_load) {
+                        int admc;
+                        if (!instruction_encoding[cpu->intermediate.instruction].single_operant_writeback) {
+                            admc = cpu_extended_addressing_mode_category[cpu->intermediate.addressing_mode.addressing_mode_extended];
+                        } else {
+                            admc = cpu_reduced_addressing_mode_category[cpu->intermediate.addressing_mode.addressing_mode_reduced];
+                        }
+
+                        if (admc != ADMC_NONE) {
+                            cpu_decode_cache_store(cpu, CS_COMPUTE_ADDRESS);
+                        }
+
+                        // if its only for admx, then skip to fetch source
+                        switch (admc) {
+                            case ADMC_IND:
+                                cpu->state = CS_COMPUTE_ADDRESS;
+                                goto CS_COMPUTE_ADDRESS;
+                                break;
+                            case ADMC_IMM:
+                                #ifdef _CPU_DEEP_DEBUG_
+                                log_msg(LP_INFO, "CPU (C:%d CS:%d DS:%d): admc is not indirect, skipping CS_COMPUTE_ADDRESS", cpu->clock, cpu->state, cpu->device.device_state);
+                                #endif
+                                cpu->state = CS_COMPUTE_ADDRESS;//CS_FETCH_SOURCE;
+                                goto CS_COMPUTE_ADDRESS;
+                                break;
+                            case ADMC_REG:
+                                cpu->state = CS_COMPUTE_ADDRESS;//CS_FETCH_SOURCE;
+                                goto CS_COMPUTE_ADDRESS;
+                                break;
+                            default:
+                                #ifdef _CPU_DEEP_DEBUG_
+                                log_msg(LP_ERROR, "CPU (C:%d CS:%d DS:%d): Unkown extended adm category %d [%s:%d]", cpu->clock, cpu->state, cpu->device.device_state, admc, __FILE__, __LINE__);
+                                #endif
+                                break;
+                        }
+                        break;
+                    }
+                }
+            }
+            break;
+        
+        case CS_COMPUTE_ADDRESS: 
+            {
+                CS_COMPUTE_ADDRESS:
+                #ifdef _CPU_DEEP_DEBUG_
+                log_msg(LP_INFO, "CPU (C:%d CS:%d DS:%d): Calculating source address from argument composition", cpu->clock, cpu->state, cpu->device.device_state);
+                #endif
+                cpu->regs.sr.MNI = 0;
+                int admr = cpu->intermediate.addressing_mode.addressing_mode_reduced;
+                int admx = cpu->intermediate.addressing_mode.addressing_mode_extended;
+                int argument_index = 0;
+                #ifdef _CPU_DEEP_DEBUG_
+                log_msg(LP_INFO, "CPU (C:%d CS:%d DS:%d): admx %s", cpu->clock, cpu->state, cpu->device.device_state, cpu_extended_addressing_mode_string[admx]);
+                #endif
+                cpu->intermediate.argument_count_for_admr = argument_index;
+                switch (admx) {
+                    case ADMX_R0:
+                    case ADMX_R1:
+                    case ADMX_R2:
+                    case ADMX_R3:
+                    case ADMX_SP:
+                    case ADMX_PC:
+                        // Idea, here set flag to not fetch data from this "address"
+                        #ifdef _CPU_DEEP_DEBUG_
+                        log_msg(LP_DEBUG, "CPU (C:%d CS:%d DS:%d): admx is not an address", cpu->clock, cpu->state, cpu->device.device_state, cpu->intermediate.argument_address_reduced);
+                        #endif
+                        cpu->state = CS_FETCH_SOURCE;
+                        break;
+                    case ADMX_IMM16:
+                        argument_index += 2;
+                        cpu->state = CS_FETCH_SOURCE;
+                        break;
+                    
+                    case ADMX_IND_R0:
+                        {
+                            cpu->intermediate.argument_address_extended = cpu->regs.r0;
+                            #ifdef _CPU_DEEP_DEBUG_
+                            log_msg(LP_DEBUG, "CPU (C:%d CS:%d DS:%d): admx base address [%.4x]", cpu->clock, cpu->state, cpu->device.device_state, cpu->intermediate.argument_address_extended);
+                            #endif
+                            cpu->state = CS_FETCH_SOURCE;
+                        }
+                        break;
+                    
+                    case ADMX_IND_R1:
+                        {
+                            cpu->intermediate.argument_address_extended = cpu->regs.r1;
+                            #ifdef _CPU_DEEP_DEBUG_
+                            log_msg(LP_DEBUG, "CPU (C:%d CS:%d DS:%d): admx base address [%.4x]", cpu->clock, cpu->state, cpu->device.device_state, cpu->intermediate.argument_address_extended);
+                            #endif
+                            cpu->state = CS_FETCH_SOURCE;
+                        }
+                        break;
+                    
+                    case ADMX_IND_R2:
+                        {
+                            cpu->intermediate.argument_address_extended = cpu->regs.r2;
+                            #ifdef _CPU_DEEP_DEBUG_
+                            log_msg(LP_DEBUG, "CPU (C:%d CS:%d DS:%d): admx base address [%.4x]", cpu->clock, cpu->state, cpu->device.device_state, cpu->intermediate.argument_address_extended);
+                            #endif
+                            cpu->state = CS_FETCH_SOURCE;
+                        }
+                        break;
+                    
+                    case ADMX_IND_R3:
+                        {
+                            cpu->intermediate.argument_address_extended = cpu->regs.r3;
+                            #ifdef _CPU_DEEP_DEBUG_
+                            log_msg(LP_DEBUG, "CPU (C:%d CS:%d DS:%d): admx base address [%.4x]", cpu->clock, cpu->state, cpu->device.device_state, cpu->intermediate.argument_address_extended);
+                            #endif
+                            cpu->state = CS_FETCH_SOURCE;
+                        }
+                        break;
+                    
+                    case ADMX_IND_SP:
+                        {
+                            cpu->intermediate.argument_address_extended = cpu->regs.sp;
+                            #ifdef _CPU_DEEP_DEBUG_
+                            log_msg(LP_DEBUG, "CPU (C:%d CS:%d DS:%d): admx base address [%.4x]", cpu->clock, cpu->state, cpu->device.device_state, cpu->intermediate.argument_address_extended); 
+                            #endif
+                            cpu->state = CS_FETCH_SOURCE;
+                        }
+                        break;
+                    
+                    case ADMX_IND_PC:
+                        {
+                            cpu->intermediate.argument_address_extended = cpu->regs.pc;
+                            #ifdef _CPU_DEEP_DEBUG_
+                            log_msg(LP_DEBUG, "CPU (C:%d CS:%d DS:%d): admx base address [%.4x]", cpu->clock, cpu->state, cpu->device.device_state, cpu->intermediate.argument_address_extended); 
+                            #endif
+                            cpu->state = CS_FETCH_SOURCE;
+                        }
+                        break;
+                    
+                    case ADMX_IND16:
+                        {
+                            cpu->intermediate.argument_address_extended = (uint8_t) cpu->intermediate.argument_data_raw[argument_index];
+                            argument_index ++;
+                            cpu->intermediate.argument_address_extended |= (cpu->intermediate.argument_data_raw[argument_index] << 8);
+                            argument_index ++;
+                            #ifdef _CPU_DEEP_DEBUG_
+                            log_msg(LP_DEBUG, "CPU (C:%d CS:%d DS:%d): admx base address [%.4x]", cpu->clock, cpu->state, cpu->device.device_state, cpu->intermediate.argument_address_extended);
+                            #endif
+                            cpu->state = CS_FETCH_SOURCE;
+                        }
+                        break;
+                    
+                    case ADMX_IND_R0_OFFSET16:
+                        {
+                            cpu->intermediate.argument_address_extended = (uint8_t) cpu->intermediate.argument_data_raw[argument_index];
+                            argument_index ++;
+                            cpu->intermediate.argument_address_extended |= (cpu->intermediate.argument_data_raw[argument_index] << 8);
+                            argument_index ++;
+                            ////log_msg_inline(LP_DEBUG, "CPU (C:%d CS:%d DS:%d): admx base address [%.4x + %.4x] = ", cpu->clock, cpu->state, cpu->device.device_state, cpu->intermediate.argument_address_extended, cpu->regs.r0);
+                            cpu->intermediate.argument_address_extended += cpu->regs.r0;
+                            //printf("[%.4x]\n", cpu->intermediate.argument_address_extended);
+                            cpu->state = CS_FETCH_SOURCE;
+                        }
+                        break;
+                    
+                    case ADMX_IND_R1_OFFSET16:
+                        {
+                            cpu->intermediate.argument_address_extended = (uint8_t) cpu->intermediate.argument_data_raw[argument_index];
+                            argument_index ++;
+                            cpu->intermediate.argument_address_extended |= (cpu->intermediate.argument_data_raw[argument_index] << 8);
+                            argument_index ++;
+                            ////log_msg_inline(LP_DEBUG, "CPU (C:%d CS:%d DS:%d): admx base address [%.4x + %.4x] = ", cpu->clock, cpu->state, cpu->device.device_state, cpu->intermediate.argument_address_extended, cpu->regs.r1);
+                            cpu->intermediate.argument_address_extended += cpu->regs.r1;
+                            //printf("[%.4x]\n", cpu->intermediate.argument_address_extended);
+                            cpu->state = CS_FETCH_SOURCE;
+                        }
+                        break;
+                    
+                    case ADMX_IND_R2_OFFSET16:
+                        {
+                            cpu->intermediate.argument_address_extended = (uint8_t) cpu->intermediate.argument_data_raw[argument_index];
+                            argument_index ++;
+                            cpu->intermediate.argument_address_extended |= (cpu->intermediate.argument_data_raw[argument_index] << 8);
+                            argument_index ++;
+                            ////log_msg_inline(LP_DEBUG, "CPU (C:%d CS:%d DS:%d): admx base address [%.4x + %.4x] = ", cpu->clock, cpu->state, cpu->device.device_state, cpu->intermediate.argument_address_extended, cpu->regs.r2);
+                            cpu->intermediate.argument_address_extended += cpu->regs.r2;
+                            //printf("[%.4x]\n", cpu->intermediate.argument_address_extended);
+                            cpu->state = CS_FETCH_SOURCE;
+                        }
+                        break;
+                    
+                    case ADMX_IND_R3_OFFSET16:
+                        {
+                            cpu->intermediate.argument_address_extended = (uint8_t) cpu->intermediate.argument_data_raw[argument_index];
+                            argument_index ++;
+                            cpu->intermediate.argument_address_extended |= (cpu->intermediate.argument_data_raw[argument_index] << 8);
+                            argument_index ++;
+                            ////log_msg_inline(LP_DEBUG, "CPU (C:%d CS:%d DS:%d): admx base address [%.4x + %.4x] = ", cpu->clock, cpu->state, cpu->device.device_state, cpu->intermediate.argument_address_extended, cpu->regs.r3);
+                            cpu->intermediate.argument_address_extended += cpu->regs.r3;
+                            //printf("[%.4x]\n", cpu->intermediate.argument_address_extended);
+                            cpu->state = CS_FETCH_SOURCE;
+                        }
+                        break;
+                    
+                    case ADMX_IND_SP_OFFSET16:
+                        {
+                            cpu->intermediate.argument_address_extended = (uint8_t) cpu->intermediate.argument_data_raw[argument_index];
+                            argument_index ++;
+                            cpu->intermediate.argument_address_extended |= (cpu->intermediate.argument_data_raw[argument_index] << 8);
+                            argument_index ++;
+                            ////log_msg_inline(LP_DEBUG, "CPU (C:%d CS:%d DS:%d): admx base address [%.4x + %.4x] = ", cpu->clock, cpu->state, cpu->device.device_state, cpu->intermediate.argument_address_extended, cpu->regs.sp);
+                            cpu->intermediate.argument_address_extended += cpu->regs.sp;
+                            //printf("[%.4x]\n", cpu->intermediate.argument_address_extended);
+                            cpu->state = CS_FETCH_SOURCE;
+                        }
+                        break;
+                    
+                    case ADMX_IND_PC_OFFSET16:
+                        {
+                            cpu->intermediate.argument_address_extended = (uint8_t) cpu->intermediate.argument_data_raw[argument_index];
+                            argument_index ++;
+                            cpu->intermediate.argument_address_extended |= (cpu->intermediate.argument_data_raw[argument_index] << 8);
+                            argument_index ++;
+                            ////log_msg_inline(LP_DEBUG, "CPU (C:%d CS:%d DS:%d): admx base address [%.4x + %.4x] = ", cpu->clock, cpu->state, cpu->device.device_state, cpu->intermediate.argument_address_extended, cpu->regs.pc);
+                            cpu->intermediate.argument_address_extended += cpu->regs.pc;
+                            //printf("[%.4x]\n", cpu->intermediate.argument_address_extended);
+                            cpu->state = CS_FETCH_SOURCE;
+                        }
+                        break;
+
+                    case ADMX_IND16_SCALED8_R0_OFFSET:
+                        {
+                            cpu->intermediate.argument_address_extended = (uint8_t) cpu->intermediate.argument_data_raw[argument_index];
+                            argument_index ++;
+                            cpu->intermediate.argument_address_extended |= (cpu->intermediate.argument_data_raw[argument_index] << 8);
+                            argument_index ++;
+                            uint8_t scaler = cpu->intermediate.argument_data_raw[argument_index];
+                            ////log_msg_inline(LP_DEBUG, "CPU (C:%d CS:%d DS:%d): admx base address [%.4x + %.2x * %.4x] = ", cpu->clock, cpu->state, cpu->device.device_state, cpu->intermediate.argument_address_extended, scaler, cpu->regs.r0);
+                            cpu->intermediate.argument_address_extended += scaler * cpu->regs.r0;
+                            //printf("[%.4x]\n", cpu->intermediate.argument_address_extended);
+                            cpu->state = CS_FETCH_SOURCE;
+                        }
+                        break;
+
+                    case ADMX_IND16_SCALED8_R1_OFFSET:
+                        {
+                            cpu->intermediate.argument_address_extended = (uint8_t) cpu->intermediate.argument_data_raw[argument_index];
+                            argument_index ++;
+                            cpu->intermediate.argument_address_extended |= (cpu->intermediate.argument_data_raw[argument_index] << 8);
+                            argument_index ++;
+                            uint8_t scaler = cpu->intermediate.argument_data_raw[argument_index];
+                            ////log_msg_inline(LP_DEBUG, "CPU (C:%d CS:%d DS:%d): admx base address [%.4x + %.2x * %.4x] = ", cpu->clock, cpu->state, cpu->device.device_state, cpu->intermediate.argument_address_extended, scaler, cpu->regs.r1);
+                            cpu->intermediate.argument_address_extended += scaler * cpu->regs.r1;
+                            //printf("[%.4x]\n", cpu->intermediate.argument_address_extended);
+                            cpu->state = CS_FETCH_SOURCE;
+                        }
+                        break;
+
+                    case ADMX_IND16_SCALED8_R2_OFFSET:
+                        {
+                            cpu->intermediate.argument_address_extended = (uint8_t) cpu->intermediate.argument_data_raw[argument_index];
+                            argument_index ++;
+                            cpu->intermediate.argument_address_extended |= (cpu->intermediate.argument_data_raw[argument_index] << 8);
+                            argument_index ++;
+                            uint8_t scaler = cpu->intermediate.argument_data_raw[argument_index];
+                            ////log_msg_inline(LP_DEBUG, "CPU (C:%d CS:%d DS:%d): admx base address [%.4x + %.2x * %.4x] = ", cpu->clock, cpu->state, cpu->device.device_state, cpu->intermediate.argument_address_extended, scaler, cpu->regs.r2);
+                            cpu->intermediate.argument_address_extended += scaler * cpu->regs.r2;
+                            //printf("[%.4x]\n", cpu->intermediate.argument_address_extended);
+                            cpu->state = CS_FETCH_SOURCE;
+                        }
+                        break;
+
+                    case ADMX_IND16_SCALED8_R3_OFFSET:
+                        {
+                            cpu->intermediate.argument_address_extended = (uint8_t) cpu->intermediate.argument_data_raw[argument_index];
+                            argument_index ++;
+                            cpu->intermediate.argument_address_extended |= (cpu->intermediate.argument_data_raw[argument_index] << 8);
+                            argument_index ++;
+                            uint8_t scaler = cpu->intermediate.argument_data_raw[argument_index];
+                            ////log_msg_inline(LP_DEBUG, "CPU (C:%d CS:%d DS:%d): admx base address [%.4x + %.2x * %.4x] = ", cpu->clock, cpu->state, cpu->device.device_state, cpu->intermediate.argument_address_extended, scaler, cpu->regs.r3);
+                            cpu->intermediate.argument_address_extended += scaler * cpu->regs.r3;
+                            //printf("[%.4x]\n", cpu->intermediate.argument_address_extended);
+                            cpu->state = CS_FETCH_SOURCE;
+                        }
+                        break;
+
+                    case ADMX_IND16_SCALED8_SP_OFFSET:
+                        {
+                            cpu->intermediate.argument_address_extended = (uint8_t) cpu->intermediate.argument_data_raw[argument_index];
+                            argument_index ++;
+                            cpu->intermediate.argument_address_extended |= (cpu->intermediate.argument_data_raw[argument_index] << 8);
+                            argument_index ++;
+                            uint8_t scaler = cpu->intermediate.argument_data_raw[argument_index];
+                            ////log_msg_inline(LP_DEBUG, "CPU (C:%d CS:%d DS:%d): admx base address [%.4x + %.2x * %.4x] = ", cpu->clock, cpu->state, cpu->device.device_state, cpu->intermediate.argument_address_extended, scaler, cpu->regs.sp);
+                            cpu->intermediate.argument_address_extended += scaler * cpu->regs.sp;
+                            //printf("[%.4x]\n", cpu->intermediate.argument_address_extended);
+                            cpu->state = CS_FETCH_SOURCE;
+                        }
+                        break;
+
+                    case ADMX_IND16_SCALED8_PC_OFFSET:
+                        {
+                            cpu->intermediate.argument_address_extended = (uint8_t) cpu->intermediate.argument_data_raw[argument_index];
+                            argument_index ++;
+                            cpu->intermediate.argument_address_extended |= (cpu->intermediate.argument_data_raw[argument_index] << 8);
+                            argument_index ++;
+                            uint8_t scaler = cpu->intermediate.argument_data_raw[argument_index];
+                            ////log_msg_inline(LP_DEBUG, "CPU (C:%d CS:%d DS:%d): admx base address [%.4x + %.2x * %.4x] = ", cpu->clock, cpu->state, cpu->device.device_state, cpu->intermediate.argument_address_extended, scaler, cpu->regs.pc);
+                            cpu->intermediate.argument_address_extended += scaler * cpu->regs.pc;
+                            //printf("[%.4x]\n", cpu->intermediate.argument_address_extended);
+                            cpu->state = CS_FETCH_SOURCE;
+                        }
+                        break;
+
+                    case ADMX_NONE:
+                        #ifdef _CPU_DEEP_DEBUG_
+                        log_msg(LP_DEBUG, "CPU (C:%d CS:%d DS:%d): no admx address specified", cpu->clock, cpu->state, cpu->device.device_state);
+                        #endif
+                        cpu->state = CS_FETCH_DESTINATION;
+                        break;
+
+                    default:
+                        #ifdef _CPU_DEEP_DEBUG_
+                        log_msg(LP_ERROR, "CPU (C:%d CS:%d DS:%d): unknown extended addressing mode [%s:%d]", cpu->clock, cpu->state, cpu->device.device_state, __FILE__, __LINE__);
+                        #endif
+                        break;
+                }
+                // We cant switch the oder of admr and admx to add goto skip-aheads, because of argument_index
+                #ifdef _CPU_DEEP_DEBUG_
+                log_msg(LP_INFO, "CPU (C:%d CS:%d DS:%d): admr %s", cpu->clock, cpu->state, cpu->device.device_state, cpu_reduced_addressing_mode_string[admr]);
+                #endif
+                switch (admr) {
+                    case ADMR_R0:
+                    case ADMR_R1:
+                    case ADMR_R2:
+                    case ADMR_R3:
+                    case ADMR_SP:
+                        #ifdef _CPU_DEEP_DEBUG_
+                        log_msg(LP_DEBUG, "CPU (C:%d CS:%d DS:%d): admr is not an address", cpu->clock, cpu->state, cpu->device.device_state, cpu->intermediate.argument_address_reduced);
+                        #endif
+                        break;
+
+                    case ADMR_IND16:
+                        cpu->intermediate.argument_address_reduced = (uint8_t) cpu->intermediate.argument_data_raw[argument_index];
+                        argument_index ++;
+                        cpu->intermediate.argument_address_reduced |= (cpu->intermediate.argument_data_raw[argument_index] << 8);
+                        //argument_index ++;
+                        #ifdef _CPU_DEEP_DEBUG_
+                        log_msg(LP_DEBUG, "CPU (C:%d CS:%d DS:%d): admr address [%.4x]", cpu->clock, cpu->state, cpu->device.device_state, cpu->intermediate.argument_address_reduced);
+                        #endif
+                        break;
+
+                    case ADMR_IND_R0:
+                        cpu->intermediate.argument_address_reduced = cpu->regs.r0;
+                        #ifdef _CPU_DEEP_DEBUG_
+                        log_msg(LP_DEBUG, "CPU (C:%d CS:%d DS:%d): admr address [%.4x]", cpu->clock, cpu->state, cpu->device.device_state, cpu->intermediate.argument_address_reduced);
+                        #endif
+                        break;
+
+                    case ADMR_NONE:
+                        #ifdef _CPU_DEEP_DEBUG_
+                        log_msg(LP_DEBUG, "CPU (C:%d CS:%d DS:%d): no admx address specified", cpu->clock, cpu->state, cpu->device.device_state);
+                        #endif
+                        //cpu->state = CS_FETCH_DESTINATION;
+                        break;
+
+                    default:
+                        #ifdef _CPU_DEEP_DEBUG_
+                        log_msg(LP_ERROR, "CPU (C:%d CS:%d DS:%d): unknown reduced addressing mode [%s:%d]", cpu->clock, cpu->state, cpu->device.device_state, __FILE__, __LINE__);
+                        #endif
+                        break;
+                }
+            }
+            break;
+
+        case CS_FETCH_SOURCE: // only fetch data from source, nothing else
+            {
+                #ifdef _CPU_DEEP_DEBUG_
+                log_msg(LP_INFO, "CPU (C:%d CS:%d DS:%d): Fetching source (low) from adm address", cpu->clock, cpu->state, cpu->device.device_state);
+                #endif
+                cpu->regs.sr.MNI = 0;
+                int admxc = cpu_extended_addressing_mode_category[cpu->intermediate.addressing_mode.addressing_mode_extended];
+                switch (admxc) {
+                    case ADMC_IMM:
+                        {
+                            int admx = cpu->intermediate.addressing_mode.addressing_mode_extended;
+                            switch (admx) {
+                                case ADMX_IMM16:
+                                    #ifdef _CPU_DEEP_DEBUG_
+                                    log_msg(LP_DEBUG, "CPU (C:%d CS:%d DS:%d): IMM16", cpu->clock, cpu->state, cpu->device.device_state);
+                                    #endif
+                                    cpu->intermediate.data_address_extended = (uint8_t) cpu->intermediate.argument_data_raw[cpu->intermediate.argument_count_for_admr];
+                                    cpu->intermediate.data_address_extended |= (cpu->intermediate.argument_data_raw[cpu->intermediate.argument_count_for_admr + 1] << 8);
+                                    break;
+                                default:
+                                    #ifdef _CPU_DEEP_DEBUG_
+                                    log_msg(LP_ERROR, "CPU (C:%d CS:%d DS:%d): unknown immediate extended addressing mode [%s:%d]", cpu->clock, cpu->state, cpu->device.device_state, __FILE__, __LINE__);
+                                    #endif
+                                    break;
+                            }
+                            if (cpu->intermediate.argument_count == 2) {
+                                cpu->state = CS_FETCH_DESTINATION;
+                                goto CS_FETCH_DESTINATION;
+                            } else {
+                                #ifdef _CPU_DEEP_DEBUG_
+                                log_msg(LP_DEBUG, "CPU (C:%d CS:%d DS:%d): Skipping destination fetching, cause only one argument", cpu->clock, cpu->state, cpu->device.device_state);
+                                #endif
+                                cpu->state = CS_EXECUTE;
+                                goto CS_EXECUTE;
+                            }
+                            
+                        }
+                        break;
+                    case ADMC_REG:
+                        {
+                            int admx = cpu->intermediate.addressing_mode.addressing_mode_extended;
+                            switch (admx) {
+                                case ADMX_R0:
+                                    #ifdef _CPU_DEEP_DEBUG_
+                                    log_msg(LP_DEBUG, "CPU (C:%d CS:%d DS:%d): r0", cpu->clock, cpu->state, cpu->device.device_state);
+                                    #endif
+                                    cpu->intermediate.data_address_extended = cpu->regs.r0;
+                                    break;
+                                case ADMX_R1:
+                                    #ifdef _CPU_DEEP_DEBUG_
+                                    log_msg(LP_DEBUG, "CPU (C:%d CS:%d DS:%d): r1", cpu->clock, cpu->state, cpu->device.device_state);
+                                    #endif
+                                    cpu->intermediate.data_address_extended = cpu->regs.r1;
+                                    break;
+                                case ADMX_R2:
+                                    #ifdef _CPU_DEEP_DEBUG_
+                                    log_msg(LP_DEBUG, "CPU (C:%d CS:%d DS:%d): r2", cpu->clock, cpu->state, cpu->device.device_state);
+                                    #endif
+                                    cpu->intermediate.data_address_extended = cpu->regs.r2;
+                                    break;
+                                case ADMX_R3:
+                                    #ifdef _CPU_DEEP_DEBUG_
+                                    log_msg(LP_DEBUG, "CPU (C:%d CS:%d DS:%d): r3", cpu->clock, cpu->state, cpu->device.device_state);
+                                    #endif
+                                    cpu->intermediate.data_address_extended = cpu->regs.r3;
+                                    break;
+                                case ADMX_SP:
+                                    #ifdef _CPU_DEEP_DEBUG_
+                                    log_msg(LP_DEBUG, "CPU (C:%d CS:%d DS:%d): sp", cpu->clock, cpu->state, cpu->device.device_state);
+                                    #endif
+                                    cpu->intermediate.data_address_extended = cpu->regs.sp;
+                                    break;
+                                case ADMX_PC:
+                                    #ifdef _CPU_DEEP_DEBUG_
+                                    log_msg(LP_DEBUG, "CPU (C:%d CS:%d DS:%d): pc", cpu->clock, cpu->state, cpu->device.device_state);
+                                    #endif
+                                    cpu->intermediate.data_address_extended = cpu->intermediate.previous_pc;
+                                    break;
+                                    
+                                default:
+                                    #ifdef _CPU_DEEP_DEBUG_
+                                    log_msg(LP_ERROR, "CPU (C:%d CS:%d DS:%d): unknown register extended addressing mode [%s:%d]", cpu->clock, cpu->state, cpu->device.device_state, __FILE__, __LINE__);
+                                    #endif
+                                    break;
+                            }
+                            if (cpu->intermediate.argument_count == 2) {
+                                cpu->state = CS_FETCH_DESTINATION;
+                                goto CS_FETCH_DESTINATION;
+                            } else {
+                                #ifdef _CPU_DEEP_DEBUG_
+                                log_msg(LP_DEBUG, "CPU (C:%d CS:%d DS:%d): Skipping destination fetching, cause only one argument", cpu->clock, cpu->state, cpu->device.device_state);
+                                #endif
+                                cpu->state = CS_EXECUTE;
+                                goto CS_EXECUTE;
+                            }
+                        }
+                        break;
+                    case ADMC_IND:
+                        {
+                            uint8_t data;
+                            int success = CPU_CLOCK_READ_MEMORY(cpu, cpu->intermediate.argument_address_extended, &data);
+                            if (success) {
+                                cpu->intermediate.data_address_extended = (uint8_t) data;
+                                cpu->state = CS_FETCH_SOURCE_HIGH;
+                                goto CS_FETCH_SOURCE_HIGH;
+                            }
+                            break;
+                        }
+                    default:
+                        #ifdef _CPU_DEEP_DEBUG_
+                        log_msg(LP_ERROR, "CPU (C:%d CS:%d DS:%d): Unkown indirect extended addressing mode category %d [%s:%d]", cpu->clock, cpu->state, cpu->device.device_state, admxc, __FILE__, __LINE__);
+                        #endif
+                        break;
+                }
+            }
+            #ifdef _CPU_DEEP_DEBUG_
+            log_msg(LP_INFO, "CPU (C:%d CS:%d DS:%d): Intermediate data_address_extended %.4x", cpu->clock, cpu->state, cpu->device.device_state, cpu->intermediate.data_address_extended);
+            #endif
+            break;
+        
+        case CS_FETCH_SOURCE_HIGH: // only fetch data from source, nothing else
+            {
+                CS_FETCH_SOURCE_HIGH:
+                #ifdef _CPU_DEEP_DEBUG_
+                log_msg(LP_INFO, "CPU (C:%d CS:%d DS:%d): Fetching source high from adm address", cpu->clock, cpu->state, cpu->device.device_state);
+                #endif
+                cpu->regs.sr.MNI = 0;
+                int admc = cpu_extended_addressing_mode_category[cpu->intermediate.addressing_mode.addressing_mode_extended];
+                switch (admc) {
+                    case ADMC_IND:
+                        {
+                            uint8_t data;
+                            int success = CPU_CLOCK_READ_MEMORY(cpu, cpu->intermediate.argument_address_extended + 1, &data);
+                            if (success) {
+                                cpu->intermediate.data_address_extended |= (uint16_t)(data << 8);
+                                
+                                if (cpu->intermediate.argument_count == 2) {
+                                    cpu->state = CS_FETCH_DESTINATION;
+                                    goto CS_FETCH_DESTINATION;
+                                } else {
+                                    #ifdef _CPU_DEEP_DEBUG_
+                                    log_msg(LP_DEBUG, "CPU (C:%d CS:%d DS:%d): Skipping destination fetching, cause only one argument", cpu->clock, cpu->state, cpu->device.device_state);
+                                    #endif
+                                    cpu->state = CS_EXECUTE;
+                                    goto CS_EXECUTE;
+                                }
+                            }
+                            break;
+                        }
+                    default:
+                        #ifdef _CPU_DEEP_DEBUG_
+                        log_msg(LP_ERROR, "CPU (C:%d CS:%d DS:%d): Unkown indirect extended addressing mode category %d [%s:%d]", cpu->clock, cpu->state, cpu->device.device_state, admc, __FILE__, __LINE__);
+                        #endif
+                        break;
+                }
+            }
+            #ifdef _CPU_DEEP_DEBUG_
+            log_msg(LP_INFO, "CPU (C:%d CS:%d DS:%d): Intermediate data_address_extended %.4x", cpu->clock, cpu->state, cpu->device.device_state, cpu->intermediate.data_address_extended);
+            #endif
+            break;
+        
+        case CS_FETCH_DESTINATION: // only fetch data from destination, nothing else
+            {
+                CS_FETCH_DESTINATION:
+                #ifdef _CPU_DEEP_DEBUG_
+                log_msg(LP_INFO, "CPU (C:%d CS:%d DS:%d): Fetching destination from adm address", cpu->clock, cpu->state, cpu->device.device_state);
+                #endif
+                cpu->regs.sr.MNI = 0;
+                int admc = cpu_reduced_addressing_mode_category[cpu->intermediate.addressing_mode.addressing_mode_reduced];
+                switch (admc) {
+                    
+                    case ADMC_REG:
+                        {
+                            int admr = cpu->intermediate.addressing_mode.addressing_mode_reduced;
+                            switch (admr) {
+                                case ADMR_R0:
+                                    #ifdef _CPU_DEEP_DEBUG_
+                                    log_msg(LP_DEBUG, "CPU (C:%d CS:%d DS:%d): r0", cpu->clock, cpu->state, cpu->device.device_state);
+                                    #endif
+                                    cpu->intermediate.data_address_reduced = cpu->regs.r0;
+                                    break;
+                                case ADMR_R1:
+                                    #ifdef _CPU_DEEP_DEBUG_
+                                    log_msg(LP_DEBUG, "CPU (C:%d CS:%d DS:%d): r1", cpu->clock, cpu->state, cpu->device.device_state);
+                                    #endif
+                                    cpu->intermediate.data_address_reduced = cpu->regs.r1;
+                                    break;
+                                case ADMR_R2:
+                                    #ifdef _CPU_DEEP_DEBUG_
+                                    log_msg(LP_DEBUG, "CPU (C:%d CS:%d DS:%d): r2", cpu->clock, cpu->state, cpu->device.device_state);
+                                    #endif
+                                    cpu->intermediate.data_address_reduced = cpu->regs.r2;
+                                    break;
+                                case ADMR_R3:
+                                    #ifdef _CPU_DEEP_DEBUG_
+                                    log_msg(LP_DEBUG, "CPU (C:%d CS:%d DS:%d): r3", cpu->clock, cpu->state, cpu->device.device_state);
+                                    #endif
+                                    cpu->intermediate.data_address_reduced = cpu->regs.r3;
+                                    break;
+                                case ADMR_SP:
+                                    #ifdef _CPU_DEEP_DEBUG_
+                                    log_msg(LP_DEBUG, "CPU (C:%d CS:%d DS:%d): sp", cpu->clock, cpu->state, cpu->device.device_state);
+                                    #endif
+                                    cpu->intermediate.data_address_reduced = cpu->regs.sp;
+                                    break;
+
+                                default:
+                                    #ifdef _CPU_DEEP_DEBUG_
+                                    log_msg(LP_ERROR, "CPU (C:%d CS:%d DS:%d): unknown register extended addressing mode [%s:%d]", cpu->clock, cpu->state, cpu->device.device_state, __FILE__, __LINE__);
+                                    #endif
+                                    break;
+                            }
+                            cpu->state = CS_EXECUTE;
+                            goto CS_EXECUTE;
+                        }
+                        break;
+                    case ADMC_IND:
+                        {
+                            uint8_t data;
+                            int success = CPU_CLOCK_READ_MEMORY(cpu, cpu->intermediate.argument_address_reduced, &data);
+                            if (success) {
+                                cpu->intermediate.data_address_reduced = (uint8_t) data;
+                                cpu->state = CS_FETCH_DESTINATION_HIGH;
+                                goto CS_FETCH_DESTINATION_HIGH;
+                            }
+                            break;
+                        }
+                    default:
+                        #ifdef _CPU_DEEP_DEBUG_
+                        log_msg(LP_ERROR, "CPU (C:%d CS:%d DS:%d): Unkown indirect extended addressing mode category %d [%s:%d]", cpu->clock, cpu->state, cpu->device.device_state, admc, __FILE__, __LINE__);
+                        #endif
+                        cpu->state = CS_EXCEPTION;
+                        break;
+                }
+            }
+            #ifdef _CPU_DEEP_DEBUG_
+            log_msg(LP_INFO, "CPU (C:%d CS:%d DS:%d): Intermediate data_address_reduced %.4x", cpu->clock, cpu->state, cpu->device.device_state, cpu->intermediate.data_address_reduced);
+            #endif
+            break;
+
+        case CS_FETCH_DESTINATION_HIGH: // only fetch data from destination, nothing else
+            {
+                CS_FETCH_DESTINATION_HIGH:
+                #ifdef _CPU_DEEP_DEBUG_
+                log_msg(LP_INFO, "CPU (C:%d CS:%d DS:%d): Fetching destination from adm address", cpu->clock, cpu->state, cpu->device.device_state);
+                #endif
+                cpu->regs.sr.MNI = 0;
+                int admc = cpu_reduced_addressing_mode_category[cpu->intermediate.addressing_mode.addressing_mode_reduced];
+                switch (admc) {
+                    case ADMC_IND:
+                        {
+                            uint8_t data;
+                            int success = CPU_CLOCK_READ_MEMORY(cpu, cpu->intermediate.argument_address_reduced + 1, &data);
+                            if (success) {
+                                cpu->intermediate.data_address_reduced |= (uint16_t)(data << 8);
+                                cpu->state = CS_EXECUTE;
+                                goto CS_EXECUTE;
+                            }
+                            break;
+                        }
+                    default:
+                        #ifdef _CPU_DEEP_DEBUG_
+                        log_msg(LP_ERROR, "CPU (C:%d CS:%d DS:%d): Unkown indirect extended addressing mode category %d [%s:%d]", cpu->clock, cpu->state, cpu->device.device_state, admc, __FILE__, __LINE__);
+                        #endif
+                        break;
+                }
+            }
+            #ifdef _CPU_DEEP_DEBUG_
+            log_msg(LP_INFO, "CPU (C:%d CS:%d DS:%d): Intermediate data_address_reduced %.4x", cpu->clock, cpu->state, cpu->device.device_state, cpu->intermediate.data_address_reduced);
+            #endif
+            break;
+        
+        // =======================================================================================
+        case CS_EXECUTE: 
+            {
+                CS_EXECUTE:
+                #ifdef _CPU_DEEP_DEBUG_
+                log_msg(LP_INFO, "CPU (C:%d CS:%d DS:%d): Executing instruction and writing to intermediate result for possible writeback", cpu->clock, cpu->state, cpu->device.device_state);
+                #endif
+                cpu->regs.sr.MNI = 0;
+                if (cpu->flags.pending) {
+                    cpu_resolve_flags_for(cpu, cpu->intermediate.instruction);
+                }
+                if (CPU_CLOCK_OBSERVED && cpu->branch_predictor) {
+                    cpu_predict_branch(cpu);
+                }
+                #ifdef CPU_THREADED_DISPATCH
+                {
+                    // one indirect jump straight into the handler below, the switch stays as the portable fallback
+                    static void* const cpu_execute_target[INSTRUCTION_COUNT] = {
+                        CPU_INSTRUCTION_LIST(CPU_EXECUTE_TARGET_ENTRY)
+                    };
+                    uint32_t instruction = (uint32_t) cpu->intermediate.instruction;
+                    if (instruction < INSTRUCTION_COUNT && cpu_execute_target[instruction]) {
+                        CPU_EXECUTE_DISPATCH(cpu_execute_target[instruction]);
+                    }
+                    CPU_EXECUTE_DISPATCH(CPU_EXECUTE_TARGET(default));
+                }
+                #endif
+                switch (cpu->intermediate.instruction) {
+                    case NOP: CPU_EXECUTE_LABEL(NOP)
+                        cpu->instruction ++;
+                        cpu->state = CS_FETCH_INSTRUCTION;
+                        goto CS_FETCH_INSTRUCTION;
+                        break;
+                
+                    case MOV: CPU_EXECUTE_LABEL(MOV)
+                        cpu->intermediate.result = cpu->intermediate.data_address_extended;
+                        cpu->state = CS_WRITEBACK_LOW;
+                        goto CS_WRITEBACK_LOW;
+                        break;
+                
+                    case MOVB: CPU_EXECUTE_LABEL(MOVB)
+                        cpu->intermediate.result = (cpu->intermediate.data_address_extended & 0x00ff) | (cpu->intermediate.data_address_extended << 8); // janky, just to get the behavior to be consistent between register and ram usage
+                        cpu->intermediate.argument_address_reduced -= 1;
+                        cpu->state = CS_WRITEBACK_HIGH;
+                        goto CS_WRITEBACK_HIGH;
+                        break;
+
+                    case PUSH: CPU_EXECUTE_LABEL(PUSH)
+                        cpu->intermediate.result = cpu->intermediate.data_address_extended;
+                        cpu->state = CS_PUSH_HIGH;
+                        goto CS_PUSH_HIGH;
+                        break;
+                
+                    case PUSHB: CPU_EXECUTE_LABEL(PUSHB)
+                        cpu->intermediate.result = cpu->intermediate.data_address_extended;
+                        cpu->state = CS_PUSH_LOW;
+                        goto CS_PUSH_LOW;
+                        break;
+
+                    case POP: CPU_EXECUTE_LABEL(POP)
+                        cpu->state = CS_POP_LOW;
+                        goto CS_POP_LOW;
+                        break;
+                
+                    case POPB: CPU_EXECUTE_LABEL(POPB)
+                        cpu->state = CS_POP_LOW;
+                        goto CS_POP_LOW;
+                        break;
+
+                    case PUSHSR: CPU_EXECUTE_LABEL(PUSHSR)
+                        cpu->intermediate.result = cpu->regs.sr.value;
+                        cpu->state = CS_PUSH_HIGH;
+                        goto CS_PUSH_HIGH;
+                        break;
+
+                    case POPSR: CPU_EXECUTE_LABEL(POPSR)
+                        cpu->intermediate.argument_address_reduced = cpu->regs.sp;
+                        cpu->state = CS_POPSR_LOW;
+                        goto CS_POPSR_LOW;
+                        break;
+                    
+                    
+                    case JMP: CPU_EXECUTE_LABEL(JMP)
+                        cpu->regs.pc = cpu->intermediate.data_address_extended;
+                        cpu->instruction ++;
+                        cpu->state = CS_FETCH_INSTRUCTION;
+                        goto CS_FETCH_INSTRUCTION;
+                        break;
+                    
+                    case JZ: CPU_EXECUTE_LABEL(JZ)
+                        if (cpu->regs.sr.Z) {
+                            cpu->regs.pc = cpu->intermediate.data_address_extended;
+                        }
+                        cpu->instruction ++;
+                        cpu->state = CS_FETCH_INSTRUCTION;
+                        goto CS_FETCH_INSTRUCTION;
+                        break;
+                    
+                    case JNZ: CPU_EXECUTE_LABEL(JNZ)
+                        if (!cpu->regs.sr.Z) {
+                            cpu->regs.pc = cpu->intermediate.data_address_extended;
+                        }
+                        cpu->instruction ++;
+                        cpu->state = CS_FETCH_INSTRUCTION;
+                        goto CS_FETCH_INSTRUCTION;
+                        break;
+            
+                    case CALL: CPU_EXECUTE_LABEL(CALL)
+                        cpu->intermediate.result = cpu->regs.pc;
+                        cpu->regs.pc = cpu->intermediate.data_address_extended;
+                        cpu->state = CS_PUSH_HIGH;
+                        goto CS_PUSH_HIGH;
+                        break;
+                    
+                    case RET: CPU_EXECUTE_LABEL(RET)
+                        cpu->intermediate.argument_address_reduced = cpu->regs.sp;
+                        cpu->state = CS_POP_LOW; // the part with writing to pc is taken care of in CS_POP_HIGH
+                        goto CS_POP_LOW;
+                        break;
+
+                    case CMP: CPU_EXECUTE_LABEL(CMP) {
+                            cpu_compare(cpu, cpu->intermediate.data_address_reduced, cpu->intermediate.data_address_extended);
+                            cpu->instruction ++;
+                            cpu->state = CS_FETCH_INSTRUCTION;
+                            goto CS_FETCH_INSTRUCTION;
+                        }
+                        break;
+                    
+                    case TST: CPU_EXECUTE_LABEL(TST) {
+                            cpu_test(cpu, cpu->intermediate.data_address_extended);
+                            cpu->instruction ++;
+                            cpu->state = CS_FETCH_INSTRUCTION;
+                            goto CS_FETCH_INSTRUCTION;
+                        }
+                        break;
+                
+                    case AND: CPU_EXECUTE_LABEL(AND)
+                        cpu->intermediate.result = cpu->intermediate.data_address_reduced & cpu->intermediate.data_address_extended;
+                        //cpu_update_status_register(cpu, cpu->intermediate.result);
+                        cpu->state = CS_WRITEBACK_LOW;
+                        goto CS_WRITEBACK_LOW;
+                        break;
+                    
+                    case OR: CPU_EXECUTE_LABEL(OR)
+                        cpu->intermediate.result = cpu->intermediate.data_address_reduced | cpu->intermediate.data_address_extended;
+                        //cpu_update_status_register(cpu, cpu->intermediate.result);
+                        cpu->state = CS_WRITEBACK_LOW;
+                        goto CS_WRITEBACK_LOW;
+                        break;
+                    
+                    case XOR: CPU_EXECUTE_LABEL(XOR)
+                        cpu->intermediate.result = cpu->intermediate.data_address_reduced ^ cpu->intermediate.data_address_extended;
+                        //cpu_update_status_register(cpu, cpu->intermediate.result);
+                        cpu->state = CS_WRITEBACK_LOW;
+                        goto CS_WRITEBACK_LOW;
+                        break;
+                    
+                    case NOT: CPU_EXECUTE_LABEL(NOT)
+                        cpu->intermediate.result = ~cpu->intermediate.data_address_reduced;
+                        //cpu_update_status_register(cpu, cpu->intermediate.result);
+                        cpu->state = CS_WRITEBACK_LOW;
+                        goto CS_WRITEBACK_LOW;
+                        break;
+
+                    case UBS: CPU_EXECUTE_LABEL(UBS)
+                        cpu->intermediate.result = cpu_alu_ubs(cpu, cpu->intermediate.data_address_reduced, cpu->intermediate.data_address_extended);
+                        cpu->state = CS_WRITEBACK_LOW;
+                        goto CS_WRITEBACK_LOW;
+                        break;
+
+                    case SBS: CPU_EXECUTE_LABEL(SBS)
+                        cpu->intermediate.result = cpu_alu_sbs(cpu, cpu->intermediate.data_address_reduced, cpu->intermediate.data_address_extended);
+                        cpu->state = CS_WRITEBACK_LOW;
+                        goto CS_WRITEBACK_LOW;
+                        break;
+
+                    case INT: CPU_EXECUTE_LABEL(INT)
+                        #ifdef _CPU_DEEP_DEBUG_
+                        log_msg(LP_ERROR, "CPU (C:%d CS:%d DS:%d): undefined instruction INT [%s:%d]", cpu->clock, cpu->state, cpu->device.device_state, __FILE__, __LINE__);
+                        #endif
+                        //printf("%c", cpu->intermediate.data_address_extended & 0xffff);
+                        //cpu->instruction ++;
+                        //cpu->state = CS_FETCH_INSTRUCTION;
+                        cpu->instruction ++;
+                        cpu->state = CS_INTERRUPT_PUSH_PC_HIGH;
+                        goto CS_INTERRUPT_PUSH_PC_HIGH;
+                        //cpu->intermediate.irq_id = ;
+                        break;
+
+                    case HLT: CPU_EXECUTE_LABEL(HLT)
+                        cpu->instruction ++;
+                        cpu->state = CS_HALT;
+                        break;
+
+                    case LEA: CPU_EXECUTE_LABEL(LEA)
+                        cpu->intermediate.result = cpu->intermediate.argument_address_extended;
+                        cpu->state = CS_WRITEBACK_LOW;
+                        goto CS_WRITEBACK_LOW;
+                        break;
+
+                    case ADD: CPU_EXECUTE_LABEL(ADD)
+                        cpu->intermediate.result = (int16_t) cpu->intermediate.data_address_reduced + (int16_t) cpu->intermediate.data_address_extended;
+                        cpu->regs.sr.AO = ((uint32_t) cpu->intermediate.data_address_reduced + (uint32_t) cpu->intermediate.data_address_extended) > 0xffff;
+                        //cpu_update_status_register(cpu, cpu->intermediate.result);
+                        cpu->state = CS_WRITEBACK_LOW;
+                        goto CS_WRITEBACK_LOW;
+                        break;
+
+                    case SUB: CPU_EXECUTE_LABEL(SUB)
+                        cpu->intermediate.result = (int16_t) cpu->intermediate.data_address_reduced - (int16_t) cpu->intermediate.data_address_extended;
+                        cpu->regs.sr.AO = ((int32_t) cpu->intermediate.data_address_reduced - (int32_t) cpu->intermediate.data_address_extended) < 0;
+                        //cpu_update_status_register(cpu, cpu->intermediate.result);
+                        cpu->state = CS_WRITEBACK_LOW;
+                        goto CS_WRITEBACK_LOW;
+                        break;
+
+                    case NEG: CPU_EXECUTE_LABEL(NEG)
+                        cpu->intermediate.result = ~cpu->intermediate.data_address_reduced + 1;
+                        //cpu_update_status_register(cpu, cpu->intermediate.result);
+                        cpu->state = CS_WRITEBACK_LOW;
+                        goto CS_WRITEBACK_LOW;
+                        break;
+
+                    case ABS: CPU_EXECUTE_LABEL(ABS)
+                        cpu->intermediate.result = cpu_alu_abs(cpu, cpu->intermediate.data_address_reduced, cpu->intermediate.data_address_extended);
+                        cpu->state = CS_WRITEBACK_LOW;
+                        goto CS_WRITEBACK_LOW;
+                        break;
+
+                    case INC: CPU_EXECUTE_LABEL(INC)
+                        cpu->intermediate.result = cpu->intermediate.data_address_reduced + 1;
+                        cpu->regs.sr.AO = cpu->intermediate.result == 0;
+                        //cpu_update_status_register(cpu, cpu->intermediate.result);
+                        cpu->state = CS_WRITEBACK_LOW;
+                        goto CS_WRITEBACK_LOW;
+                        break;
+
+                    case DEC: CPU_EXECUTE_LABEL(DEC)
+                        cpu->intermediate.result = cpu->intermediate.data_address_reduced - 1;
+                        cpu->regs.sr.AO = cpu->intermediate.result == 0xffff;
+                        //cpu_update_status_register(cpu, cpu->intermediate.result);
+                        cpu->state = CS_WRITEBACK_LOW;
+                        goto CS_WRITEBACK_LOW;
+                        break;
+
+                    case SSA: CPU_EXECUTE_LABEL(SSA)
+                        cpu->intermediate.result = cpu_alu_ssa(cpu, cpu->intermediate.data_address_reduced, cpu->intermediate.data_address_extended);
+                        cpu->state = CS_WRITEBACK_LOW;
+                        goto CS_WRITEBACK_LOW;
+                        break;
+
+                    case SSS: CPU_EXECUTE_LABEL(SSS)
+                        cpu->intermediate.result = cpu_alu_sss(cpu, cpu->intermediate.data_address_reduced, cpu->intermediate.data_address_extended);
+                        cpu->state = CS_WRITEBACK_LOW;
+                        goto CS_WRITEBACK_LOW;
+                        break;
+
+                    case SSM: CPU_EXECUTE_LABEL(SSM)
+                        cpu->intermediate.result = cpu_alu_ssm(cpu, cpu->intermediate.data_address_reduced, cpu->intermediate.data_address_extended);
+                        cpu->state = CS_WRITEBACK_LOW;
+                        goto CS_WRITEBACK_LOW;
+                        break;
+                        
+                    case USA: CPU_EXECUTE_LABEL(USA)
+                        cpu->intermediate.result = cpu_alu_usa(cpu, cpu->intermediate.data_address_reduced, cpu->intermediate.data_address_extended);
+                        cpu->state = CS_WRITEBACK_LOW;
+                        goto CS_WRITEBACK_LOW;
+                        break;
+
+                    case USS: CPU_EXECUTE_LABEL(USS)
+                        cpu->intermediate.result = cpu_alu_uss(cpu, cpu->intermediate.data_address_reduced, cpu->intermediate.data_address_extended);
+                        cpu->state = CS_WRITEBACK_LOW;
+                        goto CS_WRITEBACK_LOW;
+                        break;
+
+                    case USM: CPU_EXECUTE_LABEL(USM)
+                        cpu->intermediate.result = cpu_alu_usm(cpu, cpu->intermediate.data_address_reduced, cpu->intermediate.data_address_extended);
+                        cpu->state = CS_WRITEBACK_LOW;
+                        goto CS_WRITEBACK_LOW;
+                        break;
+
+                    case MUL: CPU_EXECUTE_LABEL(MUL)
+                        cpu->intermediate.result = cpu_alu_mul(cpu, cpu->intermediate.data_address_reduced, cpu->intermediate.data_address_extended);
+                        cpu->state = CS_WRITEBACK_LOW;
+                        goto CS_WRITEBACK_LOW;
+                        break;
+
+                    case DIV: CPU_EXECUTE_LABEL(DIV)
+                        cpu->intermediate.result = cpu_alu_div(cpu, cpu->intermediate.data_address_reduced, cpu->intermediate.data_address_extended);
+                        cpu->state = CS_WRITEBACK_LOW;
+                        goto CS_WRITEBACK_LOW;
+                        break;
+
+                    case ADC: CPU_EXECUTE_LABEL(ADC)
+                        cpu->intermediate.result = cpu_alu_adc(cpu, cpu->intermediate.data_address_reduced, cpu->intermediate.data_address_extended);
+                        cpu->state = CS_WRITEBACK_LOW;
+                        goto CS_WRITEBACK_LOW;
+                        break;
+
+                    case SBC: CPU_EXECUTE_LABEL(SBC)
+                        cpu->intermediate.result = cpu_alu_sbc(cpu, cpu->intermediate.data_address_reduced, cpu->intermediate.data_address_extended);
+                        cpu->state = CS_WRITEBACK_LOW;
+                        goto CS_WRITEBACK_LOW;
+                        break;
+
+                    case JFZ: CPU_EXECUTE_LABEL(JFZ)
+                        if (cpu->regs.sr.FZ) {
+                            cpu->regs.pc = cpu->intermediate.data_address_extended;
+                        }
+                        cpu->instruction ++;
+                        cpu->state = CS_FETCH_INSTRUCTION;
+                        goto CS_FETCH_INSTRUCTION;
+                        break;
+                    
+                    case JNFZ: CPU_EXECUTE_LABEL(JNFZ)
+                        if (!cpu->regs.sr.FZ) {
+                            cpu->regs.pc = cpu->intermediate.data_address_extended;
+                        }
+                        cpu->instruction ++;
+                        cpu->state = CS_FETCH_INSTRUCTION;
+                        goto CS_FETCH_INSTRUCTION;
+                        break;
+
+                    case JL: CPU_EXECUTE_LABEL(JL)
+                        if (cpu->regs.sr.L) {
+                            cpu->regs.pc = cpu->intermediate.data_address_extended;
+                        }
+                        cpu->instruction ++;
+                        cpu->state = CS_FETCH_INSTRUCTION;
+                        goto CS_FETCH_INSTRUCTION;
+                        break;
+                    
+                    case JNL: CPU_EXECUTE_LABEL(JNL)
+                        if (!cpu->regs.sr.L) {
+                            cpu->regs.pc = cpu->intermediate.data_address_extended;
+                        }
+                        cpu->instruction ++;
+                        cpu->state = CS_FETCH_INSTRUCTION;
+                        goto CS_FETCH_INSTRUCTION;
+                        break;
+                    
+                    case JUL: CPU_EXECUTE_LABEL(JUL)
+                        if (cpu->regs.sr.UL) {
+                            cpu->regs.pc = cpu->intermediate.data_address_extended;
+                        }
+                        cpu->instruction ++;
+                        cpu->state = CS_FETCH_INSTRUCTION;
+                        goto CS_FETCH_INSTRUCTION;
+                        break;
+                    
+                    case JNUL: CPU_EXECUTE_LABEL(JNUL)
+                        if (!cpu->regs.sr.UL) {
+                            cpu->regs.pc = cpu->intermediate.data_address_extended;
+                        }
+                        cpu->instruction ++;
+                        cpu->state = CS_FETCH_INSTRUCTION;
+                        goto CS_FETCH_INSTRUCTION;
+                        break;
+                    
+                    case JFL: CPU_EXECUTE_LABEL(JFL)
+                        if (cpu->regs.sr.FL) {
+                            cpu->regs.pc = cpu->intermediate.data_address_extended;
+                        }
+                        cpu->instruction ++;
+                        cpu->state = CS_FETCH_INSTRUCTION;
+                        goto CS_FETCH_INSTRUCTION;
+                        break;
+                    
+                    case JNFL: CPU_EXECUTE_LABEL(JNFL)
+                        if (!cpu->regs.sr.FL) {
+                            cpu->regs.pc = cpu->intermediate.data_address_extended;
+                        }
+                        cpu->instruction ++;
+                        cpu->state = CS_FETCH_INSTRUCTION;
+                        goto CS_FETCH_INSTRUCTION;
+                        break;
+                    
+                    case JDL: CPU_EXECUTE_LABEL(JDL)
+                        if (cpu->regs.sr.DL) {
+                            cpu->regs.pc = cpu->intermediate.data_address_extended;
+                        }
+                        cpu->instruction ++;
+                        cpu->state = CS_FETCH_INSTRUCTION;
+                        goto CS_FETCH_INSTRUCTION;
+                        break;
+                    
+                    case JNDL: CPU_EXECUTE_LABEL(JNDL)
+                        if (!cpu->regs.sr.DL) {
+                            cpu->regs.pc = cpu->intermediate.data_address_extended;
+                        }
+                        cpu->instruction ++;
+                        cpu->state = CS_FETCH_INSTRUCTION;
+                        goto CS_FETCH_INSTRUCTION;
+                        break;
+                    
+                    case JLL: CPU_EXECUTE_LABEL(JLL)
+                        if (cpu->regs.sr.LL) {
+                            cpu->regs.pc = cpu->intermediate.data_address_extended;
+                        }
+                        cpu->instruction ++;
+                        cpu->state = CS_FETCH_INSTRUCTION;
+                        goto CS_FETCH_INSTRUCTION;
+                        break;
+                    
+                    case JNLL: CPU_EXECUTE_LABEL(JNLL)
+                        if (!cpu->regs.sr.LL) {
+                            cpu->regs.pc = cpu->intermediate.data_address_extended;
+                        }
+                        cpu->instruction ++;
+                        cpu->state = CS_FETCH_INSTRUCTION;
+                        goto CS_FETCH_INSTRUCTION;
+                        break;
+                    
+                    case JAO: CPU_EXECUTE_LABEL(JAO)
+                        if (cpu->regs.sr.AO) {
+                            cpu->regs.pc = cpu->intermediate.data_address_extended;
+                        }
+                        cpu->instruction ++;
+                        cpu->state = CS_FETCH_INSTRUCTION;
+                        goto CS_FETCH_INSTRUCTION;
+                        break;
+                    
+                    case JNAO: CPU_EXECUTE_LABEL(JNAO)
+                        if (!cpu->regs.sr.AO) {
+                            cpu->regs.pc = cpu->intermediate.data_address_extended;
+                        }
+                        cpu->instruction ++;
+                        cpu->state = CS_FETCH_INSTRUCTION;
+                        goto CS_FETCH_INSTRUCTION;
+                        break;
+
+                    case CLZ: CPU_EXECUTE_LABEL(CLZ)
+                        cpu->regs.sr.Z = 0;
+                        cpu->instruction ++;
+                        cpu->state = CS_FETCH_INSTRUCTION;
+                        goto CS_FETCH_INSTRUCTION;
+                        break;
+
+                    case SEZ: CPU_EXECUTE_LABEL(SEZ)
+                        cpu->regs.sr.Z = 1;
+                        cpu->instruction ++;
+                        cpu->state = CS_FETCH_INSTRUCTION;
+                        goto CS_FETCH_INSTRUCTION;
+                        break;
+
+                    case CLFZ: CPU_EXECUTE_LABEL(CLFZ)
+                        cpu->regs.sr.FZ = 0;
+                        cpu->instruction ++;
+                        cpu->state = CS_FETCH_INSTRUCTION;
+                        goto CS_FETCH_INSTRUCTION;
+                        break;
+
+                    case SEFZ: CPU_EXECUTE_LABEL(SEFZ)
+                        cpu->regs.sr.FZ = 1;
+                        cpu->instruction ++;
+                        cpu->state = CS_FETCH_INSTRUCTION;
+                        goto CS_FETCH_INSTRUCTION;
+                        break;
+
+                    case CLL: CPU_EXECUTE_LABEL(CLL)
+                        cpu->regs.sr.L = 0;
+                        cpu->instruction ++;
+                        cpu->state = CS_FETCH_INSTRUCTION;
+                        goto CS_FETCH_INSTRUCTION;
+                        break;
+
+                    case SEL: CPU_EXECUTE_LABEL(SEL)
+                        cpu->regs.sr.L = 1;
+                        cpu->instruction ++;
+                        cpu->state = CS_FETCH_INSTRUCTION;
+                        goto CS_FETCH_INSTRUCTION;
+                        break;
+
+                    case CLUL: CPU_EXECUTE_LABEL(CLUL)
+                        cpu->regs.sr.UL = 0;
+                        cpu->instruction ++;
+                        cpu->state = CS_FETCH_INSTRUCTION;
+                        goto CS_FETCH_INSTRUCTION;
+                        break;
+
+                    case SEUL: CPU_EXECUTE_LABEL(SEUL)
+                        cpu->regs.sr.UL = 1;
+                        cpu->instruction ++;
+                        cpu->state = CS_FETCH_INSTRUCTION;
+                        goto CS_FETCH_INSTRUCTION;
+                        break;
+
+                    case CLFL: CPU_EXECUTE_LABEL(CLFL)
+                        cpu->regs.sr.FL = 0;
+                        cpu->instruction ++;
+                        cpu->state = CS_FETCH_INSTRUCTION;
+                        goto CS_FETCH_INSTRUCTION;
+                        break;
+
+                    case SEFL: CPU_EXECUTE_LABEL(SEFL)
+                        cpu->regs.sr.FL = 1;
+                        cpu->instruction ++;
+                        cpu->state = CS_FETCH_INSTRUCTION;
+                        goto CS_FETCH_INSTRUCTION;
+                        break;
+
+                    case CLDL: CPU_EXECUTE_LABEL(CLDL)
+                        cpu->regs.sr.DL = 0;
+                        cpu->instruction ++;
+                        cpu->state = CS_FETCH_INSTRUCTION;
+                        goto CS_FETCH_INSTRUCTION;
+                        break;
+
+                    case SEDL: CPU_EXECUTE_LABEL(SEDL)
+                        cpu->regs.sr.DL = 1;
+                        cpu->instruction ++;
+                        cpu->state = CS_FETCH_INSTRUCTION;
+                        goto CS_FETCH_INSTRUCTION;
+                        break;
+
+                    case CLLL: CPU_EXECUTE_LABEL(CLLL)
+                        cpu->regs.sr.LL = 0;
+                        cpu->instruction ++;
+                        cpu->state = CS_FETCH_INSTRUCTION;
+                        goto CS_FETCH_INSTRUCTION;
+                        break;
+
+                    case SELL: CPU_EXECUTE_LABEL(SELL)
+                        cpu->regs.sr.LL = 1;
+                        cpu->instruction ++;
+                        cpu->state = CS_FETCH_INSTRUCTION;
+                        goto CS_FETCH_INSTRUCTION;
+                        break;
+
+                    case CLAO: CPU_EXECUTE_LABEL(CLAO)
+                        cpu->regs.sr.AO = 0;
+                        cpu->instruction ++;
+                        cpu->state = CS_FETCH_INSTRUCTION;
+                        goto CS_FETCH_INSTRUCTION;
+                        break;
+
+                    case SEAO: CPU_EXECUTE_LABEL(SEAO)
+                        cpu->regs.sr.AO = 1;
+                        cpu->instruction ++;
+                        cpu->state = CS_FETCH_INSTRUCTION;
+                        goto CS_FETCH_INSTRUCTION;
+                        break;
+
+                    case CLMI: CPU_EXECUTE_LABEL(CLMI)
+                        cpu->regs.sr.MI = 0;
+                        cpu->instruction ++;
+                        cpu->state = CS_FETCH_INSTRUCTION;
+                        goto CS_FETCH_INSTRUCTION;
+                        break;
+
+                    case SEMI: CPU_EXECUTE_LABEL(SEMI)
+                        cpu->regs.sr.MI = 1;
+                        cpu->instruction ++;
+                        cpu->state = CS_FETCH_INSTRUCTION;
+                        goto CS_FETCH_INSTRUCTION;
+                        break;
+
+                    case RJMP: CPU_EXECUTE_LABEL(RJMP)
+                        cpu->regs.pc += (int16_t) cpu->intermediate.data_address_extended;
+                        cpu->instruction ++;
+                        cpu->state = CS_FETCH_INSTRUCTION;
+                        goto CS_FETCH_INSTRUCTION;
+                        break;
+
+                    case RJZ: CPU_EXECUTE_LABEL(RJZ)
+                        if (cpu->regs.sr.Z) {
+                            cpu->regs.pc += (int16_t) cpu->intermediate.data_address_extended;
+                        }
+                        cpu->instruction ++;
+                        cpu->state = CS_FETCH_INSTRUCTION;
+                        goto CS_FETCH_INSTRUCTION;
+                        break;
+
+                    case RJNZ: CPU_EXECUTE_LABEL(RJNZ)
+                        if (!cpu->regs.sr.Z) {
+                            cpu->regs.pc += (int16_t) cpu->intermediate.data_address_extended;
+                        }
+                        cpu->instruction ++;
+                        cpu->state = CS_FETCH_INSTRUCTION;
+                        goto CS_FETCH_INSTRUCTION;
+                        break;
+
+                    case RJL: CPU_EXECUTE_LABEL(RJL)
+                        if (cpu->regs.sr.L) {
+                            cpu->regs.pc += (int16_t) cpu->intermediate.data_address_extended;
+                        }
+                        cpu->instruction ++;
+                        cpu->state = CS_FETCH_INSTRUCTION;
+                        goto CS_FETCH_INSTRUCTION;
+                        break;
+
+                    case RJNL: CPU_EXECUTE_LABEL(RJNL)
+                        if (!cpu->regs.sr.L) {
+                            cpu->regs.pc += (int16_t) cpu->intermediate.data_address_extended;
+                        }
+                        cpu->instruction ++;
+                        cpu->state = CS_FETCH_INSTRUCTION;
+                        goto CS_FETCH_INSTRUCTION;
+                        break;
+
+                    case RJFZ: CPU_EXECUTE_LABEL(RJFZ)
+                        if (cpu->regs.sr.FZ) {
+                            cpu->regs.pc += (int16_t) cpu->intermediate.data_address_extended;
+                        }
+                        cpu->instruction ++;
+                        cpu->state = CS_FETCH_INSTRUCTION;
+                        goto CS_FETCH_INSTRUCTION;
+                        break;
+                    
+                    case RJNFZ: CPU_EXECUTE_LABEL(RJNFZ)
+                        if (!cpu->regs.sr.FZ) {
+                            cpu->regs.pc += (int16_t) cpu->intermediate.data_address_extended;
+                        }
+                        cpu->instruction ++;
+                        cpu->state = CS_FETCH_INSTRUCTION;
+                        goto CS_FETCH_INSTRUCTION;
+                        break;
+                    
+                    case RJUL: CPU_EXECUTE_LABEL(RJUL)
+                        if (cpu->regs.sr.UL) {
+                            cpu->regs.pc += (int16_t) cpu->intermediate.data_address_extended;
+                        }
+                        cpu->instruction ++;
+                        cpu->state = CS_FETCH_INSTRUCTION;
+                        goto CS_FETCH_INSTRUCTION;
+                        break;
+                    
+                    case RJNUL: CPU_EXECUTE_LABEL(RJNUL)
+                        if (!cpu->regs.sr.UL) {
+                            cpu->regs.pc += (int16_t) cpu->intermediate.data_address_extended;
+                        }
+                        cpu->instruction ++;
+                        cpu->state = CS_FETCH_INSTRUCTION;
+                        goto CS_FETCH_INSTRUCTION;
+                        break;
+                    
+                    case RJFL: CPU_EXECUTE_LABEL(RJFL)
+                        if (cpu->regs.sr.FL) {
+                            cpu->regs.pc += (int16_t) cpu->intermediate.data_address_extended;
+                        }
+                        cpu->instruction ++;
+                        cpu->state = CS_FETCH_INSTRUCTION;
+                        goto CS_FETCH_INSTRUCTION;
+                        break;
+                    
+                    case RJNFL: CPU_EXECUTE_LABEL(RJNFL)
+                        if (!cpu->regs.sr.FL) {
+                            cpu->regs.pc += (int16_t) cpu->intermediate.data_address_extended;
+                        }
+                        cpu->instruction ++;
+                        cpu->state = CS_FETCH_INSTRUCTION;
+                        goto CS_FETCH_INSTRUCTION;
+                        break;
+                    
+                    case RJDL: CPU_EXECUTE_LABEL(RJDL)
+                        if (cpu->regs.sr.DL) {
+                            cpu->regs.pc += (int16_t) cpu->intermediate.data_address_extended;
+                        }
+                        cpu->instruction ++;
+                        cpu->state = CS_FETCH_INSTRUCTION;
+                        goto CS_FETCH_INSTRUCTION;
+                        break;
+                    
+                    case RJNDL: CPU_EXECUTE_LABEL(RJNDL)
+                        if (!cpu->regs.sr.DL) {
+                            cpu->regs.pc += (int16_t) cpu->intermediate.data_address_extended;
+                        }
+                        cpu->instruction ++;
+                        cpu->state = CS_FETCH_INSTRUCTION;
+                        goto CS_FETCH_INSTRUCTION;
+                        break;
+                    
+                    case RJLL: CPU_EXECUTE_LABEL(RJLL)
+                        if (cpu->regs.sr.LL) {
+                            cpu->regs.pc += (int16_t) cpu->intermediate.data_address_extended;
+                        }
+                        cpu->instruction ++;
+                        cpu->state = CS_FETCH_INSTRUCTION;
+                        goto CS_FETCH_INSTRUCTION;
+                        break;
+                    
+                    case RJNLL: CPU_EXECUTE_LABEL(RJNLL)
+                        if (!cpu->regs.sr.LL) {
+                            cpu->regs.pc += (int16_t) cpu->intermediate.data_address_extended;
+                        }
+                        cpu->instruction ++;
+                        cpu->state = CS_FETCH_INSTRUCTION;
+                        goto CS_FETCH_INSTRUCTION;
+                        break;
+                    
+                    case RJAO: CPU_EXECUTE_LABEL(RJAO)
+                        if (cpu->regs.sr.AO) {
+                            cpu->regs.pc += (int16_t) cpu->intermediate.data_address_extended;
+                        }
+                        cpu->instruction ++;
+                        cpu->state = CS_FETCH_INSTRUCTION;
+                        goto CS_FETCH_INSTRUCTION;
+                        break;
+                    
+                    case RJNAO: CPU_EXECUTE_LABEL(RJNAO)
+                        if (!cpu->regs.sr.AO) {
+                            cpu->regs.pc += (int16_t) cpu->intermediate.data_address_extended;
+                        }
+                        cpu->instruction ++;
+                        cpu->state = CS_FETCH_INSTRUCTION;
+                        goto CS_FETCH_INSTRUCTION;
+                        break;
+                    
+                    case RCALL: CPU_EXECUTE_LABEL(RCALL)
+                        cpu->intermediate.result = cpu->regs.pc;
+                        cpu->regs.pc += (int16_t) cpu->intermediate.data_address_extended;
+                        cpu->state = CS_PUSH_HIGH;
+                        goto CS_PUSH_HIGH;
+                        break;
+
+                    case CMOVZ: CPU_EXECUTE_LABEL(CMOVZ)
+                        if (cpu->regs.sr.Z) {
+                            cpu->intermediate.result = cpu->intermediate.data_address_extended;
+                            cpu->state = CS_WRITEBACK_LOW;
+                            goto CS_WRITEBACK_LOW;
+                            break;
+                        }
+                        cpu->instruction ++;
+                        cpu->state = CS_FETCH_INSTRUCTION;
+                        goto CS_FETCH_INSTRUCTION;
+                        break;
+
+                    case CMOVNZ: CPU_EXECUTE_LABEL(CMOVNZ)
+                        if (!cpu->regs.sr.Z) {
+                            cpu->intermediate.result = cpu->intermediate.data_address_extended;
+                            cpu->state = CS_WRITEBACK_LOW;
+                            goto CS_WRITEBACK_LOW;
+                            break;
+                        }
+                        cpu->instruction ++;
+                        cpu->state = CS_FETCH_INSTRUCTION;
+                        goto CS_FETCH_INSTRUCTION;
+                        break;
+
+                    case CMOVFZ: CPU_EXECUTE_LABEL(CMOVFZ)
+                        if (cpu->regs.sr.FZ) {
+                            cpu->intermediate.result = cpu->intermediate.data_address_extended;
+                            cpu->state = CS_WRITEBACK_LOW;
+                            goto CS_WRITEBACK_LOW;
+                            break;
+                        }
+                        cpu->instruction ++;
+                        cpu->state = CS_FETCH_INSTRUCTION;
+                        goto CS_FETCH_INSTRUCTION;
+                        break;
+
+                    case CMOVNFZ: CPU_EXECUTE_LABEL(CMOVNFZ)
+                        if (!cpu->regs.sr.FZ) {
+                            cpu->intermediate.result = cpu->intermediate.data_address_extended;
+                            cpu->state = CS_WRITEBACK_LOW;
+                            goto CS_WRITEBACK_LOW;
+                            break;
+                        }
+                        cpu->instruction ++;
+                        cpu->state = CS_FETCH_INSTRUCTION;
+                        goto CS_FETCH_INSTRUCTION;
+                        break;
+
+                    case CMOVL: CPU_EXECUTE_LABEL(CMOVL)
+                        if (cpu->regs.sr.L) {
+                            cpu->intermediate.result = cpu->intermediate.data_address_extended;
+                            cpu->state = CS_WRITEBACK_LOW;
+                            goto CS_WRITEBACK_LOW;
+                            break;
+                        }
+                        cpu->instruction ++;
+                        cpu->state = CS_FETCH_INSTRUCTION;
+                        goto CS_FETCH_INSTRUCTION;
+                        break;
+
+                    case CMOVNL: CPU_EXECUTE_LABEL(CMOVNL)
+                        if (!cpu->regs.sr.L) {
+                            cpu->intermediate.result = cpu->intermediate.data_address_extended;
+                            cpu->state = CS_WRITEBACK_LOW;
+                            goto CS_WRITEBACK_LOW;
+                            break;
+                        }
+                        cpu->instruction ++;
+                        cpu->state = CS_FETCH_INSTRUCTION;
+                        goto CS_FETCH_INSTRUCTION;
+                        break;
+
+                    case CMOVUL: CPU_EXECUTE_LABEL(CMOVUL)
+                        if (cpu->regs.sr.UL) {
+                            cpu->intermediate.result = cpu->intermediate.data_address_extended;
+                            cpu->state = CS_WRITEBACK_LOW;
+                            goto CS_WRITEBACK_LOW;
+                            break;
+                        }
+                        cpu->instruction ++;
+                        cpu->state = CS_FETCH_INSTRUCTION;
+                        goto CS_FETCH_INSTRUCTION;
+                        break;
+
+                    case CMOVNUL: CPU_EXECUTE_LABEL(CMOVNUL)
+                        if (!cpu->regs.sr.UL) {
+                            cpu->intermediate.result = cpu->intermediate.data_address_extended;
+                            cpu->state = CS_WRITEBACK_LOW;
+                            goto CS_WRITEBACK_LOW;
+                            break;
+                        }
+                        cpu->instruction ++;
+                        cpu->state = CS_FETCH_INSTRUCTION;
+                        goto CS_FETCH_INSTRUCTION;
+                        break;
+
+                    case CMOVFL: CPU_EXECUTE_LABEL(CMOVFL)
+                        if (cpu->regs.sr.FL) {
+                            cpu->intermediate.result = cpu->intermediate.data_address_extended;
+                            cpu->state = CS_WRITEBACK_LOW;
+                            goto CS_WRITEBACK_LOW;
+                            break;
+                        }
+                        cpu->instruction ++;
+                        cpu->state = CS_FETCH_INSTRUCTION;
+                        goto CS_FETCH_INSTRUCTION;
+                        break;
+
+                    case CMOVNFL: CPU_EXECUTE_LABEL(CMOVNFL)
+                        if (!cpu->regs.sr.FL) {
+                            cpu->intermediate.result = cpu->intermediate.data_address_extended;
+                            cpu->state = CS_WRITEBACK_LOW;
+                            goto CS_WRITEBACK_LOW;
+                            break;
+                        }
+                        cpu->instruction ++;
+                        cpu->state = CS_FETCH_INSTRUCTION;
+                        goto CS_FETCH_INSTRUCTION;
+                        break;
+
+                    case CMOVDL: CPU_EXECUTE_LABEL(CMOVDL)
+                        if (cpu->regs.sr.DL) {
+                            cpu->intermediate.result = cpu->intermediate.data_address_extended;
+                            cpu->state = CS_WRITEBACK_LOW;
+                            goto CS_WRITEBACK_LOW;
+                            break;
+                        }
+                        cpu->instruction ++;
+                        cpu->state = CS_FETCH_INSTRUCTION;
+                        goto CS_FETCH_INSTRUCTION;
+                        break;
+
+                    case CMOVNDL: CPU_EXECUTE_LABEL(CMOVNDL)
+                        if (!cpu->regs.sr.DL) {
+                            cpu->intermediate.result = cpu->intermediate.data_address_extended;
+                            cpu->state = CS_WRITEBACK_LOW;
+                            goto CS_WRITEBACK_LOW;
+                            break;
+                        }
+                        cpu->instruction ++;
+                        cpu->state = CS_FETCH_INSTRUCTION;
+                        goto CS_FETCH_INSTRUCTION;
+                        break;
+
+                    case CMOVLL: CPU_EXECUTE_LABEL(CMOVLL)
+                        if (cpu->regs.sr.LL) {
+                            cpu->intermediate.result = cpu->intermediate.data_address_extended;
+                            cpu->state = CS_WRITEBACK_LOW;
+                            goto CS_WRITEBACK_LOW;
+                            break;
+                        }
+                        cpu->instruction ++;
+                        cpu->state = CS_FETCH_INSTRUCTION;
+                        goto CS_FETCH_INSTRUCTION;
+                        break;
+
+                    case CMOVNLL: CPU_EXECUTE_LABEL(CMOVNLL)
+                        if (!cpu->regs.sr.LL) {
+                            cpu->intermediate.result = cpu->intermediate.data_address_extended;
+                            cpu->state = CS_WRITEBACK_LOW;
+                            goto CS_WRITEBACK_LOW;
+                            break;
+                        }
+                        cpu->instruction ++;
+                        cpu->state = CS_FETCH_INSTRUCTION;
+                        goto CS_FETCH_INSTRUCTION;
+                        break;
+
+                    case CMOVAO: CPU_EXECUTE_LABEL(CMOVAO)
+                        if (cpu->regs.sr.AO) {
+                            cpu->intermediate.result = cpu->intermediate.data_address_extended;
+                            cpu->state = CS_WRITEBACK_LOW;
+                            goto CS_WRITEBACK_LOW;
+                            break;
+                        }
+                        cpu->instruction ++;
+                        cpu->state = CS_FETCH_INSTRUCTION;
+                        goto CS_FETCH_INSTRUCTION;
+                        break;
+
+                    case CMOVNAO: CPU_EXECUTE_LABEL(CMOVNAO)
+                        if (!cpu->regs.sr.AO) {
+                            cpu->intermediate.result = cpu->intermediate.data_address_extended;
+                            cpu->state = CS_WRITEBACK_LOW;
+                            goto CS_WRITEBACK_LOW;
+                            break;
+                        }
+                        cpu->instruction ++;
+                        cpu->state = CS_FETCH_INSTRUCTION;
+                        goto CS_FETCH_INSTRUCTION;
+                        break;
+                        cpu->instruction ++;
+                        cpu->state = CS_FETCH_INSTRUCTION;
+                        goto CS_FETCH_INSTRUCTION;
+                        break;
+
+                    case CMOVMI: CPU_EXECUTE_LABEL(CMOVMI)
+                        if (cpu->regs.sr.MI) {
+                            cpu->intermediate.result = cpu->intermediate.data_address_extended;
+                            cpu->state = CS_WRITEBACK_LOW;
+                            goto CS_WRITEBACK_LOW;
+                            break;
+                        }
+                        cpu->instruction ++;
+                        cpu->state = CS_FETCH_INSTRUCTION;
+                        goto CS_FETCH_INSTRUCTION;
+                        break;
+
+                    case CMOVNMI: CPU_EXECUTE_LABEL(CMOVNMI)
+                        if (!cpu->regs.sr.MI) {
+                            cpu->intermediate.result = cpu->intermediate.data_address_extended;
+                            cpu->state = CS_WRITEBACK_LOW;
+                            goto CS_WRITEBACK_LOW;
+                            break;
+                        }
+                        cpu->instruction ++;
+                        cpu->state = CS_FETCH_INSTRUCTION;
+                        goto CS_FETCH_INSTRUCTION;
+                        break;
+
+                    case CBI: CPU_EXECUTE_LABEL(CBI)
+                        cpu->intermediate.result = cpu_alu_cbi(cpu, cpu->intermediate.data_address_reduced, cpu->intermediate.data_address_extended);
+                        cpu->state = CS_WRITEBACK_LOW;
+                        goto CS_WRITEBACK_LOW;
+                        break;
+
+                    case ADDF: CPU_EXECUTE_LABEL(ADDF)
+                        cpu->intermediate.result = cpu_alu_addf(cpu, cpu->intermediate.data_address_reduced, cpu->intermediate.data_address_extended);
+                        cpu->state = CS_WRITEBACK_LOW;
+                        goto CS_WRITEBACK_LOW;
+                        break;
+
+                    case SUBF: CPU_EXECUTE_LABEL(SUBF)
+                        cpu->intermediate.result = cpu_alu_subf(cpu, cpu->intermediate.data_address_reduced, cpu->intermediate.data_address_extended);
+                        cpu->state = CS_WRITEBACK_LOW;
+                        goto CS_WRITEBACK_LOW;
+                        break;
+
+                    case MULF: CPU_EXECUTE_LABEL(MULF)
+                        cpu->intermediate.result = cpu_alu_mulf(cpu, cpu->intermediate.data_address_reduced, cpu->intermediate.data_address_extended);
+                        cpu->state = CS_WRITEBACK_LOW;
+                        goto CS_WRITEBACK_LOW;
+                        break;
+
+                    case DIVF: CPU_EXECUTE_LABEL(DIVF)
+                        cpu->intermediate.result = cpu_alu_divf(cpu, cpu->intermediate.data_address_reduced, cpu->intermediate.data_address_extended);
+                        cpu->state = CS_WRITEBACK_LOW;
+                        goto CS_WRITEBACK_LOW;
+                        break;
+
+                    case ADDD: CPU_EXECUTE_LABEL(ADDD)
+                        cpu->intermediate.result = cpu_alu_addd(cpu, cpu->intermediate.data_address_reduced, cpu->intermediate.data_address_extended);
+                        cpu->state = CS_WRITEBACK_LOW;
+                        goto CS_WRITEBACK_LOW;
+                        break;
+
+                    case SUBD: CPU_EXECUTE_LABEL(SUBD)
+                        cpu->intermediate.result = cpu_alu_subd(cpu, cpu->intermediate.data_address_reduced, cpu->intermediate.data_address_extended);
+                        cpu->state = CS_WRITEBACK_LOW;
+                        goto CS_WRITEBACK_LOW;
+                        break;
+
+                    case MULD: CPU_EXECUTE_LABEL(MULD)
+                        cpu->intermediate.result = cpu_alu_muld(cpu, cpu->intermediate.data_address_reduced, cpu->intermediate.data_address_extended);
+                        cpu->state = CS_WRITEBACK_LOW;
+                        goto CS_WRITEBACK_LOW;
+                        break;
+
+                    case DIVD: CPU_EXECUTE_LABEL(DIVD)
+                        cpu->intermediate.result = cpu_alu_divd(cpu, cpu->intermediate.data_address_reduced, cpu->intermediate.data_address_extended);
+                        cpu->state = CS_WRITEBACK_LOW;
+                        goto CS_WRITEBACK_LOW;
+                        break;
+
+                    case ADDL: CPU_EXECUTE_LABEL(ADDL)
+                        cpu->intermediate.result = cpu_alu_addl(cpu, cpu->intermediate.data_address_reduced, cpu->intermediate.data_address_extended);
+                        cpu->state = CS_WRITEBACK_LOW;
+                        goto CS_WRITEBACK_LOW;
+                        break;
+
+                    case SUBL: CPU_EXECUTE_LABEL(SUBL)
+                        cpu->intermediate.result = cpu_alu_subl(cpu, cpu->intermediate.data_address_reduced, cpu->intermediate.data_address_extended);
+                        cpu->state = CS_WRITEBACK_LOW;
+                        goto CS_WRITEBACK_LOW;
+                        break;
+
+                    case MULL: CPU_EXECUTE_LABEL(MULL)
+                        cpu->intermediate.result = cpu_alu_mull(cpu, cpu->intermediate.data_address_reduced, cpu->intermediate.data_address_extended);
+                        cpu->state = CS_WRITEBACK_LOW;
+                        goto CS_WRITEBACK_LOW;
+                        break;
+
+                    case DIVL: CPU_EXECUTE_LABEL(DIVL)
+                        cpu->intermediate.result = cpu_alu_divl(cpu, cpu->intermediate.data_address_reduced, cpu->intermediate.data_address_extended);
+                        cpu->state = CS_WRITEBACK_LOW;
+                        goto CS_WRITEBACK_LOW;
+                        break;
+
+                    case CIF: CPU_EXECUTE_LABEL(CIF)
+                        cpu->intermediate.result = cpu_alu_cif(cpu, cpu->intermediate.data_address_reduced, cpu->intermediate.data_address_extended);
+                        cpu->state = CS_WRITEBACK_LOW;
+                        goto CS_WRITEBACK_LOW;
+                        break;
+
+                    case CID: CPU_EXECUTE_LABEL(CID)
+                        cpu->intermediate.result = cpu_alu_cid(cpu, cpu->intermediate.data_address_reduced, cpu->intermediate.data_address_extended);
+                        cpu->state = CS_WRITEBACK_LOW;
+                        goto CS_WRITEBACK_LOW;
+                        break;
+
+                    case CIL: CPU_EXECUTE_LABEL(CIL)
+                        cpu->intermediate.result = cpu_alu_cil(cpu, cpu->intermediate.data_address_reduced, cpu->intermediate.data_address_extended);
+                        cpu->state = CS_WRITEBACK_LOW;
+                        goto CS_WRITEBACK_LOW;
+                        break;
+
+                    case CFI: CPU_EXECUTE_LABEL(CFI)
+                        cpu->intermediate.result = cpu_alu_cfi(cpu, cpu->intermediate.data_address_reduced, cpu->intermediate.data_address_extended);
+                        cpu->state = CS_WRITEBACK_LOW;
+                        goto CS_WRITEBACK_LOW;
+                        break;
+
+                    case CFD: CPU_EXECUTE_LABEL(CFD)
+                        cpu->intermediate.result = cpu_alu_cfd(cpu, cpu->intermediate.data_address_reduced, cpu->intermediate.data_address_extended);
+                        cpu->state = CS_WRITEBACK_LOW;
+                        goto CS_WRITEBACK_LOW;
+                        break;
+
+                    case CFL: CPU_EXECUTE_LABEL(CFL)
+                        cpu->intermediate.result = cpu_alu_cfl(cpu, cpu->intermediate.data_address_reduced, cpu->intermediate.data_address_extended);
+                        cpu->state = CS_WRITEBACK_LOW;
+                        goto CS_WRITEBACK_LOW;
+                        break;
+
+                    case CDI: CPU_EXECUTE_LABEL(CDI)
+                        cpu->intermediate.result = cpu_alu_cdi(cpu, cpu->intermediate.data_address_reduced, cpu->intermediate.data_address_extended);
+                        cpu->state = CS_WRITEBACK_LOW;
+                        goto CS_WRITEBACK_LOW;
+                        break;
+
+                    case CDF: CPU_EXECUTE_LABEL(CDF)
+                        cpu->intermediate.result = cpu_alu_cdf(cpu, cpu->intermediate.data_address_reduced, cpu->intermediate.data_address_extended);
+                        cpu->state = CS_WRITEBACK_LOW;
+                        goto CS_WRITEBACK_LOW;
+                        break;
+
+                    case CDL: CPU_EXECUTE_LABEL(CDL)
+                        cpu->intermediate.result = cpu_alu_cdl(cpu, cpu->intermediate.data_address_reduced, cpu->intermediate.data_address_extended);
+                        cpu->state = CS_WRITEBACK_LOW;
+                        goto CS_WRITEBACK_LOW;
+                        break;
+
+                    case CLI: CPU_EXECUTE_LABEL(CLI)
+                        cpu->intermediate.result = cpu_alu_cli(cpu, cpu->intermediate.data_address_reduced, cpu->intermediate.data_address_extended);
+                        cpu->state = CS_WRITEBACK_LOW;
+                        goto CS_WRITEBACK_LOW;
+                        break;
+
+                    case CLF: CPU_EXECUTE_LABEL(CLF)
+                        cpu->intermediate.result = cpu_alu_clf(cpu, cpu->intermediate.data_address_reduced, cpu->intermediate.data_address_extended);
+                        cpu->state = CS_WRITEBACK_LOW;
+                        goto CS_WRITEBACK_LOW;
+                        break;
+
+                    case CLD: CPU_EXECUTE_LABEL(CLD)
+                        cpu->intermediate.result = cpu_alu_cld(cpu, cpu->intermediate.data_address_reduced, cpu->intermediate.data_address_extended);
+                        cpu->state = CS_WRITEBACK_LOW;
+                        goto CS_WRITEBACK_LOW;
+                        break;
+
+                    case INV: CPU_EXECUTE_LABEL(INV)
+                        cache_invalidate(cpu->cache);
+                        cpu->instruction ++;
+                        cpu->state = CS_FETCH_INSTRUCTION;
+                        goto CS_FETCH_INSTRUCTION;
+                        break;
+                    
+                    case FTC: CPU_EXECUTE_LABEL(FTC) {
+                        // doesnt even improve performance on optimal scenraios
+                        uint8_t data;
+                        int success = CPU_CLOCK_READ_MEMORY(cpu, cpu->intermediate.data_address_extended, &data);
+                        if (success) {
+                            cpu->instruction ++;
+                            cpu->state = CS_FETCH_INSTRUCTION;
+                            goto CS_FETCH_INSTRUCTION;
+                        }
+                        break;
+                    }
+
+                    case HWCLOCK: CPU_EXECUTE_LABEL(HWCLOCK)
+                        cpu->regs.r0 = cpu->clock & ((uint64_t) 0xffff << 0);
+                        cpu->regs.r1 = cpu->clock & ((uint64_t) 0xffff << 16);
+                        cpu->regs.r2 = cpu->clock & ((uint64_t) 0xffff << 32);
+                        cpu->regs.r3 = cpu->clock & ((uint64_t) 0xffff << 48);
+                        cpu->instruction ++;
+                        cpu->state = CS_FETCH_INSTRUCTION;
+                        goto CS_FETCH_INSTRUCTION;
+                        break;
+                    
+                    case HWINSTR: CPU_EXECUTE_LABEL(HWINSTR)
+                        cpu->regs.r0 = cpu->instruction & ((uint64_t) 0xffff << 0);
+                        cpu->regs.r1 = cpu->instruction & ((uint64_t) 0xffff << 16);
+                        cpu->regs.r2 = cpu->instruction & ((uint64_t) 0xffff << 32);
+                        cpu->regs.r3 = cpu->instruction & ((uint64_t) 0xffff << 48);
+                        cpu->instruction ++;
+                        cpu->state = CS_FETCH_INSTRUCTION;
+                        goto CS_FETCH_INSTRUCTION;
+                        break;
+                    
+                    case HWCORE: CPU_EXECUTE_LABEL(HWCORE)
+                        cpu->regs.r0 = cpu->core_id;
+                        cpu->instruction ++;
+                        cpu->state = CS_FETCH_INSTRUCTION;
+                        goto CS_FETCH_INSTRUCTION;
+                        break;
+                    
+                    case HWSLEEP: CPU_EXECUTE_LABEL(HWSLEEP)
+                        cpu->instruction ++;
+                        // the instruction is done, the interrupt that wakes the cpu returns behind it instead of back into the sleep
+                        cpu->intermediate.previous_pc = cpu->regs.pc;
+                        cpu->intermediate.previous_sp = cpu->regs.sp;
+                        cpu->state = CS_SLEEP;
+                        goto CS_SLEEP;
+                        break;
+                    
+                    // Extended instructions
+
+                    case EXTNOP: CPU_EXECUTE_LABEL(EXTNOP)
+                        cpu->instruction ++;
+                        cpu->state = CS_FETCH_INSTRUCTION;
+                        goto CS_FETCH_INSTRUCTION;
+                        break;
+
+                    case EXTNOP2: CPU_EXECUTE_LABEL(EXTNOP2)
+                        cpu->instruction ++;
+                        cpu->state = CS_FETCH_INSTRUCTION;
+                        goto CS_FETCH_INSTRUCTION;
+                        break;
+
+                    default: CPU_EXECUTE_LABEL(default)
+                        #ifdef _CPU_DEEP_DEBUG_
+                        log_msg(LP_ERROR, "CPU (C:%d CS:%d DS:%d): Unknown instruction [%d] [%s:%d]", cpu->clock, cpu->state, cpu->device.device_state, cpu->intermediate.instruction, __FILE__, __LINE__);
+                        #endif
+                        cpu->instruction ++;
+                        cpu->state = CS_EXCEPTION;
+                        break;
+                }
+                #ifdef _CPU_DEEP_DEBUG_
+                log_msg(LP_INFO, "CPU (C:%d CS:%d DS:%d): intermediate result: 0x%.4x", cpu->clock, cpu->state, cpu->device.device_state, cpu->intermediate.result);
+                #endif
+            }
+            break;
+        // =======================================================================================
+        
+        case CS_WRITEBACK_LOW: 
+            {
+                CS_WRITEBACK_LOW:
+                #ifdef _CPU_DEEP_DEBUG_
+                log_msg(LP_INFO, "CPU (C:%d CS:%d DS:%d): Writing low result back to cpu/memory", cpu->clock, cpu->state, cpu->device.device_state);
+                #endif
+                cpu->regs.sr.MNI = 1;
+                switch (cpu_reduced_addressing_mode_category[cpu->intermediate.addressing_mode.addressing_mode_reduced]) {
+                    case ADMC_IND:
+                        if (cpu_word_store(cpu, cpu->intermediate.argument_address_reduced)) {
+                            // both bytes in one transaction, CS_WRITEBACK_HIGH is skipped
+                            int success = CPU_CLOCK_WRITE_MEMORY(cpu, cpu->intermediate.argument_address_reduced, cpu->intermediate.result, 2);
+                            if (success) {
+                                cpu->instruction ++;
+                                cpu->state = CS_FETCH_INSTRUCTION;
+                                goto CS_FETCH_INSTRUCTION;
+                            }
+                        } else {
+                            int success = CPU_CLOCK_WRITE_MEMORY(cpu, cpu->intermediate.argument_address_reduced, (uint8_t) (cpu->intermediate.result & 0x00ff), 1);
+                            if (success) {
+                                cpu->state = CS_WRITEBACK_HIGH;
+                                goto CS_WRITEBACK_HIGH;
+                            }
+                        }
+                        break;
+
+                    case ADMC_REG:
+                        switch (cpu->intermediate.addressing_mode.addressing_mode_reduced) {
+                            case ADMR_R0:
+                                cpu->regs.r0 = (cpu->regs.r0 & 0x00ff) | (cpu->intermediate.result & 0xff00);
+                                break;
+                            case ADMR_R1:
+                                cpu->regs.r1 = (cpu->regs.r1 & 0x00ff) | (cpu->intermediate.result & 0xff00);
+                                break;
+                            case ADMR_R2:
+                                cpu->regs.r2 = (cpu->regs.r2 & 0x00ff) | (cpu->intermediate.result & 0xff00);
+                                break;
+                            case ADMR_R3:
+                                cpu->regs.r3 = (cpu->regs.r3 & 0x00ff) | (cpu->intermediate.result & 0xff00);
+                                break;
+                            case ADMR_SP:
+                                cpu->regs.sp = (cpu->regs.sp & 0x00ff) | (cpu->intermediate.result & 0xff00);
+                                break;
+                            default:
+                                break;
+                        }
+                        cpu->instruction ++;
+                        cpu->state = CS_WRITEBACK_HIGH;
+                        goto CS_WRITEBACK_HIGH;
+                        break;
+
+                    case ADMC_NONE:
+                        // Here if writeback happens to admx instead of admr
+                        #ifdef _CPU_DEEP_DEBUG_
+                        log_msg(LP_NOTICE, "CPU (C:%d CS:%d DS:%d): Writeback to ADMX instead of ADMR", cpu->clock, cpu->state, cpu->device.device_state);
+                        #endif
+                        break;
+
+                    default:
+                        #ifdef _CPU_DEEP_DEBUG_
+                        log_msg(LP_ERROR, "CPU (C:%d CS:%d DS:%d): Unkown addressing mode category %d [%s:%d]", cpu->clock, cpu->state, cpu->device.device_state, cpu->intermediate.addressing_mode.addressing_mode_reduced, __FILE__, __LINE__);
+                        #endif
+                        cpu->state = CS_EXCEPTION;
+                        break;
+                }
+            }
+            break;
+        
+        case CS_WRITEBACK_HIGH: 
+            {
+                CS_WRITEBACK_HIGH:
+                #ifdef _CPU_DEEP_DEBUG_
+                log_msg(LP_INFO, "CPU (C:%d CS:%d DS:%d): Writing high result back to memory", cpu->clock, cpu->state, cpu->device.device_state);
+                #endif
+                cpu->regs.sr.MNI = 1;
+                switch (cpu_reduced_addressing_mode_category[cpu->intermediate.addressing_mode.addressing_mode_reduced]) {
+                    case ADMC_IND:
+                        {
+                            int success = CPU_CLOCK_WRITE_MEMORY(cpu, cpu->intermediate.argument_address_reduced + 1, (uint8_t) ((cpu->intermediate.result & 0xff00) >> 8), 1);
+                            if (success) {
+                                cpu->instruction ++;
+                                cpu->state = CS_FETCH_INSTRUCTION;
+                                goto CS_FETCH_INSTRUCTION;
+                            }
+                        }
+                        break;
+
+                    case ADMC_REG:
+                        // TODO: switch case and write to register
+                        switch (cpu->intermediate.addressing_mode.addressing_mode_reduced) {
+                            case ADMR_R0:
+                                cpu->regs.r0 = (cpu->regs.r0 & 0xff00) | (cpu->intermediate.result & 0x00ff);
+                                break;
+                            case ADMR_R1:
+                                cpu->regs.r1 = (cpu->regs.r1 & 0xff00) | (cpu->intermediate.result & 0x00ff);
+                                break;
+                            case ADMR_R2:
+                                cpu->regs.r2 = (cpu->regs.r2 & 0xff00) | (cpu->intermediate.result & 0x00ff);
+                                break;
+                            case ADMR_R3:
+                                cpu->regs.r3 = (cpu->regs.r3 & 0xff00) | (cpu->intermediate.result & 0x00ff);
+                                break;
+                            case ADMR_SP:
+                                cpu->regs.sp = (cpu->regs.sp & 0xff00) | (cpu->intermediate.result & 0x00ff);
+                                break;
+                            default:
+                                break;
+                        }
+                        cpu->instruction ++;
+                        cpu->state = CS_FETCH_INSTRUCTION;
+                        goto CS_FETCH_INSTRUCTION;
+                        break;
+                    
+                    case ADMC_IMM:
+                    case ADMC_NONE:
+                    default:
+                        #ifdef _CPU_DEEP_DEBUG_
+                        log_msg(LP_ERROR, "CPU (C:%d CS:%d DS:%d): Unkown addressing mode category %d [%s:%d]", cpu->clock, cpu->state, cpu->device.device_state, cpu->intermediate.argument_address_reduced, __FILE__, __LINE__);
+                        #endif
+                        break;
+                }
+            }
+            break;
+        
+        case CS_PUSH_HIGH: 
+            {
+                CS_PUSH_HIGH:
+                #ifdef _CPU_DEEP_DEBUG_
+                log_msg(LP_INFO, "CPU (C:%d CS:%d DS:%d): Pushing low result", cpu->clock, cpu->state, cpu->device.device_state);
+                #endif
+                cpu->regs.sr.MNI = 1;
+                if (cpu_word_store(cpu, cpu->regs.sp - 2)) {
+                    // both bytes in one transaction, CS_PUSH_LOW is skipped
+                    int success = CPU_CLOCK_WRITE_MEMORY(cpu, cpu->regs.sp - 2, cpu->intermediate.result, 2);
+                    if (success) {
+                        cpu->regs.sp -= 2;
+                        cpu->instruction ++;
+                        cpu->state = CS_FETCH_INSTRUCTION;
+                        goto CS_FETCH_INSTRUCTION;
+                    }
+                    break;
+                }
+                int success = CPU_CLOCK_WRITE_MEMORY(cpu, cpu->regs.sp - 1, (uint8_t) ((cpu->intermediate.result & 0xff00) >> 8), 1);
+                if (success) {
+                    cpu->regs.sp --;
+                    cpu->state = CS_PUSH_LOW;
+                    goto CS_PUSH_LOW;
+                }
+            }
+            break;
+        
+        case CS_PUSH_LOW: 
+            {   
+                CS_PUSH_LOW:
+                #ifdef _CPU_DEEP_DEBUG_
+                log_msg(LP_INFO, "CPU (C:%d CS:%d DS:%d): Pushing high result", cpu->clock, cpu->state, cpu->device.device_state);
+                #endif
+                cpu->regs.sr.MNI = 1;
+                int success = CPU_CLOCK_WRITE_MEMORY(cpu, cpu->regs.sp - 1, (uint8_t) (cpu->intermediate.result & 0x00ff), 1);
+                if (success) {
+                    cpu->regs.sp --;
+                    cpu->instruction ++;
+                    cpu->state = CS_FETCH_INSTRUCTION;
+                    goto CS_FETCH_INSTRUCTION;
+                }
+            }
+            break;
+        
+        case CS_POP_LOW: 
+            {
+                CS_POP_LOW:
+                #ifdef _CPU_DEEP_DEBUG_
+                log_msg(LP_INFO, "CPU (C:%d CS:%d DS:%d): Popping low result", cpu->clock, cpu->state, cpu->device.device_state);
+                #endif
+                cpu->regs.sr.MNI = 1;
+                uint8_t data;
+                int success = CPU_CLOCK_READ_MEMORY(cpu, cpu->regs.sp, &data);
+                if (success) {
+                    cpu->regs.sp ++;
+                    cpu->intermediate.result = data;
+                    #ifdef _CPU_DEEP_DEBUG_
+                    log_msg(LP_DEBUG, "CPU (C:%d CS:%d DS:%d): intermediate result: %.4x", cpu->clock, cpu->state, cpu->device.device_state, cpu->intermediate.result);
+                    #endif
+                    if (cpu->intermediate.instruction == POPB) {
+                        cpu->state = CS_WRITEBACK_LOW;
+                        goto CS_WRITEBACK_LOW;
+                    }
+                    cpu->state = CS_POP_HIGH;
+                    goto CS_POP_HIGH;
+                }
+            }
+            break;
+        
+        case CS_POP_HIGH: 
+            {   
+                CS_POP_HIGH:
+                #ifdef _CPU_DEEP_DEBUG_
+                log_msg(LP_INFO, "CPU (C:%d CS:%d DS:%d): Popping high result", cpu->clock, cpu->state, cpu->device.device_state);
+                #endif
+                cpu->regs.sr.MNI = 1;
+                uint8_t data;
+                int success = CPU_CLOCK_READ_MEMORY(cpu, cpu->regs.sp, &data);
+                if (success) {
+                    cpu->regs.sp ++;
+                    cpu->intermediate.result |= (uint16_t) (data << 8);
+                    #ifdef _CPU_DEEP_DEBUG_
+                    log_msg(LP_DEBUG, "CPU (C:%d CS:%d DS:%d): intermediate result: %.4x", cpu->clock, cpu->state, cpu->device.device_state, cpu->intermediate.result);
+                    #endif
+                    if (cpu->intermediate.instruction == RET) {
+                        if (CPU_CLOCK_OBSERVED && cpu->branch_predictor) {
+                            cpu_branch_predictor_return(cpu->branch_predictor, cpu->intermediate.previous_pc, cpu->intermediate.result);
+                        }
+                        cpu->regs.pc = cpu->intermediate.result;
+                        cpu->instruction ++;
+                        cpu->state = CS_FETCH_INSTRUCTION;
+                        goto CS_FETCH_INSTRUCTION;
+                    } else {
+                        cpu->state = CS_WRITEBACK_LOW;
+                        goto CS_WRITEBACK_LOW;
+                    }
+                }
+            }
+            break;
+        
+        case CS_POPSR_LOW: 
+            {
+                CS_POPSR_LOW:
+                #ifdef _CPU_DEEP_DEBUG_
+                log_msg(LP_INFO, "CPU (C:%d CS:%d DS:%d): Popping low result", cpu->clock, cpu->state, cpu->device.device_state);
+                #endif
+                cpu->regs.sr.MNI = 1;
+                uint8_t data;
+                int success = CPU_CLOCK_READ_MEMORY(cpu, cpu->regs.sp, &data);
+                if (success) {
+                    cpu->regs.sp ++;
+                    cpu->regs.sr.value = (uint8_t) data;
+                    #ifdef _CPU_DEEP_DEBUG_
+                    log_msg(LP_DEBUG, "CPU (C:%d CS:%d DS:%d): intermediate result: %.4x", cpu->clock, cpu->state, cpu->device.device_state, cpu->intermediate.result);
+                    #endif
+                    cpu->state = CS_POPSR_HIGH;
+                    goto CS_POPSR_HIGH;
+                }
+            }
+            break;
+        
+        case CS_POPSR_HIGH: 
+            {   
+                CS_POPSR_HIGH:
+                #ifdef _CPU_DEEP_DEBUG_
+                log_msg(LP_INFO, "CPU (C:%d CS:%d DS:%d): Popping high result", cpu->clock, cpu->state, cpu->device.device_state);
+                #endif
+                cpu->regs.sr.MNI = 1;
+                uint8_t data;
+                int success = CPU_CLOCK_READ_MEMORY(cpu, cpu->regs.sp, &data);
+                if (success) {
+                    cpu->regs.sp ++;
+                    cpu->regs.sr.value |= (uint16_t) (data << 8);
+                    #ifdef _CPU_DEEP_DEBUG_
+                    log_msg(LP_DEBUG, "CPU (C:%d CS:%d DS:%d): intermediate result: %.4x", cpu->clock, cpu->state, cpu->device.device_state, cpu->intermediate.result);
+                    #endif
+                    cpu->state = CS_FETCH_INSTRUCTION;
+                    goto CS_FETCH_INSTRUCTION;
+                }
+            }
+            break;
+        
+        case CS_INTERRUPT_PUSH_PC_HIGH:
+            {
+                CS_INTERRUPT_PUSH_PC_HIGH:
+                #ifdef _CPU_DEEP_DEBUG_
+                log_msg(LP_INFO, "CPU (C:%d CS:%d DS:%d): Interrupt push pc high", cpu->clock, cpu->state, cpu->device.device_state);
+                #endif
+                cpu->regs.sr.MNI = 1;
+                if (cpu_word_store(cpu, cpu->regs.sp - 2)) {
+                    // both bytes in one transaction, CS_INTERRUPT_PUSH_PC_LOW is skipped
+                    int success = CPU_CLOCK_WRITE_MEMORY(cpu, cpu->regs.sp - 2, cpu->regs.pc, 2);
+                    if (success) {
+                        cpu->regs.sp -= 2;
+                        cpu->state = CS_INTERRUPT_FETCH_IRQ_VECTOR_LOW;
+                        goto CS_INTERRUPT_FETCH_IRQ_VECTOR_LOW;
+                    }
+                    break;
+                }
+                int success = CPU_CLOCK_WRITE_MEMORY(cpu, cpu->regs.sp - 1, (uint8_t) ((cpu->regs.pc & 0xff00) >> 8), 1);
+                if (success) {
+                    cpu->regs.sp --;
+                    cpu->state = CS_INTERRUPT_PUSH_PC_LOW;
+                    goto CS_INTERRUPT_PUSH_PC_LOW;
+                }
+            }
+            break;
+        
+        case CS_INTERRUPT_PUSH_PC_LOW:
+            {   
+                CS_INTERRUPT_PUSH_PC_LOW:
+                #ifdef _CPU_DEEP_DEBUG_
+                log_msg(LP_INFO, "CPU (C:%d CS:%d DS:%d): Interrupt push pc low", cpu->clock, cpu->state, cpu->device.device_state);
+                #endif
+                cpu->regs.sr.MNI = 1;
+                int success = CPU_CLOCK_WRITE_MEMORY(cpu, cpu->regs.sp - 1, (uint8_t) (cpu->regs.pc & 0x00ff), 1);
+                if (success) {
+                    cpu->regs.sp --;
+                    cpu->state = CS_INTERRUPT_FETCH_IRQ_VECTOR_LOW;
+                    goto CS_INTERRUPT_FETCH_IRQ_VECTOR_LOW;
+                }
+            }
+            break;
+    
+        case CS_INTERRUPT_FETCH_IRQ_VECTOR_LOW:
+            {
+                CS_INTERRUPT_FETCH_IRQ_VECTOR_LOW:
+                #ifdef _CPU_DEEP_DEBUG_
+                log_msg(LP_INFO, "CPU (C:%d CS:%d DS:%d): Interrupt fetch irq vector low (0x%.4x)", cpu->clock, cpu->state, cpu->device.device_state, SEGMENT_IRQ_TABLE + cpu->intermediate.irq_id * 2);
+                #endif
+                cpu->regs.sr.MNI = 1;
+                uint8_t data;
+                int success = CPU_CLOCK_READ_MEMORY(cpu, SEGMENT_IRQ_TABLE + cpu->intermediate.irq_id * 2, &data);
+                if (success) {
+                    cpu->intermediate.data_address_extended = (uint8_t) data;
+                    cpu->state = CS_INTERRUPT_FETCH_IRQ_VECTOR_HIGH;
+                    goto CS_INTERRUPT_FETCH_IRQ_VECTOR_HIGH;
+                }
+            }
+            break;
+    
+        case CS_INTERRUPT_FETCH_IRQ_VECTOR_HIGH:
+            {
+                CS_INTERRUPT_FETCH_IRQ_VECTOR_HIGH:
+                #ifdef _CPU_DEEP_DEBUG_
+                log_msg(LP_INFO, "CPU (C:%d CS:%d DS:%d): Interrupt fetch irq vector high (0x%.4x)", cpu->clock, cpu->state, cpu->device.device_state, SEGMENT_IRQ_TABLE + cpu->intermediate.irq_id * 2);
+                #endif
+                cpu->regs.sr.MNI = 1;
+                uint8_t data;
+                int success = CPU_CLOCK_READ_MEMORY(cpu, SEGMENT_IRQ_TABLE + cpu->intermediate.irq_id * 2 + 1, &data);
+                if (success) {
+                    cpu->intermediate.data_address_extended |= ((uint16_t) data) << 8;
+                    cpu->regs.pc = cpu->intermediate.data_address_extended;
+                    if (cpu->interrupt.servicing) {
+                        cpu_record_interrupt_latency(cpu);
+                    }
+                    cpu->state = CS_FETCH_INSTRUCTION;
+                    goto CS_FETCH_INSTRUCTION;
+                }
+            }
+            break;
+
+        case CS_HALT: 
+            {
+                cpu->regs.sr.MNI = 1;
+                if (!halted) {
+                    halted = 1;
+                }
+                //exit(1);
+                break;
+            }
+
+        case CS_SLEEP: 
+            {
+                CS_SLEEP:
+                #ifdef _CPU_DEEP_DEBUG_
+                log_msg(LP_DEBUG, "CPU (C:%d, I:%d CS:%d DS:%d): SLEEP [%s:%d]", cpu->clock, cpu->instruction, cpu->state, cpu->device.device_state, __FILE__, __LINE__);
+                #endif
+                // HWSLEEP already completed, so this is an instruction boundary
+                if (cpu->interrupt.pending && cpu_take_interrupt(cpu)) {
+                    goto CS_INTERRUPT_PUSH_PC_HIGH;
+                }
+                break;
+            }
+
+        case CS_EXCEPTION:
+            if (!halted) {
+                #ifdef _CPU_DEEP_DEBUG_
+                log_msg(LP_ERROR, "CPU (C:%d CS:%d DS:%d): EXCEPTION [%s:%d]", cpu->clock, cpu->state, cpu->device.device_state, __FILE__, __LINE__);
+                #endif
+                halted = 1;
+            }
+            break;
+
+        default:
+            if (!halted) {
+                #ifdef _CPU_DEEP_DEBUG_
+                log_msg(LP_ERROR, "CPU (C:%d CS:%d DS:%d): UNKNOWN STATE [%s:%d]", cpu->clock, cpu->state, cpu->device.device_state, __FILE__, __LINE__);
+                #endif
+                halted = 1;
+            }
+            break;
+    }
+
+    if (cpu->flags.pending && !cpu->direct_ram) {
+        cpu_resolve_flags(cpu, CPU_FLAGS_COMPARE_MASK);     // on the bus everyone may look at sr between two cycles
+    }
+    if (cpu->device.transaction_capacity && cpu->state >= CS_COMPUTE_ADDRESS && cpu->state <= CS_PUSH_HIGH) {
+        cpu_prefetch_ahead(cpu);
+    }
+    cpu->clock ++;
+    cpu_account_cycles(cpu, state_start, clock_start, memory_start);
+    return;
+}
+
+#undef CPU_CLOCK_READ_MEMORY
+#undef CPU_CLOCK_WRITE_MEMORY
+#undef CPU_CLOCK_FUNCTION
+#undef CPU_CLOCK_CACHE
+#undef CPU_CLOCK_OBSERVED
+#undef CPU_CLOCK_TRACE
@@ -0,0 +1,245 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "utils/Log.h"
+
+#include "globals/memory_layout.h"
+
+#include "modules/ram.h"
+
+#include "cpu/cpu_instructions.h"
+#include "cpu/cpu_addressing_modes.h"
+#include "cpu/cpu_decode_cache.h"
+
+
+const char* cpu_fusion_name[CF_COUNT] = {
+    "none", 
+    "load+push", 
+    "lea+store", 
+    "compare+jump", 
+    "prologue", 
+};
+
+
+CpuDecodeCache_t* cpu_decode_cache_create(uint16_t capacity, RAM_t* ram) {
+    if (capacity == 0 || (capacity & (capacity - 1))) {
+        log_msg(LP_ERROR, "Decode Cache: Capacity has to be a power of 2 [%s:%d]", __FILE__, __LINE__);
+        return NULL;
+    }
+    if (!ram) {
+        log_msg(LP_ERROR, "Decode Cache: No RAM given to decode from [%s:%d]", __FILE__, __LINE__);
+        return NULL;
+    }
+
+    CpuDecodeCache_t* decode_cache = calloc(1, sizeof(CpuDecodeCache_t));
+    if (!decode_cache) {
+        log_msg(LP_ERROR, "Decode Cache: Memory allocation failure [%s:%d]", __FILE__, __LINE__);
+        return NULL;
+    }
+    decode_cache->capacity = capacity;
+    decode_cache->ram = ram;
+    decode_cache->fusion = 1;
+    decode_cache->entry = calloc(capacity, sizeof(CpuDecodedInstruction_t));
+    if (!decode_cache->entry) {
+        log_msg(LP_ERROR, "Decode Cache: Memory allocation failure [%s:%d]", __FILE__, __LINE__);
+        free(decode_cache);
+        return NULL;
+    }
+
+    return decode_cache;
+}
+
+void cpu_decode_cache_delete(CpuDecodeCache_t** decode_cache) {
+    if (!decode_cache) {return;}
+    if (!*decode_cache) {return;}
+    free((*decode_cache)->entry);
+    free(*decode_cache);
+    *decode_cache = NULL;
+}
+
+CpuDecodedInstruction_t* cpu_decode_cache_lookup(CpuDecodeCache_t* decode_cache, uint16_t pc) {
+    CpuDecodedInstruction_t* decoded = &decode_cache->entry[pc & (decode_cache->capacity - 1)];
+    if (!decoded->valid || decoded->pc != pc) {
+        decode_cache->miss ++;
+        return NULL;
+    }
+    uint32_t* generation = decode_cache->ram->generation;
+    if (
+        decoded->generation[0] != generation[pc >> RAM_GENERATION_SHIFT] ||
+        decoded->generation[1] != generation[(uint16_t) (pc + decoded->length - 1) >> RAM_GENERATION_SHIFT]
+    ) {
+        // the code has been written to since it was decoded
+        decoded->valid = 0;
+        decode_cache->miss ++;
+        return NULL;
+    }
+    decode_cache->hit ++;
+    return decoded;
+}
+
+void cpu_decode_cache_insert(CpuDecodeCache_t* decode_cache, CpuDecodedInstruction_t* decoded) {
+    uint32_t* generation = decode_cache->ram->generation;
+    decoded->valid = 1;
+    decoded->generation[0] = generation[decoded->pc >> RAM_GENERATION_SHIFT];
+    decoded->generation[1] = generation[(uint16_t) (decoded->pc + decoded->length - 1) >> RAM_GENERATION_SHIFT];
+    decode_cache->entry[decoded->pc & (decode_cache->capacity - 1)] = *decoded;
+}
+
+void cpu_decode_cache_invalidate(CpuDecodeCache_t* decode_cache) {
+    if (!decode_cache) {return;}
+    for (int i = 0; i < decode_cache->capacity; i++) {
+        decode_cache->entry[i].valid = 0;
+    }
+}
+
+
+// same as cpu_decode_cache_lookup, but without touching the statistics
+static CpuDecodedInstruction_t* cpu_decode_cache_peek(CpuDecodeCache_t* decode_cache, uint16_t pc) {
+    CpuDecodedInstruction_t* decoded = &decode_cache->entry[pc & (decode_cache->capacity - 1)];
+    if (!decoded->valid || decoded->pc != pc || decoded->no_cache) {
+        return NULL;
+    }
+    uint32_t* generation = decode_cache->ram->generation;
+    if (
+        decoded->generation[0] != generation[pc >> RAM_GENERATION_SHIFT] ||
+        decoded->generation[1] != generation[(uint16_t) (pc + decoded->length - 1) >> RAM_GENERATION_SHIFT]
+    ) {
+        return NULL;
+    }
+    return decoded;
+}
+
+static int cpu_decode_cache_admr(CpuDecodedInstruction_t* decoded) {
+    return decoded->addressing_mode & 0x07;
+}
+
+static int cpu_decode_cache_admx(CpuDecodedInstruction_t* decoded) {
+    return decoded->addressing_mode >> 3;
+}
+
+static int cpu_decode_cache_is_register_or_immediate(int admx) {
+    return admx == ADMX_IMM16 || (admx >= ADMX_R0 && admx <= ADMX_SP);
+}
+
+static int cpu_decode_cache_is_conditional_jump(int instruction) {
+    return (instruction >= JZ && instruction <= JNAO) || (instruction >= RJZ && instruction <= RJNAO);
+}
+
+/*
+Returns the kind of superinstruction head and next form, or CF_NONE. 
+next[1] may be NULL if there is no decoded instruction after next[0]
+*/
+static CpuFusion_t cpu_decode_cache_match(CpuDecodedInstruction_t* head, CpuDecodedInstruction_t* next[CPU_FUSION_MAX_FOLLOWERS], int* followers) {
+    int admr = cpu_decode_cache_admr(head);
+    int admx = cpu_decode_cache_admx(head);
+    int next_admr = cpu_decode_cache_admr(next[0]);
+    int next_admx = cpu_decode_cache_admx(next[0]);
+    *followers = 1;
+    switch (head->instruction) {
+        case MOV:
+            if (
+                admr >= ADMR_R0 && admr <= ADMR_R3 && admx >= ADMX_IND_R0_OFFSET16 && admx <= ADMX_IND_SP_OFFSET16 &&
+                next[0]->instruction == PUSH && next_admx == ADMX_R0 + (admr - ADMR_R0) && next_admr == ADMR_NONE
+            ) {
+                return CF_LOAD_PUSH;
+            }
+            break;
+
+        case LEA:
+            if (
+                admr == ADMR_R0 && (admx == ADMX_IND16 || (admx >= ADMX_IND_R0 && admx <= ADMX_IND_SP) || (admx >= ADMX_IND_R0_OFFSET16 && admx <= ADMX_IND_SP_OFFSET16)) &&
+                next[0]->instruction == MOV && next_admr == ADMR_IND_R0 && cpu_decode_cache_is_register_or_immediate(next_admx)
+            ) {
+                return CF_LEA_STORE;
+            }
+            break;
+
+        case CMP:
+        case TST:
+            if (head->instruction == CMP ? !(admr >= ADMR_R0 && admr <= ADMR_SP) : admr != ADMR_NONE) {
+                break;
+            }
+            if (
+                cpu_decode_cache_is_register_or_immediate(admx) && 
+                cpu_decode_cache_is_conditional_jump(next[0]->instruction) && next_admx == ADMX_IMM16 && next_admr == ADMR_NONE
+            ) {
+                return CF_COMPARE_JUMP;
+            }
+            break;
+
+        case PUSH:
+            if (
+                admr == ADMR_NONE && admx >= ADMX_R0 && admx <= ADMX_R3 && 
+                next[0]->instruction == MOV && next_admr == ADMR_R0 + (admx - ADMX_R0) && next_admx == ADMX_SP && 
+                next[1] && next[1]->instruction == SUB && cpu_decode_cache_admr(next[1]) == ADMR_SP && cpu_decode_cache_admx(next[1]) == ADMX_IMM16
+            ) {
+                *followers = 2;
+                return CF_PROLOGUE;
+            }
+            break;
+
+        default:
+            break;
+    }
+    return CF_NONE;
+}
+
+void cpu_decode_cache_fuse(CpuDecodeCache_t* decode_cache, CpuDecodedInstruction_t* decoded) {
+    if (!decode_cache->fusion || decoded->fusion_checked || decoded->no_cache) {return;}
+
+    CpuDecodedInstruction_t* next[CPU_FUSION_MAX_FOLLOWERS] = {NULL};
+    uint32_t pc = decoded->pc + decoded->length;
+    for (int i = 0; i < CPU_FUSION_MAX_FOLLOWERS && pc <= SEGMENT_CODE_END; i++) {
+        next[i] = cpu_decode_cache_peek(decode_cache, pc);
+        if (!next[i]) {break;}
+        pc += next[i]->length;
+    }
+    if (!next[0]) {
+        return;     // not decoded yet, try again next time
+    }
+
+    int followers = 0;
+    CpuFusion_t fusion = cpu_decode_cache_match(decoded, next, &followers);
+    if (fusion == CF_NONE && decoded->instruction == PUSH && !next[1]) {
+        return;     // could still become a prologue once the third instruction is decoded
+    }
+    decoded->fusion_checked = 1;
+    if (fusion == CF_NONE) {return;}
+
+    uint16_t length = decoded->length;
+    for (int i = 0; i < followers; i++) {
+        decoded->follower[i].instruction = next[i]->instruction;
+        decoded->follower[i].addressing_mode = next[i]->addressing_mode;
+        memcpy(decoded->follower[i].argument_data_raw, next[i]->argument_data_raw, sizeof(next[i]->argument_data_raw));
+        length += next[i]->length;
+    }
+    if (length > (1 << RAM_GENERATION_SHIFT)) {
+        return;     // would span more than two generation blocks
+    }
+    uint32_t* generation = decode_cache->ram->generation;
+    decoded->fusion = fusion;
+    decoded->fused_length = length;
+    decoded->fused_next_pc = decoded->pc + length;
+    decoded->fused_generation[0] = generation[decoded->pc >> RAM_GENERATION_SHIFT];
+    decoded->fused_generation[1] = generation[(uint16_t) (decoded->pc + length - 1) >> RAM_GENERATION_SHIFT];
+}
+
+int cpu_decode_cache_fusion_valid(CpuDecodeCache_t* decode_cache, CpuDecodedInstruction_t* decoded) {
+    uint32_t* generation = decode_cache->ram->generation;
+    if (
+        decoded->fused_generation[0] != generation[decoded->pc >> RAM_GENERATION_SHIFT] ||
+        decoded->fused_generation[1] != generation[(uint16_t) (decoded->pc + decoded->fused_length - 1) >> RAM_GENERATION_SHIFT]
+    ) {
+        // a fused instruction has been written to, the head itself might still be fine
+        decoded->fusion = CF_NONE;
+        decoded->fusion_checked = 0;
+        return 0;
+    }
+    // a follower that lost its entry would miss and fetch its bytes through the data cache, so it has to run on its own
+    for (uint16_t pc = decoded->pc + decoded->length; pc != decoded->fused_next_pc; ) {
+        CpuDecodedInstruction_t* follower = cpu_decode_cache_peek(decode_cache, pc);
+        if (!follower) {return 0;}
+        pc += follower->length;
+    }
+    return 1;
+}
@@ -0,0 +1,1107 @@
+#include <stdint.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <sys/mman.h>
+
+#include "globals/memory_layout.h"
+
+#include "utils/Log.h"
+
+#include "modules/cache.h"
+#include "modules/device.h"
+#include "modules/ram.h"
+
+#include "cpu/cpu_instructions.h"
+#include "cpu/cpu_addressing_modes.h"
+#include "cpu/cpu.h"
+#include "cpu/cpu_jit.h"
+
+#include "cpu_alu.h"
+
+
+// x86-64 registers, the numbers are the ones used in the instruction encoding
+typedef enum CpuJitHostRegister_t {
+    HR_AX, HR_CX, HR_DX, HR_BX, HR_SP, HR_BP, HR_SI, HR_DI,
+    HR_R8, HR_R9, HR_R10, HR_R11, HR_R12, HR_R13, HR_R14, HR_R15,
+} CpuJitHostRegister_t;
+
+/*
+Register usage inside of a block:
+rbx     CPU_t*
+r12     CpuJit_t*
+rbp     address of the source operand
+r13     address of the destination operand
+r14     value of the source operand
+eax     value of the destination operand, then the result
+ecx, edx, esi, edi are scratch and get clobbered by every helper call
+*/
+#define HR_CPU HR_BX
+#define HR_JIT HR_R12
+#define HR_SOURCE_ADDRESS HR_BP
+#define HR_DESTINATION_ADDRESS HR_R13
+#define HR_SOURCE HR_R14
+
+#define CPU_JIT_FIELD(field) ((int32_t) offsetof(CPU_t, field))
+
+#define SR_NC_MASK (1 << 9)
+#define SR_MNI_MASK (1 << 10)
+
+typedef struct CpuJitInstruction_t {
+    uint16_t pc;                    // first byte, including EXT prefixes
+    uint16_t next_pc;
+    int instruction;
+    int no_cache;
+    int argument_count;
+    int admr, admx;
+    int8_t argument_data_raw[5];
+    int cycles;                     // cycles cpu_step_instruction spends on it besides memory accesses
+} CpuJitInstruction_t;
+
+typedef struct CpuJitExit_t {
+    size_t fixup[4];                // rel32 jumps that lead to this exit
+    int fixup_count;
+    uint16_t pc;                    // where the guest continues
+    int interpret;                  // block return value, 1 if the interpreter has to execute the instruction at pc
+    uint64_t instruction;           // instructions retired before leaving
+    uint64_t clock;
+    uint32_t fetched;               // instruction bytes read before leaving
+    int last_instruction;
+} CpuJitExit_t;
+
+typedef struct CpuJitTranslation_t {
+    CpuJitExit_t exit[2 * CPU_JIT_BLOCK_INSTRUCTIONS];
+    int exit_count;
+    uint64_t instruction;           // instructions retired by the block so far
+    uint64_t clock;
+    uint32_t fetched;
+    int last_instruction;
+} CpuJitTranslation_t;
+
+typedef uint16_t (*CpuJitAlu_t)(CPU_t* cpu, uint16_t reduced, uint16_t extended);
+
+
+// =======================================================================================
+// helpers called from translated code
+
+/*
+A data access of a CJF_CACHED block can evict code bytes, whose fetch would then miss.
+The block leaves after the current instruction if any code byte that shares a cache slot with [address, address + bytes) is gone,
+the instructions after it then fetch through the interpreter or a block that probes the cache again
+*/
+static void cpu_jit_watch(CPU_t* cpu, uint16_t address, int bytes) {
+    CpuJit_t* jit = cpu->jit;
+    if (jit->fetch != CJF_CACHED) {return;}
+    uint16_t mask = cpu->cache->capacity - 1;
+    for (int i = 0; i < bytes; i++) {
+        uint16_t code = jit->fetch_start + ((uint16_t) (address + i - jit->fetch_start) & mask);
+        if (code < jit->fetch_end && !cache_contains(cpu->cache, code)) {
+            jit->exit_requested = 1;
+            return;
+        }
+    }
+}
+
+// the instruction bytes the block has read by the time it leaves, see CpuJitFetch_t
+static void cpu_jit_fetched(CPU_t* cpu, uint32_t bytes) {
+    switch (cpu->jit->fetch) {
+        case CJF_DIRECT:
+            cpu_charge_direct_reads(cpu, bytes);
+            break;
+        case CJF_CACHED:
+            cpu->cache->hit += bytes;
+            break;
+        default:
+            break;
+    }
+}
+
+// 1 if every byte in [start, end) is cached
+static int cpu_jit_code_cached(Cache_t* cache, uint16_t start, uint16_t end) {
+    if ((uint16_t) (end - start) > cache->capacity) {return 0;}
+    for (uint16_t address = start; address != end; address++) {
+        if (!cache_contains(cache, address)) {return 0;}
+    }
+    return 1;
+}
+
+static uint16_t cpu_jit_read16(CPU_t* cpu, uint16_t address) {
+    uint8_t low = 0, high = 0;
+    cpu_read_memory(cpu, address, &low);
+    cpu_read_memory(cpu, address + 1, &high);
+    // a miss fills the cache with the 8 bytes from the address it missed on
+    cpu_jit_watch(cpu, address, 9);
+    return low | (high << 8);
+}
+
+// the reads CS_FETCH_INSTRUCTION, CS_FETCH_ADDRESSING_MODES and CS_FETCH_ARGUMENT_BYTES would have done, for the cache and the clock
+static void cpu_jit_fetch(CPU_t* cpu, uint16_t address, uint16_t length) {
+    uint8_t data;
+    // the opcode is still read with the NC bit of the previous instruction, translated instructions never set it
+    cpu_read_memory(cpu, address, &data);
+    cpu->regs.sr.NC = 0;
+    for (uint16_t i = 1; i < length; i++) {
+        cpu_read_memory(cpu, address + i, &data);
+    }
+}
+
+static void cpu_jit_write8(CPU_t* cpu, uint16_t address, uint16_t data) {
+    cpu_write_memory(cpu, address, (uint8_t) data);
+    cpu_jit_watch(cpu, address, 1);
+    if (cpu->jit->code_map[address >> RAM_GENERATION_SHIFT]) {
+        cpu->jit->exit_requested = 1;
+    }
+}
+
+static void cpu_jit_write16(CPU_t* cpu, uint16_t address, uint16_t data) {
+    if (cpu_word_store(cpu, address)) {
+        cpu_write_memory_width(cpu, address, data, 2);
+        cpu_jit_watch(cpu, address, 2);
+        if (cpu->jit->code_map[address >> RAM_GENERATION_SHIFT] || cpu->jit->code_map[(uint16_t) (address + 1) >> RAM_GENERATION_SHIFT]) {
+            cpu->jit->exit_requested = 1;
+        }
+        return;
+    }
+    cpu_jit_write8(cpu, address, data & 0x00ff);
+    cpu_jit_write8(cpu, address + 1, (data & 0xff00) >> 8);
+}
+
+static void cpu_jit_push16(CPU_t* cpu, uint16_t data) {
+    if (cpu_word_store(cpu, cpu->regs.sp - 2)) {
+        cpu_jit_write16(cpu, cpu->regs.sp - 2, data);
+        cpu->regs.sp -= 2;
+        return;
+    }
+    cpu_jit_write8(cpu, cpu->regs.sp - 1, (data & 0xff00) >> 8);
+    cpu->regs.sp --;
+    cpu_jit_write8(cpu, cpu->regs.sp - 1, data & 0x00ff);
+    cpu->regs.sp --;
+}
+
+static void cpu_jit_push8(CPU_t* cpu, uint16_t data) {
+    cpu_jit_write8(cpu, cpu->regs.sp - 1, data & 0x00ff);
+    cpu->regs.sp --;
+}
+
+static uint16_t cpu_jit_pop16(CPU_t* cpu) {
+    uint16_t data = cpu_jit_read16(cpu, cpu->regs.sp);
+    cpu->regs.sp += 2;
+    return data;
+}
+
+static uint16_t cpu_jit_pop8(CPU_t* cpu) {
+    uint8_t data = 0;
+    cpu_read_memory(cpu, cpu->regs.sp, &data);
+    cpu_jit_watch(cpu, cpu->regs.sp, 8);
+    cpu->regs.sp ++;
+    return data;
+}
+
+// translated code reads the status bits straight from sr, so the lazy flags of CMP and TST are resolved right away
+static uint16_t cpu_jit_cmp(CPU_t* cpu, uint16_t a, uint16_t b) {
+    cpu_compare(cpu, a, b);
+    cpu_status_register(cpu);
+    return 0;
+}
+
+static uint16_t cpu_jit_tst(CPU_t* cpu, uint16_t a, uint16_t value) {
+    (void) a;
+    cpu_test(cpu, value);
+    cpu_status_register(cpu);
+    return 0;
+}
+
+// instructions that compute a result from (reduced, extended) through a helper, all others are emitted inline
+static const CpuJitAlu_t cpu_jit_alu[INSTRUCTION_COUNT] = {
+    [ADC] = cpu_alu_adc, [SBC] = cpu_alu_sbc, [MUL] = cpu_alu_mul, [DIV] = cpu_alu_div, [ABS] = cpu_alu_abs,
+    [SSA] = cpu_alu_ssa, [SSS] = cpu_alu_sss, [SSM] = cpu_alu_ssm,
+    [USA] = cpu_alu_usa, [USS] = cpu_alu_uss, [USM] = cpu_alu_usm,
+    [UBS] = cpu_alu_ubs, [SBS] = cpu_alu_sbs,
+    [CMP] = cpu_jit_cmp, [TST] = cpu_jit_tst,
+    [ADDF] = cpu_alu_addf, [SUBF] = cpu_alu_subf, [MULF] = cpu_alu_mulf, [DIVF] = cpu_alu_divf,
+    [ADDD] = cpu_alu_addd, [SUBD] = cpu_alu_subd, [MULD] = cpu_alu_muld, [DIVD] = cpu_alu_divd,
+    [ADDL] = cpu_alu_addl, [SUBL] = cpu_alu_subl, [MULL] = cpu_alu_mull, [DIVL] = cpu_alu_divl,
+    [CIF] = cpu_alu_cif, [CID] = cpu_alu_cid, [CIL] = cpu_alu_cil,
+    [CFI] = cpu_alu_cfi, [CFD] = cpu_alu_cfd, [CFL] = cpu_alu_cfl,
+    [CDI] = cpu_alu_cdi, [CDF] = cpu_alu_cdf, [CDL] = cpu_alu_cdl,
+    [CLI] = cpu_alu_cli, [CLF] = cpu_alu_clf, [CLD] = cpu_alu_cld,
+    [CBI] = cpu_alu_cbi,
+};
+
+
+// =======================================================================================
+// x86-64 emitter
+
+static void cpu_jit_emit8(CpuJit_t* jit, uint8_t byte) {
+    jit->code[jit->code_used++] = byte;
+}
+
+static void cpu_jit_emit16(CpuJit_t* jit, uint16_t value) {
+    cpu_jit_emit8(jit, value & 0xff);
+    cpu_jit_emit8(jit, value >> 8);
+}
+
+static void cpu_jit_emit32(CpuJit_t* jit, uint32_t value) {
+    for (int i = 0; i < 4; i++) {
+        cpu_jit_emit8(jit, (value >> (8 * i)) & 0xff);
+    }
+}
+
+static void cpu_jit_emit64(CpuJit_t* jit, uint64_t value) {
+    for (int i = 0; i < 8; i++) {
+        cpu_jit_emit8(jit, (value >> (8 * i)) & 0xff);
+    }
+}
+
+static void cpu_jit_emit_rex(CpuJit_t* jit, int w, int reg, int rm) {
+    uint8_t rex = 0x40 | (w << 3) | ((reg >> 3) << 2) | (rm >> 3);
+    if (rex != 0x40) {
+        cpu_jit_emit8(jit, rex);
+    }
+}
+
+// op dst, src (32 bit). opcode is one of 0x01 add, 0x09 or, 0x21 and, 0x29 sub, 0x31 xor, 0x39 cmp, 0x89 mov
+static void cpu_jit_emit_op_rr(CpuJit_t* jit, uint8_t opcode, int dst, int src) {
+    cpu_jit_emit_rex(jit, 0, src, dst);
+    cpu_jit_emit8(jit, opcode);
+    cpu_jit_emit8(jit, 0xc0 | ((src & 7) << 3) | (dst & 7));
+}
+
+static void cpu_jit_emit_mov_rr(CpuJit_t* jit, int dst, int src) {
+    cpu_jit_emit_op_rr(jit, 0x89, dst, src);
+}
+
+// op dst, imm32. extension is one of 0 add, 1 or, 4 and, 5 sub, 6 xor, 7 cmp
+static void cpu_jit_emit_op_ri(CpuJit_t* jit, int extension, int dst, uint32_t imm) {
+    cpu_jit_emit_rex(jit, 0, 0, dst);
+    cpu_jit_emit8(jit, 0x81);
+    cpu_jit_emit8(jit, 0xc0 | (extension << 3) | (dst & 7));
+    cpu_jit_emit32(jit, imm);
+}
+
+static void cpu_jit_emit_mov_ri(CpuJit_t* jit, int dst, uint32_t imm) {
+    cpu_jit_emit_rex(jit, 0, 0, dst);
+    cpu_jit_emit8(jit, 0xb8 + (dst & 7));
+    cpu_jit_emit32(jit, imm);
+}
+
+// movzx dst, src16
+static void cpu_jit_emit_zero_extend(CpuJit_t* jit, int dst, int src) {
+    cpu_jit_emit_rex(jit, 0, dst, src);
+    cpu_jit_emit8(jit, 0x0f);
+    cpu_jit_emit8(jit, 0xb7);
+    cpu_jit_emit8(jit, 0xc0 | ((dst & 7) << 3) | (src & 7));
+}
+
+// unary op on eax: 0 inc, 1 dec, 2 not, 3 neg
+static void cpu_jit_emit_unary_eax(CpuJit_t* jit, int op) {
+    static const uint8_t encoding[4][2] = {{0xff, 0xc0}, {0xff, 0xc8}, {0xf7, 0xd0}, {0xf7, 0xd8}};
+    cpu_jit_emit8(jit, encoding[op][0]);
+    cpu_jit_emit8(jit, encoding[op][1]);
+}
+
+// imul reg, reg, imm32
+static void cpu_jit_emit_imul_ri(CpuJit_t* jit, int reg, uint32_t imm) {
+    cpu_jit_emit_rex(jit, 0, reg, reg);
+    cpu_jit_emit8(jit, 0x69);
+    cpu_jit_emit8(jit, 0xc0 | ((reg & 7) << 3) | (reg & 7));
+    cpu_jit_emit32(jit, imm);
+}
+
+// modrm + disp32 for [rbx + disp]
+static void cpu_jit_emit_field_operand(CpuJit_t* jit, int reg, int32_t field) {
+    cpu_jit_emit8(jit, 0x80 | ((reg & 7) << 3) | HR_CPU);
+    cpu_jit_emit32(jit, (uint32_t) field);
+}
+
+// movzx dst, word [cpu + field]
+static void cpu_jit_emit_load_field(CpuJit_t* jit, int dst, int32_t field) {
+    cpu_jit_emit_rex(jit, 0, dst, HR_CPU);
+    cpu_jit_emit8(jit, 0x0f);
+    cpu_jit_emit8(jit, 0xb7);
+    cpu_jit_emit_field_operand(jit, dst, field);
+}
+
+// mov word [cpu + field], src
+static void cpu_jit_emit_store_field(CpuJit_t* jit, int32_t field, int src) {
+    cpu_jit_emit8(jit, 0x66);
+    cpu_jit_emit_rex(jit, 0, src, HR_CPU);
+    cpu_jit_emit8(jit, 0x89);
+    cpu_jit_emit_field_operand(jit, src, field);
+}
+
+// mov word [cpu + field], imm16
+static void cpu_jit_emit_store_field_imm(CpuJit_t* jit, int32_t field, uint16_t imm) {
+    cpu_jit_emit8(jit, 0x66);
+    cpu_jit_emit8(jit, 0xc7);
+    cpu_jit_emit_field_operand(jit, 0, field);
+    cpu_jit_emit16(jit, imm);
+}
+
+// and/or/test word [cpu + field], imm16
+static void cpu_jit_emit_and_field_imm(CpuJit_t* jit, int32_t field, uint16_t imm) {
+    cpu_jit_emit8(jit, 0x66);
+    cpu_jit_emit8(jit, 0x81);
+    cpu_jit_emit_field_operand(jit, 4, field);
+    cpu_jit_emit16(jit, imm);
+}
+
+static void cpu_jit_emit_or_field_imm(CpuJit_t* jit, int32_t field, uint16_t imm) {
+    cpu_jit_emit8(jit, 0x66);
+    cpu_jit_emit8(jit, 0x81);
+    cpu_jit_emit_field_operand(jit, 1, field);
+    cpu_jit_emit16(jit, imm);
+}
+
+static void cpu_jit_emit_test_field_imm(CpuJit_t* jit, int32_t field, uint16_t imm) {
+    cpu_jit_emit8(jit, 0x66);
+    cpu_jit_emit8(jit, 0xf7);
+    cpu_jit_emit_field_operand(jit, 0, field);
+    cpu_jit_emit16(jit, imm);
+}
+
+// add qword [cpu + field], imm32
+static void cpu_jit_emit_add_field64_imm(CpuJit_t* jit, int32_t field, uint32_t imm) {
+    cpu_jit_emit8(jit, 0x48);
+    cpu_jit_emit8(jit, 0x81);
+    cpu_jit_emit_field_operand(jit, 0, field);
+    cpu_jit_emit32(jit, imm);
+}
+
+// mov dword [cpu + field], imm32
+static void cpu_jit_emit_store_field32_imm(CpuJit_t* jit, int32_t field, uint32_t imm) {
+    cpu_jit_emit8(jit, 0xc7);
+    cpu_jit_emit_field_operand(jit, 0, field);
+    cpu_jit_emit32(jit, imm);
+}
+
+// copies the carry/zero/above condition into sr bit `bit`. condition is the setcc opcode (0x92 b, 0x94 e, 0x97 a)
+static void cpu_jit_emit_set_status_bit(CpuJit_t* jit, uint8_t condition, int bit) {
+    cpu_jit_emit8(jit, 0x0f); cpu_jit_emit8(jit, condition); cpu_jit_emit8(jit, 0xc2);      // setcc dl
+    cpu_jit_emit8(jit, 0x0f); cpu_jit_emit8(jit, 0xb6); cpu_jit_emit8(jit, 0xd2);           // movzx edx, dl
+    if (bit) {
+        cpu_jit_emit8(jit, 0xc1); cpu_jit_emit8(jit, 0xe2); cpu_jit_emit8(jit, bit);        // shl edx, bit
+    }
+    cpu_jit_emit_and_field_imm(jit, CPU_JIT_FIELD(regs.sr.value), ~(1 << bit));
+    cpu_jit_emit8(jit, 0x66); cpu_jit_emit8(jit, 0x09);                                     // or word [sr], dx
+    cpu_jit_emit_field_operand(jit, HR_DX, CPU_JIT_FIELD(regs.sr.value));
+}
+
+// cmp byte [r12 + field], imm8
+static void cpu_jit_emit_cmp_jit_field(CpuJit_t* jit, int32_t field, uint8_t imm) {
+    cpu_jit_emit8(jit, 0x41); cpu_jit_emit8(jit, 0x80); cpu_jit_emit8(jit, 0xbc); cpu_jit_emit8(jit, 0x24);
+    cpu_jit_emit32(jit, (uint32_t) field);
+    cpu_jit_emit8(jit, imm);
+}
+
+// returns the position of the rel32 to patch. condition is the second opcode byte of jcc (0x84 z, 0x85 nz, 0x87 a)
+static size_t cpu_jit_emit_jcc(CpuJit_t* jit, uint8_t condition) {
+    cpu_jit_emit8(jit, 0x0f);
+    cpu_jit_emit8(jit, condition);
+    cpu_jit_emit32(jit, 0);
+    return jit->code_used - 4;
+}
+
+static void cpu_jit_patch(CpuJit_t* jit, size_t fixup, size_t target) {
+    int32_t rel = (int32_t) (target - (fixup + 4));
+    memcpy(&jit->code[fixup], &rel, sizeof(rel));
+}
+
+static void cpu_jit_emit_call(CpuJit_t* jit, uintptr_t function) {
+    cpu_jit_emit8(jit, 0x48); cpu_jit_emit8(jit, 0xb8);                 // mov rax, imm64
+    cpu_jit_emit64(jit, function);
+    cpu_jit_emit8(jit, 0xff); cpu_jit_emit8(jit, 0xd0);                 // call rax
+}
+
+// helper(cpu, esi, edx), the arguments have to be in place already except for the cpu. The uint16_t result ends up zero extended in eax
+static void cpu_jit_emit_helper(CpuJit_t* jit, uintptr_t function) {
+    cpu_jit_emit8(jit, 0x48); cpu_jit_emit8(jit, 0x89); cpu_jit_emit8(jit, 0xdf);   // mov rdi, rbx
+    cpu_jit_emit_call(jit, function);
+    cpu_jit_emit_zero_extend(jit, HR_AX, HR_AX);
+}
+
+static void cpu_jit_emit_prologue(CpuJit_t* jit) {
+    cpu_jit_emit8(jit, 0x53);                                           // push rbx
+    cpu_jit_emit8(jit, 0x55);                                           // push rbp
+    cpu_jit_emit8(jit, 0x41); cpu_jit_emit8(jit, 0x54);                 // push r12
+    cpu_jit_emit8(jit, 0x41); cpu_jit_emit8(jit, 0x55);                 // push r13
+    cpu_jit_emit8(jit, 0x41); cpu_jit_emit8(jit, 0x56);                 // push r14
+    cpu_jit_emit8(jit, 0x48); cpu_jit_emit8(jit, 0x89); cpu_jit_emit8(jit, 0xfb);   // mov rbx, rdi
+    cpu_jit_emit8(jit, 0x49); cpu_jit_emit8(jit, 0x89); cpu_jit_emit8(jit, 0xf4);   // mov r12, rsi
+    // the fetch of the first instruction would have cleared it, NC is cleared once the first opcode is read
+    cpu_jit_emit_and_field_imm(jit, CPU_JIT_FIELD(regs.sr.value), (uint16_t) ~SR_MNI_MASK);
+}
+
+static void cpu_jit_emit_return(CpuJit_t* jit, int value) {
+    cpu_jit_emit_mov_ri(jit, HR_AX, value);
+    cpu_jit_emit8(jit, 0x41); cpu_jit_emit8(jit, 0x5e);                 // pop r14
+    cpu_jit_emit8(jit, 0x41); cpu_jit_emit8(jit, 0x5d);                 // pop r13
+    cpu_jit_emit8(jit, 0x41); cpu_jit_emit8(jit, 0x5c);                 // pop r12
+    cpu_jit_emit8(jit, 0x5d);                                           // pop rbp
+    cpu_jit_emit8(jit, 0x5b);                                           // pop rbx
+    cpu_jit_emit8(jit, 0xc3);                                           // ret
+}
+
+static void cpu_jit_emit_retire(CpuJit_t* jit, uint64_t instruction, uint64_t clock, uint32_t fetched, int last_instruction) {
+    if (fetched) {
+        cpu_jit_emit_mov_ri(jit, HR_SI, fetched);
+        cpu_jit_emit_helper(jit, (uintptr_t) &cpu_jit_fetched);
+    }
+    if (instruction) {
+        cpu_jit_emit_add_field64_imm(jit, CPU_JIT_FIELD(instruction), (uint32_t) instruction);
+    }
+    if (clock) {
+        cpu_jit_emit_add_field64_imm(jit, CPU_JIT_FIELD(clock), (uint32_t) clock);
+    }
+    if (last_instruction >= 0) {
+        cpu_jit_emit_store_field32_imm(jit, CPU_JIT_FIELD(last_instruction), (uint32_t) last_instruction);
+    }
+}
+
+
+// =======================================================================================
+// translation
+
+static const int32_t cpu_jit_register_field[5] = {
+    CPU_JIT_FIELD(regs.r0), CPU_JIT_FIELD(regs.r1), CPU_JIT_FIELD(regs.r2), CPU_JIT_FIELD(regs.r3), CPU_JIT_FIELD(regs.sp),
+};
+
+static uint16_t cpu_jit_immediate(CpuJitInstruction_t* decoded, int index) {
+    return (uint8_t) decoded->argument_data_raw[index] | ((uint8_t) decoded->argument_data_raw[index + 1] << 8);
+}
+
+/*
+Decodes the instruction at pc straight from ram, the same way CS_FETCH_INSTRUCTION up to CS_FETCH_ARGUMENT_BYTES would.
+Returns 0 for encodings the interpreter would not get through cleanly, or if the instruction leaves ram
+*/
+static int cpu_jit_decode(CpuJit_t* jit, uint16_t pc, CpuJitInstruction_t* decoded) {
+    uint8_t* data = jit->ram->data;
+    uint32_t address = pc;
+    int extension_index = 0;
+    memset(decoded, 0, sizeof(*decoded));
+    decoded->pc = pc;
+    while (1) {
+        if (address > SEGMENT_CODE_END) return 0;
+        uint8_t opcode = data[address++];
+        decoded->no_cache = (opcode & 0x80) != 0;
+        if ((opcode & 0x7f) == EXT) {
+            extension_index ++;
+            if (extension_index > 2) return 0;
+            continue;
+        }
+        decoded->instruction = (opcode & 0x7f) + extension_index * 0x80;
+        break;
+    }
+    if (decoded->instruction >= INSTRUCTION_COUNT) return 0;
+
+    const CPU_INSTRUCTION_ENCODING_t* encoding = &instruction_encoding[decoded->instruction];
+    decoded->argument_count = encoding->argument_count;
+    if (decoded->argument_count) {
+        if (address > SEGMENT_CODE_END) return 0;
+        uint8_t addressing_mode = data[address++];
+        decoded->admr = addressing_mode & 0x07;
+        decoded->admx = addressing_mode >> 3;
+        int bytes;
+        if (decoded->argument_count == 2) {
+            if (decoded->admr == ADMR_NONE || cpu_extended_addressing_mode_category[decoded->admx] == ADMC_NONE) return 0;
+            bytes = cpu_reduced_addressing_mode_bytes[decoded->admr] + cpu_extended_addressing_mode_bytes[decoded->admx];
+        } else if (encoding->single_operant_writeback) {
+            if (decoded->admr == ADMR_NONE || decoded->admx != ADMX_NONE) return 0;
+            bytes = cpu_reduced_addressing_mode_bytes[decoded->admr];
+        } else {
+            if (cpu_extended_addressing_mode_category[decoded->admx] == ADMC_NONE) return 0;
+            bytes = cpu_extended_addressing_mode_bytes[decoded->admx];
+        }
+        if (address + bytes - 1 > SEGMENT_CODE_END) return 0;
+        for (int i = 0; i < bytes; i++) {
+            decoded->argument_data_raw[i] = (int8_t) data[address++];
+        }
+        // with direct ram every state chains into the next, except that every argument byte but the last and CS_COMPUTE_ADDRESS end the cycle
+        decoded->cycles = 1 + (bytes > 1 ? bytes - 1 : 0);
+    }
+    // so does every EXT prefix
+    decoded->cycles += extension_index;
+    decoded->next_pc = (uint16_t) address;
+    return 1;
+}
+
+static CpuJitExit_t* cpu_jit_exit(CpuJitTranslation_t* translation, uint16_t pc, int interpret) {
+    CpuJitExit_t* exit = &translation->exit[translation->exit_count++];
+    exit->fixup_count = 0;
+    exit->pc = pc;
+    exit->interpret = interpret;
+    exit->instruction = translation->instruction;
+    exit->clock = translation->clock;
+    exit->fetched = translation->fetched;
+    exit->last_instruction = translation->last_instruction;
+    return exit;
+}
+
+// leaves through the exit if reg > limit
+static void cpu_jit_emit_check(CpuJit_t* jit, CpuJitExit_t* exit, int reg, uint16_t limit) {
+    cpu_jit_emit_op_ri(jit, 7, reg, limit);
+    exit->fixup[exit->fixup_count++] = cpu_jit_emit_jcc(jit, 0x87);
+}
+
+// checks that sp + offset (16 bit) and the bytes after it are in ram
+static void cpu_jit_emit_stack_check(CpuJit_t* jit, CpuJitExit_t* exit, int offset, int bytes) {
+    cpu_jit_emit_load_field(jit, HR_CX, CPU_JIT_FIELD(regs.sp));
+    if (offset) {
+        cpu_jit_emit_op_ri(jit, 0, HR_CX, (uint32_t) offset);
+        cpu_jit_emit_zero_extend(jit, HR_CX, HR_CX);
+    }
+    cpu_jit_emit_check(jit, exit, HR_CX, SEGMENT_CODE_END - (bytes - 1));
+}
+
+// argument_address_extended, as in CS_COMPUTE_ADDRESS
+static void cpu_jit_emit_source_address(CpuJit_t* jit, CpuJitInstruction_t* decoded, int dst) {
+    int admx = decoded->admx;
+    if (admx == ADMX_IND16) {
+        cpu_jit_emit_mov_ri(jit, dst, cpu_jit_immediate(decoded, 0));
+    } else if (admx >= ADMX_IND_R0 && admx <= ADMX_IND_SP) {
+        cpu_jit_emit_load_field(jit, dst, cpu_jit_register_field[admx - ADMX_IND_R0]);
+    } else if (admx == ADMX_IND_PC) {
+        cpu_jit_emit_mov_ri(jit, dst, decoded->next_pc);
+    } else if (admx >= ADMX_IND_R0_OFFSET16 && admx <= ADMX_IND_SP_OFFSET16) {
+        cpu_jit_emit_load_field(jit, dst, cpu_jit_register_field[admx - ADMX_IND_R0_OFFSET16]);
+        cpu_jit_emit_op_ri(jit, 0, dst, cpu_jit_immediate(decoded, 0));
+        cpu_jit_emit_zero_extend(jit, dst, dst);
+    } else if (admx == ADMX_IND_PC_OFFSET16) {
+        cpu_jit_emit_mov_ri(jit, dst, (uint16_t) (cpu_jit_immediate(decoded, 0) + decoded->next_pc));
+    } else if (admx >= ADMX_IND16_SCALED8_R0_OFFSET && admx <= ADMX_IND16_SCALED8_SP_OFFSET) {
+        cpu_jit_emit_load_field(jit, dst, cpu_jit_register_field[admx - ADMX_IND16_SCALED8_R0_OFFSET]);
+        cpu_jit_emit_imul_ri(jit, dst, (uint8_t) decoded->argument_data_raw[2]);
+        cpu_jit_emit_op_ri(jit, 0, dst, cpu_jit_immediate(decoded, 0));
+        cpu_jit_emit_zero_extend(jit, dst, dst);
+    } else if (admx == ADMX_IND16_SCALED8_PC_OFFSET) {
+        cpu_jit_emit_mov_ri(jit, dst, (uint16_t) (cpu_jit_immediate(decoded, 0) + (uint8_t) decoded->argument_data_raw[2] * decoded->next_pc));
+    }
+}
+
+// data_address_extended for immediate and register modes, as in CS_FETCH_SOURCE
+static void cpu_jit_emit_source_value(CpuJit_t* jit, CpuJitInstruction_t* decoded, int dst) {
+    int admx = decoded->admx;
+    if (admx == ADMX_IMM16) {
+        cpu_jit_emit_mov_ri(jit, dst, cpu_jit_immediate(decoded, 0));
+    } else if (admx >= ADMX_R0 && admx <= ADMX_SP) {
+        cpu_jit_emit_load_field(jit, dst, cpu_jit_register_field[admx - ADMX_R0]);
+    } else if (admx == ADMX_PC) {
+        cpu_jit_emit_mov_ri(jit, dst, decoded->pc);
+    }
+}
+
+// argument_address_reduced. The admr bytes follow the admx ones, but the scaler byte is not skipped (see CS_COMPUTE_ADDRESS)
+static void cpu_jit_emit_destination_address(CpuJit_t* jit, CpuJitInstruction_t* decoded, int dst) {
+    if (decoded->admr == ADMR_IND16) {
+        int index = cpu_extended_addressing_mode_bytes[decoded->admx] > 2 ? 2 : cpu_extended_addressing_mode_bytes[decoded->admx];
+        cpu_jit_emit_mov_ri(jit, dst, cpu_jit_immediate(decoded, index));
+    } else if (decoded->admr == ADMR_IND_R0) {
+        cpu_jit_emit_load_field(jit, dst, CPU_JIT_FIELD(regs.r0));
+    }
+}
+
+// result in eax goes to admr, returns the number of retired instructions (register writebacks count twice)
+static int cpu_jit_emit_writeback(CpuJit_t* jit, CpuJitInstruction_t* decoded) {
+    if (cpu_reduced_addressing_mode_category[decoded->admr] == ADMC_REG) {
+        cpu_jit_emit_store_field(jit, cpu_jit_register_field[decoded->admr - ADMR_R0], HR_AX);
+        return 2;
+    }
+    cpu_jit_emit_mov_rr(jit, HR_SI, HR_DESTINATION_ADDRESS);
+    cpu_jit_emit_mov_rr(jit, HR_DX, HR_AX);
+    cpu_jit_emit_helper(jit, (uintptr_t) &cpu_jit_write16);
+    return 1;
+}
+
+// reads the pc of the instruction after the current one, jumping there if the status bit matches
+static void cpu_jit_emit_conditional_pc(CpuJit_t* jit, CpuJitInstruction_t* decoded, uint16_t mask, int negated) {
+    cpu_jit_emit_store_field_imm(jit, CPU_JIT_FIELD(regs.pc), decoded->next_pc);
+    cpu_jit_emit_test_field_imm(jit, CPU_JIT_FIELD(regs.sr.value), mask);
+    size_t skip = cpu_jit_emit_jcc(jit, negated ? 0x85 : 0x84);
+    cpu_jit_emit_store_field(jit, CPU_JIT_FIELD(regs.pc), HR_AX);
+    cpu_jit_patch(jit, skip, jit->code_used);
+}
+
+/*
+Emits one guest instruction.
+Returns 1 if the block continues after it, 2 if it ends the block (pc is set) and 0 if it has to be left to the interpreter
+*/
+static int cpu_jit_translate_instruction(CpuJit_t* jit, CpuJitTranslation_t* translation, CpuJitInstruction_t* decoded) {
+    int instruction = decoded->instruction;
+    if (decoded->no_cache) {
+        // NC stores skip the cache, the interpreter keeps track of the stale lines that leaves behind
+        return 0;
+    }
+
+    int is_jump = (instruction >= JZ && instruction <= JNAO) || instruction == JMP;
+    int is_relative_jump = instruction >= RJMP && instruction <= RJNAO;
+    int is_cmov = instruction >= CMOVZ && instruction <= CMOVNMI;
+    int is_status = instruction >= CLZ && instruction <= SEMI;
+    int is_alu = cpu_jit_alu[instruction] != NULL;
+    switch (instruction) {
+        case NOP: case EXTNOP: case EXTNOP2:
+        case MOV: case MOVB: case LEA:
+        case PUSH: case PUSHB: case PUSHSR: case POP: case POPB:
+        case CALL: case RCALL: case RET:
+        case ADD: case SUB: case AND: case OR: case XOR: case NOT: case NEG: case INC: case DEC:
+            break;
+        default:
+            if (!is_jump && !is_relative_jump && !is_cmov && !is_status && !is_alu) {
+                return 0;
+            }
+            break;
+    }
+    if (instruction == LEA && cpu_extended_addressing_mode_category[decoded->admx] != ADMC_IND) {
+        // would write back whatever address the previous instruction left behind
+        return 0;
+    }
+
+    int writeback = instruction_encoding[instruction].single_operant_writeback;
+    int reads_source = decoded->argument_count == 2 || (decoded->argument_count == 1 && !writeback);
+    int reads_destination = decoded->argument_count == 2 || (decoded->argument_count == 1 && writeback);
+    int source_indirect = reads_source && cpu_extended_addressing_mode_category[decoded->admx] == ADMC_IND;
+    int destination_indirect = reads_destination && cpu_reduced_addressing_mode_category[decoded->admr] == ADMC_IND;
+    int loads = source_indirect || destination_indirect || instruction == POP || instruction == POPB;
+
+    // everything that could leave ram is checked before the first side effect
+    CpuJitExit_t* side_exit = cpu_jit_exit(translation, decoded->pc, 1);
+    if (source_indirect) {
+        cpu_jit_emit_source_address(jit, decoded, HR_SOURCE_ADDRESS);
+        cpu_jit_emit_check(jit, side_exit, HR_SOURCE_ADDRESS, SEGMENT_CODE_END - 1);
+    }
+    if (destination_indirect) {
+        cpu_jit_emit_destination_address(jit, decoded, HR_DESTINATION_ADDRESS);
+        cpu_jit_emit_check(jit, side_exit, HR_DESTINATION_ADDRESS, SEGMENT_CODE_END - 1);
+    }
+    switch (instruction) {
+        case PUSH: case PUSHSR: case CALL: case RCALL:
+            cpu_jit_emit_stack_check(jit, side_exit, -2, 2);
+            break;
+        case PUSHB:
+            cpu_jit_emit_stack_check(jit, side_exit, -1, 1);
+            break;
+        case POP: case RET:
+            cpu_jit_emit_stack_check(jit, side_exit, 0, 2);
+            break;
+        case POPB:
+            cpu_jit_emit_stack_check(jit, side_exit, 0, 1);
+            break;
+        default:
+            break;
+    }
+    if (!side_exit->fixup_count) {
+        translation->exit_count --;
+    }
+
+    // with CJF_DIRECT and CJF_CACHED the exits account for the bytes
+    cpu_jit_emit_cmp_jit_field(jit, offsetof(CpuJit_t, fetch), CJF_EACH);
+    size_t batched = cpu_jit_emit_jcc(jit, 0x85);
+    cpu_jit_emit_mov_ri(jit, HR_SI, decoded->pc);
+    cpu_jit_emit_mov_ri(jit, HR_DX, (uint16_t) (decoded->next_pc - decoded->pc));
+    cpu_jit_emit_helper(jit, (uintptr_t) &cpu_jit_fetch);
+    cpu_jit_patch(jit, batched, jit->code_used);
+    if (!translation->fetched) {
+        // the fetch of the first instruction clears NC, translated instructions never set it
+        cpu_jit_emit_and_field_imm(jit, CPU_JIT_FIELD(regs.sr.value), (uint16_t) ~SR_NC_MASK);
+    }
+    translation->fetched += (uint16_t) (decoded->next_pc - decoded->pc);
+
+    // CS_FETCH_SOURCE
+    if (reads_source) {
+        if (source_indirect) {
+            cpu_jit_emit_mov_rr(jit, HR_SI, HR_SOURCE_ADDRESS);
+            cpu_jit_emit_helper(jit, (uintptr_t) &cpu_jit_read16);
+            cpu_jit_emit_mov_rr(jit, HR_SOURCE, HR_AX);
+        } else {
+            cpu_jit_emit_source_value(jit, decoded, HR_SOURCE);
+        }
+    }
+    // CS_FETCH_DESTINATION
+    if (reads_destination) {
+        if (destination_indirect) {
+            cpu_jit_emit_mov_rr(jit, HR_SI, HR_DESTINATION_ADDRESS);
+            cpu_jit_emit_helper(jit, (uintptr_t) &cpu_jit_read16);
+        } else {
+            cpu_jit_emit_load_field(jit, HR_AX, cpu_jit_register_field[decoded->admr - ADMR_R0]);
+        }
+    }
+
+    // CS_EXECUTE
+    int retired = 1;
+    int stores = destination_indirect;
+    int ends_block = 0;
+    if (is_alu) {
+        cpu_jit_emit_mov_rr(jit, HR_SI, HR_AX);
+        cpu_jit_emit_mov_rr(jit, HR_DX, HR_SOURCE);
+        cpu_jit_emit_helper(jit, (uintptr_t) cpu_jit_alu[instruction]);
+        if (instruction == CMP || instruction == TST) {
+            stores = 0;
+        } else {
+            retired = cpu_jit_emit_writeback(jit, decoded);
+        }
+    } else if (is_jump || is_relative_jump) {
+        cpu_jit_emit_mov_rr(jit, HR_AX, HR_SOURCE);
+        if (is_relative_jump) {
+            cpu_jit_emit_op_ri(jit, 0, HR_AX, decoded->next_pc);
+            cpu_jit_emit_zero_extend(jit, HR_AX, HR_AX);
+        }
+        if (instruction == JMP || instruction == RJMP) {
+            cpu_jit_emit_store_field(jit, CPU_JIT_FIELD(regs.pc), HR_AX);
+        } else {
+            // the conditional jumps come in pairs in the same order as the status bits
+            int condition = is_relative_jump ? instruction - RJZ : instruction - JZ;
+            cpu_jit_emit_conditional_pc(jit, decoded, 1 << (condition / 2), condition & 1);
+        }
+        ends_block = 1;
+    } else if (is_cmov) {
+        int condition = instruction - CMOVZ;
+        stores = 0;
+        cpu_jit_emit_test_field_imm(jit, CPU_JIT_FIELD(regs.sr.value), 1 << (condition / 2));
+        size_t skip = cpu_jit_emit_jcc(jit, (condition & 1) ? 0x85 : 0x84);
+        cpu_jit_emit_mov_rr(jit, HR_AX, HR_SOURCE);
+        if (cpu_jit_emit_writeback(jit, decoded) == 2) {
+            cpu_jit_emit_add_field64_imm(jit, CPU_JIT_FIELD(instruction), 1);
+        } else {
+            // only a taken cmov stores
+            cpu_jit_emit_cmp_jit_field(jit, offsetof(CpuJit_t, exit_requested), 0);
+            translation->instruction += 1;
+            translation->clock += decoded->cycles;
+            translation->last_instruction = instruction;
+            CpuJitExit_t* exit = cpu_jit_exit(translation, decoded->next_pc, 0);
+            exit->fixup[exit->fixup_count++] = cpu_jit_emit_jcc(jit, 0x85);
+            translation->instruction -= 1;
+            translation->clock -= decoded->cycles;
+        }
+        cpu_jit_patch(jit, skip, jit->code_used);
+    } else if (is_status) {
+        int bit = (instruction - CLZ) / 2;
+        if ((instruction - CLZ) & 1) {
+            cpu_jit_emit_or_field_imm(jit, CPU_JIT_FIELD(regs.sr.value), 1 << bit);
+        } else {
+            cpu_jit_emit_and_field_imm(jit, CPU_JIT_FIELD(regs.sr.value), (uint16_t) ~(1 << bit));
+        }
+    } else {
+        switch (instruction) {
+            case NOP: case EXTNOP: case EXTNOP2:
+                break;
+            case MOV:
+                cpu_jit_emit_mov_rr(jit, HR_AX, HR_SOURCE);
+                retired = cpu_jit_emit_writeback(jit, decoded);
+                break;
+            case LEA:
+                cpu_jit_emit_mov_rr(jit, HR_AX, HR_SOURCE_ADDRESS);
+                retired = cpu_jit_emit_writeback(jit, decoded);
+                break;
+            case MOVB:
+                // only the low byte of the source is written, see CS_EXECUTE
+                if (destination_indirect) {
+                    cpu_jit_emit_mov_rr(jit, HR_SI, HR_DESTINATION_ADDRESS);
+                    cpu_jit_emit_mov_rr(jit, HR_DX, HR_SOURCE);
+                    cpu_jit_emit_helper(jit, (uintptr_t) &cpu_jit_write8);
+                } else {
+                    int32_t field = cpu_jit_register_field[decoded->admr - ADMR_R0];
+                    cpu_jit_emit_mov_rr(jit, HR_CX, HR_SOURCE);
+                    cpu_jit_emit8(jit, 0x88); cpu_jit_emit_field_operand(jit, HR_CX, field);    // mov byte [field], cl
+                }
+                break;
+            case ADD:
+                cpu_jit_emit_mov_rr(jit, HR_CX, HR_AX);
+                cpu_jit_emit_op_rr(jit, 0x01, HR_CX, HR_SOURCE);
+                cpu_jit_emit_op_ri(jit, 7, HR_CX, 0xffff);
+                cpu_jit_emit_set_status_bit(jit, 0x97, 7);
+                cpu_jit_emit_zero_extend(jit, HR_AX, HR_CX);
+                retired = cpu_jit_emit_writeback(jit, decoded);
+                break;
+            case SUB:
+                cpu_jit_emit_op_rr(jit, 0x39, HR_AX, HR_SOURCE);
+                cpu_jit_emit_set_status_bit(jit, 0x92, 7);
+                cpu_jit_emit_op_rr(jit, 0x29, HR_AX, HR_SOURCE);
+                cpu_jit_emit_zero_extend(jit, HR_AX, HR_AX);
+                retired = cpu_jit_emit_writeback(jit, decoded);
+                break;
+            case AND: case OR: case XOR:
+                cpu_jit_emit_op_rr(jit, instruction == AND ? 0x21 : (instruction == OR ? 0x09 : 0x31), HR_AX, HR_SOURCE);
+                retired = cpu_jit_emit_writeback(jit, decoded);
+                break;
+            case NOT: case NEG:
+                cpu_jit_emit_unary_eax(jit, instruction == NOT ? 2 : 3);
+                cpu_jit_emit_zero_extend(jit, HR_AX, HR_AX);
+                retired = cpu_jit_emit_writeback(jit, decoded);
+                break;
+            case INC:
+                cpu_jit_emit_unary_eax(jit, 0);
+                cpu_jit_emit_zero_extend(jit, HR_AX, HR_AX);
+                cpu_jit_emit_op_ri(jit, 7, HR_AX, 0);
+                cpu_jit_emit_set_status_bit(jit, 0x94, 7);
+                retired = cpu_jit_emit_writeback(jit, decoded);
+                break;
+            case DEC:
+                cpu_jit_emit_unary_eax(jit, 1);
+                cpu_jit_emit_zero_extend(jit, HR_AX, HR_AX);
+                cpu_jit_emit_op_ri(jit, 7, HR_AX, 0xffff);
+                cpu_jit_emit_set_status_bit(jit, 0x94, 7);
+                retired = cpu_jit_emit_writeback(jit, decoded);
+                break;
+            case PUSH: case PUSHB:
+                cpu_jit_emit_mov_rr(jit, HR_SI, HR_SOURCE);
+                cpu_jit_emit_helper(jit, instruction == PUSH ? (uintptr_t) &cpu_jit_push16 : (uintptr_t) &cpu_jit_push8);
+                stores = 1;
+                break;
+            case PUSHSR:
+                cpu_jit_emit_load_field(jit, HR_SI, CPU_JIT_FIELD(regs.sr.value));
+                cpu_jit_emit_helper(jit, (uintptr_t) &cpu_jit_push16);
+                stores = 1;
+                break;
+            case POP: case POPB:
+                cpu_jit_emit_helper(jit, instruction == POP ? (uintptr_t) &cpu_jit_pop16 : (uintptr_t) &cpu_jit_pop8);
+                retired = cpu_jit_emit_writeback(jit, decoded);
+                break;
+            case CALL: case RCALL:
+                cpu_jit_emit_mov_ri(jit, HR_SI, decoded->next_pc);
+                cpu_jit_emit_helper(jit, (uintptr_t) &cpu_jit_push16);
+                cpu_jit_emit_mov_rr(jit, HR_AX, HR_SOURCE);
+                if (instruction == RCALL) {
+                    cpu_jit_emit_op_ri(jit, 0, HR_AX, decoded->next_pc);
+                }
+                cpu_jit_emit_store_field(jit, CPU_JIT_FIELD(regs.pc), HR_AX);
+                ends_block = 1;
+                break;
+            case RET:
+                cpu_jit_emit_helper(jit, (uintptr_t) &cpu_jit_pop16);
+                cpu_jit_emit_store_field(jit, CPU_JIT_FIELD(regs.pc), HR_AX);
+                ends_block = 1;
+                break;
+            default:
+                break;
+        }
+    }
+
+    translation->instruction += retired;
+    translation->clock += decoded->cycles;
+    translation->last_instruction = instruction;
+    if (ends_block) {
+        return 2;
+    }
+    if (stores || loads) {
+        // the store might have overwritten the code that follows, any access might have evicted it from the cache
+        cpu_jit_emit_cmp_jit_field(jit, offsetof(CpuJit_t, exit_requested), 0);
+        CpuJitExit_t* exit = cpu_jit_exit(translation, decoded->next_pc, 0);
+        exit->fixup[exit->fixup_count++] = cpu_jit_emit_jcc(jit, 0x85);
+    }
+    return 1;
+}
+
+static void cpu_jit_free_block(CpuJit_t* jit, uint16_t pc) {
+    free(jit->block[pc]);
+    jit->block[pc] = NULL;
+}
+
+static int cpu_jit_block_valid(CpuJit_t* jit, CpuJitBlock_t* block) {
+    uint32_t* generation = jit->ram->generation;
+    int first = block->pc >> RAM_GENERATION_SHIFT;
+    int last = (block->end - 1) >> RAM_GENERATION_SHIFT;
+    for (int i = first; i <= last; i++) {
+        if (block->generation[i - first] != generation[i]) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+static CpuJitBlock_t* cpu_jit_translate(CpuJit_t* jit, uint16_t pc) {
+    if (jit->code_used + CPU_JIT_BLOCK_CODE_MAX > CPU_JIT_CODE_SIZE) {
+        cpu_jit_flush(jit);
+    }
+
+    CpuJitTranslation_t* translation = calloc(1, sizeof(CpuJitTranslation_t));
+    if (!translation) {
+        log_msg(LP_ERROR, "JIT: Memory allocation failure [%s:%d]", __FILE__, __LINE__);
+        return NULL;
+    }
+    translation->last_instruction = -1;
+
+    size_t start = jit->code_used;
+    cpu_jit_emit_prologue(jit);
+
+    uint32_t address = pc;
+    int instruction_count = 0;
+    int ended = 0;
+    while (instruction_count < CPU_JIT_BLOCK_INSTRUCTIONS) {
+        CpuJitInstruction_t decoded;
+        if (!cpu_jit_decode(jit, (uint16_t) address, &decoded)) {
+            break;
+        }
+        size_t code_mark = jit->code_used;
+        int exit_mark = translation->exit_count;
+        int result = cpu_jit_translate_instruction(jit, translation, &decoded);
+        if (!result) {
+            jit->code_used = code_mark;
+            translation->exit_count = exit_mark;
+            break;
+        }
+        instruction_count ++;
+        address = decoded.next_pc;
+        if (result == 2) {
+            ended = 1;
+            break;
+        }
+    }
+
+    uint32_t end = address;
+    if (instruction_count == 0) {
+        // remember that the interpreter has to take over here
+        jit->code_used = start;
+        end = pc + 1;
+    } else {
+        if (!ended) {
+            cpu_jit_emit_store_field_imm(jit, CPU_JIT_FIELD(regs.pc), (uint16_t) address);
+        }
+        cpu_jit_emit_retire(jit, translation->instruction, translation->clock, translation->fetched, translation->last_instruction);
+        cpu_jit_emit_return(jit, 0);
+        for (int i = 0; i < translation->exit_count; i++) {
+            CpuJitExit_t* exit = &translation->exit[i];
+            for (int j = 0; j < exit->fixup_count; j++) {
+                cpu_jit_patch(jit, exit->fixup[j], jit->code_used);
+            }
+            cpu_jit_emit_store_field_imm(jit, CPU_JIT_FIELD(regs.pc), exit->pc);
+            cpu_jit_emit_retire(jit, exit->instruction, exit->clock, exit->fetched, exit->last_instruction);
+            cpu_jit_emit_return(jit, exit->interpret);
+        }
+    }
+    free(translation);
+
+    int first = pc >> RAM_GENERATION_SHIFT;
+    int last = (end - 1) >> RAM_GENERATION_SHIFT;
+    CpuJitBlock_t* block = malloc(sizeof(CpuJitBlock_t) + sizeof(uint32_t) * (last - first + 1));
+    if (!block) {
+        log_msg(LP_ERROR, "JIT: Memory allocation failure [%s:%d]", __FILE__, __LINE__);
+        jit->code_used = start;
+        return NULL;
+    }
+    block->pc = pc;
+    block->end = (uint16_t) end;
+    block->instruction_count = instruction_count;
+    block->code = NULL;
+    if (instruction_count) {
+        union {uint8_t* data; CpuJitBlockCode_t code;} entry = {.data = &jit->code[start]};
+        block->code = entry.code;
+    }
+    for (int i = first; i <= last; i++) {
+        block->generation[i - first] = jit->ram->generation[i];
+        jit->code_map[i] = 1;
+    }
+    jit->block[pc] = block;
+    jit->translated ++;
+    return block;
+}
+
+
+// =======================================================================================
+
+CpuJit_t* cpu_jit_create(RAM_t* ram) {
+    #if !defined(__x86_64__)
+        (void) ram;
+        log_msg(LP_ERROR, "JIT: Only x86-64 hosts are supported [%s:%d]", __FILE__, __LINE__);
+        return NULL;
+    #else
+    if (!ram) {
+        log_msg(LP_ERROR, "JIT: No RAM given to translate from [%s:%d]", __FILE__, __LINE__);
+        return NULL;
+    }
+
+    CpuJit_t* jit = calloc(1, sizeof(CpuJit_t));
+    if (!jit) {
+        log_msg(LP_ERROR, "JIT: Memory allocation failure [%s:%d]", __FILE__, __LINE__);
+        return NULL;
+    }
+    jit->ram = ram;
+    jit->block = calloc(SEGMENT_CODE_END + 1, sizeof(CpuJitBlock_t*));
+    jit->code_map = calloc((SEGMENT_CODE_END >> RAM_GENERATION_SHIFT) + 1, sizeof(uint8_t));
+    if (!jit->block || !jit->code_map) {
+        log_msg(LP_ERROR, "JIT: Memory allocation failure [%s:%d]", __FILE__, __LINE__);
+        free(jit->block);
+        free(jit->code_map);
+        free(jit);
+        return NULL;
+    }
+    jit->code = mmap(NULL, CPU_JIT_CODE_SIZE, PROT_READ | PROT_WRITE | PROT_EXEC, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (jit->code == MAP_FAILED) {
+        log_msg(LP_ERROR, "JIT: Could not map executable memory [%s:%d]", __FILE__, __LINE__);
+        free(jit->block);
+        free(jit->code_map);
+        free(jit);
+        return NULL;
+    }
+
+    return jit;
+    #endif
+}
+
+void cpu_jit_delete(CpuJit_t** jit) {
+    if (!jit) {return;}
+    if (!*jit) {return;}
+    cpu_jit_flush(*jit);
+    munmap((*jit)->code, CPU_JIT_CODE_SIZE);
+    free((*jit)->block);
+    free((*jit)->code_map);
+    free(*jit);
+    *jit = NULL;
+}
+
+void cpu_jit_flush(CpuJit_t* jit) {
+    if (!jit) {return;}
+    for (int pc = 0; pc <= SEGMENT_CODE_END; pc++) {
+        if (jit->block[pc]) {
+            cpu_jit_free_block(jit, pc);
+        }
+    }
+    memset(jit->code_map, 0, (SEGMENT_CODE_END >> RAM_GENERATION_SHIFT) + 1);
+    jit->code_used = 0;
+    jit->flushes ++;
+}
+
+int cpu_jit_run(CpuJit_t* jit, CPU_t* cpu) {
+    uint16_t pc = cpu->regs.pc;
+    if (cpu->state != CS_FETCH_INSTRUCTION || cpu->intermediate.extension_index != 0) return 0;
+    if (cpu->device.device_state != DS_IDLE || cpu->device.processed || cpu->interrupt.pending) return 0;
+    if (cpu->pipeline || cpu->branch_predictor) return 0;  // translated blocks do not report the instructions they run
+    if (pc > SEGMENT_CODE_END) return 0;
+
+    CpuJitBlock_t* block = jit->block[pc];
+    if (block && !cpu_jit_block_valid(jit, block)) {
+        cpu_jit_free_block(jit, pc);
+        block = NULL;
+    }
+    if (!block) {
+        block = cpu_jit_translate(jit, pc);
+        if (!block) return 0;
+    }
+    if (!block->instruction_count) return 0;
+
+    cpu_status_register(cpu);   // translated code reads and writes sr directly
+
+    jit->fetch = CJF_EACH;
+    if (!cpu->prefetch.active && !cpu->prefetch.valid && !cpu->device.transaction_capacity) {
+        if (!cpu->cache) {
+            jit->fetch = CJF_DIRECT;
+        } else if (!cpu->regs.sr.NC && cpu_jit_code_cached(cpu->cache, block->pc, block->end)) {
+            // NC would keep the first opcode out of the cache
+            jit->fetch = CJF_CACHED;
+        }
+    }
+    jit->fetch_start = block->pc;
+    jit->fetch_end = block->end;
+    jit->exit_requested = 0;
+    cpu->direct_ram = jit->ram;
+    int interpret = block->code(cpu, jit);
+    cpu->direct_ram = NULL;
+    jit->executed ++;
+    if (interpret) {
+        jit->side_exits ++;
+    }
+
+    // an interrupt taken right now must not roll back into the block
+    cpu->intermediate.previous_pc = cpu->regs.pc;
+    cpu->intermediate.previous_sp = cpu->regs.sp;
+    return !interpret;
+}
@@ -0,0 +1,295 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "utils/Log.h"
+
+#include "globals/memory_layout.h"
+
+#include "modules/ram.h"
+
+#include "cpu/cpu_instructions.h"
+#include "cpu/cpu_addressing_modes.h"
+#include "cpu/cpu_decode_cache.h"
+#include "cpu/cpu_pipeline.h"
+
+#define CPU_PIPELINE_SP 4
+#define CPU_PIPELINE_SR 5
+
+typedef struct CpuPipelineInstruction_t {
+    uint16_t next_pc;               // fall through
+    uint8_t length;
+    uint8_t control;                // may redirect the fetch
+    uint8_t direct;                 // unconditional jump or call with a target that is known at decode
+    uint8_t reads, writes;          // register masks, bit CPU_PIPELINE_SR is the status register
+    uint8_t loaded;                 // register mask of results that come from memory
+    uint8_t memory_accesses;
+    int execute_cycles;
+} CpuPipelineInstruction_t;
+
+
+CpuPipeline_t* cpu_pipeline_create(RAM_t* ram, CpuPipelineConfig_t config) {
+    if (!ram) {
+        log_msg(LP_ERROR, "Pipeline: No RAM given to decode from [%s:%d]", __FILE__, __LINE__);
+        return NULL;
+    }
+    if (config.fetch_bytes <= 0 || config.memory_cycles <= 0 || config.multiply_cycles <= 0 || config.divide_cycles <= 0 || config.float_cycles <= 0) {
+        log_msg(LP_ERROR, "Pipeline: Stage latencies have to be at least 1 [%s:%d]", __FILE__, __LINE__);
+        return NULL;
+    }
+    CpuPipeline_t* pipeline = calloc(1, sizeof(CpuPipeline_t));
+    if (!pipeline) {
+        log_msg(LP_ERROR, "Pipeline: Memory allocation failure [%s:%d]", __FILE__, __LINE__);
+        return NULL;
+    }
+    pipeline->ram = ram;
+    pipeline->config = config;
+    return pipeline;
+}
+
+void cpu_pipeline_delete(CpuPipeline_t** pipeline) {
+    if (!pipeline) {return;}
+    free(*pipeline);
+    *pipeline = NULL;
+}
+
+
+// register index (r0-r3, sp) an addressing mode reads, -1 if none
+static int cpu_pipeline_admx_register(int admx) {
+    if (admx >= ADMX_R0 && admx <= ADMX_SP) {return admx - ADMX_R0;}
+    if (admx >= ADMX_IND_R0 && admx <= ADMX_IND_SP) {return admx - ADMX_IND_R0;}
+    if (admx >= ADMX_IND_R0_OFFSET16 && admx <= ADMX_IND_SP_OFFSET16) {return admx - ADMX_IND_R0_OFFSET16;}
+    if (admx >= ADMX_IND16_SCALED8_R0_OFFSET && admx <= ADMX_IND16_SCALED8_SP_OFFSET) {return admx - ADMX_IND16_SCALED8_R0_OFFSET;}
+    return -1;
+}
+
+static int cpu_pipeline_execute_cycles(CpuPipeline_t* pipeline, int instruction) {
+    switch (instruction) {
+        case MUL: case MULL: case SSM: case USM:
+            return pipeline->config.multiply_cycles;
+        case DIV: case DIVL: case DIVF: case DIVD:
+            return pipeline->config.divide_cycles;
+        case ADDF: case SUBF: case MULF: case ADDD: case SUBD: case MULD:
+        case CIF: case CID: case CFI: case CFD: case CFL: case CDI: case CDF: case CDL: case CLF: case CLD:
+            return pipeline->config.float_cycles;
+        default:
+            return 1;
+    }
+}
+
+static int cpu_pipeline_reads_status(int instruction) {
+    return (instruction >= JZ && instruction <= JNAO) || (instruction >= RJZ && instruction <= RJNAO) ||
+        (instruction >= CMOVZ && instruction <= CMOVNMI) || instruction == ADC || instruction == SBC || instruction == PUSHSR;
+}
+
+static int cpu_pipeline_writes_status(int instruction) {
+    return (instruction >= ADD && instruction <= TST) || (instruction >= CLZ && instruction <= SEMI) ||
+        (instruction >= SSA && instruction <= USM) || instruction == POPSR;
+}
+
+/*
+Decodes the instruction at pc from ram and works out what it reads and writes.
+Returns 0 if it does not lie in ram or is no valid instruction
+*/
+static int cpu_pipeline_decode(CpuPipeline_t* pipeline, uint16_t pc, CpuPipelineInstruction_t* decoded) {
+    uint8_t* data = pipeline->ram->data;
+    uint32_t address = pc;
+    int extension_index = 0;
+    int instruction;
+    memset(decoded, 0, sizeof(*decoded));
+    while (1) {
+        if (address > SEGMENT_CODE_END) {return 0;}
+        uint8_t opcode = data[address++];
+        if ((opcode & 0x7f) == EXT) {
+            if (++extension_index > 2) {return 0;}
+            continue;
+        }
+        instruction = (opcode & 0x7f) + extension_index * 0x80;
+        break;
+    }
+    if (instruction >= INSTRUCTION_COUNT) {return 0;}
+
+    const CPU_INSTRUCTION_ENCODING_t* encoding = &instruction_encoding[instruction];
+    int admr = ADMR_NONE, admx = ADMX_NONE;
+    if (encoding->argument_count) {
+        if (address > SEGMENT_CODE_END) {return 0;}
+        uint8_t addressing_mode = data[address++];
+        admr = addressing_mode & 0x07;
+        admx = addressing_mode >> 3;
+        if (encoding->argument_count == 2) {
+            address += cpu_reduced_addressing_mode_bytes[admr] + cpu_extended_addressing_mode_bytes[admx];
+        } else if (encoding->single_operant_writeback) {
+            address += cpu_reduced_addressing_mode_bytes[admr];
+        } else {
+            address += cpu_extended_addressing_mode_bytes[admx];
+        }
+    }
+    decoded->next_pc = (uint16_t) address;
+    decoded->length = (uint8_t) (address - pc);
+    decoded->control = instruction >= JMP && instruction <= RCALL;
+    decoded->direct = instruction == RJMP || instruction == RCALL || ((instruction == JMP || instruction == CALL) && admx == ADMX_IMM16);
+    decoded->execute_cycles = cpu_pipeline_execute_cycles(pipeline, instruction);
+
+    // source operand
+    int source = cpu_pipeline_admx_register(admx);
+    if (source >= 0) {
+        decoded->reads |= 1 << source;
+    }
+    if (cpu_extended_addressing_mode_category[admx] == ADMC_IND && instruction != LEA) {
+        decoded->memory_accesses ++;
+    }
+
+    // destination operand
+    int reads_destination = 0, writes_destination = 0;
+    if (encoding->argument_count == 2) {
+        reads_destination = instruction != MOV && instruction != LEA && instruction != MOVB;
+        writes_destination = instruction != CMP;
+    } else if (encoding->single_operant_writeback) {
+        reads_destination = instruction != POP && instruction != POPB;
+        writes_destination = 1;
+    }
+    if (admr >= ADMR_R0 && admr <= ADMR_SP) {
+        if (reads_destination) {decoded->reads |= 1 << (admr - ADMR_R0);}
+        if (writes_destination) {decoded->writes |= 1 << (admr - ADMR_R0);}
+    } else if (cpu_reduced_addressing_mode_category[admr] == ADMC_IND) {
+        if (admr == ADMR_IND_R0) {decoded->reads |= 1 << 0;}
+        decoded->memory_accesses += reads_destination + writes_destination;
+    }
+
+    // implicit operands
+    switch (instruction) {
+        case POP: case POPB: case POPSR: case RET:
+            decoded->reads |= 1 << CPU_PIPELINE_SP;
+            decoded->writes |= 1 << CPU_PIPELINE_SP;
+            decoded->memory_accesses ++;
+            decoded->loaded = decoded->writes & ~(1 << CPU_PIPELINE_SP);
+            break;
+        case PUSH: case PUSHB: case PUSHSR: case CALL: case RCALL: case INT:
+            decoded->reads |= 1 << CPU_PIPELINE_SP;
+            decoded->writes |= 1 << CPU_PIPELINE_SP;
+            decoded->memory_accesses ++;
+            decoded->control |= instruction == INT;
+            break;
+        default:
+            if (cpu_extended_addressing_mode_category[admx] == ADMC_IND && instruction != LEA) {
+                decoded->loaded = decoded->writes;
+            }
+            break;
+    }
+    if (cpu_pipeline_reads_status(instruction)) {
+        decoded->reads |= 1 << CPU_PIPELINE_SR;
+    }
+    if (cpu_pipeline_writes_status(instruction)) {
+        decoded->writes |= 1 << CPU_PIPELINE_SR;
+        if (instruction == POPSR) {
+            decoded->loaded |= 1 << CPU_PIPELINE_SR;
+        }
+    }
+    return 1;
+}
+
+static uint64_t cpu_pipeline_max(uint64_t a, uint64_t b) {
+    return a > b ? a : b;
+}
+
+static void cpu_pipeline_schedule(CpuPipeline_t* pipeline, const CpuPipelineInstruction_t* instruction, int redirect) {
+    uint64_t fetch_start = pipeline->fetch_free;
+    if (pipeline->fetch_resume > fetch_start) {
+        pipeline->control_stalls += pipeline->fetch_resume - fetch_start;
+        fetch_start = pipeline->fetch_resume;
+    }
+    uint64_t fetch_end = fetch_start + (instruction->length + pipeline->config.fetch_bytes - 1) / pipeline->config.fetch_bytes;
+    uint64_t decode_end = cpu_pipeline_max(fetch_end, pipeline->decode_free) + 1;
+
+    // data hazards, the instruction waits in decode for its operands
+    uint64_t execute_start = cpu_pipeline_max(decode_end, pipeline->execute_free);
+    for (int r = 0; r < CPU_PIPELINE_REGISTERS; r++) {
+        if ((instruction->reads & (1 << r)) && pipeline->ready[r] > execute_start) {
+            pipeline->data_stalls += pipeline->ready[r] - execute_start;
+            execute_start = pipeline->ready[r];
+        }
+    }
+    uint64_t execute_end = execute_start + instruction->execute_cycles;
+    uint64_t memory_start = cpu_pipeline_max(execute_end, pipeline->memory_free);
+    uint64_t memory_end = memory_start + (instruction->memory_accesses ? instruction->memory_accesses * pipeline->config.memory_cycles : 1);
+    uint64_t writeback = memory_end + 1;
+
+    for (int r = 0; r < CPU_PIPELINE_REGISTERS; r++) {
+        if (!(instruction->writes & (1 << r))) {continue;}
+        if (!pipeline->config.forwarding) {
+            pipeline->ready[r] = writeback;
+        } else {
+            pipeline->ready[r] = (instruction->loaded & (1 << r)) ? memory_end : execute_end;
+        }
+    }
+
+    pipeline->fetch_free = fetch_end;
+    pipeline->decode_free = execute_start;
+    pipeline->execute_free = execute_end;
+    pipeline->memory_free = memory_end;
+    if (redirect) {
+        // resolved at the end of execute, whatever was fetched behind it is flushed
+        pipeline->fetch_resume = execute_end;
+        pipeline->redirects ++;
+    }
+    pipeline->clock = cpu_pipeline_max(pipeline->clock, writeback);
+    pipeline->instructions ++;
+}
+
+void cpu_pipeline_fetch(CpuPipeline_t* pipeline, uint16_t pc) {
+    if (pipeline->in_flight) {
+        uint16_t address = pipeline->pc;
+        for (int i = 0; i <= CPU_FUSION_MAX_FOLLOWERS; i++) {
+            CpuPipelineInstruction_t instruction;
+            if (!cpu_pipeline_decode(pipeline, address, &instruction)) {
+                // code outside of ram, counts as a plain single cycle instruction
+                instruction = (CpuPipelineInstruction_t) {.next_pc = pc, .length = 1, .control = 1, .execute_cycles = 1};
+            }
+            // a fall through that is not pc after anything but a jump means the decode cache fused the next instructions in
+            if (instruction.control || instruction.next_pc == pc || i == CPU_FUSION_MAX_FOLLOWERS) {
+                int redirect = instruction.next_pc != pc;
+                CpuBranchPredictor_t* predictor = pipeline->predictor;
+                if (predictor && instruction.control) {
+                    if (predictor->last_valid && predictor->last_pc == address) {
+                        redirect = predictor->last_mispredicted;
+                    } else if (instruction.direct) {
+                        redirect = 0;
+                    }
+                }
+                cpu_pipeline_schedule(pipeline, &instruction, redirect);
+                break;
+            }
+            cpu_pipeline_schedule(pipeline, &instruction, 0);
+            address = instruction.next_pc;
+        }
+    }
+    pipeline->in_flight = 1;
+    pipeline->pc = pc;
+}
+
+void cpu_pipeline_interrupt(CpuPipeline_t* pipeline, uint16_t pc) {
+    cpu_pipeline_fetch(pipeline, pc);
+    pipeline->in_flight = 0;
+    // entering the handler works like a call: push pc, load the vector, redirect
+    CpuPipelineInstruction_t entry = {
+        .next_pc = pc,
+        .control = 1,
+        .reads = 1 << CPU_PIPELINE_SP,
+        .writes = 1 << CPU_PIPELINE_SP,
+        .memory_accesses = 2,
+        .execute_cycles = 1,
+    };
+    cpu_pipeline_schedule(pipeline, &entry, 1);
+}
+
+void cpu_pipeline_advance(CpuPipeline_t* pipeline, uint64_t cycles, uint64_t instructions) {
+    pipeline->fetch_free += cycles;
+    pipeline->decode_free += cycles;
+    pipeline->execute_free += cycles;
+    pipeline->memory_free += cycles;
+    pipeline->fetch_resume += cycles;
+    for (int r = 0; r < CPU_PIPELINE_REGISTERS; r++) {
+        pipeline->ready[r] += cycles;
+    }
+    pipeline->clock += cycles;
+    pipeline->instructions += instructions;
+}
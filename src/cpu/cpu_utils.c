@@ -4,6 +4,7 @@
 
 #include "utils/ExtendedTypes.h"
 #include "utils/String.h"
+#include "utils/Log.h"
 
 #include "globals/memory_layout.h"
 
@@ -107,7 +108,7 @@ void cpu_print_state(CPU_t* cpu) {
 
     // Status Register (Full Value)
     printf("\n\033[1;33m Status Register\033[0m\n");
-    printf(" \033[1;32mSR\033[0m  0x%04X\n", cpu->regs.sr.value);
+    printf(" \033[1;32mSR\033[0m  0x%04X\n", cpu_status_register(cpu));
 
     // Individual Flags
     printf(" \033[1;32mZ\033[0m  [%d]  \033[1;32mFZ\033[0m [%d]  \033[1;32mL\033[0m  [%d]  \033[1;32mUL\033[0m [%d]  \033[1;32mFL\033[0m [%d]\n"
@@ -123,6 +124,86 @@ void cpu_print_state(CPU_t* cpu) {
         printf(" \033[1;32mHits\033[0m [%lu]  \033[1;32mMiss\033[0m [%lu]  \033[1;32mRate\033[0m [%2.2f%%]\n", cpu->cache->hit, cpu->cache->miss, (double) cpu->cache->hit / (double) (cpu->cache->hit + cpu->cache->miss) * 100.0);
     }
 
+    // Prefetch buffer
+    if (cpu->prefetch.active) {
+        printf("\n\033[1;33m Burst Fetch\033[0m\n");
+        printf(" \033[1;32mBursts\033[0m [%lu]  \033[1;32mBuffer Hits\033[0m [%lu]\n", cpu->prefetch.fill, cpu->prefetch.hit);
+    }
+    if (cpu->device.transaction_capacity) {
+        printf("\n\033[1;33m Split Transactions\033[0m\n");
+        printf(" \033[1;32mTags\033[0m [%d]  \033[1;32mFetched Ahead\033[0m [%lu]  \033[1;32mUsed\033[0m [%lu]  \033[1;32mBuffer Hits\033[0m [%lu]\n", cpu->device.transaction_capacity, cpu->prefetch.ahead, cpu->prefetch.ahead_used, cpu->prefetch.hit);
+    }
+
+    // Decode Cache
+    if (cpu->decode_cache) {
+        printf("\n\033[1;33m Decode Cache\033[0m\n");
+        printf(" \033[1;32mHits\033[0m [%lu]  \033[1;32mMiss\033[0m [%lu]  \033[1;32mRate\033[0m [%2.2f%%]\n", cpu->decode_cache->hit, cpu->decode_cache->miss, (double) cpu->decode_cache->hit / (double) (cpu->decode_cache->hit + cpu->decode_cache->miss) * 100.0);
+        if (cpu->decode_cache->fusion) {
+            uint64_t runs = 0;
+            for (int i = CF_NONE + 1; i < CF_COUNT; i++) {
+                runs += cpu->decode_cache->fused[i];
+            }
+            // fused instructions past the head are never looked up
+            uint64_t fetched = cpu->decode_cache->hit + cpu->decode_cache->miss + cpu->decode_cache->fused_instructions - runs;
+            printf(" \033[1;32mFused\033[0m [%lu]  \033[1;32mFallback\033[0m [%lu]  \033[1;32mRate\033[0m [%2.2f%% of instructions]\n", runs, cpu->decode_cache->fusion_fallback, fetched ? (double) cpu->decode_cache->fused_instructions / (double) fetched * 100.0 : 0.0);
+            for (int i = CF_NONE + 1; i < CF_COUNT; i++) {
+                printf("   %-14s [%lu]\n", cpu_fusion_name[i], cpu->decode_cache->fused[i]);
+            }
+        }
+    }
+
+    // JIT
+    if (cpu->jit) {
+        printf("\n\033[1;33m JIT\033[0m\n");
+        printf(" \033[1;32mBlocks\033[0m [%lu]  \033[1;32mRuns\033[0m [%lu]  \033[1;32mSide Exits\033[0m [%lu]  \033[1;32mFlushes\033[0m [%lu]  \033[1;32mCode\033[0m [%zu B]\n", cpu->jit->translated, cpu->jit->executed, cpu->jit->side_exits, cpu->jit->flushes, cpu->jit->code_used);
+    }
+
+    // Pipeline
+    if (cpu->pipeline) {
+        CpuPipeline_t* pipeline = cpu->pipeline;
+        printf("\n\033[1;33m Pipeline\033[0m\n");
+        printf(" \033[1;32mCycles\033[0m [%lu]  \033[1;32mInstructions\033[0m [%lu]  \033[1;32mCPI\033[0m [%2.3f]  \033[1;32mSpeedup\033[0m [%2.2fx]\n", pipeline->clock, pipeline->instructions, pipeline->instructions ? (double) pipeline->clock / (double) pipeline->instructions : 0.0, pipeline->clock ? (double) cpu->clock / (double) pipeline->clock : 0.0);
+        printf(" \033[1;32mData Stalls\033[0m [%lu]  \033[1;32mControl Stalls\033[0m [%lu]  \033[1;32mRedirects\033[0m [%lu]\n", pipeline->data_stalls, pipeline->control_stalls, pipeline->redirects);
+    }
+
+    // Branch Prediction
+    if (cpu->branch_predictor) {
+        cpu_branch_predictor_print(cpu->branch_predictor, 8);
+    }
+
+    // Interrupts
+    if (cpu->interrupt.taken || cpu->interrupt.dropped) {
+        printf("\n\033[1;33m Interrupts\033[0m\n");
+        printf(" \033[1;32mTaken\033[0m [%lu]  \033[1;32mDropped\033[0m [%lu]  \033[1;32mMax Latency\033[0m [%lu cycles]\n", cpu->interrupt.taken, cpu->interrupt.dropped, cpu->interrupt.latency_max);
+        for (int b = 0; b < CPU_INTERRUPT_LATENCY_BUCKETS; b++) {
+            if (!cpu->interrupt.latency[b]) {continue;}
+            uint64_t low = b ? (uint64_t) 1 << (b - 1) : 0;
+            uint64_t high = b ? ((uint64_t) 1 << b) - 1 : 0;
+            if (b == CPU_INTERRUPT_LATENCY_BUCKETS - 1) {
+                printf("   %6lu+        cycles [%lu]\n", low, cpu->interrupt.latency[b]);
+            } else {
+                printf("   %6lu-%-6lu cycles [%lu]\n", low, high, cpu->interrupt.latency[b]);
+            }
+        }
+    }
+
+    // Cycles per state
+    uint64_t active = 0, stalled = 0;
+    for (int state = 0; state < CS_COUNT; state++) {
+        active += cpu->cycles.active[state];
+        stalled += cpu->cycles.stalled[state];
+    }
+    printf("\n\033[1;33m Cycles\033[0m\n");
+    printf(" \033[1;32mActive\033[0m [%lu]  \033[1;32mStalled on Memory\033[0m [%lu]  \033[1;32mUnattributed\033[0m [%lu]\n", active, stalled, cpu->clock > active + stalled ? cpu->clock - active - stalled : 0);
+    if (active + stalled) {
+        printf("   state                              active       stalled      share\n");
+        for (int state = 0; state < CS_COUNT; state++) {
+            uint64_t cycles = cpu->cycles.active[state] + cpu->cycles.stalled[state];
+            if (!cycles) {continue;}
+            printf("   %-34s %-12lu %-12lu %5.1f%%\n", cpu_state_name[state], cpu->cycles.active[state], cpu->cycles.stalled[state], (double) cycles / (double) (active + stalled) * 100.0);
+        }
+    }
+
     // Other
     printf("\n\033[1;33m Other\033[0m\n");
     printf(" \033[1;32mclock\033[0m    %-12ld\n", cpu->clock);
@@ -138,6 +219,33 @@ void cpu_print_state(CPU_t* cpu) {
     printf("\033[1;35m=========================================\033[0m\n\n");
 }
 
+int cpu_export_cycles_json(CPU_t* cpu, const char* filename) {
+    FILE* file = fopen(filename, "w");
+    if (!file) {
+        log_msg(LP_ERROR, "CPU: Could not open \"%s\" for writing [%s:%d]", filename, __FILE__, __LINE__);
+        return 0;
+    }
+    uint64_t active = 0, stalled = 0;
+    for (int state = 0; state < CS_COUNT; state++) {
+        active += cpu->cycles.active[state];
+        stalled += cpu->cycles.stalled[state];
+    }
+    fprintf(file, "{\n");
+    fprintf(file, "  \"clock\": %lu,\n", cpu->clock);
+    fprintf(file, "  \"instructions\": %lu,\n", cpu->instruction);
+    fprintf(file, "  \"active\": %lu,\n", active);
+    fprintf(file, "  \"stalled\": %lu,\n", stalled);
+    fprintf(file, "  \"unattributed\": %lu,\n", cpu->clock > active + stalled ? cpu->clock - active - stalled : 0);
+    fprintf(file, "  \"states\": {\n");
+    for (int state = 0; state < CS_COUNT; state++) {
+        fprintf(file, "    \"%s\": {\"active\": %lu, \"stalled\": %lu}%s\n", cpu_state_name[state], cpu->cycles.active[state], cpu->cycles.stalled[state], state + 1 < CS_COUNT ? "," : "");
+    }
+    fprintf(file, "  }\n");
+    fprintf(file, "}\n");
+    fclose(file);
+    return 1;
+}
+
 void cpu_print_state_compact(CPU_t* cpu) {
     printf("\033[1;35m[CPU STATE]\033[0m ");
     printf("\033[1;32mR0\033[0m: 0x%04X  ", cpu->regs.r0);
@@ -1,5 +1,6 @@
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
 
 #include "utils/Log.h"
 
@@ -10,26 +11,47 @@
 
 
 BUS_t* bus_create(void) {
-    BUS_t* bus = malloc(sizeof(BUS_t));
+    BUS_t* bus = calloc(1, sizeof(BUS_t));
     for (int i = 0; i < 16; i++) {
         bus->device[i] = 0;
     }
     bus->device_count = 0;
+    bus->rotation_count = 0;
     bus->attended_device_index = 0;
+    bus->owner = NULL;
     bus->clock = 0ULL;
+    bus->timing_model = BTM_ROUND_ROBIN;
+    atomic_init(&bus->pending, 0);
     return bus;
 }
 
 void bus_delete(BUS_t** bus) {
     if (!bus) {return;}
+    if (!*bus) {return;}
+    for (int p = 0; p < BUS_PAGE_COUNT; p++) {
+        free((*bus)->read_page[p].sub);
+        free((*bus)->write_page[p].sub);
+    }
     free(*bus);
     *bus = NULL;
 }
 
 void bus_add_device(BUS_t* bus, Device_t* device) {
+    if (bus->rotation_count != bus->device_count) {
+        log_msg(LP_ERROR, "BUS: Devices in the rotation have to be added before the ones outside of it [%s:%d]", __FILE__, __LINE__);
+        return;
+    }
+    bus_add_device_outside_rotation(bus, device);
+    bus->rotation_count++;
+}
+
+void bus_add_device_outside_rotation(BUS_t* bus, Device_t* device) {
     int index = bus->device_count;
     bus->device[index] = device;
     bus->device_count++;
+    device->slot = index;
+    device->bus = bus;
+    bus_map_addresses(bus);
 }
 
 Device_t* bus_find_device_by_type(BUS_t* bus, DEVICE_TYPE_t device_type) {
@@ -41,58 +63,90 @@ Device_t* bus_find_device_by_type(BUS_t* bus, DEVICE_TYPE_t device_type) {
     return NULL;
 }
 
-Device_t* bus_find_readable_device_by_mmio_address(BUS_t* bus, uint16_t address) {
-    Device_t* device = NULL;
-    //log_msg(LP_DEBUG, "read, address %.4x", address);
+
+// fills page from map (one device per address), logs the listeners that overlap
+static void bus_map_access(BUS_t* bus, BusPage_t* page, Device_t** map, ListeningRegionAccess_t access_type) {
+    for (int a = 0; a < BUS_PAGE_COUNT * BUS_PAGE_SIZE; a++) {
+        map[a] = NULL;
+    }
+    // in bus order, like the old linear search the later device wins, but no longer silently
     for (int i = 0; i < bus->device_count; i++) {
-        for (int l = 0; l < bus->device[i]->listening_region_count; l++) {
-            if (!(bus->device[i]->listening_region[l].access_type & LR_READ)) {
-                //log_msg(LP_DEBUG, "read, device %d (type %d, listening region %d) was not readable", i, bus->device[i]->device_type, l);
-                continue;
-            }
-            //log_msg(LP_DEBUG, "read, device %d (type %d, listening region %d) check region %.4x - %.4x", i, bus->device[i]->device_type, l, bus->device[i]->listening_region[l].address_listener_low, bus->device[i]->listening_region[l].address_listener_high);
-            if (
-                address >= bus->device[i]->listening_region[l].address_listener_low && 
-                address <= bus->device[i]->listening_region[l].address_listener_high
-            ) {
-                if (device) {
-                    //log_msg(LP_ERROR, "BUS: Device memory read listeners are not unique (%d) [%s:%d]", device->device_type, __FILE__, __LINE__);
+        Device_t* device = bus->device[i];
+        for (int l = 0; l < device->listening_region_count; l++) {
+            ListeningRegion_t* region = &device->listening_region[l];
+            if (!(region->access_type & access_type)) {continue;}
+            int overlap = -1;
+            Device_t* other = NULL;
+            for (int a = region->address_listener_low; a <= region->address_listener_high; a++) {
+                if (map[a] && map[a] != device && overlap < 0) {
+                    overlap = a;
+                    other = map[a];
                 }
-                device = bus->device[i];
+                map[a] = device;
+            }
+            if (overlap >= 0) {
+                log_msg(LP_ERROR, "BUS: Device %d (type %d) %s $%.4x-$%.4x, overlapping device %d (type %d) from $%.4x on [%s:%d]", 
+                    i, device->device_type, access_type == LR_READ ? "reads" : "writes", region->address_listener_low, region->address_listener_high, 
+                    other->slot, other->device_type, overlap, __FILE__, __LINE__);
             }
         }
     }
-    if (device) {
-        //log_msg(LP_DEBUG, "BUS: Found readable mmio device (type %d)", device->device_type);
-    }
-    return device;
-}
 
-Device_t* bus_find_writable_device_by_mmio_address(BUS_t* bus, uint16_t address) {
-    Device_t* device = NULL;
-    //log_msg(LP_DEBUG, "write, address %.4x", address);
-    for (int i = 0; i < bus->device_count; i++) {
-        for (int l = 0; l < bus->device[i]->listening_region_count; l++) {
-            if (!(bus->device[i]->listening_region[l].access_type & LR_WRITE)) {
-                //log_msg(LP_DEBUG, "write, device %d was not readable", bus->device[i]->device_type);
-                continue;
+    for (int p = 0; p < BUS_PAGE_COUNT; p++) {
+        Device_t** entry = &map[p * BUS_PAGE_SIZE];
+        int shared = 0;
+        for (int a = 1; a < BUS_PAGE_SIZE; a++) {
+            if (entry[a] != entry[0]) {
+                shared = 1;
+                break;
             }
-            //log_msg(LP_DEBUG, "write, device %d check region %.4x - %.4x", bus->device[i]->device_type, bus->device[i]->listening_region[l].address_listener_low, bus->device[i]->listening_region[l].address_listener_high);
-            if (
-                address >= bus->device[i]->listening_region[l].address_listener_low && 
-                address <= bus->device[i]->listening_region[l].address_listener_high
-            ) {
-                if (device) {
-                    //log_msg(LP_ERROR, "BUS: Device memory write listeners are not unique (%d) [%s:%d]", device->device_type, __FILE__, __LINE__);
-                }
-                device = bus->device[i];
+        }
+        if (!shared) {
+            free(page[p].sub);
+            page[p].sub = NULL;
+            page[p].device = entry[0];
+            continue;
+        }
+        if (!page[p].sub) {
+            page[p].sub = malloc(BUS_PAGE_SIZE * sizeof(Device_t*));
+            if (!page[p].sub) {
+                log_msg(LP_ERROR, "BUS: Memory allocation failure [%s:%d]", __FILE__, __LINE__);
+                continue;
             }
         }
+        memcpy(page[p].sub, entry, BUS_PAGE_SIZE * sizeof(Device_t*));
+        page[p].device = NULL;
     }
-    if (device) {
-        //log_msg(LP_DEBUG, "BUS: Found writable mmio device %d", device->device_type);
+}
+
+void bus_map_addresses(BUS_t* bus) {
+    Device_t** map = malloc(BUS_PAGE_COUNT * BUS_PAGE_SIZE * sizeof(Device_t*));
+    if (!map) {
+        log_msg(LP_ERROR, "BUS: Memory allocation failure [%s:%d]", __FILE__, __LINE__);
+        return;
     }
-    return device;
+    bus_map_access(bus, bus->read_page, map, LR_READ);
+    bus_map_access(bus, bus->write_page, map, LR_WRITE);
+    free(map);
+}
+
+static inline Device_t* bus_page_lookup(BusPage_t* page, uint16_t address) {
+    BusPage_t* entry = &page[address >> 8];
+    return entry->sub ? entry->sub[address & (BUS_PAGE_SIZE - 1)] : entry->device;
+}
+
+Device_t* bus_find_readable_device_by_mmio_address(BUS_t* bus, uint16_t address) {
+    return bus_page_lookup(bus->read_page, address);
+}
+
+Device_t* bus_find_writable_device_by_mmio_address(BUS_t* bus, uint16_t address) {
+    return bus_page_lookup(bus->write_page, address);
+}
+
+// replies go by slot, the id stays the identity of the device outside the bus
+static inline Device_t* bus_device_by_slot(BUS_t* bus, int slot) {
+    if (slot < 0 || slot >= bus->device_count) {return NULL;}
+    return bus->device[slot];
 }
 
 Device_t* bus_find_device_by_id(BUS_t* bus, DeviceID_t id) {
@@ -105,330 +159,229 @@ Device_t* bus_find_device_by_id(BUS_t* bus, DeviceID_t id) {
 }
 
 
-void bus_clock(BUS_t* bus) {
-    Device_t* device = bus->device[bus->attended_device_index];
-    DEVICE_TYPE_t device_type = device->device_type;
+void bus_post(BUS_t* bus, Device_t* device) {
+    atomic_fetch_or_explicit(&bus->pending, 1u << device->slot, memory_order_relaxed);
+}
+
+int bus_issue_transactions(BUS_t* bus, Device_t* device) {
+    int issued_all = 1;
+    for (int t = 0; t < device->transaction_capacity; t++) {
+        DeviceTransaction_t* transaction = &device->transaction[t];
+        if (transaction->state == DS_IDLE || transaction->issued) {continue;}
+        if (transaction->cancelled) {
+            transaction->state = DS_IDLE;
+            continue;
+        }
+        Device_t* device_mmio = transaction->state == DS_FETCH 
+            ? bus_find_readable_device_by_mmio_address(bus, transaction->address) 
+            : bus_find_writable_device_by_mmio_address(bus, transaction->address);
+        if (!device_mmio) {
+            // open bus, like the untagged request
+            transaction->issued = 1;
+            transaction->processed = 1;
+            continue;
+        }
+        if (device_mmio->device_state != DS_IDLE) {
+            issued_all = 0;
+            continue;
+        }
+        device_mmio->address = transaction->address;
+        device_mmio->data = transaction->data;
+        device_mmio->width = transaction->width;
+        device_mmio->device_target_id = device->device_id;
+        device_mmio->target_slot = device->slot;
+        device_mmio->target_tag = t + 1;
+        device_mmio->device_state = transaction->state;
+        device_mmio->processed = 0;
+        transaction->issued = 1;
+    }
+    return issued_all;
+}
+
+int bus_forward_request(BUS_t* bus, Device_t* device) {
+    int served = 1;
     DEVICE_STATE_t device_state = device->device_state;
-    switch (device_type) {
-        case DT_CPU:
-            //log_msg(LP_DEBUG, "BUS %d: Attending to a CPU", bus->clock);
-            switch (device_state) {
-                case DS_IDLE:
-                    //log_msg(LP_DEBUG, "BUS %d: The CPU is idle", bus->clock);
-                    break;
-                
-                case DS_FETCH: {
-                    //log_msg(LP_DEBUG, "BUS %d: The CPU is fetching data", bus->clock);
-                    if (device->processed == 1) {
-                        //log_msg(LP_DEBUG, "BUS %d: The CPU has a fulfilled request pending", bus->clock);
-                        break;
-                    }
-                    // Check the reading address, if its below 0xF000, then its addressing ram
-                    Device_t* device_mmio = bus_find_readable_device_by_mmio_address(bus, device->address);
-                    if (!device_mmio) {
-                        // this here is open bus behavior! Good. 
-                        device->processed = 1;
-                        device->device_state = DS_IDLE;
-                        //log_msg(LP_DEBUG, "BUS %d: No MMIO device attached to the BUS, that is responding on reads from address $%.4x [%s:%d]", bus->clock, device->address, __FILE__, __LINE__);
-                        // what do now?
-                        break;
-                    }
-                    //log_msg(LP_DEBUG, "BUS %d: Found MMIO device to fetch data from. Making request", bus->clock);
-                    // lets just straight up overwrite it and see what happens
-                    if (device_mmio->device_state == DS_IDLE) {
-                        device_mmio->address = device->address;
-                        device_mmio->device_target_id = device->device_id;
-                        device_mmio->device_state = DS_FETCH;
-                        device_mmio->processed = 0;
-                    } else {
-                        //log_msg(LP_DEBUG, "BUS %d: MMIO device is Idle, need to wait", bus->clock);
-                    }
-                    break;
-                }
-                
-                case DS_STORE: {
-                    //log_msg(LP_DEBUG, "BUS %d: The CPU is storing data", bus->clock);
-                    if (device->processed == 1) {
-                        //log_msg(LP_SUCCESS, "BUS %d: The CPU has a fulfilled request pending", bus->clock);
-                        break;
-                    }
-                    // Check the reading address, if its below 0xF000, then its addressing ram
-                    Device_t* device_mmio = bus_find_writable_device_by_mmio_address(bus, device->address);
-                    if (!device_mmio) {
-                        device->processed = 1;
-                        device->device_state = DS_IDLE;
-                        //log_msg(LP_DEBUG, "BUS %d: No MMIO device attached to the BUS, that is responding on writes to address $%.4x [%s:%d]", bus->clock, device->address, __FILE__, __LINE__);
-                        // what do now?
-                        break;
-                    }
-                    //log_msg(LP_DEBUG, "BUS %d: Found RAM device to store data to. Making request", bus->clock);
-                    // lets just straight up overwrite it and see what happens
-                    if (device_mmio->device_state == DS_IDLE) {
-                        device_mmio->address = device->address;
-                        device_mmio->data = device->data;
-                        device_mmio->device_target_id = device->device_id;
-                        device_mmio->device_state = DS_STORE;
-                        device_mmio->processed = 0;
-                    } else {
-                        //log_msg(LP_DEBUG, "BUS %d: RAM device is Idle, need to wait", bus->clock);
-                    }
-                    break;
-                }
-                
-                case DS_INTERRUPT:
-                    // CPU will handle... I guess
-                    break;
-                
-                default:
-                    //log_msg(LP_DEBUG, "BUS %d: The CPU is in an unknown state %d", bus->clock, device_state);
-                    break;
-            }
+    if (bus->owner && bus->owner != device) {
+        // another core runs on its own host thread right now
+        return 0;
+    }
+    switch (device_state) {
+        case DS_IDLE:
+            //log_msg(LP_DEBUG, "BUS %d: The CPU is idle", bus->clock);
             break;
         
-        
-        
-        
-        case DT_RAM:
-            //log_msg(LP_DEBUG, "BUS %d: Attending to a RAM", bus->clock);
-            
-            // figure out what the CPU wants
-            switch (device_state) {
-                case DS_IDLE:
-                    //log_msg(LP_DEBUG, "BUS %d: The RAM is idle", bus->clock);
-                    break;
-                
-                case DS_FETCH: {
-                    //log_msg(LP_DEBUG, "BUS %d: The RAM is retrieving data", bus->clock);
-                    if (device->processed == 0) {
-                        //log_msg(LP_DEBUG, "BUS %d: The RAM is not done with the request yet", bus->clock);
-                        break;
-                    }
-                    Device_t* device_target = bus_find_device_by_id(bus, device->device_target_id);
-                    if (!device_target) {
-                        //log_msg(LP_ERROR, "BUS %d: Target device is not attached to the BUS [%s:%d]", bus->clock, __FILE__, __LINE__);
-                        break;
-                    }
-                    //log_msg(LP_DEBUG, "BUS %d: Found Target device to send data to", bus->clock);
-                    device_target->data = device->data;
-                    device_target->processed = 1;
-                    device->device_state = DS_IDLE;
-                    break;
-                }
-                
-                case DS_STORE: {
-                    //log_msg(LP_DEBUG, "BUS %d: The RAM is storing data", bus->clock);
-                    if (device->processed == 0) {
-                        //log_msg(LP_DEBUG, "BUS %d: The RAM is not done with the request yet", bus->clock);
-                        break;
-                    }
-                    Device_t* device_target = bus_find_device_by_id(bus, device->device_target_id);
-                    if (!device_target) {
-                        //log_msg(LP_ERROR, "BUS %d: Target device is not attached to the BUS [%s:%d]", bus->clock, __FILE__, __LINE__);
-                        break;
-                    }
-                    //log_msg(LP_DEBUG, "BUS %d: Found Target device to validate", bus->clock);
-                    device_target->processed = 1;
-                    device->device_state = DS_IDLE;
-                    break;
-                }
-                
-                default:
-                    //log_msg(LP_DEBUG, "BUS %d: The RAM is in an unknown state %d", bus->clock, device_state);
-                    break;
+        case DS_FETCH: {
+            //log_msg(LP_DEBUG, "BUS %d: The CPU is fetching data", bus->clock);
+            if (device->processed == 1) {
+                //log_msg(LP_DEBUG, "BUS %d: The CPU has a fulfilled request pending", bus->clock);
+                break;
+            }
+            // Check the reading address, if its below 0xF000, then its addressing ram
+            Device_t* device_mmio = bus_find_readable_device_by_mmio_address(bus, device->address);
+            if (!device_mmio) {
+                // this here is open bus behavior! Good. 
+                device->processed = 1;
+                device->device_state = DS_IDLE;
+                //log_msg(LP_DEBUG, "BUS %d: No MMIO device attached to the BUS, that is responding on reads from address $%.4x [%s:%d]", bus->clock, device->address, __FILE__, __LINE__);
+                // what do now?
+                break;
+            }
+            //log_msg(LP_DEBUG, "BUS %d: Found MMIO device to fetch data from. Making request", bus->clock);
+            // lets just straight up overwrite it and see what happens
+            if (device_mmio->device_state == DS_IDLE) {
+                device_mmio->address = device->address;
+                device_mmio->device_target_id = device->device_id;
+                device_mmio->target_slot = device->slot;
+                device_mmio->target_tag = 0;
+                device_mmio->device_state = DS_FETCH;
+                device_mmio->processed = 0;
+            } else {
+                //log_msg(LP_DEBUG, "BUS %d: MMIO device is Idle, need to wait", bus->clock);
+                served = 0;
             }
             break;
-
-
-
-        
-        case DT_CLOCK:
-            //log_msg(LP_DEBUG, "BUS %d: Attending to a Clock", bus->clock);
-            switch (device_state) {
-                case DS_IDLE:
-                    //log_msg(LP_DEBUG, "BUS %d: The CLOCK is idle", bus->clock);
-                    break;
-                
-                case DS_INTERRUPT: {
-                    //log_msg(LP_DEBUG, "BUS %d: The CLOCK has sent an interrupt signal", bus->clock);
-                    Device_t* device_target = bus_find_device_by_type(bus, DT_CPU);
-                    if (!device_target) {
-                        //log_msg(LP_WARNING, "BUS %d: The CLOCK did not find a CPU to notify [%s:%d]", bus->clock, __FILE__, __LINE__);
-                        device->device_state = DS_IDLE;
-                        break;
-                    }
-                    if (device_target->device_state != DS_IDLE) {
-                        //log_msg(LP_WARNING, "BUS %d: The target device (CPU) is not idle [%s:%d]", bus->clock, __FILE__, __LINE__);
-                        break;
-                    }
-                    device_target->device_state = DS_INTERRUPT;
-                    device_target->address = device->address;
-                    device->device_state = DS_IDLE;
-                    //log_msg(LP_DEBUG, "BUS %d: Target device (CPU) notified", bus->clock);
-                    break;
-                }
-                
-                default:
-                    //log_msg(LP_DEBUG, "BUS %d: The CLOCK is in an unknown state %d", bus->clock, device_state);
-                    break;
-                }
-            break;
-
-
-
-        
+        }
         
-        case DT_TERMINAL:
-            //log_msg(LP_DEBUG, "BUS %d: Attending to a Terminal", bus->clock);
-            // figure out what the CPU wants
-            switch (device_state) {
-                case DS_IDLE:
-                    //log_msg(LP_DEBUG, "BUS %d: The Terminal is idle", bus->clock);
-                    break;
-                
-                case DS_FETCH:
-                    break;
-                
-                case DS_STORE: {
-                    //log_msg(LP_DEBUG, "BUS %d: The Terminal is storing data", bus->clock);
-                    if (device->processed == 0) {
-                        //log_msg(LP_DEBUG, "BUS %d: The Terminal is not done with the request yet", bus->clock);
-                        break;
-                    }
-                    Device_t* device_target = bus_find_device_by_id(bus, device->device_target_id);
-                    if (!device_target) {
-                        //log_msg(LP_ERROR, "BUS %d: Terminal target device is not attached to the BUS [%s:%d]", bus->clock, __FILE__, __LINE__);
-                        break;
-                    }
-                    //log_msg(LP_DEBUG, "BUS %d: Found Terminal target device to validate", bus->clock);
-                    device_target->processed = 1;
-                    device->device_state = DS_IDLE;
-                    break;
-                }
-                
-                default:
-                    //log_msg(LP_DEBUG, "BUS %d: The Terminal is in an unknown state %d", bus->clock, device_state);
-                    break;
+        case DS_STORE: {
+            //log_msg(LP_DEBUG, "BUS %d: The CPU is storing data", bus->clock);
+            if (device->processed == 1) {
+                //log_msg(LP_SUCCESS, "BUS %d: The CPU has a fulfilled request pending", bus->clock);
+                break;
+            }
+            // Check the reading address, if its below 0xF000, then its addressing ram
+            Device_t* device_mmio = bus_find_writable_device_by_mmio_address(bus, device->address);
+            if (!device_mmio) {
+                device->processed = 1;
+                device->device_state = DS_IDLE;
+                //log_msg(LP_DEBUG, "BUS %d: No MMIO device attached to the BUS, that is responding on writes to address $%.4x [%s:%d]", bus->clock, device->address, __FILE__, __LINE__);
+                // what do now?
+                break;
+            }
+            //log_msg(LP_DEBUG, "BUS %d: Found RAM device to store data to. Making request", bus->clock);
+            // lets just straight up overwrite it and see what happens
+            if (device_mmio->device_state == DS_IDLE) {
+                device_mmio->address = device->address;
+                device_mmio->data = device->data;
+                device_mmio->width = device->width;
+                device_mmio->device_target_id = device->device_id;
+                device_mmio->target_slot = device->slot;
+                device_mmio->target_tag = 0;
+                device_mmio->device_state = DS_STORE;
+                device_mmio->processed = 0;
+            } else {
+                //log_msg(LP_DEBUG, "BUS %d: RAM device is Idle, need to wait", bus->clock);
+                served = 0;
             }
             break;
+        }
         
-
-
-
-        case DT_MEMORY_BANK:
-            //log_msg(LP_DEBUG, "BUS %d: Attending to a MEMORY_BANK", bus->clock);
-            
-            // figure out what the CPU wants
-            switch (device_state) {
-                case DS_IDLE:
-                    //log_msg(LP_DEBUG, "BUS %d: The MEMORY_BANK is idle", bus->clock);
-                    break;
-                
-                case DS_FETCH: {
-                    //log_msg(LP_DEBUG, "BUS %d: The MEMORY_BANK is retrieving data", bus->clock);
-                    if (device->processed == 0) {
-                        //log_msg(LP_DEBUG, "BUS %d: The MEMORY_BANK is not done with the request yet", bus->clock);
-                        break;
-                    }
-                    Device_t* device_target = bus_find_device_by_id(bus, device->device_target_id);
-                    if (!device_target) {
-                        //log_msg(LP_ERROR, "BUS %d: Target device is not attached to the BUS [%s:%d]", bus->clock, __FILE__, __LINE__);
-                        break;
-                    }
-                    //log_msg(LP_DEBUG, "BUS %d: Found Target device to send data to", bus->clock);
-                    device_target->data = device->data;
-                    device_target->processed = 1;
-                    device->device_state = DS_IDLE;
-                    break;
-                }
-                
-                case DS_STORE: {
-                    //log_msg(LP_DEBUG, "BUS %d: The MEMORY_BANK is storing data", bus->clock);
-                    if (device->processed == 0) {
-                        //log_msg(LP_DEBUG, "BUS %d: The MEMORY_BANK is not done with the request yet", bus->clock);
-                        break;
-                    }
-                    Device_t* device_target = bus_find_device_by_id(bus, device->device_target_id);
-                    if (!device_target) {
-                        //log_msg(LP_ERROR, "BUS %d: Target device is not attached to the BUS [%s:%d]", bus->clock, __FILE__, __LINE__);
-                        break;
-                    }
-                    //log_msg(LP_DEBUG, "BUS %d: Found Target device to validate", bus->clock);
-                    device_target->processed = 1;
-                    device->device_state = DS_IDLE;
-                    break;
-                }
-                
-                default:
-                    //log_msg(LP_DEBUG, "BUS %d: The MEMORY_BANK is in an unknown state %d", bus->clock, device_state);
-                    break;
-            }
+        case DS_INTERRUPT:
+            // CPU will handle... I guess
             break;
         
+        default:
+            //log_msg(LP_DEBUG, "BUS %d: The CPU is in an unknown state %d", bus->clock, device_state);
+            break;
+    }
+    // the untagged request goes first, the tagged ones take the targets it left idle
+    if (device->transaction_capacity && !bus_issue_transactions(bus, device)) {
+        served = 0;
+    }
+    return served;
+}
 
+void bus_return_reply(BUS_t* bus, Device_t* device) {
+    Device_t* device_target = bus_device_by_slot(bus, device->target_slot);
+    if (!device_target) {
+        //log_msg(LP_ERROR, "BUS %d: Target device is not attached to the BUS [%s:%d]", bus->clock, __FILE__, __LINE__);
+        return;
+    }
+    if (device->device_state == DS_FETCH) {
+        //log_msg(LP_DEBUG, "BUS %d: Found Target device to send data to", bus->clock);
+        device_reply(device_target, device->target_tag, device->data);
+    } else {
+        //log_msg(LP_DEBUG, "BUS %d: Found Target device to validate", bus->clock);
+        device_acknowledge(device_target, device->target_tag);
+    }
+    device->device_state = DS_IDLE;
+}
 
+int bus_deliver_interrupt(BUS_t* bus, Device_t* device) {
+    if (device->device_state != DS_INTERRUPT) {return 1;}
+    // the core the interrupt is routed to, the first cpu if none is set
+    Device_t* device_target = device->target_slot >= 0 ? bus_device_by_slot(bus, device->target_slot) : bus_find_device_by_type(bus, DT_CPU);
+    if (!device_target) {
+        //log_msg(LP_WARNING, "BUS %d: The CLOCK did not find a CPU to notify [%s:%d]", bus->clock, __FILE__, __LINE__);
+        device->device_state = DS_IDLE;
+        return 1;
+    }
+    if (device_target->device_state != DS_IDLE) {
+        //log_msg(LP_WARNING, "BUS %d: The target device (CPU) is not idle [%s:%d]", bus->clock, __FILE__, __LINE__);
+        return 0;
+    }
+    device_target->device_state = DS_INTERRUPT;
+    device_target->address = device->address;
+    device_target->asserted = device->asserted;
+    device_target->coalesced = device->coalesced;
+    device->device_state = DS_IDLE;
+    //log_msg(LP_DEBUG, "BUS %d: Target device (CPU) notified", bus->clock);
+    return 1;
+}
 
-        case DT_FILESYSTEM:
-            //log_msg(LP_DEBUG, "BUS %d: Attending to a FILESYSTEM", bus->clock);
-            
-            // figure out what the CPU wants
-            switch (device_state) {
-                case DS_IDLE:
-                    //log_msg(LP_DEBUG, "BUS %d: The FILESYSTEM is idle", bus->clock);
-                    break;
-                
-                case DS_FETCH: {
-                    //log_msg(LP_DEBUG, "BUS %d: The FILESYSTEM is retrieving data", bus->clock);
-                    if (device->processed == 0) {
-                        //log_msg(LP_DEBUG, "BUS %d: The FILESYSTEM is not done with the request yet", bus->clock);
-                        break;
-                    }
-                    Device_t* device_target = bus_find_device_by_id(bus, device->device_target_id);
-                    if (!device_target) {
-                        //log_msg(LP_ERROR, "BUS %d: Target device is not attached to the BUS [%s:%d]", bus->clock, __FILE__, __LINE__);
-                        break;
-                    }
-                    //log_msg(LP_DEBUG, "BUS %d: Found Target device to send data to", bus->clock);
-                    device_target->data = device->data;
-                    device_target->processed = 1;
-                    device->device_state = DS_IDLE;
-                    break;
-                }
-                
-                case DS_STORE: {
-                    //log_msg(LP_DEBUG, "BUS %d: The FILESYSTEM is storing data", bus->clock);
-                    if (device->processed == 0) {
-                        //log_msg(LP_DEBUG, "BUS %d: The FILESYSTEM is not done with the request yet", bus->clock);
-                        break;
-                    }
-                    Device_t* device_target = bus_find_device_by_id(bus, device->device_target_id);
-                    if (!device_target) {
-                        //log_msg(LP_ERROR, "BUS %d: Target device is not attached to the BUS [%s:%d]", bus->clock, __FILE__, __LINE__);
-                        break;
-                    }
-                    //log_msg(LP_DEBUG, "BUS %d: Found Target device to validate", bus->clock);
-                    device_target->processed = 1;
-                    device->device_state = DS_IDLE;
-                    break;
-                }
-                
-                default:
-                    //log_msg(LP_DEBUG, "BUS %d: The FILESYSTEM is in an unknown state %d", bus->clock, device_state);
-                    break;
-            }
-            break;
-
+// serves what device posted, returns 0 if it has to wait for another device and stays pending
+static int bus_attend(BUS_t* bus, Device_t* device) {
+    const DeviceOps_t* ops = device->ops;
+    if (!ops) {return 1;}
+    if (ops->reply && device->processed && (device->device_state == DS_FETCH || device->device_state == DS_STORE)) {
+        ops->reply(bus, device);
+        if (!ops->request) {return 1;}
+        // a target that is a master as well (DMA) goes on with its own requests
+    }
+    return ops->request ? ops->request(bus, device) : 1;
+}
 
-            default:
-                //log_msg(LP_WARNING, "BUS %d: Attending to an unknown device %d / %llu [%s:%d]", bus->clock, device_type, device->device_id, __FILE__, __LINE__);
-                break;
+void bus_clock(BUS_t* bus) {
+    if (bus->timing_model == BTM_EVENT) {
+        uint32_t pending = atomic_exchange_explicit(&bus->pending, 0, memory_order_relaxed);
+        uint32_t waiting = 0;
+        while (pending) {
+            int slot = __builtin_ctz(pending);
+            pending &= pending - 1;
+            if (!bus_attend(bus, bus->device[slot])) {
+                waiting |= 1u << slot;
+            }
+        }
+        if (waiting) {
+            atomic_fetch_or_explicit(&bus->pending, waiting, memory_order_relaxed);
+        }
+        bus->clock ++;
+        return;
     }
 
+    uint32_t bit = 1u << bus->attended_device_index;
+    if (atomic_load_explicit(&bus->pending, memory_order_relaxed) & bit) {
+        atomic_fetch_and_explicit(&bus->pending, ~bit, memory_order_relaxed);
+        if (!bus_attend(bus, bus->device[bus->attended_device_index])) {
+            atomic_fetch_or_explicit(&bus->pending, bit, memory_order_relaxed);
+        }
+    }
 
     // attending to possible request of the next device
-    bus->attended_device_index = (bus->attended_device_index + 1) % bus->device_count;
+    bus->attended_device_index = (bus->attended_device_index + 1) % bus->rotation_count;
     bus->clock ++;
     return;
 }
 
+void bus_attend_outside_rotation(BUS_t* bus) {
+    for (int slot = bus->rotation_count; slot < bus->device_count; slot++) {
+        uint32_t bit = 1u << slot;
+        if (!(atomic_load_explicit(&bus->pending, memory_order_relaxed) & bit)) {continue;}
+        atomic_fetch_and_explicit(&bus->pending, ~bit, memory_order_relaxed);
+        if (!bus_attend(bus, bus->device[slot])) {
+            atomic_fetch_or_explicit(&bus->pending, bit, memory_order_relaxed);
+        }
+    }
+}
+
 
 
@@ -61,6 +61,12 @@ int cache_read(Cache_t* cache, uint16_t address, uint8_t* data) {
     return 1;
 }
 
+int cache_contains(Cache_t* cache, uint16_t address) {
+    if (!cache) return 0;
+    uint16_t cache_address = address & (cache->capacity - 1);
+    return cache->state[cache_address].valid && cache->address[cache_address] == address;
+}
+
 int cache_write(Cache_t* cache, uint16_t address, uint8_t* data, size_t data_size) {
     if (!cache) return 0;
 
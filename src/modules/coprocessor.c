@@ -7,13 +7,24 @@
 #include "globals/memory_layout.h"
 
 #include "modules/device.h"
+#include "modules/bus.h"
 #include "modules/coprocessor.h"
 
 const uint16_t MMIO_MODE_REGISTER_ADDRESS = SEGMENT_MMIO + 6;       // sets the general operation mode (r/w)
 
+static void coprocessor_device_clock(void* coprocessor) {
+    coprocessor_clock((Coprocessor_t*) coprocessor);
+}
+
+static const DeviceOps_t coprocessor_device_ops = {
+    .clock = coprocessor_device_clock, 
+    .reply = bus_return_reply, 
+};
+
 Coprocessor_t* coprocessor_create(void) {
     Coprocessor_t* coprocessor = malloc(sizeof(Coprocessor_t));
     coprocessor->device = device_create(DT_FILESYSTEM);
+    device_register_ops(&coprocessor->device, &coprocessor_device_ops, coprocessor, 1);
 
     device_add_listening_region(
         &coprocessor->device, 
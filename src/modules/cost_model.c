@@ -0,0 +1,373 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "utils/Log.h"
+
+#include "globals/memory_layout.h"
+
+#include "cpu/cpu.h"
+#include "cpu/cpu_instructions.h"
+#include "cpu/cpu_addressing_modes.h"
+
+#include "modules/cache.h"
+#include "modules/device.h"
+#include "modules/ram.h"
+#include "modules/system.h"
+#include "modules/cost_model.h"
+
+#include "compiler/asm/disassembler.h"
+
+/*
+Addresses of the measurement. They fall into different lines of small direct mapped caches, so a warm instruction
+does not evict its own code. Everything else in ram is hlt, so whatever an instruction jumps, calls or returns to,
+the cpu halts right behind it
+*/
+#define COST_MODEL_CODE 0x1000          // where the measured instruction is placed
+#define COST_MODEL_REGISTER 0x0030      // r0-r3, indirect register operands
+#define COST_MODEL_STACK 0x6018         // sp, push and pop
+#define COST_MODEL_ARGUMENT 0x4020      // every 16-bit argument, immediates and indirect bases
+#define COST_MODEL_INDEX(instruction, no_cache, admr, admx) ((((instruction) * 2 + (no_cache)) * ADMR_ADDRESSING_MODE_COUNT + (admr)) * ADMX_ADDRESSING_MODE_COUNT + (admx))
+
+
+static int cost_model_run_phases(CostModel_t* model, const uint8_t* code, int length, uint32_t* cold_sum, uint32_t* warm_sum, int* cold_min, int* cold_max);
+
+CostModel_t* cost_model_create(uint16_t cache_capacity, BusTimingModel_t bus_timing) {
+    CostModel_t* model = calloc(1, sizeof(CostModel_t));
+    if (!model) {
+        log_msg(LP_ERROR, "Cost Model: Memory allocation failure [%s:%d]", __FILE__, __LINE__);
+        return NULL;
+    }
+    model->cost = calloc(INSTRUCTION_COUNT * 2 * ADMR_ADDRESSING_MODE_COUNT * ADMX_ADDRESSING_MODE_COUNT, sizeof(InstructionCost_t));
+    if (!model->cost) {
+        log_msg(LP_ERROR, "Cost Model: Memory allocation failure [%s:%d]", __FILE__, __LINE__);
+        free(model);
+        return NULL;
+    }
+    model->system = system_create(cache_capacity != 0, cache_capacity, 0, 0.0, CTM_MULTI_CYCLE, 1);
+    if (!model->system) {
+        log_msg(LP_ERROR, "Cost Model: System could not be created [%s:%d]", __FILE__, __LINE__);
+        cost_model_delete(&model);
+        return NULL;
+    }
+    system_set_bus_timing(model->system, bus_timing);
+    model->cache_capacity = cache_capacity;
+    model->bus_phases = bus_timing == BTM_EVENT ? 1 : model->system->bus->rotation_count;
+
+    // what the trailing hlt costs, taken off every measurement
+    uint8_t halt = HLT;
+    uint32_t cold_sum, warm_sum;
+    int cold_min, cold_max;
+    cost_model_run_phases(model, &halt, 1, &cold_sum, &warm_sum, &cold_min, &cold_max);
+    model->halt_cold = (float) cold_sum / (float) model->bus_phases;
+    model->halt_warm = (float) warm_sum / (float) model->bus_phases;
+    return model;
+}
+
+void cost_model_delete(CostModel_t** model) {
+    if (!model) {return;}
+    if (!*model) {return;}
+    system_delete(&(*model)->system);
+    free((*model)->cost);
+    free(*model);
+    *model = NULL;
+}
+
+
+// puts the cpu back to how cpu_create left it, keeping its bus device and the contents of its cache
+static int cost_model_reset_cpu(CostModel_t* model) {
+    CPU_t* cpu = model->system->cpu;
+    CPU_t* fresh = cpu_create();
+    if (!fresh) {
+        log_msg(LP_ERROR, "Cost Model: Memory allocation failure [%s:%d]", __FILE__, __LINE__);
+        return 0;
+    }
+    Cache_t* cache = cpu->cache;
+    Device_t device = cpu->device;
+    *cpu = *fresh;
+    free(fresh);
+    cpu->cache = cache;
+    cpu->device = device;
+    device_reset(&cpu->device);
+    cpu_select_clock_variant(cpu);
+
+    cpu->regs.r0 = cpu->regs.r1 = cpu->regs.r2 = cpu->regs.r3 = COST_MODEL_REGISTER;
+    cpu->regs.sp = COST_MODEL_STACK;
+    cpu->regs.pc = COST_MODEL_CODE;
+    return 1;
+}
+
+// fills ram with hlt and puts code at COST_MODEL_CODE
+static void cost_model_load(CostModel_t* model, const uint8_t* code, int length) {
+    memset(model->system->ram->data, HLT, SEGMENT_MMIO);
+    memcpy(&model->system->ram->data[COST_MODEL_CODE], code, length);
+}
+
+// lets the request the cpu still has in flight complete, so it cannot answer the next measurement
+static void cost_model_drain(CostModel_t* model) {
+    System_t* system = model->system;
+    system->cpu->state = CS_HALT;
+    for (int cycle = 0; cycle < COST_MODEL_MAX_CYCLES; cycle++) {
+        int busy = system->cpu->device.device_state != DS_IDLE && !system->cpu->device.processed;
+        for (int i = 0; i < system->bus->device_count; i++) {
+            if (system->bus->device[i] != &system->cpu->device && system->bus->device[i]->device_state != DS_IDLE) {
+                busy = 1;
+            }
+        }
+        if (!busy) {return;}
+        system_clock(system);
+    }
+}
+
+// cycles from the first fetch at COST_MODEL_CODE until the cpu halts or sleeps, -1 if it excepts
+static int cost_model_run(CostModel_t* model, int phase) {
+    System_t* system = model->system;
+    CPU_t* cpu = system->cpu;
+    if (!cost_model_reset_cpu(model)) {return -1;}
+    system->bus->attended_device_index = phase;
+
+    int cycles = -1;
+    for (int cycle = 1; cycle <= COST_MODEL_MAX_CYCLES; cycle++) {
+        system_clock(system);
+        if (cpu->state == CS_EXCEPTION) {break;}
+        if (cpu->state == CS_HALT || cpu->state == CS_SLEEP) {
+            cycles = cycle;
+            break;
+        }
+    }
+    cost_model_drain(model);
+    return cycles;
+}
+
+// runs code from every bus phase, cold and again warm, sums the cycles until the cpu halts or sleeps. 0 if it excepts
+static int cost_model_run_phases(CostModel_t* model, const uint8_t* code, int length, uint32_t* cold_sum, uint32_t* warm_sum, int* cold_min, int* cold_max) {
+    *cold_sum = *warm_sum = 0;
+    *cold_min = COST_MODEL_MAX_CYCLES;
+    *cold_max = 0;
+    for (int phase = 0; phase < model->bus_phases; phase++) {
+        cost_model_load(model, code, length);
+        if (model->system->cpu->cache) {
+            cache_invalidate(model->system->cpu->cache);
+        }
+        int cold = cost_model_run(model, phase);
+        // stores of the cold run may have overwritten code or hlt
+        cost_model_load(model, code, length);
+        int warm = cost_model_run(model, phase);
+        if (cold < 0 || warm < 0) {return 0;}
+        *cold_sum += cold;
+        *warm_sum += warm;
+        if (cold < *cold_min) {*cold_min = cold;}
+        if (cold > *cold_max) {*cold_max = cold;}
+    }
+    return 1;
+}
+
+static void cost_model_measure(CostModel_t* model, InstructionCost_t* cost, int instruction, int admr, int admx, int no_cache) {
+    uint8_t code[16] = {0};
+    int length = 0;
+    for (int e = 0; e < instruction / 0x80; e++) {
+        code[length++] = EXT;
+    }
+    code[length++] = (uint8_t) ((instruction & 0x7f) | (no_cache ? 0x80 : 0x00));
+    int argument_bytes = 0;
+    if (instruction_encoding[instruction].argument_count > 0) {
+        code[length++] = (uint8_t) ((admx << 3) | admr);
+        argument_bytes = cpu_reduced_addressing_mode_bytes[admr] + cpu_extended_addressing_mode_bytes[admx];
+    }
+    for (int b = 0; b < argument_bytes; b++) {
+        code[length++] = (b & 1) ? (COST_MODEL_ARGUMENT >> 8) : (COST_MODEL_ARGUMENT & 0xff);
+    }
+
+    uint32_t cold_sum, warm_sum;
+    int cold_min, cold_max;
+    cost->measured = 1;
+    cost->valid = (uint8_t) cost_model_run_phases(model, code, length, &cold_sum, &warm_sum, &cold_min, &cold_max);
+    if (!cost->valid) {return;}
+
+    /*
+    Back to back instructions overlap, the fetch of the next one starts in the cycle the last one ends
+    and cached bytes are read in the same cycle. So the cost is what the instruction adds in front of the hlt it runs into,
+    unless it stops the cpu itself
+    */
+    float cold_halt = 0.0f, warm_halt = 0.0f;
+    if (instruction != HLT && instruction != HWSLEEP) {
+        cold_halt = model->halt_cold;
+        warm_halt = model->halt_warm;
+    }
+    float phases = (float) model->bus_phases;
+    cost->cold = (float) cold_sum / phases - cold_halt;
+    cost->warm = (float) warm_sum / phases - warm_halt;
+    cost->min = (uint16_t) (cold_min - cold_halt > 0.0f ? cold_min - cold_halt + 0.5f : 0.0f);
+    cost->max = (uint16_t) (cold_max - cold_halt > 0.0f ? cold_max - cold_halt + 0.5f : 0.0f);
+}
+
+const InstructionCost_t* cost_model_lookup(CostModel_t* model, int instruction, int admr, int admx, int no_cache) {
+    if (instruction < 0 || instruction >= INSTRUCTION_COUNT || admr < 0 || admr >= ADMR_ADDRESSING_MODE_COUNT || admx < 0 || admx >= ADMX_ADDRESSING_MODE_COUNT) {
+        return NULL;
+    }
+    if (instruction != NOP && instruction_encoding[instruction].mnemonic == 0) {
+        return NULL;
+    }
+    if (instruction_encoding[instruction].argument_count == 0) {
+        admr = admx = 0;
+    }
+    InstructionCost_t* cost = &model->cost[COST_MODEL_INDEX(instruction, no_cache != 0, admr, admx)];
+    if (!cost->measured) {
+        cost_model_measure(model, cost, instruction, admr, admx, no_cache != 0);
+    }
+    return cost;
+}
+
+const InstructionCost_t* cost_model_lookup_binary(CostModel_t* model, const uint8_t* binary, long binary_size, uint16_t address, int* length) {
+    long index = address;
+    if (index >= binary_size) {return NULL;}
+    int ext_count = 0;
+    while ((binary[index] & 0x7f) == EXT) {
+        ext_count ++;
+        if (++index >= binary_size) {return NULL;}
+    }
+    int no_cache = (binary[index] & 0x80) != 0;
+    int instruction = (binary[index++] & 0x7f) + ext_count * 0x80;
+    if (instruction >= INSTRUCTION_COUNT || (instruction != NOP && instruction_encoding[instruction].mnemonic == 0)) {
+        return NULL;
+    }
+    int admr = 0, admx = 0;
+    if (instruction_encoding[instruction].argument_count > 0) {
+        if (index >= binary_size) {return NULL;}
+        admr = binary[index] & 0x07;
+        admx = (binary[index++] & 0xf8) >> 3;
+        index += cpu_reduced_addressing_mode_bytes[admr] + cpu_extended_addressing_mode_bytes[admx];
+    }
+    if (index > binary_size) {return NULL;}
+    if (length) {*length = (int) (index - address);}
+    return cost_model_lookup(model, instruction, admr, admx, no_cache);
+}
+
+
+typedef struct CostModelLine_t {
+    uint16_t address;
+    int length;                     // 0 for a data byte
+    const InstructionCost_t* cost;
+    char* text;
+} CostModelLine_t;
+
+static int cost_model_label_index(const uint16_t* label_address, int label_count, uint16_t address) {
+    for (int l = 0; l < label_count; l++) {
+        if (label_address[l] == address) {return l;}
+    }
+    return -1;
+}
+
+// the address of the next label after address, binary_size if there is none
+static long cost_model_next_label(const uint16_t* label_address, int label_count, long address, long binary_size) {
+    long next = binary_size;
+    for (int l = 0; l < label_count; l++) {
+        if (label_address[l] > address && label_address[l] < next) {
+            next = label_address[l];
+        }
+    }
+    return next;
+}
+
+static void cost_model_print_label(CostModelLine_t* line, int line_count, int first, long end, const char* name, FILE* file) {
+    int instructions = 0, unknown = 0;
+    double cold = 0.0, warm = 0.0;
+    for (int i = first; i < line_count && line[i].address < end; i++) {
+        if (!line[i].length) {continue;}
+        if (!line[i].cost || !line[i].cost->valid) {
+            unknown ++;
+            continue;
+        }
+        instructions ++;
+        cold += line[i].cost->cold;
+        warm += line[i].cost->warm;
+    }
+    fprintf(file, "%-44s; %d instructions, %.1f cycles (warm %.1f)", name, instructions, cold, warm);
+    if (unknown) {
+        fprintf(file, ", %d without estimate", unknown);
+    }
+    fprintf(file, "\n");
+}
+
+void cost_model_annotate(CostModel_t* model, const uint8_t* binary, long binary_size, const uint16_t* label_address, char** label_name, int label_count, FILE* file) {
+    // the decoder reads whole argument fields, so it gets a copy with room behind the last byte
+    uint8_t* padded = calloc(binary_size + 16, sizeof(uint8_t));
+    CostModelLine_t* line = calloc(binary_size + 1, sizeof(CostModelLine_t));
+    if (!padded || !line) {
+        log_msg(LP_ERROR, "Cost Model: Memory allocation failure [%s:%d]", __FILE__, __LINE__);
+        free(padded);
+        free(line);
+        return;
+    }
+    memcpy(padded, binary, binary_size);
+
+    int line_count = 0;
+    long address = 0;
+    while (address < binary_size) {
+        long next_label = cost_model_next_label(label_address, label_count, address, binary_size);
+        int length = 0;
+        const InstructionCost_t* cost = cost_model_lookup_binary(model, padded, binary_size, (uint16_t) address, &length);
+        // padding between segments
+        if (padded[address] == 0x00 && cost_model_label_index(label_address, label_count, (uint16_t) address) < 0) {
+            address ++;
+            continue;
+        }
+        CostModelLine_t* current = &line[line_count++];
+        current->address = (uint16_t) address;
+        if (cost && address + length <= next_label) {
+            int index = (int) address;
+            int valid = 0;
+            current->text = disassembler_decompile_single_instruction(padded, &index, &valid, NULL, NULL, NULL, 0);
+            current->length = length;
+            current->cost = cost;
+            address += length;
+        } else {
+            // does not decode, or would run into a label
+            current->text = calloc(16, sizeof(char));
+            if (current->text) {
+                sprintf(current->text, ".db $%.2X", padded[address]);
+            }
+            address ++;
+        }
+    }
+
+    if (model->system->bus->timing_model == BTM_EVENT) {
+        fprintf(file, "; cycle estimate: multi-cycle timing, event bus, ");
+    } else {
+        fprintf(file, "; cycle estimate: multi-cycle timing, round-robin bus over %d devices, ", model->bus_phases);
+    }
+    if (model->cache_capacity) {
+        fprintf(file, "data cache of %d bytes\n", model->cache_capacity);
+    } else {
+        fprintf(file, "no data cache\n");
+    }
+    fprintf(file, "; cycles are averaged over the bus phases [cold min-max] and again with the instruction cached (warm)\n");
+
+    for (int i = 0; i < line_count; i++) {
+        int label = cost_model_label_index(label_address, label_count, line[i].address);
+        if (label >= 0 || i == 0) {
+            long end = cost_model_next_label(label_address, label_count, line[i].address, binary_size);
+            char name[32];
+            if (label < 0) {
+                sprintf(name, "; (entry)");
+            } else if (!label_name) {
+                sprintf(name, ".$%.4X", line[i].address);
+            }
+            cost_model_print_label(line, line_count, i, end, (label >= 0 && label_name) ? label_name[label] : name, file);
+        }
+        char* text = line[i].text ? line[i].text : "";
+        if (!line[i].length) {
+            fprintf(file, "    0x%.4x  %-32s;\n", line[i].address, text);
+        } else if (!line[i].cost->valid) {
+            fprintf(file, "    0x%.4x  %-32s;   ? cycles, excepts\n", line[i].address, text);
+        } else {
+            fprintf(file, "    0x%.4x  %-32s; %5.1f [%d-%d]  warm %5.1f\n", line[i].address, text, line[i].cost->cold, line[i].cost->min, line[i].cost->max, line[i].cost->warm);
+        }
+    }
+
+    for (int i = 0; i < line_count; i++) {
+        free(line[i].text);
+    }
+    free(line);
+    free(padded);
+}
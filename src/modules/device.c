@@ -1,8 +1,10 @@
 #include <stdlib.h>
 
 #include "utils/Random.h"
+#include "utils/Log.h"
 
 #include "modules/device.h"
+#include "modules/bus.h"
 
 Device_t device_create(DEVICE_TYPE_t type) {
     return (Device_t) {
@@ -12,9 +14,19 @@ Device_t device_create(DEVICE_TYPE_t type) {
         .processed = 0,
         .address = 0,
         .data = 0,
+        .width = 1, 
         .device_target_id = 0, 
+        .slot = -1, 
+        .target_slot = -1, 
+        .target_tag = 0, 
+        .transaction_capacity = 0, 
+        .transaction = NULL, 
         .listening_region = NULL, 
         .listening_region_count = 0, 
+        .bus = NULL, 
+        .ops = NULL, 
+        .owner = NULL, 
+        .divider = 1, 
     };
 }
 
@@ -29,6 +41,23 @@ ListeningRegion_t listening_region_create(uint16_t address_listener_low, uint16_
 void device_add_listening_region(Device_t* device, ListeningRegion_t listening_region) {
     device->listening_region = realloc(device->listening_region, sizeof(ListeningRegion_t) * (device->listening_region_count + 1));
     device->listening_region[device->listening_region_count++] = listening_region;
+    if (device->bus) {
+        bus_map_addresses(device->bus);
+    }
+}
+
+void device_register_ops(Device_t* device, const DeviceOps_t* ops, void* owner, uint32_t divider) {
+    device->ops = ops;
+    device->owner = owner;
+    device_set_clock_divider(device, divider);
+}
+
+void device_set_clock_divider(Device_t* device, uint32_t divider) {
+    if (divider == 0) {
+        log_msg(LP_ERROR, "DEVICE: Clock divider 0, clocking every cycle [%s:%d]", __FILE__, __LINE__);
+        divider = 1;
+    }
+    device->divider = divider;
 }
 
 // sets the device back to idle and set processed to 0
@@ -39,6 +68,83 @@ void device_reset(Device_t* device) {
     device->data = 0xffffffffffffffffULL;
 }
 
+void device_post(Device_t* device) {
+    if (device->bus) {
+        bus_post(device->bus, device);
+    }
+}
+
+void device_set_transaction_capacity(Device_t* device, int capacity) {
+    free(device->transaction);
+    device->transaction = NULL;
+    device->transaction_capacity = 0;
+    if (capacity <= 0) {return;}
+    if (capacity > DEVICE_MAX_TRANSACTIONS) {
+        log_msg(LP_ERROR, "DEVICE: At most %d tagged requests can be outstanding, not %d [%s:%d]", DEVICE_MAX_TRANSACTIONS, capacity, __FILE__, __LINE__);
+        capacity = DEVICE_MAX_TRANSACTIONS;
+    }
+    device->transaction = calloc(capacity, sizeof(DeviceTransaction_t));
+    if (!device->transaction) {
+        log_msg(LP_ERROR, "DEVICE: Memory allocation failure [%s:%d]", __FILE__, __LINE__);
+        return;
+    }
+    device->transaction_capacity = capacity;
+}
+
+int device_issue(Device_t* device, DEVICE_STATE_t state, uint64_t address, uint64_t data, uint8_t width) {
+    for (int t = 0; t < device->transaction_capacity; t++) {
+        DeviceTransaction_t* transaction = &device->transaction[t];
+        if (transaction->state != DS_IDLE) {continue;}
+        *transaction = (DeviceTransaction_t) {
+            .state = state, 
+            .width = width, 
+            .address = address, 
+            .data = data, 
+        };
+        device_post(device);
+        return t + 1;
+    }
+    return 0;
+}
+
+void device_release(Device_t* device, int tag) {
+    if (tag <= 0 || tag > device->transaction_capacity) {return;}
+    DeviceTransaction_t* transaction = &device->transaction[tag - 1];
+    if (transaction->issued && !transaction->processed) {
+        transaction->cancelled = 1;
+        return;
+    }
+    transaction->state = DS_IDLE;
+}
+
+void device_reply(Device_t* device, uint8_t tag, uint64_t data) {
+    if (tag == 0) {
+        device->data = data;
+        device->processed = 1;
+        return;
+    }
+    if (tag > device->transaction_capacity) {return;}
+    DeviceTransaction_t* transaction = &device->transaction[tag - 1];
+    transaction->data = data;
+    transaction->processed = 1;
+    if (transaction->cancelled) {
+        transaction->state = DS_IDLE;
+    }
+}
+
+void device_acknowledge(Device_t* device, uint8_t tag) {
+    if (tag == 0) {
+        device->processed = 1;
+        return;
+    }
+    if (tag > device->transaction_capacity) {return;}
+    DeviceTransaction_t* transaction = &device->transaction[tag - 1];
+    transaction->processed = 1;
+    if (transaction->cancelled) {
+        transaction->state = DS_IDLE;
+    }
+}
+
 // returns 1 if the current request has been processed, else 0
 int device_check_response(Device_t* device) {
     return device->processed;
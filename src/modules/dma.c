@@ -0,0 +1,236 @@
+#include <stdlib.h>
+#include <stdint.h>
+
+#include "globals/memory_layout.h"
+#include "globals/interrupt.h"
+
+#include "utils/Log.h"
+
+#include "modules/device.h"
+#include "modules/bus.h"
+#include "modules/ram.h"
+#include "modules/memory_bank.h"
+#include "modules/dma.h"
+
+const uint16_t MMIO_DMA_SOURCE_REGISTER = SEGMENT_MMIO + 0x10;         // (r/w)
+const uint16_t MMIO_DMA_DESTINATION_REGISTER = SEGMENT_MMIO + 0x12;    // (r/w)
+const uint16_t MMIO_DMA_LENGTH_REGISTER = SEGMENT_MMIO + 0x14;         // bytes left (r/w)
+const uint16_t MMIO_DMA_VALUE_REGISTER = SEGMENT_MMIO + 0x16;          // fill byte or bank index (r/w)
+const uint16_t MMIO_DMA_MODE_REGISTER = SEGMENT_MMIO + 0x17;           // starts the transfer (w), mode while busy (r)
+
+static void dma_device_clock(void* dma) {
+    dma_clock((DMA_t*) dma);
+}
+
+// the controller is a master for its own transfers and a target for its registers at the same time
+static int dma_request(BUS_t* bus, Device_t* device) {
+    int served = bus_issue_transactions(bus, device);
+    if (device->device_state == DS_INTERRUPT && !bus_deliver_interrupt(bus, device)) {
+        served = 0;
+    }
+    return served;
+}
+
+static const DeviceOps_t dma_device_ops = {
+    .clock = dma_device_clock, 
+    .request = dma_request, 
+    .reply = bus_return_reply, 
+    .clock_idle = 1, 
+};
+
+DMA_t* dma_create(MemoryBank_t* memory_bank) {
+    DMA_t* dma = calloc(1, sizeof(DMA_t));
+    if (!dma) {
+        log_msg(LP_ERROR, "DMA: Memory allocation failure [%s:%d]", __FILE__, __LINE__);
+        return NULL;
+    }
+    dma->device = device_create(DT_DMA);
+    device_register_ops(&dma->device, &dma_device_ops, dma, 1);
+    device_add_listening_region(
+        &dma->device, 
+        listening_region_create(MMIO_DMA_SOURCE_REGISTER, MMIO_DMA_MODE_REGISTER, LR_READ | LR_WRITE)
+    );
+    device_set_transaction_capacity(&dma->device, DMA_TRANSACTIONS);
+    dma->device.device_state = DS_IDLE;
+    dma->memory_bank = memory_bank;
+    dma->interrupt_slot = -1;
+    dma->clock = 0ULL;
+    return dma;
+}
+
+void dma_delete(DMA_t** dma) {
+    if (!dma || !*dma) {return;}
+    device_set_transaction_capacity(&(*dma)->device, 0);
+    free((*dma)->device.listening_region);
+    free(*dma);
+    *dma = NULL;
+}
+
+int dma_busy(DMA_t* dma) {
+    return dma->mode || dma->interrupt_pending || dma->device.device_state == DS_INTERRUPT;
+}
+
+static uint8_t dma_read_register(DMA_t* dma, uint16_t address) {
+    switch ((uint16_t) (address - MMIO_DMA_SOURCE_REGISTER)) {
+        case 0: return (uint8_t) dma->source;
+        case 1: return (uint8_t) (dma->source >> 8);
+        case 2: return (uint8_t) dma->destination;
+        case 3: return (uint8_t) (dma->destination >> 8);
+        case 4: return (uint8_t) dma->length;
+        case 5: return (uint8_t) (dma->length >> 8);
+        case 6: return dma->value;
+        case 7: return dma->mode;
+        default: return 0;
+    }
+}
+
+static void dma_start(DMA_t* dma, uint8_t mode) {
+    uint8_t operation = mode & DMA_OPERATION;
+    if (operation < DMA_COPY || operation > DMA_BANK_TO_RAM) {
+        log_msg(LP_ERROR, "DMA: Unknown mode 0x%.2x [%s:%d]", mode, __FILE__, __LINE__);
+        return;
+    }
+    if (operation == DMA_BANK_TO_RAM && !dma->memory_bank) {
+        log_msg(LP_ERROR, "DMA: No memory bank to transfer from [%s:%d]", __FILE__, __LINE__);
+        return;
+    }
+    dma->mode = mode;
+    dma->interrupt_slot = dma->device.target_slot;
+}
+
+// the set up of a running transfer cannot be changed
+static void dma_write_register(DMA_t* dma, uint16_t address, uint8_t data) {
+    if (dma->mode) {return;}
+    switch ((uint16_t) (address - MMIO_DMA_SOURCE_REGISTER)) {
+        case 0: dma->source = (dma->source & 0xff00) | data; break;
+        case 1: dma->source = (dma->source & 0x00ff) | (uint16_t) (data << 8); break;
+        case 2: dma->destination = (dma->destination & 0xff00) | data; break;
+        case 3: dma->destination = (dma->destination & 0x00ff) | (uint16_t) (data << 8); break;
+        case 4: dma->length = (dma->length & 0xff00) | data; break;
+        case 5: dma->length = (dma->length & 0x00ff) | (uint16_t) (data << 8); break;
+        case 6: dma->value = data; break;
+        case 7: dma_start(dma, data); break;
+        default: break;
+    }
+}
+
+// answers the register access of another device, like every other MMIO device does
+static void dma_serve_register(DMA_t* dma) {
+    Device_t* device = &dma->device;
+    if (device->processed || (device->device_state != DS_FETCH && device->device_state != DS_STORE)) {return;}
+    uint16_t address = (uint16_t) device->address;
+    if (device->device_state == DS_FETCH) {
+        uint64_t data = 0;
+        for (int i = 0; i < DMA_BLOCK_BYTES; i++) {
+            data |= (uint64_t) dma_read_register(dma, address + i) << (8 * i);
+        }
+        device->data = data;
+    } else {
+        for (uint8_t i = 0; i < device->width; i++) {
+            dma_write_register(dma, address + i, (uint8_t) (device->data >> (8 * i)));
+        }
+    }
+    device->processed = 1;
+    device_post(device);
+}
+
+// bytes of the next block, it stays inside the page of source and destination (and inside the bank)
+static uint8_t dma_block_width(DMA_t* dma, uint8_t operation) {
+    if (
+        (dma->mode & DMA_FIXED_DESTINATION) || dma->destination >= SEGMENT_MMIO || 
+        (operation == DMA_COPY && ((dma->mode & DMA_FIXED_SOURCE) || dma->source >= SEGMENT_MMIO))
+    ) {
+        return 1;
+    }
+    uint16_t width = dma->length < DMA_BLOCK_BYTES ? dma->length : DMA_BLOCK_BYTES;
+    uint16_t source_left = operation == DMA_BANK_TO_RAM 
+        ? MMIO_BANK_WIDTH - dma->source % MMIO_BANK_WIDTH 
+        : BUS_PAGE_SIZE - (dma->source & (BUS_PAGE_SIZE - 1));
+    uint16_t destination_left = BUS_PAGE_SIZE - (dma->destination & (BUS_PAGE_SIZE - 1));
+    if (operation != DMA_FILL && source_left < width) {width = source_left;}
+    if (destination_left < width) {width = destination_left;}
+    return (uint8_t) width;
+}
+
+// reads the next block, the fetch of a copy arrives later
+static void dma_next_block(DMA_t* dma) {
+    uint8_t operation = dma->mode & DMA_OPERATION;
+    uint8_t width = dma_block_width(dma, operation);
+    dma->staged_width = width;
+    dma->staged_destination = dma->destination;
+    switch (operation) {
+        case DMA_FILL:
+            dma->staged_data = dma->value * 0x0101010101010101ULL;
+            dma->staged = 1;
+            break;
+
+        case DMA_BANK_TO_RAM: {
+            uint16_t base = (uint16_t) ((dma->value & 0x07) * MMIO_BANK_WIDTH + dma->source % MMIO_BANK_WIDTH);
+            dma->staged_data = 0;
+            for (uint8_t i = 0; i < width; i++) {
+                dma->staged_data |= (uint64_t) ram_read(dma->memory_bank->ram, base + i) << (8 * i);
+            }
+            dma->staged = 1;
+            break;
+        }
+
+        default:
+            dma->fetch_tag = (uint8_t) device_issue(&dma->device, DS_FETCH, dma->source, 0, width);
+            if (!dma->fetch_tag) {return;}
+            break;
+    }
+    if (!(dma->mode & DMA_FIXED_SOURCE)) {dma->source += width;}
+    if (!(dma->mode & DMA_FIXED_DESTINATION)) {dma->destination += width;}
+    dma->length -= width;
+}
+
+static void dma_store_staged(DMA_t* dma) {
+    if (!dma->staged || dma->store_tag) {return;}
+    dma->store_tag = (uint8_t) device_issue(&dma->device, DS_STORE, dma->staged_destination, dma->staged_data, dma->staged_width);
+    if (dma->store_tag) {
+        dma->staged = 0;
+        dma->bytes += dma->staged_width;
+    }
+}
+
+// one fetch and one store in flight, the store of a block always goes out before the next one is read
+static void dma_transfer(DMA_t* dma) {
+    Device_t* device = &dma->device;
+    if (dma->store_tag && device->transaction[dma->store_tag - 1].processed) {
+        device_release(device, dma->store_tag);
+        dma->store_tag = 0;
+    }
+    if (dma->fetch_tag && device->transaction[dma->fetch_tag - 1].processed) {
+        dma->staged_data = device->transaction[dma->fetch_tag - 1].data;
+        dma->staged = 1;
+        device_release(device, dma->fetch_tag);
+        dma->fetch_tag = 0;
+    }
+    dma_store_staged(dma);
+    if (!dma->staged && !dma->fetch_tag && dma->length) {
+        dma_next_block(dma);
+        dma_store_staged(dma);
+    }
+    if (!dma->length && !dma->staged && !dma->fetch_tag && !dma->store_tag) {
+        dma->interrupt_pending = (dma->mode & DMA_INTERRUPT) != 0;
+        dma->mode = 0;
+        dma->transfers ++;
+    }
+}
+
+void dma_clock(DMA_t* dma) {
+    dma_serve_register(dma);
+    if (dma->mode) {
+        dma_transfer(dma);
+    }
+    if (dma->interrupt_pending && dma->device.device_state == DS_IDLE) {
+        // to the core that started the transfer
+        dma->device.device_state = DS_INTERRUPT;
+        dma->device.address = INT_DMA;
+        dma->device.data = 0;
+        dma->device.target_slot = dma->interrupt_slot;
+        dma->interrupt_pending = 0;
+        device_post(&dma->device);
+    }
+    dma->clock ++;
+}
@@ -5,6 +5,7 @@
 #include "globals/memory_layout.h"
 
 #include "modules/device.h"
+#include "modules/bus.h"
 #include "modules/filesystem.h"
 
 const uint16_t MMIO_MODE_REGISTER_ADDRESS = SEGMENT_MMIO + 6;       // sets the general operation mode (r/w)
@@ -12,9 +13,19 @@ const uint16_t MMIO_MODIFIER_REGISTER_ADDRESS = SEGMENT_MMIO + 7;   // sets modi
 const uint16_t MMIO_INPUT_REGISTER_ADDRESS = SEGMENT_MMIO + 8;      // accepts user input, use depends on operation mode (w)
 const uint16_t MMIO_OUTPUT_REGISTER_ADDRESS = SEGMENT_MMIO + 9;     // returns misc. information, depends on operaion mode (r)
 
+static void filesystem_device_clock(void* filesystem) {
+    filesystem_clock((FileSystem_t*) filesystem);
+}
+
+static const DeviceOps_t filesystem_device_ops = {
+    .clock = filesystem_device_clock, 
+    .reply = bus_return_reply, 
+};
+
 FileSystem_t* filesystem_create(void) {
     FileSystem_t* filesystem = malloc(sizeof(FileSystem_t));
     filesystem->device = device_create(DT_FILESYSTEM);
+    device_register_ops(&filesystem->device, &filesystem_device_ops, filesystem, 1);
     device_add_listening_region(
         &filesystem->device, 
         listening_region_create(MMIO_MODE_REGISTER_ADDRESS, MMIO_MODE_REGISTER_ADDRESS, LR_READ | LR_WRITE)
@@ -128,9 +139,11 @@ void filesystem_clock(FileSystem_t* filesystem) {
         }
 
         filesystem->device.processed = 1;
+        device_post(&filesystem->device);
     
     } else if (filesystem->device.address == MMIO_MODIFIER_REGISTER_ADDRESS) {
         filesystem->device.processed = 1;
+        device_post(&filesystem->device);
     
     } else if (filesystem->device.address == MMIO_INPUT_REGISTER_ADDRESS) {
         switch (filesystem->mode) {
@@ -157,11 +170,13 @@ void filesystem_clock(FileSystem_t* filesystem) {
         }
         filesystem->mode = 0;
         filesystem->device.processed = 1;
+        device_post(&filesystem->device);
         //log_msg(LP_DEBUG, "Filesystem %lld: Update mode after successful operation to %d", filesystem->clock, filesystem->mode);
     
     } else if (filesystem->device.address == MMIO_OUTPUT_REGISTER_ADDRESS) {
         filesystem->device.data = filesystem->output;
         filesystem->device.processed = 1;
+        device_post(&filesystem->device);
         //log_msg(LP_DEBUG, "Filesystem %lld: fetched output register %d", filesystem->clock, filesystem->mode);
     }
 
@@ -0,0 +1,316 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "utils/Log.h"
+
+#include "globals/memory_layout.h"
+
+#include "cpu/cpu.h"
+#include "cpu/cpu_instructions.h"
+#include "cpu/cpu_addressing_modes.h"
+
+#include "modules/ram.h"
+#include "modules/system.h"
+#include "modules/lockstep.h"
+
+#define LOCKSTEP_SR_AO 0x0080           // AO
+#define LOCKSTEP_SR_INTERNAL 0x0600     // NC, MNI
+
+typedef struct LockstepInstruction_t {
+    int instruction;
+    int destination;                    // index into regs
+    int source;                         // index into regs, -1 for the immediate
+    uint16_t immediate;
+    uint8_t length;
+} LockstepInstruction_t;
+
+
+Lockstep_t* lockstep_create(int count) {
+    if (count <= 0) {
+        log_msg(LP_ERROR, "Lockstep: At least one lane is needed [%s:%d]", __FILE__, __LINE__);
+        return NULL;
+    }
+    Lockstep_t* lockstep = calloc(1, sizeof(Lockstep_t));
+    if (!lockstep) {
+        log_msg(LP_ERROR, "Lockstep: Memory allocation failure [%s:%d]", __FILE__, __LINE__);
+        return NULL;
+    }
+    lockstep->count = count;
+    lockstep->system = calloc(count, sizeof(System_t*));
+    for (int r = 0; r < LOCKSTEP_REGISTERS; r++) {
+        lockstep->regs[r] = calloc(count, sizeof(uint16_t));
+    }
+    lockstep->pc = calloc(count, sizeof(uint16_t));
+    lockstep->sr = calloc(count, sizeof(uint16_t));
+    lockstep->immediate = calloc(count, sizeof(uint16_t));
+    lockstep->member = calloc(count, sizeof(uint8_t));
+    lockstep->running = calloc(count, sizeof(uint8_t));
+    int failed = !lockstep->system || !lockstep->pc || !lockstep->sr || !lockstep->immediate || !lockstep->member || !lockstep->running;
+    for (int r = 0; r < LOCKSTEP_REGISTERS; r++) {
+        failed |= !lockstep->regs[r];
+    }
+    if (failed) {
+        log_msg(LP_ERROR, "Lockstep: Memory allocation failure [%s:%d]", __FILE__, __LINE__);
+        lockstep_delete(&lockstep);
+        return NULL;
+    }
+
+    for (int lane = 0; lane < count; lane++) {
+        lockstep->system[lane] = system_create(0, 0, 0, 0.0, CTM_MULTI_CYCLE, 1);
+        if (!lockstep->system[lane]) {
+            log_msg(LP_ERROR, "Lockstep: System of lane %d could not be created [%s:%d]", lane, __FILE__, __LINE__);
+            lockstep_delete(&lockstep);
+            return NULL;
+        }
+    }
+    return lockstep;
+}
+
+void lockstep_delete(Lockstep_t** lockstep) {
+    if (!lockstep) {return;}
+    if (!*lockstep) {return;}
+    if ((*lockstep)->system) {
+        for (int lane = 0; lane < (*lockstep)->count; lane++) {
+            system_delete(&(*lockstep)->system[lane]);
+        }
+    }
+    free((*lockstep)->system);
+    for (int r = 0; r < LOCKSTEP_REGISTERS; r++) {
+        free((*lockstep)->regs[r]);
+    }
+    free((*lockstep)->pc);
+    free((*lockstep)->sr);
+    free((*lockstep)->immediate);
+    free((*lockstep)->member);
+    free((*lockstep)->running);
+    free(*lockstep);
+    *lockstep = NULL;
+}
+
+void lockstep_load(Lockstep_t* lockstep, const uint8_t* binary, long size) {
+    for (int lane = 0; lane < lockstep->count; lane++) {
+        for (long i = 0; i < size; i++) {
+            ram_write(lockstep->system[lane]->ram, i, binary[i]);
+        }
+    }
+}
+
+
+// copies the registers of a lane from its cpu into the arrays
+static void lockstep_gather(Lockstep_t* lockstep, int lane) {
+    CPU_t* cpu = lockstep->system[lane]->cpu;
+    lockstep->regs[0][lane] = cpu->regs.r0;
+    lockstep->regs[1][lane] = cpu->regs.r1;
+    lockstep->regs[2][lane] = cpu->regs.r2;
+    lockstep->regs[3][lane] = cpu->regs.r3;
+    lockstep->regs[4][lane] = cpu->regs.sp;
+    lockstep->pc[lane] = cpu->regs.pc;
+    lockstep->sr[lane] = cpu->regs.sr.value;
+}
+
+// and back
+static void lockstep_scatter(Lockstep_t* lockstep, int lane) {
+    CPU_t* cpu = lockstep->system[lane]->cpu;
+    cpu->regs.r0 = lockstep->regs[0][lane];
+    cpu->regs.r1 = lockstep->regs[1][lane];
+    cpu->regs.r2 = lockstep->regs[2][lane];
+    cpu->regs.r3 = lockstep->regs[3][lane];
+    cpu->regs.sp = lockstep->regs[4][lane];
+    cpu->regs.pc = lockstep->pc[lane];
+    cpu->regs.sr.value = lockstep->sr[lane];
+}
+
+static int lockstep_lane_running(Lockstep_t* lockstep, int lane, uint64_t instruction_end) {
+    CPU_t* cpu = lockstep->system[lane]->cpu;
+    // without a ticker nothing wakes a sleeping cpu up
+    return cpu->state != CS_HALT && cpu->state != CS_EXCEPTION && cpu->state != CS_SLEEP && cpu->instruction < instruction_end;
+}
+
+// steps one lane through the cpu
+static void lockstep_step_scalar(Lockstep_t* lockstep, int lane, uint64_t instruction_end) {
+    lockstep_scatter(lockstep, lane);
+    system_run_fast(lockstep->system[lane], 1, UINT64_MAX);
+    lockstep_gather(lockstep, lane);
+    lockstep->running[lane] = (uint8_t) lockstep_lane_running(lockstep, lane, instruction_end);
+    if (lockstep->system[lane]->cpu->state == CS_SLEEP) {
+        log_msg(LP_ERROR, "Lockstep: Lane %d went to sleep at pc %.4x, lanes have no ticker to wake it [%s:%d]", lane, lockstep->system[lane]->cpu->regs.pc, __FILE__, __LINE__);
+    }
+    lockstep->scalar_steps ++;
+}
+
+/*
+Returns 1 if the instruction at pc is one the lanes can apply in one pass, see lockstep.h
+*/
+static int lockstep_decode(RAM_t* ram, uint16_t pc, LockstepInstruction_t* decoded) {
+    if (pc + 4 > SEGMENT_CODE_END) {return 0;}
+    uint8_t* data = &ram->data[pc];
+    int instruction = data[0] & 0x7f;
+    switch (instruction) {
+        case MOV: case ADD: case SUB: case AND: case OR: case XOR: case INC: case DEC: case NOT:
+            break;
+        default:
+            return 0;
+    }
+    int admr = data[1] & 0x07;
+    int admx = data[1] >> 3;
+    if (admr < ADMR_R0 || admr > ADMR_SP) {return 0;}
+    decoded->instruction = instruction;
+    decoded->destination = admr - ADMR_R0;
+    decoded->source = -1;
+    decoded->immediate = 0;
+    decoded->length = 2;
+    if (instruction_encoding[instruction].argument_count == 2) {
+        if (admx == ADMX_IMM16) {
+            decoded->immediate = (uint16_t) (data[2] | (data[3] << 8));
+            decoded->length = 4;
+        } else if (admx >= ADMX_R0 && admx <= ADMX_SP) {
+            decoded->source = admx - ADMX_R0;
+        } else {
+            return 0;
+        }
+    } else if (admx != ADMX_NONE) {
+        return 0;
+    }
+    return 1;
+}
+
+#define LOCKSTEP_PASS(RESULT, OVERFLOW) \
+    for (int i = 0; i < count; i++) { \
+        uint32_t a = destination[i]; \
+        uint32_t b = source[i]; \
+        (void) a; (void) b; \
+        uint16_t result = (uint16_t) (RESULT); \
+        uint16_t status = (uint16_t) ((sr[i] & ~(LOCKSTEP_SR_AO | LOCKSTEP_SR_INTERNAL)) | internal | ((OVERFLOW) ? LOCKSTEP_SR_AO : 0)); \
+        destination[i] = member[i] ? result : destination[i]; \
+        sr[i] = member[i] ? status : sr[i]; \
+    }
+
+// applies the instruction to all member lanes, internal are the NC and MNI bits the leading lane ended up with
+static void lockstep_step_vector(Lockstep_t* lockstep, const LockstepInstruction_t* decoded, uint16_t internal) {
+    int count = lockstep->count;
+    uint16_t* destination = lockstep->regs[decoded->destination];
+    const uint16_t* source = lockstep->immediate;
+    if (decoded->source >= 0) {
+        source = lockstep->regs[decoded->source];
+    } else {
+        for (int i = 0; i < count; i++) {
+            lockstep->immediate[i] = decoded->immediate;
+        }
+    }
+    uint16_t* sr = lockstep->sr;
+    const uint8_t* member = lockstep->member;
+
+    switch (decoded->instruction) {
+        case MOV: LOCKSTEP_PASS(b, sr[i] & LOCKSTEP_SR_AO) break;
+        case ADD: LOCKSTEP_PASS(a + b, (a + b) > 0xffff) break;
+        case SUB: LOCKSTEP_PASS(a - b, a < b) break;
+        case AND: LOCKSTEP_PASS(a & b, sr[i] & LOCKSTEP_SR_AO) break;
+        case OR:  LOCKSTEP_PASS(a | b, sr[i] & LOCKSTEP_SR_AO) break;
+        case XOR: LOCKSTEP_PASS(a ^ b, sr[i] & LOCKSTEP_SR_AO) break;
+        case INC: LOCKSTEP_PASS(a + 1, a == 0xffff) break;
+        case DEC: LOCKSTEP_PASS(a - 1, a == 0) break;
+        case NOT: LOCKSTEP_PASS(~a, sr[i] & LOCKSTEP_SR_AO) break;
+        default: break;
+    }
+    for (int i = 0; i < count; i++) {
+        lockstep->pc[i] = member[i] ? (uint16_t) (lockstep->pc[i] + decoded->length) : lockstep->pc[i];
+    }
+}
+
+uint64_t lockstep_run(Lockstep_t* lockstep, uint64_t max_instructions) {
+    if (!lockstep) {
+        log_msg(LP_ERROR, "Lockstep: NULL pointer [%s:%d]", __FILE__, __LINE__);
+        return 0;
+    }
+    int count = lockstep->count;
+    uint64_t* instruction_end = malloc(count * sizeof(uint64_t));
+    if (!instruction_end) {
+        log_msg(LP_ERROR, "Lockstep: Memory allocation failure [%s:%d]", __FILE__, __LINE__);
+        return 0;
+    }
+    uint64_t instructions = 0;
+    for (int lane = 0; lane < count; lane++) {
+        CPU_t* cpu = lockstep->system[lane]->cpu;
+        instruction_end[lane] = cpu->instruction + max_instructions;
+        instructions -= cpu->instruction;
+        lockstep_gather(lockstep, lane);
+        lockstep->running[lane] = (uint8_t) lockstep_lane_running(lockstep, lane, instruction_end[lane]);
+    }
+
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    while (1) {
+        // the lanes furthest behind go first, so lanes that took a branch wait for the others at the next common pc
+        int leader = -1;
+        for (int lane = 0; lane < count; lane++) {
+            if (lockstep->running[lane] && (leader < 0 || lockstep->pc[lane] < lockstep->pc[leader])) {
+                leader = lane;
+            }
+        }
+        if (leader < 0) {break;}
+        uint16_t pc = lockstep->pc[leader];
+        RAM_t* ram = lockstep->system[leader]->ram;
+
+        LockstepInstruction_t decoded;
+        int vector = lockstep_decode(ram, pc, &decoded);
+        CPU_t* cpu = lockstep->system[leader]->cpu;
+        uint64_t clock = cpu->clock;
+        uint64_t instruction = cpu->instruction;
+        lockstep_step_scalar(lockstep, leader, instruction_end[leader]);
+        lockstep->steps ++;
+        // it has to have finished the instruction like any other register instruction would
+        vector = vector && cpu->state == CS_FETCH_INSTRUCTION && cpu->regs.pc == (uint16_t) (pc + decoded.length);
+
+        int members = 0;
+        for (int lane = 0; lane < count; lane++) {
+            lockstep->member[lane] = lockstep->running[lane] && lane != leader && lockstep->pc[lane] == pc &&
+                (!vector || memcmp(&lockstep->system[lane]->ram->data[pc], &ram->data[pc], decoded.length) == 0);
+            members += lockstep->member[lane];
+        }
+        if (!members) {continue;}
+
+        if (!vector) {
+            for (int lane = 0; lane < count; lane++) {
+                if (lockstep->member[lane]) {
+                    lockstep_step_scalar(lockstep, lane, instruction_end[lane]);
+                }
+            }
+            continue;
+        }
+        lockstep_step_vector(lockstep, &decoded, cpu->regs.sr.value & LOCKSTEP_SR_INTERNAL);
+        for (int lane = 0; lane < count; lane++) {
+            if (!lockstep->member[lane]) {continue;}
+            CPU_t* lane_cpu = lockstep->system[lane]->cpu;
+            lane_cpu->clock += cpu->clock - clock;
+            lane_cpu->instruction += cpu->instruction - instruction;
+            lane_cpu->last_instruction = cpu->last_instruction;
+            lockstep->running[lane] = lane_cpu->instruction < instruction_end[lane];
+        }
+        lockstep->vector_steps ++;
+        lockstep->vector_lanes += members;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    lockstep->host_seconds += (double) (end.tv_sec - start.tv_sec) + (double) (end.tv_nsec - start.tv_nsec) / 1e9;
+
+    for (int lane = 0; lane < count; lane++) {
+        lockstep_scatter(lockstep, lane);
+        instructions += lockstep->system[lane]->cpu->instruction;
+    }
+    free(instruction_end);
+    return instructions;
+}
+
+void lockstep_print(Lockstep_t* lockstep) {
+    uint64_t instructions = 0;
+    for (int lane = 0; lane < lockstep->count; lane++) {
+        instructions += lockstep->system[lane]->cpu->instruction;
+    }
+    uint64_t lane_steps = lockstep->vector_lanes + lockstep->scalar_steps;
+    printf("\n\033[1;33m Lockstep\033[0m\n");
+    printf(" \033[1;32mLanes\033[0m [%d]  \033[1;32mInstructions\033[0m [%lu]  \033[1;32mHost\033[0m [%.3f s]  \033[1;32mRate\033[0m [%.1f M instructions/s]\n",
+        lockstep->count, instructions, lockstep->host_seconds, lockstep->host_seconds > 0.0 ? (double) instructions / lockstep->host_seconds / 1e6 : 0.0);
+    printf(" \033[1;32mSteps\033[0m [%lu]  \033[1;32mVector\033[0m [%lu]  \033[1;32mLane Steps\033[0m [%lu]  \033[1;32mIn Vector Passes\033[0m [%2.2f%%]\n",
+        lockstep->steps, lockstep->vector_steps, lane_steps, lane_steps ? (double) lockstep->vector_lanes / (double) lane_steps * 100.0 : 0.0);
+}
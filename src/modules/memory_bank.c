@@ -5,6 +5,7 @@
 #include "globals/memory_layout.h"
 
 #include "modules/device.h"
+#include "modules/bus.h"
 #include "modules/ram.h"
 #include "modules/memory_bank.h"
 
@@ -13,9 +14,19 @@ const uint16_t MMIO_REGISTER_ADDRESS = SEGMENT_MMIO + 4;
 const uint16_t MMIO_BASE_ADDRESS = SEGMENT_MEMORY_BANK;
 const uint16_t MMIO_BANK_WIDTH = 0x2000;
 
+static void memory_bank_device_clock(void* memory_bank) {
+    memory_bank_clock((MemoryBank_t*) memory_bank);
+}
+
+static const DeviceOps_t memory_bank_device_ops = {
+    .clock = memory_bank_device_clock, 
+    .reply = bus_return_reply, 
+};
+
 MemoryBank_t* memory_bank_create(void) {
     MemoryBank_t* memory_bank = malloc(sizeof(MemoryBank_t));
     memory_bank->device = device_create(DT_MEMORY_BANK);
+    device_register_ops(&memory_bank->device, &memory_bank_device_ops, memory_bank, 1);
     device_add_listening_region(
         &memory_bank->device, 
         listening_region_create(MMIO_REGISTER_ADDRESS, MMIO_REGISTER_ADDRESS, LR_WRITE)
@@ -61,6 +72,7 @@ void memory_bank_clock(MemoryBank_t* memory_bank) {
         }
         memory_bank->device.data = data;
         memory_bank->device.processed = 1;
+        device_post(&memory_bank->device);
         //log_msg(LP_INFO, "RAM %d: fetch [%.8x] = %.8x", ram->clock, ram->device.address, ram->device.data);
     }
     if (memory_bank->device.device_state == DS_STORE) {
@@ -72,6 +84,7 @@ void memory_bank_clock(MemoryBank_t* memory_bank) {
             memory_bank->bank_index = data & 0x07;  // mod 8
             memory_bank->clock ++;
             memory_bank->device.processed = 1;
+            device_post(&memory_bank->device);
             //log_msg(LP_INFO, "MEMORY BANK %d: setbank_index to %d (raw %.4x)", memory_bank->clock, memory_bank->bank_index, data);
             return;
         }
@@ -80,8 +93,11 @@ void memory_bank_clock(MemoryBank_t* memory_bank) {
             address, 
             virtual_address
         );*/
-        ram_write(memory_bank->ram, virtual_address, data);
+        for (uint8_t i = 0; i < memory_bank->device.width; i++) {
+            ram_write(memory_bank->ram, virtual_address + i, (uint8_t) (memory_bank->device.data >> (8 * i)));
+        }
         memory_bank->device.processed = 1;
+        device_post(&memory_bank->device);
         //log_msg(LP_INFO, "RAM %d: written %.8x at [%.8x]", ram->clock, ram->device.data, ram->device.address);
     }
 
@@ -2,13 +2,30 @@
 
 #include "globals/memory_layout.h"
 
+#include "utils/Log.h"
+
 #include "modules/device.h"
+#include "modules/bus.h"
 #include "modules/ram.h"
 
 
+static void ram_device_clock(void* ram) {
+    ram_clock((RAM_t*) ram);
+}
+
+static const DeviceOps_t ram_device_ops = {
+    .clock = ram_device_clock, 
+    .reply = bus_return_reply, 
+};
+
 RAM_t* ram_create(uint32_t capacity) {
-    RAM_t* ram = malloc(sizeof(RAM_t));
+    RAM_t* ram = calloc(1, sizeof(RAM_t));
+    if (!ram) {
+        log_msg(LP_ERROR, "RAM: Memory allocation failure [%s:%d]", __FILE__, __LINE__);
+        return NULL;
+    }
     ram->device = device_create(DT_RAM);
+    device_register_ops(&ram->device, &ram_device_ops, ram, 1);
     device_add_listening_region(
         &ram->device, 
         listening_region_create(SEGMENT_CODE, SEGMENT_CODE_END, LR_READ | LR_WRITE)
@@ -17,6 +34,13 @@ RAM_t* ram_create(uint32_t capacity) {
     ram->capacity = capacity;
     //log_msg(LP_INFO, "setting ram cap to %.4x and is now %.4x\n", capacity, ram->capacity);
     ram->data = malloc(sizeof(uint8_t) * capacity);
+    ram->generation = calloc((capacity >> RAM_GENERATION_SHIFT) + 1, sizeof(uint32_t));
+    if (!ram->data || !ram->generation) {
+        log_msg(LP_ERROR, "RAM: Memory allocation failure [%s:%d]", __FILE__, __LINE__);
+        free(ram->device.listening_region);
+        ram_delete(&ram);
+        return NULL;
+    }
     for (uint32_t i = 0; i < capacity; i++) {
         ram->data[i] = 0x00; //rand8();
     }
@@ -41,6 +65,7 @@ RAM_t* ram_create(uint32_t capacity) {
 void ram_delete(RAM_t** ram) {
     if (!ram) {return;}
     free((*ram)->data);
+    free((*ram)->generation);
     #ifdef __RAM_DEBUG
         free((*ram)->debug.reads);
         free((*ram)->debug.writes);
@@ -55,13 +80,17 @@ uint8_t ram_read(RAM_t* ram, uint16_t address) {
         //log_msg(LP_CRITICAL, "RAM %d: capacity is zero!", ram->clock);
         return 0x00;
     }
-    ram->reads += 1ULL;
     uint16_t hw_address = address % ram->capacity;
 
     #ifdef __RAM_DEBUG
         ram->debug.reads[hw_address] ++;
     #endif
 
+    if (ram->shared) {
+        __atomic_fetch_add(&ram->reads, 1ULL, __ATOMIC_RELAXED);
+        return __atomic_load_n(&ram->data[hw_address], __ATOMIC_RELAXED);
+    }
+    ram->reads += 1ULL;
     return ram->data[hw_address];
 }
 
@@ -70,13 +99,20 @@ void ram_write(RAM_t* ram, uint16_t address, uint8_t data) {
         //log_msg(LP_CRITICAL, "RAM %d: capacity is zero!", ram->clock);
         return;
     }
-    ram->writes += 1ULL;
     uint16_t hw_address = address % ram->capacity;
 
     #ifdef __RAM_DEBUG
         ram->debug.writes[hw_address] ++;
     #endif
+    if (ram->shared) {
+        __atomic_fetch_add(&ram->writes, 1ULL, __ATOMIC_RELAXED);
+        __atomic_store_n(&ram->data[hw_address], data, __ATOMIC_RELAXED);
+        __atomic_fetch_add(&ram->generation[hw_address >> RAM_GENERATION_SHIFT], 1U, __ATOMIC_RELAXED);
+        return;
+    }
+    ram->writes += 1ULL;
     ram->data[hw_address] = data;
+    ram->generation[hw_address >> RAM_GENERATION_SHIFT] ++;
 }
 
 void ram_clock(RAM_t* ram) {
@@ -97,14 +133,17 @@ void ram_clock(RAM_t* ram) {
         }
         ram->device.data = data;
         ram->device.processed = 1;
+        device_post(&ram->device);
         //log_msg(LP_INFO, "RAM %d: fetch [%.8x] = %.8x", ram->clock, ram->device.address, ram->device.data);
     }
     if (ram->device.device_state == DS_STORE) {
         //log_msg(LP_INFO, "RAM %d: recieved store request", ram->clock);
         uint16_t address = (uint16_t) ram->device.address;
-        uint8_t data = ram->device.data;
-        ram_write(ram, address, data);
+        for (uint8_t i = 0; i < ram->device.width; i++) {
+            ram_write(ram, address + i, (uint8_t) (ram->device.data >> (8 * i)));
+        }
         ram->device.processed = 1;
+        device_post(&ram->device);
         //log_msg(LP_INFO, "RAM %d: written %.8x at [%.8x]", ram->clock, ram->device.data, ram->device.address);
     }
 
@@ -1,5 +1,9 @@
 #include <stdlib.h>
 #include <stdio.h>
+#include <math.h>
+#include <time.h>
+#include <sched.h>      // for sched_yield
+#include <pthread.h>
 
 #include "utils/Log.h"
 
@@ -12,6 +16,7 @@
 #include "modules/system.h"
 #include "modules/terminal.h"
 #include "modules/filesystem.h"
+#include "modules/dma.h"
 
 int VERBOSE = 0;
 
@@ -19,10 +24,59 @@ void hook_action_halt(void* system) {
     ((System_t*) system)->cpu->state = CS_HALT;
 }
 
+// the round-robin bus attends one device per bus clock, so it is clocked between the devices to keep requests moving
+static void system_build_clock_order(System_t* system) {
+    int* order = system->clock_order;
+    int size = 0;
+    for (int c = 0; c < system->core_count; c++) {
+        order[size++] = system->core[c]->device.slot;
+    }
+    if (system->bus->timing_model == BTM_EVENT) {
+        // one bus clock forwards what the cpus posted, one after the devices delivers their replies
+        order[size++] = SYSTEM_CLOCK_BUS;
+        order[size++] = system->ram->device.slot;
+        order[size++] = system->terminal->device.slot;
+        order[size++] = system->filesystem->device.slot;
+        if (system->ticker) {
+            order[size++] = system->ticker->device.slot;
+        }
+        order[size++] = system->memory_bank->device.slot;
+        if (system->dma) {
+            order[size++] = system->dma->device.slot;
+        }
+        order[size++] = SYSTEM_CLOCK_BUS;
+        system->clock_order_size = size;
+        return;
+    }
+    order[size++] = SYSTEM_CLOCK_BUS;
+    order[size++] = system->ram->device.slot;
+    order[size++] = SYSTEM_CLOCK_BUS;
+    order[size++] = system->terminal->device.slot;
+    order[size++] = system->filesystem->device.slot;
+    if (system->ticker) {
+        order[size++] = SYSTEM_CLOCK_BUS;
+        order[size++] = system->ticker->device.slot;
+    }
+    order[size++] = SYSTEM_CLOCK_BUS;
+    order[size++] = system->memory_bank->device.slot;
+    order[size++] = SYSTEM_CLOCK_BUS;
+    if (system->dma) {
+        order[size++] = system->dma->device.slot;
+        order[size++] = SYSTEM_CLOCK_BUS_OUTSIDE;
+    }
+    system->clock_order_size = size;
+}
+
 System_t* system_create(
     int cache_active, uint16_t cache_capacity, 
-    int ticker_active, float ticker_frequency
+    int ticker_active, float ticker_frequency, 
+    CpuTimingModel_t timing_model, 
+    int core_count
 ) {
+    if (core_count < 1 || core_count > SYSTEM_MAX_CORES) {
+        log_msg(LP_ERROR, "System: Core count %d is not in [1, %d] [%s:%d]", core_count, SYSTEM_MAX_CORES, __FILE__, __LINE__);
+        return NULL;
+    }
     System_t* system = calloc(1, sizeof(System_t));
 
     system->bus = bus_create();
@@ -32,16 +86,41 @@ System_t* system_create(
     system->memory_bank = memory_bank_create();
     system->filesystem = filesystem_create();
 
-    if (cache_active) {
-        Cache_t* cache = cache_create(cache_capacity);
-        if (!cache) {
-            log_msg(LP_ERROR, "System: Cache could not be created [%s:%d]", __FILE__, __LINE__);
-            return NULL;
+    system->core[0] = system->cpu;
+    for (int c = 1; c < core_count; c++) {
+        system->core[c] = cpu_create();
+        // cpu_create clears the device id, every further core needs one of its own
+        system->core[c]->device.device_id = device_create(DT_CPU).device_id;
+        system->core[c]->core_id = (uint8_t) c;
+        system->core[c]->regs.sp -= (uint16_t) (c * SYSTEM_CORE_STACK_SIZE);
+    }
+    system->core_count = core_count;
+    system->interrupt_core = 0;
+    atomic_init(&system->bus_owner, -1);
+
+    for (int c = 0; c < core_count; c++) {
+        if (cache_active) {
+            Cache_t* cache = cache_create(cache_capacity);
+            if (!cache) {
+                log_msg(LP_ERROR, "System: Cache could not be created [%s:%d]", __FILE__, __LINE__);
+                return NULL;
+            }
+            cpu_mount_cache(system->core[c], cache);
+        }
+
+        if (timing_model == CTM_PIPELINED) {
+            CpuPipeline_t* pipeline = cpu_pipeline_create(system->ram, CPU_PIPELINE_DEFAULT_CONFIG);
+            if (!pipeline) {
+                log_msg(LP_ERROR, "System: Pipeline could not be created [%s:%d]", __FILE__, __LINE__);
+                return NULL;
+            }
+            cpu_mount_pipeline(system->core[c], pipeline);
         }
-        cpu_mount_cache(system->cpu, cache);
     }
 
-    bus_add_device(system->bus, &system->cpu->device);
+    for (int c = 0; c < core_count; c++) {
+        bus_add_device(system->bus, &system->core[c]->device);
+    }
     bus_add_device(system->bus, &system->ram->device);
     bus_add_device(system->bus, &system->terminal->device);
     bus_add_device(system->bus, &system->memory_bank->device);
@@ -52,22 +131,10 @@ System_t* system_create(
         bus_add_device(system->bus, &system->ticker->device);
     }
 
-    system->clock_order_size = 0;
-    system->clock_order = malloc(sizeof(SystemClockDevice_t) * 16);
-    system->clock_order[system->clock_order_size++] = SCD_CPU;
-    system->clock_order[system->clock_order_size++] = SCD_BUS;
-    system->clock_order[system->clock_order_size++] = SCD_RAM;
-    system->clock_order[system->clock_order_size++] = SCD_BUS;
-    system->clock_order[system->clock_order_size++] = SCD_TERMINAL;
-    system->clock_order[system->clock_order_size++] = SCD_FILESYSTEM;
-    if (ticker_active) {
-        system->clock_order[system->clock_order_size++] = SCD_BUS;
-        system->clock_order[system->clock_order_size++] = SCD_TICKER;
-    }
-    system->clock_order[system->clock_order_size++] = SCD_BUS;
-    system->clock_order[system->clock_order_size++] = SCD_MEMORY_BANK;
-    system->clock_order[system->clock_order_size++] = SCD_BUS;
+    system->clock_order = malloc(sizeof(int) * SYSTEM_CLOCK_ORDER_CAPACITY);
+    system_build_clock_order(system);
 
+    system->frequency = SYSTEM_DEFAULT_FREQUENCY;
     system->hook = NULL;
     system->hook_count = 0;
 
@@ -77,47 +144,463 @@ System_t* system_create(
 void system_delete(System_t** system) {
     if (!system) {return;}
     ram_delete(&(*system)->ram);
+    for (int c = 1; c < (*system)->core_count; c++) {
+        cpu_delete(&(*system)->core[c]);
+    }
     cpu_delete(&(*system)->cpu);
     bus_delete(&(*system)->bus);
     ticker_delete(&(*system)->ticker);
     terminal_delete(&(*system)->terminal);
+    dma_delete(&(*system)->dma);
+    free((*system)->clock_order);
+    free((*system)->breakpoint);
+    free((*system)->cycle_window);
     *system = NULL;
 }
 
 
+// the core a device interrupts, the interrupt core if it has no target
+static CPU_t* system_interrupt_target(System_t* system, Device_t* device) {
+    for (int c = 0; c < system->core_count; c++) {
+        if (system->core[c]->device.slot == device->target_slot) {return system->core[c];}
+    }
+    return system->core[system->interrupt_core];
+}
+
+// stamps an interrupt with the clock of the core it goes to as the device raises it, the latency is taken from there
+static inline void system_clock_device(System_t* system, Device_t* device) {
+    DEVICE_STATE_t state = device->device_state;
+    device->ops->clock(device->owner);
+    if (device->device_state == DS_INTERRUPT && state != DS_INTERRUPT) {
+        device->asserted = system_interrupt_target(system, device)->clock;
+    }
+}
+
 void system_clock(System_t *system) {
     if (!system) {
         log_msg(LP_ERROR, "System: NULL pointer [%s:%d]", __FILE__, __LINE__);
         return;
     }
+    uint64_t clock = system->clock++;
     for (int i = 0; i < system->clock_order_size; i++) {
-        switch (system->clock_order[i]) {
-            case SCD_CPU:
-                cpu_clock(system->cpu);
-                break;
-            case SCD_RAM:
-                ram_clock(system->ram);
-                break;
-            case SCD_BUS:
-                bus_clock(system->bus);
-                break;
-            case SCD_TICKER:
-                ticker_clock(system->ticker);
-                break;
-            case SCD_TERMINAL:
-                terminal_clock(system->terminal);
+        int slot = system->clock_order[i];
+        if (slot == SYSTEM_CLOCK_BUS) {
+            bus_clock(system->bus);
+            continue;
+        }
+        if (slot == SYSTEM_CLOCK_BUS_OUTSIDE) {
+            bus_attend_outside_rotation(system->bus);
+            continue;
+        }
+        Device_t* device = system->bus->device[slot];
+        if (device->ops && device_clock_due(device, clock)) {
+            system_clock_device(system, device);
+        }
+    }
+}
+
+void system_set_bus_timing(System_t* system, BusTimingModel_t timing_model) {
+    if (!system) {
+        log_msg(LP_ERROR, "System: NULL pointer [%s:%d]", __FILE__, __LINE__);
+        return;
+    }
+    system->bus->timing_model = timing_model;
+    system_build_clock_order(system);
+}
+
+void system_attach_dma(System_t* system) {
+    if (!system) {
+        log_msg(LP_ERROR, "System: NULL pointer [%s:%d]", __FILE__, __LINE__);
+        return;
+    }
+    if (system->dma) {return;}
+    system->dma = dma_create(system->memory_bank);
+    if (!system->dma) {
+        log_msg(LP_ERROR, "System: DMA could not be created [%s:%d]", __FILE__, __LINE__);
+        return;
+    }
+    bus_add_device_outside_rotation(system->bus, &system->dma->device);
+    system_build_clock_order(system);
+}
+
+// 1 while the DMA moves data, the cpus have to go through the bus next to it
+static inline int system_dma_busy(System_t* system) {
+    return system->dma && dma_busy(system->dma);
+}
+
+void system_set_interrupt_target(System_t* system, int core) {
+    if (!system) {
+        log_msg(LP_ERROR, "System: NULL pointer [%s:%d]", __FILE__, __LINE__);
+        return;
+    }
+    if (core < 0 || core >= system->core_count) {
+        log_msg(LP_ERROR, "System: Core %d does not exist [%s:%d]", core, __FILE__, __LINE__);
+        return;
+    }
+    system->interrupt_core = core;
+    if (system->ticker) {
+        system->ticker->device.device_target_id = system->core[core]->device.device_id;
+        system->ticker->device.target_slot = system->core[core]->device.slot;
+    }
+}
+
+
+int system_cores_running(System_t* system) {
+    int running = 0;
+    for (int c = 0; c < system->core_count; c++) {
+        running += system->core[c]->state != CS_HALT && system->core[c]->state != CS_EXCEPTION;
+    }
+    return running;
+}
+
+
+// the bus is not clocked between whole instructions, so the ticker gets its turn here
+static void system_clock_ticker(System_t* system) {
+    if (!system->ticker) {return;}
+    ticker_clock(system->ticker);
+    if (system->ticker->device.device_state == DS_INTERRUPT) {
+        // same as the bus would do, the cpu is idle on an instruction boundary
+        CPU_t* cpu = system->core[system->interrupt_core];
+        cpu->device.device_state = DS_INTERRUPT;
+        cpu->device.address = system->ticker->device.address;
+        cpu->device.asserted = cpu->clock;
+        cpu->device.coalesced = system->ticker->device.coalesced;
+        system->ticker->device.device_state = DS_IDLE;
+    }
+}
+
+static uint64_t system_idle_loop_skip(System_t* system, uint16_t pc_before, uint64_t instruction_end);
+
+// clock + max_cycles, UINT64_MAX if that does not fit
+static inline uint64_t system_clock_end(uint64_t clock, uint64_t max_cycles) {
+    return max_cycles > UINT64_MAX - clock ? UINT64_MAX : clock + max_cycles;
+}
+
+/*
+1 if cpu sleeps and nothing can wake it up any more: interrupts are masked (they are dropped on arrival), 
+or neither the ticker nor the DMA can raise one for it
+*/
+static int system_sleeps_forever(System_t* system, CPU_t* cpu) {
+    if (cpu->state != CS_SLEEP || cpu->interrupt.pending || cpu->device.device_state == DS_INTERRUPT) {return 0;}
+    if (cpu->regs.sr.MI) {return 1;}
+    int ticker = system->ticker && system->core[system->interrupt_core] == cpu;
+    return !ticker && !system_dma_busy(system);
+}
+
+void system_run_fast(System_t* system, uint64_t max_instructions, uint64_t max_cycles) {
+    if (!system) {
+        log_msg(LP_ERROR, "System: NULL pointer [%s:%d]", __FILE__, __LINE__);
+        return;
+    }
+    CPU_t* cpu = system->cpu;
+    uint64_t instruction_end = cpu->instruction + max_instructions;
+    uint64_t clock_end = system_clock_end(cpu->clock, max_cycles);
+    while (cpu->state != CS_HALT && cpu->state != CS_EXCEPTION && cpu->instruction < instruction_end && cpu->clock < clock_end) {
+        if (system_dma_busy(system)) {
+            system_clock(system);
+            continue;
+        }
+        uint16_t pc = cpu->regs.pc;
+        if (cpu->jit && cpu_jit_run(cpu->jit, cpu)) {
+            // a whole block ran, the ticker gets its turn below
+        } else if (!cpu_step_instruction(cpu, system->ram)) {
+            if (cpu->state == CS_HALT || cpu->state == CS_EXCEPTION) {
                 break;
-            case SCD_MEMORY_BANK:
-                memory_bank_clock(system->memory_bank);
+            }
+            if (system_sleeps_forever(system, cpu)) {
+                log_msg(LP_ERROR, "System: The cpu sleeps at pc %.4x with nothing to wake it up (MI %d) [%s:%d]", cpu->regs.pc, cpu->regs.sr.MI, __FILE__, __LINE__);
                 break;
-            case SCD_FILESYSTEM:
-                filesystem_clock(system->filesystem);
+            }
+            // waiting on a device or sleeping, let the whole system catch up
+            if (cpu->state == CS_SLEEP && system_fast_forward(system, clock_end - cpu->clock)) {
+                continue;
+            }
+            system_clock(system);
+            continue;
+        }
+        system_idle_loop_skip(system, pc, instruction_end);
+        system_clock_ticker(system);
+    }
+    cpu_status_register(cpu);   // leave the status register complete for whoever looks at it next
+}
+
+
+static void system_hook_check(System_t* system);
+
+// what system_clock does to every clock, times cycles, the other devices have nothing to do and are not clocked
+static void system_advance_clocks(System_t* system, uint64_t cycles) {
+    uint64_t bus_clocks = 0;
+    for (int c = 0; c < system->core_count; c++) {
+        system->core[c]->clock += cycles;
+    }
+    for (int i = 0; i < system->clock_order_size; i++) {
+        bus_clocks += system->clock_order[i] == SYSTEM_CLOCK_BUS;
+    }
+    if (system->ticker) {
+        system->ticker->clock += cycles;
+        system->ticker->interrupts += cycles;
+    }
+    system->clock += cycles;
+    system->bus->clock += bus_clocks * cycles;
+    if (system->bus->rotation_count) {
+        system->bus->attended_device_index = (system->bus->attended_device_index + (bus_clocks * cycles) % system->bus->rotation_count) % system->bus->rotation_count;
+    }
+}
+
+// 1 if no request is in flight anywhere on the bus
+static int system_devices_idle(System_t* system) {
+    // devices keep processed set once they served a request, only the cpus still have to pick their replies up
+    for (int c = 0; c < system->core_count; c++) {
+        if (system->core[c]->device.processed || system->core[c]->interrupt.pending) {return 0;}
+    }
+    for (int i = 0; i < system->bus->device_count; i++) {
+        if (system->bus->device[i]->device_state != DS_IDLE) {return 0;}
+    }
+    return !system_dma_busy(system);
+}
+
+// 1 if at least one core sleeps and all others sleep or are done
+static int system_cores_asleep(System_t* system) {
+    int sleeping = 0;
+    for (int c = 0; c < system->core_count; c++) {
+        CpuState_t state = system->core[c]->state;
+        if (state == CS_SLEEP) {
+            sleeping = 1;
+        } else if (state != CS_HALT && state != CS_EXCEPTION) {
+            return 0;
+        }
+    }
+    return sleeping;
+}
+
+// cycles until the ticker fires at system->frequency, at most max_cycles
+static uint64_t system_cycles_to_interrupt(System_t* system, uint64_t max_cycles) {
+    double wait = ticker_time_to_interrupt(system->ticker);
+    if (wait <= 0.0) {return 0;}
+    if (ceil(wait * system->frequency) < (double) max_cycles) {
+        return (uint64_t) ceil(wait * system->frequency);
+    }
+    return max_cycles;
+}
+
+// lets the host catch up with cycles that are skipped instead of emulated
+static void system_wait_cycles(System_t* system, uint64_t cycles) {
+    double seconds = (double) cycles / system->frequency;
+    struct timespec duration = {.tv_sec = (time_t) seconds, .tv_nsec = (long) ((seconds - (double) (time_t) seconds) * 1e9)};
+    nanosleep(&duration, NULL);
+}
+
+uint64_t system_fast_forward(System_t* system, uint64_t max_cycles) {
+    if (!system) {
+        log_msg(LP_ERROR, "System: NULL pointer [%s:%d]", __FILE__, __LINE__);
+        return 0;
+    }
+    if (!system_cores_asleep(system) || !system->ticker || !max_cycles) {return 0;}
+    if (!system_devices_idle(system)) {return 0;}
+
+    uint64_t cycles = system_cycles_to_interrupt(system, max_cycles);
+    if (!cycles) {return 0;}
+
+    system_wait_cycles(system, cycles);
+    system_advance_clocks(system, cycles);
+    return cycles;
+}
+
+
+typedef struct SystemCoreThread_t {
+    System_t* system;
+    int core;
+    uint64_t max_instructions;
+    uint64_t max_cycles;
+} SystemCoreThread_t;
+
+// a spinlock on bus_owner: the bus and every device behind it belong to the core that swapped its index in
+static int system_bus_try_lock(System_t* system, int core) {
+    int expected = -1;
+    if (!atomic_compare_exchange_strong_explicit(&system->bus_owner, &expected, core, memory_order_acquire, memory_order_relaxed)) {
+        return 0;
+    }
+    system->bus->owner = &system->core[core]->device;
+    return 1;
+}
+
+// spins until the bus is free, yielding the host thread between the tries
+static void system_bus_spin_lock(System_t* system, int core) {
+    while (!system_bus_try_lock(system, core)) {
+        sched_yield();
+    }
+}
+
+static void system_bus_unlock(System_t* system) {
+    system->bus->owner = NULL;
+    atomic_store_explicit(&system->bus_owner, -1, memory_order_release);
+}
+
+// system_clock for one core, the ticker is left to system_clock_ticker on the core it interrupts
+static void system_clock_core(System_t* system, CPU_t* cpu) {
+    uint64_t clock = system->clock++;
+    for (int i = 0; i < system->clock_order_size; i++) {
+        int slot = system->clock_order[i];
+        if (slot == SYSTEM_CLOCK_BUS) {
+            bus_clock(system->bus);
+            continue;
+        }
+        if (slot == SYSTEM_CLOCK_BUS_OUTSIDE) {
+            bus_attend_outside_rotation(system->bus);
+            continue;
+        }
+        Device_t* device = system->bus->device[slot];
+        if ((device->device_type == DT_CPU && device != &cpu->device) || device->device_type == DT_CLOCK) {continue;}
+        if (device->ops && device_clock_due(device, clock)) {
+            system_clock_device(system, device);
+        }
+    }
+}
+
+static void* system_core_thread(void* argument) {
+    SystemCoreThread_t* thread = argument;
+    System_t* system = thread->system;
+    CPU_t* cpu = system->core[thread->core];
+    int ticker_core = system->ticker && thread->core == system->interrupt_core;
+    uint64_t instruction_end = cpu->instruction + thread->max_instructions;
+    uint64_t clock_end = system_clock_end(cpu->clock, thread->max_cycles);
+    uint64_t ticker_due = cpu->instruction + SYSTEM_PARALLEL_TICKER_INTERVAL;
+    int on_bus = 0;     // a request is in flight, the bus delivers into the cpu device, so it is only touched while holding the bus
+    while (cpu->state != CS_HALT && cpu->state != CS_EXCEPTION && cpu->instruction < instruction_end && cpu->clock < clock_end) {
+        if (!on_bus) {
+            if (cpu_step_instruction(cpu, system->ram)) {
+                if (ticker_core && cpu->instruction >= ticker_due && system_bus_try_lock(system, thread->core)) {
+                    system_clock_ticker(system);
+                    system_bus_unlock(system);
+                    ticker_due = cpu->instruction + SYSTEM_PARALLEL_TICKER_INTERVAL;
+                }
+                continue;
+            }
+            if (cpu->state == CS_HALT || cpu->state == CS_EXCEPTION) {
                 break;
-            default:
-                log_msg(LP_ERROR, "System: Unknown SCD clock [%s:%d]", __FILE__, __LINE__);
+            }
+            if (system_sleeps_forever(system, cpu)) {
+                // a core that went to sleep without the ticker routed to it is done, one that masked interrupts hangs
+                if (cpu->regs.sr.MI) {
+                    log_msg(LP_ERROR, "System: Core %d sleeps at pc %.4x with interrupts masked [%s:%d]", thread->core, cpu->regs.pc, __FILE__, __LINE__);
+                }
                 break;
+            }
+        }
+        system_bus_spin_lock(system, thread->core);
+        if (cpu->state == CS_SLEEP) {
+            system_clock_ticker(system);
+        }
+        system_clock_core(system, cpu);
+        on_bus = cpu->device.device_state != DS_IDLE || cpu->device.processed;
+        system_bus_unlock(system);
+        if (cpu->state == CS_SLEEP && !on_bus && ticker_core && !system_dma_busy(system)) {
+            double wait = ticker_time_to_interrupt(system->ticker);
+            if (wait > 0.0) {
+                // like system_fast_forward, the skipped cycles count, so max_cycles bounds a core that keeps going to sleep
+                uint64_t cycles = (uint64_t) ceil(wait * system->frequency);
+                if (cycles > clock_end - cpu->clock) {
+                    cycles = clock_end - cpu->clock;
+                }
+                system_wait_cycles(system, cycles);
+                cpu->clock += cycles;
+            }
+        }
+    }
+    cpu_status_register(cpu);
+    return NULL;
+}
+
+void system_run_parallel(System_t* system, uint64_t max_instructions, uint64_t max_cycles) {
+    if (!system) {
+        log_msg(LP_ERROR, "System: NULL pointer [%s:%d]", __FILE__, __LINE__);
+        return;
+    }
+    pthread_t thread[SYSTEM_MAX_CORES];
+    SystemCoreThread_t core_thread[SYSTEM_MAX_CORES];
+    int started = 0;
+    system->ram->shared = system->core_count > 1;
+    for (int c = 0; c < system->core_count; c++) {
+        core_thread[c] = (SystemCoreThread_t) {.system = system, .core = c, .max_instructions = max_instructions, .max_cycles = max_cycles};
+        if (pthread_create(&thread[c], NULL, system_core_thread, &core_thread[c]) != 0) {
+            log_msg(LP_ERROR, "System: Thread for core %d could not be created [%s:%d]", c, __FILE__, __LINE__);
+            break;
         }
+        started ++;
+    }
+    for (int c = 0; c < started; c++) {
+        pthread_join(thread[c], NULL);
+    }
+    system->ram->shared = 0;
+}
+
+static void system_idle_loop_arm(System_t* system) {
+    CPU_t* cpu = system->cpu;
+    system->idle_loop = (SystemIdleLoop_t) {
+        .pc = cpu->regs.pc, 
+        .r0 = cpu->regs.r0, .r1 = cpu->regs.r1, .r2 = cpu->regs.r2, .r3 = cpu->regs.r3, 
+        .sp = cpu->regs.sp, .sr = cpu->regs.sr.value, 
+        .flags_operation = cpu->flags.operation, .flags_pending = cpu->flags.pending, 
+        .flags_a = cpu->flags.a, .flags_b = cpu->flags.b, 
+        .clock = cpu->clock, .instruction = cpu->instruction, .stores = cpu->stores, 
+        .valid = 1, 
+    };
+    if (cpu->pipeline) {
+        system->idle_loop.pipeline_clock = cpu->pipeline->clock;
+        system->idle_loop.pipeline_instructions = cpu->pipeline->instructions;
+    }
+}
+
+/*
+Called after every instruction (or JIT block) that started at pc_before. 
+Jumps that go backwards close a loop iteration, see SystemIdleLoop_t. 
+Returns the number of skipped cycles
+*/
+static uint64_t system_idle_loop_skip(System_t* system, uint16_t pc_before, uint64_t instruction_end) {
+    CPU_t* cpu = system->cpu;
+    SystemIdleLoop_t* loop = &system->idle_loop;
+    if (cpu->regs.pc > pc_before || cpu->state != CS_FETCH_INSTRUCTION) {return 0;}
+    if (
+        !loop->valid || loop->pc != cpu->regs.pc || loop->stores != cpu->stores || 
+        loop->r0 != cpu->regs.r0 || loop->r1 != cpu->regs.r1 || loop->r2 != cpu->regs.r2 || loop->r3 != cpu->regs.r3 || 
+        loop->sp != cpu->regs.sp || loop->sr != cpu->regs.sr.value || 
+        loop->flags_operation != cpu->flags.operation || loop->flags_pending != cpu->flags.pending || 
+        loop->flags_a != cpu->flags.a || loop->flags_b != cpu->flags.b
+    ) {
+        system_idle_loop_arm(system);
+        return 0;
+    }
+
+    uint64_t cycles = cpu->clock - loop->clock;
+    uint64_t instructions = cpu->instruction - loop->instruction;
+    if (!cycles || !instructions || cpu->instruction >= instruction_end || !system_devices_idle(system)) {
+        system_idle_loop_arm(system);
+        return 0;
+    }
+    uint64_t iterations = (instruction_end - cpu->instruction) / instructions;
+    if (system->ticker) {
+        // the interrupt is the only thing that can break the loop, it has to be taken on time
+        uint64_t wait = system_cycles_to_interrupt(system, iterations * cycles);
+        iterations = wait / cycles;
     }
+    if (!iterations) {
+        system_idle_loop_arm(system);
+        return 0;
+    }
+
+    uint64_t skipped = iterations * cycles;
+    if (system->ticker) {
+        system_wait_cycles(system, skipped);
+    }
+    system_advance_clocks(system, skipped);
+    cpu->instruction += iterations * instructions;
+    if (cpu->pipeline) {
+        cpu_pipeline_advance(cpu->pipeline, iterations * (cpu->pipeline->clock - loop->pipeline_clock), iterations * (cpu->pipeline->instructions - loop->pipeline_instructions));
+    }
+    system->idle_loop_skips ++;
+    system->idle_loop_cycles += skipped;
+    system_idle_loop_arm(system);
+    return skipped;
 }
 
 
@@ -171,7 +654,10 @@ void system_clock_debug(System_t *system) {
         return;
     }
     system_clock(system);
-    
+    system_hook_check(system);
+}
+
+static void system_hook_check(System_t* system) {
     // save intermediate values again
     int index = 0;
     for (int h = 0; h < system->hook_count; h++) {
@@ -253,3 +739,151 @@ void system_clock_debug(System_t *system) {
     }
 }
 
+
+void system_add_breakpoint(System_t* system, uint16_t pc) {
+    if (!system) {
+        log_msg(LP_ERROR, "System: NULL pointer [%s:%d]", __FILE__, __LINE__);
+        return;
+    }
+    system->breakpoint = realloc(system->breakpoint, sizeof(uint16_t) * (system->breakpoint_count + 1));
+    system->breakpoint[system->breakpoint_count++] = pc;
+}
+
+void system_add_cycle_window(System_t* system, uint16_t start, uint16_t end) {
+    if (!system) {
+        log_msg(LP_ERROR, "System: NULL pointer [%s:%d]", __FILE__, __LINE__);
+        return;
+    }
+    if (end <= start) {
+        log_msg(LP_ERROR, "System: Empty cycle window 0x%.4X-0x%.4X [%s:%d]", start, end, __FILE__, __LINE__);
+        return;
+    }
+    system->cycle_window = realloc(system->cycle_window, sizeof(SystemCycleWindow_t) * (system->cycle_window_count + 1));
+    system->cycle_window[system->cycle_window_count++] = (SystemCycleWindow_t) {.start = start, .end = end};
+}
+
+// hooks that have to look at every single cycle
+static int system_hooks_every_cycle(System_t* system) {
+    for (int h = 0; h < system->hook_count; h++) {
+        switch (system->hook[h].condition) {
+            case HC_ALWAYS:
+            case HC_READ_FROM:
+                return 1;
+            case HC_CHANGE:
+                if (system->hook[h].target == (void*) &system->cpu->regs.pc) {return 1;}
+                break;
+            default:
+                break;
+        }
+    }
+    return 0;
+}
+
+// 1 if a pc HC_MATCH hook could fire while the instruction at pc runs
+static int system_hooks_pc_ahead(System_t* system, uint16_t pc) {
+    for (int h = 0; h < system->hook_count; h++) {
+        Hook_t* hook = &system->hook[h];
+        if (hook->condition != HC_MATCH || hook->target != (void*) &system->cpu->regs.pc) {continue;}
+        uint16_t match = hook->target_bytes == 1 ? *(uint8_t*) hook->match : *(uint16_t*) hook->match;
+        if ((uint16_t) (match - pc - 1) < SYSTEM_HYBRID_LOOKAHEAD) {return 1;}
+    }
+    return 0;
+}
+
+static int system_in_cycle_window(System_t* system, uint16_t pc) {
+    for (int i = 0; i < system->cycle_window_count; i++) {
+        if (pc >= system->cycle_window[i].start && pc < system->cycle_window[i].end) {return 1;}
+    }
+    return 0;
+}
+
+static int system_at_breakpoint(System_t* system, uint16_t pc) {
+    for (int i = 0; i < system->breakpoint_count; i++) {
+        if (system->breakpoint[i] == pc) {return 1;}
+    }
+    return 0;
+}
+
+int system_run_hybrid(System_t* system, uint64_t max_instructions, uint64_t max_cycles) {
+    if (!system) {
+        log_msg(LP_ERROR, "System: NULL pointer [%s:%d]", __FILE__, __LINE__);
+        return 0;
+    }
+    CPU_t* cpu = system->cpu;
+    uint64_t instruction_end = cpu->instruction + max_instructions;
+    uint64_t clock_end = system_clock_end(cpu->clock, max_cycles);
+    int every_cycle = system_hooks_every_cycle(system);
+    int stops = system->hook_count || system->breakpoint_count || system->cycle_window_count;
+    int jit = cpu->jit && !stops;
+    // a superinstruction would run past the pcs of its followers, so it is off for as long as anything can stop there
+    uint8_t fusion = cpu->decode_cache ? cpu->decode_cache->fusion : 0;
+    if (cpu->decode_cache && stops) {
+        cpu->decode_cache->fusion = 0;
+    }
+    int stopped = 0;
+    int was_boundary = 1;       // a breakpoint the cpu is sitting on right now does not stop it again
+    int device = 0;             // the current instruction went through the bus, it finishes cycle by cycle
+    uint16_t device_pc = 0;
+
+    while (cpu->state != CS_HALT && cpu->state != CS_EXCEPTION && cpu->instruction < instruction_end && cpu->clock < clock_end) {
+        // on the bus the next fetch can already be underway, the instruction still counts as not started
+        int boundary = cpu->state == CS_FETCH_INSTRUCTION && cpu->intermediate.extension_index == 0;
+        uint16_t pc = boundary ? cpu->regs.pc : cpu->intermediate.previous_pc;
+        if (boundary && !was_boundary && system->breakpoint_count && system_at_breakpoint(system, pc)) {
+            stopped = 1;
+            break;
+        }
+        was_boundary = boundary;
+        if (device && pc != device_pc) {
+            device = 0;
+        }
+
+        if (
+            every_cycle || device || system_dma_busy(system) || 
+            (system->cycle_window_count && system_in_cycle_window(system, pc)) || 
+            (system->hook_count && system_hooks_pc_ahead(system, pc))
+        ) {
+            if (system_sleeps_forever(system, cpu)) {
+                log_msg(LP_ERROR, "System: The cpu sleeps at pc %.4x with nothing to wake it up (MI %d) [%s:%d]", cpu->regs.pc, cpu->regs.sr.MI, __FILE__, __LINE__);
+                break;
+            }
+            if (cpu->state == CS_SLEEP && !every_cycle && system_fast_forward(system, clock_end - cpu->clock)) {
+                continue;
+            }
+            if (system->hook_count) {
+                system_clock_debug(system);
+            } else {
+                system_clock(system);
+            }
+            system->hybrid_accurate_cycles ++;
+            continue;
+        }
+
+        uint64_t instruction = cpu->instruction;
+        uint16_t pc_before = cpu->regs.pc;
+        if (jit && cpu_jit_run(cpu->jit, cpu)) {
+            // a whole block ran
+        } else if (!cpu_step_instruction(cpu, system->ram)) {
+            if (cpu->state == CS_HALT || cpu->state == CS_EXCEPTION) {
+                break;
+            }
+            device = 1;
+            device_pc = cpu->intermediate.previous_pc;
+            continue;
+        }
+        system->hybrid_fast_instructions += cpu->instruction - instruction;
+        was_boundary = 0;
+        if (system->hook_count) {
+            system_hook_check(system);
+        } else if (!system->breakpoint_count) {
+            // a breakpoint inside the loop has to be hit on the next iteration
+            system_idle_loop_skip(system, pc_before, instruction_end);
+        }
+        system_clock_ticker(system);
+    }
+    cpu_status_register(cpu);
+    if (cpu->decode_cache) {
+        cpu->decode_cache->fusion = fusion;
+    }
+    return stopped;
+}
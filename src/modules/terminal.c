@@ -5,13 +5,24 @@
 #include "globals/memory_layout.h"
 
 #include "modules/device.h"
+#include "modules/bus.h"
 #include "modules/terminal.h"
 
 const uint16_t MMIO_INPUT_REGISTER = SEGMENT_MMIO + 2;
 
+static void terminal_device_clock(void* terminal) {
+    terminal_clock((Terminal_t*) terminal);
+}
+
+static const DeviceOps_t terminal_device_ops = {
+    .clock = terminal_device_clock, 
+    .reply = bus_return_reply, 
+};
+
 Terminal_t* terminal_create(void) {
     Terminal_t* terminal = malloc(sizeof(Terminal_t));
     terminal->device = device_create(DT_TERMINAL);
+    device_register_ops(&terminal->device, &terminal_device_ops, terminal, 1);
     device_add_listening_region(
         &terminal->device, 
         listening_region_create(MMIO_INPUT_REGISTER, MMIO_INPUT_REGISTER, LR_WRITE)
@@ -39,12 +50,14 @@ void terminal_clock(Terminal_t* terminal) {
     //log_msg(LP_INFO, "Terminal %d: state %d", terminal->clock, terminal->device.device_state);
     if (terminal->device.device_state == DS_FETCH) {
         terminal->device.processed = 1;
+        device_post(&terminal->device);
     }
     if (terminal->device.device_state == DS_STORE) {
         //log_msg(LP_INFO, "Terminal %d: recieved store request", terminal->clock);
         uint8_t data = terminal->device.data;
         printf("%c", data);
         terminal->device.processed = 1;
+        device_post(&terminal->device);
         //log_msg(LP_INFO, "Terminal %d: written %.2x", terminal->clock, terminal->device.data);
     }
 
@@ -5,6 +5,7 @@
 #include "globals/interrupt.h"
 
 #include "modules/device.h"
+#include "modules/bus.h"
 #include "modules/ticker.h"
 
 int n = 0;
@@ -16,12 +17,23 @@ static inline double get_time_seconds(void) {
     return t;
 }
 
+static void ticker_device_clock(void* ticker) {
+    ticker_clock((Ticker_t*) ticker);
+}
+
+static const DeviceOps_t ticker_device_ops = {
+    .clock = ticker_device_clock, 
+    .request = bus_deliver_interrupt, 
+    .clock_idle = 1, 
+};
+
 Ticker_t* ticker_create(float frequency) {
     Ticker_t* ticker = malloc(sizeof(Ticker_t));
     ticker->time = 0.0;
     ticker->intervall = 1.0 / frequency;
     ticker->last_time = get_time_seconds();
     ticker->device = device_create(DT_CLOCK);
+    device_register_ops(&ticker->device, &ticker_device_ops, ticker, 1);
     ticker->device.device_state = DS_IDLE;
 
     ticker->clock = 0ULL;
@@ -45,14 +57,27 @@ void ticker_clock(Ticker_t* ticker) {
 
     if (ticker->time >= ticker->intervall) {
         //log_msg(LP_DEBUG, "Ticker: INTERRUPTING!");
-        ticker->device.device_state = DS_INTERRUPT;
-        ticker->device.address = INT_CLOCK;
-        ticker->device.data = 0;
+        uint32_t elapsed = 0;
         while (ticker->time >= ticker->intervall) {
             ticker->time -= ticker->intervall;
+            elapsed ++;
+        }
+        if (ticker->device.device_state == DS_INTERRUPT) {
+            // the last one is still waiting for the bus, these go with it
+            ticker->device.coalesced += elapsed;
+        } else {
+            ticker->device.device_state = DS_INTERRUPT;
+            device_post(&ticker->device);
+            ticker->device.address = INT_CLOCK;
+            ticker->device.data = 0;
+            ticker->device.coalesced = elapsed - 1;
         }
     }
 
     ticker->clock ++;
     ticker->interrupts ++;
 }
+
+double ticker_time_to_interrupt(Ticker_t* ticker) {
+    return ticker->intervall - ticker->time - (get_time_seconds() - ticker->last_time);
+}